@@ -1,9 +1,1138 @@
+#define _DEFAULT_SOURCE // madvise(), O_CLOEXEC
+#define _FILE_OFFSET_BITS 64 // off_t
 #include <stdbool.h> // bool
-#include <stdlib.h> // malloc(), free(), qsort()
+#include <stdlib.h> // malloc(), free()
+#include <string.h> // memcpy(), memchr(), memset()
+#include <float.h> // FLT_EVAL_METHOD
+#include <stdint.h> // SIZE_MAX
+#include <pthread.h> // pthread_*()
+#include <fcntl.h> // open()
+#include <unistd.h> // close(), sysconf()
+#include <errno.h> // errno
+#include <sys/stat.h> // fstat()
+#include <sys/mman.h> // mmap(), munmap(), madvise()
 #include "jiffy.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h> // _mm_*()
+#endif // __SSE2__
+
+#ifdef __SSSE3__
+#include <tmmintrin.h> // _mm_shuffle_epi8(), _mm_alignr_epi8()
+#endif // __SSSE3__
+
+#ifdef __AVX2__
+#include <immintrin.h> // _mm256_*()
+#endif // __AVX2__
+
+#ifdef __PCLMUL__
+#include <wmmintrin.h> // _mm_clmulepi64_si128()
+#endif // __PCLMUL__
+
 #define MAX(a, b) (((a) > (b)) ? (a) : (b))
 
+/**
+ * Get the index of the lowest set bit in the given non-zero mask.
+ */
+static inline size_t
+ctz32(
+  const uint32_t mask
+) {
+#ifdef __GNUC__
+  return __builtin_ctz(mask);
+#else
+  size_t r = 0;
+  while (!(mask & ((uint32_t) 1 << r))) {
+    r++;
+  }
+  return r;
+#endif // __GNUC__
+}
+
+/**
+ * Get the index of the lowest set bit in the given non-zero mask.
+ */
+static inline size_t
+ctz64(
+  const uint64_t mask
+) {
+#ifdef __GNUC__
+  return __builtin_ctzll(mask);
+#else
+  size_t r = 0;
+  while (!(mask & ((uint64_t) 1 << r))) {
+    r++;
+  }
+  return r;
+#endif // __GNUC__
+}
+
+/**
+ * Get the number of set bits in the given mask.
+ */
+static inline size_t
+popcount64(
+  uint64_t mask
+) {
+#ifdef __GNUC__
+  return __builtin_popcountll(mask);
+#else
+  size_t r = 0;
+  for (; mask; mask &= mask - 1) {
+    r++;
+  }
+  return r;
+#endif // __GNUC__
+}
+
+/**
+ * Get the number of leading zero bits in the given non-zero value.
+ */
+static inline size_t
+clz64(
+  const uint64_t val
+) {
+#ifdef __GNUC__
+  return __builtin_clzll(val);
+#else
+  size_t r = 0;
+  while (!(val & ((uint64_t) 1 << (63 - r)))) {
+    r++;
+  }
+  return r;
+#endif // __GNUC__
+}
+
+/**
+ * Unsigned 128-bit value.
+ */
+typedef struct {
+  uint64_t lo;
+  uint64_t hi;
+} jiffy_u128_t;
+
+/**
+ * Multiply two 64-bit values and return the full 128-bit product.
+ */
+static inline jiffy_u128_t
+mul128(
+  const uint64_t a,
+  const uint64_t b
+) {
+#ifdef __SIZEOF_INT128__
+  __extension__ const unsigned __int128 r = (unsigned __int128) a * b;
+  return (jiffy_u128_t) { .lo = (uint64_t) r, .hi = (uint64_t) (r >> 64) };
+#else
+  const uint64_t a_lo = a & 0xFFFFFFFF, a_hi = a >> 32,
+                 b_lo = b & 0xFFFFFFFF, b_hi = b >> 32,
+                 ll = a_lo * b_lo, lh = a_lo * b_hi,
+                 hl = a_hi * b_lo, hh = a_hi * b_hi,
+                 mid = (ll >> 32) + (lh & 0xFFFFFFFF) + (hl & 0xFFFFFFFF);
+
+  return (jiffy_u128_t) {
+    .lo = (mid << 32) | (ll & 0xFFFFFFFF),
+    .hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32),
+  };
+#endif // __SIZEOF_INT128__
+}
+
+// smallest and largest decimal exponents which are not rounded to zero
+// or infinity, respectively, by jiffy_number_eisel_lemire()
+#define POW5_MIN (-342)
+#define POW5_MAX 308
+
+/**
+ * 128-bit truncated (or, for negative exponents, rounded up) powers of
+ * five from 5^-342 to 5^308, normalized so that the highest bit is
+ * set.  Used by jiffy_number_eisel_lemire().
+ *
+ * Generated with the table_generation.py script from the fast_float
+ * library.
+ */
+static const uint64_t
+POW5[POW5_MAX - POW5_MIN + 1][2] = {
+  { 0xeef453d6923bd65aULL, 0x113faa2906a13b3fULL },
+  { 0x9558b4661b6565f8ULL, 0x4ac7ca59a424c507ULL },
+  { 0xbaaee17fa23ebf76ULL, 0x5d79bcf00d2df649ULL },
+  { 0xe95a99df8ace6f53ULL, 0xf4d82c2c107973dcULL },
+  { 0x91d8a02bb6c10594ULL, 0x79071b9b8a4be869ULL },
+  { 0xb64ec836a47146f9ULL, 0x9748e2826cdee284ULL },
+  { 0xe3e27a444d8d98b7ULL, 0xfd1b1b2308169b25ULL },
+  { 0x8e6d8c6ab0787f72ULL, 0xfe30f0f5e50e20f7ULL },
+  { 0xb208ef855c969f4fULL, 0xbdbd2d335e51a935ULL },
+  { 0xde8b2b66b3bc4723ULL, 0xad2c788035e61382ULL },
+  { 0x8b16fb203055ac76ULL, 0x4c3bcb5021afcc31ULL },
+  { 0xaddcb9e83c6b1793ULL, 0xdf4abe242a1bbf3dULL },
+  { 0xd953e8624b85dd78ULL, 0xd71d6dad34a2af0dULL },
+  { 0x87d4713d6f33aa6bULL, 0x8672648c40e5ad68ULL },
+  { 0xa9c98d8ccb009506ULL, 0x680efdaf511f18c2ULL },
+  { 0xd43bf0effdc0ba48ULL, 0x0212bd1b2566def2ULL },
+  { 0x84a57695fe98746dULL, 0x014bb630f7604b57ULL },
+  { 0xa5ced43b7e3e9188ULL, 0x419ea3bd35385e2dULL },
+  { 0xcf42894a5dce35eaULL, 0x52064cac828675b9ULL },
+  { 0x818995ce7aa0e1b2ULL, 0x7343efebd1940993ULL },
+  { 0xa1ebfb4219491a1fULL, 0x1014ebe6c5f90bf8ULL },
+  { 0xca66fa129f9b60a6ULL, 0xd41a26e077774ef6ULL },
+  { 0xfd00b897478238d0ULL, 0x8920b098955522b4ULL },
+  { 0x9e20735e8cb16382ULL, 0x55b46e5f5d5535b0ULL },
+  { 0xc5a890362fddbc62ULL, 0xeb2189f734aa831dULL },
+  { 0xf712b443bbd52b7bULL, 0xa5e9ec7501d523e4ULL },
+  { 0x9a6bb0aa55653b2dULL, 0x47b233c92125366eULL },
+  { 0xc1069cd4eabe89f8ULL, 0x999ec0bb696e840aULL },
+  { 0xf148440a256e2c76ULL, 0xc00670ea43ca250dULL },
+  { 0x96cd2a865764dbcaULL, 0x380406926a5e5728ULL },
+  { 0xbc807527ed3e12bcULL, 0xc605083704f5ecf2ULL },
+  { 0xeba09271e88d976bULL, 0xf7864a44c633682eULL },
+  { 0x93445b8731587ea3ULL, 0x7ab3ee6afbe0211dULL },
+  { 0xb8157268fdae9e4cULL, 0x5960ea05bad82964ULL },
+  { 0xe61acf033d1a45dfULL, 0x6fb92487298e33bdULL },
+  { 0x8fd0c16206306babULL, 0xa5d3b6d479f8e056ULL },
+  { 0xb3c4f1ba87bc8696ULL, 0x8f48a4899877186cULL },
+  { 0xe0b62e2929aba83cULL, 0x331acdabfe94de87ULL },
+  { 0x8c71dcd9ba0b4925ULL, 0x9ff0c08b7f1d0b14ULL },
+  { 0xaf8e5410288e1b6fULL, 0x07ecf0ae5ee44dd9ULL },
+  { 0xdb71e91432b1a24aULL, 0xc9e82cd9f69d6150ULL },
+  { 0x892731ac9faf056eULL, 0xbe311c083a225cd2ULL },
+  { 0xab70fe17c79ac6caULL, 0x6dbd630a48aaf406ULL },
+  { 0xd64d3d9db981787dULL, 0x092cbbccdad5b108ULL },
+  { 0x85f0468293f0eb4eULL, 0x25bbf56008c58ea5ULL },
+  { 0xa76c582338ed2621ULL, 0xaf2af2b80af6f24eULL },
+  { 0xd1476e2c07286faaULL, 0x1af5af660db4aee1ULL },
+  { 0x82cca4db847945caULL, 0x50d98d9fc890ed4dULL },
+  { 0xa37fce126597973cULL, 0xe50ff107bab528a0ULL },
+  { 0xcc5fc196fefd7d0cULL, 0x1e53ed49a96272c8ULL },
+  { 0xff77b1fcbebcdc4fULL, 0x25e8e89c13bb0f7aULL },
+  { 0x9faacf3df73609b1ULL, 0x77b191618c54e9acULL },
+  { 0xc795830d75038c1dULL, 0xd59df5b9ef6a2417ULL },
+  { 0xf97ae3d0d2446f25ULL, 0x4b0573286b44ad1dULL },
+  { 0x9becce62836ac577ULL, 0x4ee367f9430aec32ULL },
+  { 0xc2e801fb244576d5ULL, 0x229c41f793cda73fULL },
+  { 0xf3a20279ed56d48aULL, 0x6b43527578c1110fULL },
+  { 0x9845418c345644d6ULL, 0x830a13896b78aaa9ULL },
+  { 0xbe5691ef416bd60cULL, 0x23cc986bc656d553ULL },
+  { 0xedec366b11c6cb8fULL, 0x2cbfbe86b7ec8aa8ULL },
+  { 0x94b3a202eb1c3f39ULL, 0x7bf7d71432f3d6a9ULL },
+  { 0xb9e08a83a5e34f07ULL, 0xdaf5ccd93fb0cc53ULL },
+  { 0xe858ad248f5c22c9ULL, 0xd1b3400f8f9cff68ULL },
+  { 0x91376c36d99995beULL, 0x23100809b9c21fa1ULL },
+  { 0xb58547448ffffb2dULL, 0xabd40a0c2832a78aULL },
+  { 0xe2e69915b3fff9f9ULL, 0x16c90c8f323f516cULL },
+  { 0x8dd01fad907ffc3bULL, 0xae3da7d97f6792e3ULL },
+  { 0xb1442798f49ffb4aULL, 0x99cd11cfdf41779cULL },
+  { 0xdd95317f31c7fa1dULL, 0x40405643d711d583ULL },
+  { 0x8a7d3eef7f1cfc52ULL, 0x482835ea666b2572ULL },
+  { 0xad1c8eab5ee43b66ULL, 0xda3243650005eecfULL },
+  { 0xd863b256369d4a40ULL, 0x90bed43e40076a82ULL },
+  { 0x873e4f75e2224e68ULL, 0x5a7744a6e804a291ULL },
+  { 0xa90de3535aaae202ULL, 0x711515d0a205cb36ULL },
+  { 0xd3515c2831559a83ULL, 0x0d5a5b44ca873e03ULL },
+  { 0x8412d9991ed58091ULL, 0xe858790afe9486c2ULL },
+  { 0xa5178fff668ae0b6ULL, 0x626e974dbe39a872ULL },
+  { 0xce5d73ff402d98e3ULL, 0xfb0a3d212dc8128fULL },
+  { 0x80fa687f881c7f8eULL, 0x7ce66634bc9d0b99ULL },
+  { 0xa139029f6a239f72ULL, 0x1c1fffc1ebc44e80ULL },
+  { 0xc987434744ac874eULL, 0xa327ffb266b56220ULL },
+  { 0xfbe9141915d7a922ULL, 0x4bf1ff9f0062baa8ULL },
+  { 0x9d71ac8fada6c9b5ULL, 0x6f773fc3603db4a9ULL },
+  { 0xc4ce17b399107c22ULL, 0xcb550fb4384d21d3ULL },
+  { 0xf6019da07f549b2bULL, 0x7e2a53a146606a48ULL },
+  { 0x99c102844f94e0fbULL, 0x2eda7444cbfc426dULL },
+  { 0xc0314325637a1939ULL, 0xfa911155fefb5308ULL },
+  { 0xf03d93eebc589f88ULL, 0x793555ab7eba27caULL },
+  { 0x96267c7535b763b5ULL, 0x4bc1558b2f3458deULL },
+  { 0xbbb01b9283253ca2ULL, 0x9eb1aaedfb016f16ULL },
+  { 0xea9c227723ee8bcbULL, 0x465e15a979c1cadcULL },
+  { 0x92a1958a7675175fULL, 0x0bfacd89ec191ec9ULL },
+  { 0xb749faed14125d36ULL, 0xcef980ec671f667bULL },
+  { 0xe51c79a85916f484ULL, 0x82b7e12780e7401aULL },
+  { 0x8f31cc0937ae58d2ULL, 0xd1b2ecb8b0908810ULL },
+  { 0xb2fe3f0b8599ef07ULL, 0x861fa7e6dcb4aa15ULL },
+  { 0xdfbdcece67006ac9ULL, 0x67a791e093e1d49aULL },
+  { 0x8bd6a141006042bdULL, 0xe0c8bb2c5c6d24e0ULL },
+  { 0xaecc49914078536dULL, 0x58fae9f773886e18ULL },
+  { 0xda7f5bf590966848ULL, 0xaf39a475506a899eULL },
+  { 0x888f99797a5e012dULL, 0x6d8406c952429603ULL },
+  { 0xaab37fd7d8f58178ULL, 0xc8e5087ba6d33b83ULL },
+  { 0xd5605fcdcf32e1d6ULL, 0xfb1e4a9a90880a64ULL },
+  { 0x855c3be0a17fcd26ULL, 0x5cf2eea09a55067fULL },
+  { 0xa6b34ad8c9dfc06fULL, 0xf42faa48c0ea481eULL },
+  { 0xd0601d8efc57b08bULL, 0xf13b94daf124da26ULL },
+  { 0x823c12795db6ce57ULL, 0x76c53d08d6b70858ULL },
+  { 0xa2cb1717b52481edULL, 0x54768c4b0c64ca6eULL },
+  { 0xcb7ddcdda26da268ULL, 0xa9942f5dcf7dfd09ULL },
+  { 0xfe5d54150b090b02ULL, 0xd3f93b35435d7c4cULL },
+  { 0x9efa548d26e5a6e1ULL, 0xc47bc5014a1a6dafULL },
+  { 0xc6b8e9b0709f109aULL, 0x359ab6419ca1091bULL },
+  { 0xf867241c8cc6d4c0ULL, 0xc30163d203c94b62ULL },
+  { 0x9b407691d7fc44f8ULL, 0x79e0de63425dcf1dULL },
+  { 0xc21094364dfb5636ULL, 0x985915fc12f542e4ULL },
+  { 0xf294b943e17a2bc4ULL, 0x3e6f5b7b17b2939dULL },
+  { 0x979cf3ca6cec5b5aULL, 0xa705992ceecf9c42ULL },
+  { 0xbd8430bd08277231ULL, 0x50c6ff782a838353ULL },
+  { 0xece53cec4a314ebdULL, 0xa4f8bf5635246428ULL },
+  { 0x940f4613ae5ed136ULL, 0x871b7795e136be99ULL },
+  { 0xb913179899f68584ULL, 0x28e2557b59846e3fULL },
+  { 0xe757dd7ec07426e5ULL, 0x331aeada2fe589cfULL },
+  { 0x9096ea6f3848984fULL, 0x3ff0d2c85def7621ULL },
+  { 0xb4bca50b065abe63ULL, 0x0fed077a756b53a9ULL },
+  { 0xe1ebce4dc7f16dfbULL, 0xd3e8495912c62894ULL },
+  { 0x8d3360f09cf6e4bdULL, 0x64712dd7abbbd95cULL },
+  { 0xb080392cc4349decULL, 0xbd8d794d96aacfb3ULL },
+  { 0xdca04777f541c567ULL, 0xecf0d7a0fc5583a0ULL },
+  { 0x89e42caaf9491b60ULL, 0xf41686c49db57244ULL },
+  { 0xac5d37d5b79b6239ULL, 0x311c2875c522ced5ULL },
+  { 0xd77485cb25823ac7ULL, 0x7d633293366b828bULL },
+  { 0x86a8d39ef77164bcULL, 0xae5dff9c02033197ULL },
+  { 0xa8530886b54dbdebULL, 0xd9f57f830283fdfcULL },
+  { 0xd267caa862a12d66ULL, 0xd072df63c324fd7bULL },
+  { 0x8380dea93da4bc60ULL, 0x4247cb9e59f71e6dULL },
+  { 0xa46116538d0deb78ULL, 0x52d9be85f074e608ULL },
+  { 0xcd795be870516656ULL, 0x67902e276c921f8bULL },
+  { 0x806bd9714632dff6ULL, 0x00ba1cd8a3db53b6ULL },
+  { 0xa086cfcd97bf97f3ULL, 0x80e8a40eccd228a4ULL },
+  { 0xc8a883c0fdaf7df0ULL, 0x6122cd128006b2cdULL },
+  { 0xfad2a4b13d1b5d6cULL, 0x796b805720085f81ULL },
+  { 0x9cc3a6eec6311a63ULL, 0xcbe3303674053bb0ULL },
+  { 0xc3f490aa77bd60fcULL, 0xbedbfc4411068a9cULL },
+  { 0xf4f1b4d515acb93bULL, 0xee92fb5515482d44ULL },
+  { 0x991711052d8bf3c5ULL, 0x751bdd152d4d1c4aULL },
+  { 0xbf5cd54678eef0b6ULL, 0xd262d45a78a0635dULL },
+  { 0xef340a98172aace4ULL, 0x86fb897116c87c34ULL },
+  { 0x9580869f0e7aac0eULL, 0xd45d35e6ae3d4da0ULL },
+  { 0xbae0a846d2195712ULL, 0x8974836059cca109ULL },
+  { 0xe998d258869facd7ULL, 0x2bd1a438703fc94bULL },
+  { 0x91ff83775423cc06ULL, 0x7b6306a34627ddcfULL },
+  { 0xb67f6455292cbf08ULL, 0x1a3bc84c17b1d542ULL },
+  { 0xe41f3d6a7377eecaULL, 0x20caba5f1d9e4a93ULL },
+  { 0x8e938662882af53eULL, 0x547eb47b7282ee9cULL },
+  { 0xb23867fb2a35b28dULL, 0xe99e619a4f23aa43ULL },
+  { 0xdec681f9f4c31f31ULL, 0x6405fa00e2ec94d4ULL },
+  { 0x8b3c113c38f9f37eULL, 0xde83bc408dd3dd04ULL },
+  { 0xae0b158b4738705eULL, 0x9624ab50b148d445ULL },
+  { 0xd98ddaee19068c76ULL, 0x3badd624dd9b0957ULL },
+  { 0x87f8a8d4cfa417c9ULL, 0xe54ca5d70a80e5d6ULL },
+  { 0xa9f6d30a038d1dbcULL, 0x5e9fcf4ccd211f4cULL },
+  { 0xd47487cc8470652bULL, 0x7647c3200069671fULL },
+  { 0x84c8d4dfd2c63f3bULL, 0x29ecd9f40041e073ULL },
+  { 0xa5fb0a17c777cf09ULL, 0xf468107100525890ULL },
+  { 0xcf79cc9db955c2ccULL, 0x7182148d4066eeb4ULL },
+  { 0x81ac1fe293d599bfULL, 0xc6f14cd848405530ULL },
+  { 0xa21727db38cb002fULL, 0xb8ada00e5a506a7cULL },
+  { 0xca9cf1d206fdc03bULL, 0xa6d90811f0e4851cULL },
+  { 0xfd442e4688bd304aULL, 0x908f4a166d1da663ULL },
+  { 0x9e4a9cec15763e2eULL, 0x9a598e4e043287feULL },
+  { 0xc5dd44271ad3cdbaULL, 0x40eff1e1853f29fdULL },
+  { 0xf7549530e188c128ULL, 0xd12bee59e68ef47cULL },
+  { 0x9a94dd3e8cf578b9ULL, 0x82bb74f8301958ceULL },
+  { 0xc13a148e3032d6e7ULL, 0xe36a52363c1faf01ULL },
+  { 0xf18899b1bc3f8ca1ULL, 0xdc44e6c3cb279ac1ULL },
+  { 0x96f5600f15a7b7e5ULL, 0x29ab103a5ef8c0b9ULL },
+  { 0xbcb2b812db11a5deULL, 0x7415d448f6b6f0e7ULL },
+  { 0xebdf661791d60f56ULL, 0x111b495b3464ad21ULL },
+  { 0x936b9fcebb25c995ULL, 0xcab10dd900beec34ULL },
+  { 0xb84687c269ef3bfbULL, 0x3d5d514f40eea742ULL },
+  { 0xe65829b3046b0afaULL, 0x0cb4a5a3112a5112ULL },
+  { 0x8ff71a0fe2c2e6dcULL, 0x47f0e785eaba72abULL },
+  { 0xb3f4e093db73a093ULL, 0x59ed216765690f56ULL },
+  { 0xe0f218b8d25088b8ULL, 0x306869c13ec3532cULL },
+  { 0x8c974f7383725573ULL, 0x1e414218c73a13fbULL },
+  { 0xafbd2350644eeacfULL, 0xe5d1929ef90898faULL },
+  { 0xdbac6c247d62a583ULL, 0xdf45f746b74abf39ULL },
+  { 0x894bc396ce5da772ULL, 0x6b8bba8c328eb783ULL },
+  { 0xab9eb47c81f5114fULL, 0x066ea92f3f326564ULL },
+  { 0xd686619ba27255a2ULL, 0xc80a537b0efefebdULL },
+  { 0x8613fd0145877585ULL, 0xbd06742ce95f5f36ULL },
+  { 0xa798fc4196e952e7ULL, 0x2c48113823b73704ULL },
+  { 0xd17f3b51fca3a7a0ULL, 0xf75a15862ca504c5ULL },
+  { 0x82ef85133de648c4ULL, 0x9a984d73dbe722fbULL },
+  { 0xa3ab66580d5fdaf5ULL, 0xc13e60d0d2e0ebbaULL },
+  { 0xcc963fee10b7d1b3ULL, 0x318df905079926a8ULL },
+  { 0xffbbcfe994e5c61fULL, 0xfdf17746497f7052ULL },
+  { 0x9fd561f1fd0f9bd3ULL, 0xfeb6ea8bedefa633ULL },
+  { 0xc7caba6e7c5382c8ULL, 0xfe64a52ee96b8fc0ULL },
+  { 0xf9bd690a1b68637bULL, 0x3dfdce7aa3c673b0ULL },
+  { 0x9c1661a651213e2dULL, 0x06bea10ca65c084eULL },
+  { 0xc31bfa0fe5698db8ULL, 0x486e494fcff30a62ULL },
+  { 0xf3e2f893dec3f126ULL, 0x5a89dba3c3efccfaULL },
+  { 0x986ddb5c6b3a76b7ULL, 0xf89629465a75e01cULL },
+  { 0xbe89523386091465ULL, 0xf6bbb397f1135823ULL },
+  { 0xee2ba6c0678b597fULL, 0x746aa07ded582e2cULL },
+  { 0x94db483840b717efULL, 0xa8c2a44eb4571cdcULL },
+  { 0xba121a4650e4ddebULL, 0x92f34d62616ce413ULL },
+  { 0xe896a0d7e51e1566ULL, 0x77b020baf9c81d17ULL },
+  { 0x915e2486ef32cd60ULL, 0x0ace1474dc1d122eULL },
+  { 0xb5b5ada8aaff80b8ULL, 0x0d819992132456baULL },
+  { 0xe3231912d5bf60e6ULL, 0x10e1fff697ed6c69ULL },
+  { 0x8df5efabc5979c8fULL, 0xca8d3ffa1ef463c1ULL },
+  { 0xb1736b96b6fd83b3ULL, 0xbd308ff8a6b17cb2ULL },
+  { 0xddd0467c64bce4a0ULL, 0xac7cb3f6d05ddbdeULL },
+  { 0x8aa22c0dbef60ee4ULL, 0x6bcdf07a423aa96bULL },
+  { 0xad4ab7112eb3929dULL, 0x86c16c98d2c953c6ULL },
+  { 0xd89d64d57a607744ULL, 0xe871c7bf077ba8b7ULL },
+  { 0x87625f056c7c4a8bULL, 0x11471cd764ad4972ULL },
+  { 0xa93af6c6c79b5d2dULL, 0xd598e40d3dd89bcfULL },
+  { 0xd389b47879823479ULL, 0x4aff1d108d4ec2c3ULL },
+  { 0x843610cb4bf160cbULL, 0xcedf722a585139baULL },
+  { 0xa54394fe1eedb8feULL, 0xc2974eb4ee658828ULL },
+  { 0xce947a3da6a9273eULL, 0x733d226229feea32ULL },
+  { 0x811ccc668829b887ULL, 0x0806357d5a3f525fULL },
+  { 0xa163ff802a3426a8ULL, 0xca07c2dcb0cf26f7ULL },
+  { 0xc9bcff6034c13052ULL, 0xfc89b393dd02f0b5ULL },
+  { 0xfc2c3f3841f17c67ULL, 0xbbac2078d443ace2ULL },
+  { 0x9d9ba7832936edc0ULL, 0xd54b944b84aa4c0dULL },
+  { 0xc5029163f384a931ULL, 0x0a9e795e65d4df11ULL },
+  { 0xf64335bcf065d37dULL, 0x4d4617b5ff4a16d5ULL },
+  { 0x99ea0196163fa42eULL, 0x504bced1bf8e4e45ULL },
+  { 0xc06481fb9bcf8d39ULL, 0xe45ec2862f71e1d6ULL },
+  { 0xf07da27a82c37088ULL, 0x5d767327bb4e5a4cULL },
+  { 0x964e858c91ba2655ULL, 0x3a6a07f8d510f86fULL },
+  { 0xbbe226efb628afeaULL, 0x890489f70a55368bULL },
+  { 0xeadab0aba3b2dbe5ULL, 0x2b45ac74ccea842eULL },
+  { 0x92c8ae6b464fc96fULL, 0x3b0b8bc90012929dULL },
+  { 0xb77ada0617e3bbcbULL, 0x09ce6ebb40173744ULL },
+  { 0xe55990879ddcaabdULL, 0xcc420a6a101d0515ULL },
+  { 0x8f57fa54c2a9eab6ULL, 0x9fa946824a12232dULL },
+  { 0xb32df8e9f3546564ULL, 0x47939822dc96abf9ULL },
+  { 0xdff9772470297ebdULL, 0x59787e2b93bc56f7ULL },
+  { 0x8bfbea76c619ef36ULL, 0x57eb4edb3c55b65aULL },
+  { 0xaefae51477a06b03ULL, 0xede622920b6b23f1ULL },
+  { 0xdab99e59958885c4ULL, 0xe95fab368e45ecedULL },
+  { 0x88b402f7fd75539bULL, 0x11dbcb0218ebb414ULL },
+  { 0xaae103b5fcd2a881ULL, 0xd652bdc29f26a119ULL },
+  { 0xd59944a37c0752a2ULL, 0x4be76d3346f0495fULL },
+  { 0x857fcae62d8493a5ULL, 0x6f70a4400c562ddbULL },
+  { 0xa6dfbd9fb8e5b88eULL, 0xcb4ccd500f6bb952ULL },
+  { 0xd097ad07a71f26b2ULL, 0x7e2000a41346a7a7ULL },
+  { 0x825ecc24c873782fULL, 0x8ed400668c0c28c8ULL },
+  { 0xa2f67f2dfa90563bULL, 0x728900802f0f32faULL },
+  { 0xcbb41ef979346bcaULL, 0x4f2b40a03ad2ffb9ULL },
+  { 0xfea126b7d78186bcULL, 0xe2f610c84987bfa8ULL },
+  { 0x9f24b832e6b0f436ULL, 0x0dd9ca7d2df4d7c9ULL },
+  { 0xc6ede63fa05d3143ULL, 0x91503d1c79720dbbULL },
+  { 0xf8a95fcf88747d94ULL, 0x75a44c6397ce912aULL },
+  { 0x9b69dbe1b548ce7cULL, 0xc986afbe3ee11abaULL },
+  { 0xc24452da229b021bULL, 0xfbe85badce996168ULL },
+  { 0xf2d56790ab41c2a2ULL, 0xfae27299423fb9c3ULL },
+  { 0x97c560ba6b0919a5ULL, 0xdccd879fc967d41aULL },
+  { 0xbdb6b8e905cb600fULL, 0x5400e987bbc1c920ULL },
+  { 0xed246723473e3813ULL, 0x290123e9aab23b68ULL },
+  { 0x9436c0760c86e30bULL, 0xf9a0b6720aaf6521ULL },
+  { 0xb94470938fa89bceULL, 0xf808e40e8d5b3e69ULL },
+  { 0xe7958cb87392c2c2ULL, 0xb60b1d1230b20e04ULL },
+  { 0x90bd77f3483bb9b9ULL, 0xb1c6f22b5e6f48c2ULL },
+  { 0xb4ecd5f01a4aa828ULL, 0x1e38aeb6360b1af3ULL },
+  { 0xe2280b6c20dd5232ULL, 0x25c6da63c38de1b0ULL },
+  { 0x8d590723948a535fULL, 0x579c487e5a38ad0eULL },
+  { 0xb0af48ec79ace837ULL, 0x2d835a9df0c6d851ULL },
+  { 0xdcdb1b2798182244ULL, 0xf8e431456cf88e65ULL },
+  { 0x8a08f0f8bf0f156bULL, 0x1b8e9ecb641b58ffULL },
+  { 0xac8b2d36eed2dac5ULL, 0xe272467e3d222f3fULL },
+  { 0xd7adf884aa879177ULL, 0x5b0ed81dcc6abb0fULL },
+  { 0x86ccbb52ea94baeaULL, 0x98e947129fc2b4e9ULL },
+  { 0xa87fea27a539e9a5ULL, 0x3f2398d747b36224ULL },
+  { 0xd29fe4b18e88640eULL, 0x8eec7f0d19a03aadULL },
+  { 0x83a3eeeef9153e89ULL, 0x1953cf68300424acULL },
+  { 0xa48ceaaab75a8e2bULL, 0x5fa8c3423c052dd7ULL },
+  { 0xcdb02555653131b6ULL, 0x3792f412cb06794dULL },
+  { 0x808e17555f3ebf11ULL, 0xe2bbd88bbee40bd0ULL },
+  { 0xa0b19d2ab70e6ed6ULL, 0x5b6aceaeae9d0ec4ULL },
+  { 0xc8de047564d20a8bULL, 0xf245825a5a445275ULL },
+  { 0xfb158592be068d2eULL, 0xeed6e2f0f0d56712ULL },
+  { 0x9ced737bb6c4183dULL, 0x55464dd69685606bULL },
+  { 0xc428d05aa4751e4cULL, 0xaa97e14c3c26b886ULL },
+  { 0xf53304714d9265dfULL, 0xd53dd99f4b3066a8ULL },
+  { 0x993fe2c6d07b7fabULL, 0xe546a8038efe4029ULL },
+  { 0xbf8fdb78849a5f96ULL, 0xde98520472bdd033ULL },
+  { 0xef73d256a5c0f77cULL, 0x963e66858f6d4440ULL },
+  { 0x95a8637627989aadULL, 0xdde7001379a44aa8ULL },
+  { 0xbb127c53b17ec159ULL, 0x5560c018580d5d52ULL },
+  { 0xe9d71b689dde71afULL, 0xaab8f01e6e10b4a6ULL },
+  { 0x9226712162ab070dULL, 0xcab3961304ca70e8ULL },
+  { 0xb6b00d69bb55c8d1ULL, 0x3d607b97c5fd0d22ULL },
+  { 0xe45c10c42a2b3b05ULL, 0x8cb89a7db77c506aULL },
+  { 0x8eb98a7a9a5b04e3ULL, 0x77f3608e92adb242ULL },
+  { 0xb267ed1940f1c61cULL, 0x55f038b237591ed3ULL },
+  { 0xdf01e85f912e37a3ULL, 0x6b6c46dec52f6688ULL },
+  { 0x8b61313bbabce2c6ULL, 0x2323ac4b3b3da015ULL },
+  { 0xae397d8aa96c1b77ULL, 0xabec975e0a0d081aULL },
+  { 0xd9c7dced53c72255ULL, 0x96e7bd358c904a21ULL },
+  { 0x881cea14545c7575ULL, 0x7e50d64177da2e54ULL },
+  { 0xaa242499697392d2ULL, 0xdde50bd1d5d0b9e9ULL },
+  { 0xd4ad2dbfc3d07787ULL, 0x955e4ec64b44e864ULL },
+  { 0x84ec3c97da624ab4ULL, 0xbd5af13bef0b113eULL },
+  { 0xa6274bbdd0fadd61ULL, 0xecb1ad8aeacdd58eULL },
+  { 0xcfb11ead453994baULL, 0x67de18eda5814af2ULL },
+  { 0x81ceb32c4b43fcf4ULL, 0x80eacf948770ced7ULL },
+  { 0xa2425ff75e14fc31ULL, 0xa1258379a94d028dULL },
+  { 0xcad2f7f5359a3b3eULL, 0x096ee45813a04330ULL },
+  { 0xfd87b5f28300ca0dULL, 0x8bca9d6e188853fcULL },
+  { 0x9e74d1b791e07e48ULL, 0x775ea264cf55347eULL },
+  { 0xc612062576589ddaULL, 0x95364afe032a819eULL },
+  { 0xf79687aed3eec551ULL, 0x3a83ddbd83f52205ULL },
+  { 0x9abe14cd44753b52ULL, 0xc4926a9672793543ULL },
+  { 0xc16d9a0095928a27ULL, 0x75b7053c0f178294ULL },
+  { 0xf1c90080baf72cb1ULL, 0x5324c68b12dd6339ULL },
+  { 0x971da05074da7beeULL, 0xd3f6fc16ebca5e04ULL },
+  { 0xbce5086492111aeaULL, 0x88f4bb1ca6bcf585ULL },
+  { 0xec1e4a7db69561a5ULL, 0x2b31e9e3d06c32e6ULL },
+  { 0x9392ee8e921d5d07ULL, 0x3aff322e62439fd0ULL },
+  { 0xb877aa3236a4b449ULL, 0x09befeb9fad487c3ULL },
+  { 0xe69594bec44de15bULL, 0x4c2ebe687989a9b4ULL },
+  { 0x901d7cf73ab0acd9ULL, 0x0f9d37014bf60a11ULL },
+  { 0xb424dc35095cd80fULL, 0x538484c19ef38c95ULL },
+  { 0xe12e13424bb40e13ULL, 0x2865a5f206b06fbaULL },
+  { 0x8cbccc096f5088cbULL, 0xf93f87b7442e45d4ULL },
+  { 0xafebff0bcb24aafeULL, 0xf78f69a51539d749ULL },
+  { 0xdbe6fecebdedd5beULL, 0xb573440e5a884d1cULL },
+  { 0x89705f4136b4a597ULL, 0x31680a88f8953031ULL },
+  { 0xabcc77118461cefcULL, 0xfdc20d2b36ba7c3eULL },
+  { 0xd6bf94d5e57a42bcULL, 0x3d32907604691b4dULL },
+  { 0x8637bd05af6c69b5ULL, 0xa63f9a49c2c1b110ULL },
+  { 0xa7c5ac471b478423ULL, 0x0fcf80dc33721d54ULL },
+  { 0xd1b71758e219652bULL, 0xd3c36113404ea4a9ULL },
+  { 0x83126e978d4fdf3bULL, 0x645a1cac083126eaULL },
+  { 0xa3d70a3d70a3d70aULL, 0x3d70a3d70a3d70a4ULL },
+  { 0xccccccccccccccccULL, 0xcccccccccccccccdULL },
+  { 0x8000000000000000ULL, 0x0000000000000000ULL },
+  { 0xa000000000000000ULL, 0x0000000000000000ULL },
+  { 0xc800000000000000ULL, 0x0000000000000000ULL },
+  { 0xfa00000000000000ULL, 0x0000000000000000ULL },
+  { 0x9c40000000000000ULL, 0x0000000000000000ULL },
+  { 0xc350000000000000ULL, 0x0000000000000000ULL },
+  { 0xf424000000000000ULL, 0x0000000000000000ULL },
+  { 0x9896800000000000ULL, 0x0000000000000000ULL },
+  { 0xbebc200000000000ULL, 0x0000000000000000ULL },
+  { 0xee6b280000000000ULL, 0x0000000000000000ULL },
+  { 0x9502f90000000000ULL, 0x0000000000000000ULL },
+  { 0xba43b74000000000ULL, 0x0000000000000000ULL },
+  { 0xe8d4a51000000000ULL, 0x0000000000000000ULL },
+  { 0x9184e72a00000000ULL, 0x0000000000000000ULL },
+  { 0xb5e620f480000000ULL, 0x0000000000000000ULL },
+  { 0xe35fa931a0000000ULL, 0x0000000000000000ULL },
+  { 0x8e1bc9bf04000000ULL, 0x0000000000000000ULL },
+  { 0xb1a2bc2ec5000000ULL, 0x0000000000000000ULL },
+  { 0xde0b6b3a76400000ULL, 0x0000000000000000ULL },
+  { 0x8ac7230489e80000ULL, 0x0000000000000000ULL },
+  { 0xad78ebc5ac620000ULL, 0x0000000000000000ULL },
+  { 0xd8d726b7177a8000ULL, 0x0000000000000000ULL },
+  { 0x878678326eac9000ULL, 0x0000000000000000ULL },
+  { 0xa968163f0a57b400ULL, 0x0000000000000000ULL },
+  { 0xd3c21bcecceda100ULL, 0x0000000000000000ULL },
+  { 0x84595161401484a0ULL, 0x0000000000000000ULL },
+  { 0xa56fa5b99019a5c8ULL, 0x0000000000000000ULL },
+  { 0xcecb8f27f4200f3aULL, 0x0000000000000000ULL },
+  { 0x813f3978f8940984ULL, 0x4000000000000000ULL },
+  { 0xa18f07d736b90be5ULL, 0x5000000000000000ULL },
+  { 0xc9f2c9cd04674edeULL, 0xa400000000000000ULL },
+  { 0xfc6f7c4045812296ULL, 0x4d00000000000000ULL },
+  { 0x9dc5ada82b70b59dULL, 0xf020000000000000ULL },
+  { 0xc5371912364ce305ULL, 0x6c28000000000000ULL },
+  { 0xf684df56c3e01bc6ULL, 0xc732000000000000ULL },
+  { 0x9a130b963a6c115cULL, 0x3c7f400000000000ULL },
+  { 0xc097ce7bc90715b3ULL, 0x4b9f100000000000ULL },
+  { 0xf0bdc21abb48db20ULL, 0x1e86d40000000000ULL },
+  { 0x96769950b50d88f4ULL, 0x1314448000000000ULL },
+  { 0xbc143fa4e250eb31ULL, 0x17d955a000000000ULL },
+  { 0xeb194f8e1ae525fdULL, 0x5dcfab0800000000ULL },
+  { 0x92efd1b8d0cf37beULL, 0x5aa1cae500000000ULL },
+  { 0xb7abc627050305adULL, 0xf14a3d9e40000000ULL },
+  { 0xe596b7b0c643c719ULL, 0x6d9ccd05d0000000ULL },
+  { 0x8f7e32ce7bea5c6fULL, 0xe4820023a2000000ULL },
+  { 0xb35dbf821ae4f38bULL, 0xdda2802c8a800000ULL },
+  { 0xe0352f62a19e306eULL, 0xd50b2037ad200000ULL },
+  { 0x8c213d9da502de45ULL, 0x4526f422cc340000ULL },
+  { 0xaf298d050e4395d6ULL, 0x9670b12b7f410000ULL },
+  { 0xdaf3f04651d47b4cULL, 0x3c0cdd765f114000ULL },
+  { 0x88d8762bf324cd0fULL, 0xa5880a69fb6ac800ULL },
+  { 0xab0e93b6efee0053ULL, 0x8eea0d047a457a00ULL },
+  { 0xd5d238a4abe98068ULL, 0x72a4904598d6d880ULL },
+  { 0x85a36366eb71f041ULL, 0x47a6da2b7f864750ULL },
+  { 0xa70c3c40a64e6c51ULL, 0x999090b65f67d924ULL },
+  { 0xd0cf4b50cfe20765ULL, 0xfff4b4e3f741cf6dULL },
+  { 0x82818f1281ed449fULL, 0xbff8f10e7a8921a4ULL },
+  { 0xa321f2d7226895c7ULL, 0xaff72d52192b6a0dULL },
+  { 0xcbea6f8ceb02bb39ULL, 0x9bf4f8a69f764490ULL },
+  { 0xfee50b7025c36a08ULL, 0x02f236d04753d5b4ULL },
+  { 0x9f4f2726179a2245ULL, 0x01d762422c946590ULL },
+  { 0xc722f0ef9d80aad6ULL, 0x424d3ad2b7b97ef5ULL },
+  { 0xf8ebad2b84e0d58bULL, 0xd2e0898765a7deb2ULL },
+  { 0x9b934c3b330c8577ULL, 0x63cc55f49f88eb2fULL },
+  { 0xc2781f49ffcfa6d5ULL, 0x3cbf6b71c76b25fbULL },
+  { 0xf316271c7fc3908aULL, 0x8bef464e3945ef7aULL },
+  { 0x97edd871cfda3a56ULL, 0x97758bf0e3cbb5acULL },
+  { 0xbde94e8e43d0c8ecULL, 0x3d52eeed1cbea317ULL },
+  { 0xed63a231d4c4fb27ULL, 0x4ca7aaa863ee4bddULL },
+  { 0x945e455f24fb1cf8ULL, 0x8fe8caa93e74ef6aULL },
+  { 0xb975d6b6ee39e436ULL, 0xb3e2fd538e122b44ULL },
+  { 0xe7d34c64a9c85d44ULL, 0x60dbbca87196b616ULL },
+  { 0x90e40fbeea1d3a4aULL, 0xbc8955e946fe31cdULL },
+  { 0xb51d13aea4a488ddULL, 0x6babab6398bdbe41ULL },
+  { 0xe264589a4dcdab14ULL, 0xc696963c7eed2dd1ULL },
+  { 0x8d7eb76070a08aecULL, 0xfc1e1de5cf543ca2ULL },
+  { 0xb0de65388cc8ada8ULL, 0x3b25a55f43294bcbULL },
+  { 0xdd15fe86affad912ULL, 0x49ef0eb713f39ebeULL },
+  { 0x8a2dbf142dfcc7abULL, 0x6e3569326c784337ULL },
+  { 0xacb92ed9397bf996ULL, 0x49c2c37f07965404ULL },
+  { 0xd7e77a8f87daf7fbULL, 0xdc33745ec97be906ULL },
+  { 0x86f0ac99b4e8dafdULL, 0x69a028bb3ded71a3ULL },
+  { 0xa8acd7c0222311bcULL, 0xc40832ea0d68ce0cULL },
+  { 0xd2d80db02aabd62bULL, 0xf50a3fa490c30190ULL },
+  { 0x83c7088e1aab65dbULL, 0x792667c6da79e0faULL },
+  { 0xa4b8cab1a1563f52ULL, 0x577001b891185938ULL },
+  { 0xcde6fd5e09abcf26ULL, 0xed4c0226b55e6f86ULL },
+  { 0x80b05e5ac60b6178ULL, 0x544f8158315b05b4ULL },
+  { 0xa0dc75f1778e39d6ULL, 0x696361ae3db1c721ULL },
+  { 0xc913936dd571c84cULL, 0x03bc3a19cd1e38e9ULL },
+  { 0xfb5878494ace3a5fULL, 0x04ab48a04065c723ULL },
+  { 0x9d174b2dcec0e47bULL, 0x62eb0d64283f9c76ULL },
+  { 0xc45d1df942711d9aULL, 0x3ba5d0bd324f8394ULL },
+  { 0xf5746577930d6500ULL, 0xca8f44ec7ee36479ULL },
+  { 0x9968bf6abbe85f20ULL, 0x7e998b13cf4e1ecbULL },
+  { 0xbfc2ef456ae276e8ULL, 0x9e3fedd8c321a67eULL },
+  { 0xefb3ab16c59b14a2ULL, 0xc5cfe94ef3ea101eULL },
+  { 0x95d04aee3b80ece5ULL, 0xbba1f1d158724a12ULL },
+  { 0xbb445da9ca61281fULL, 0x2a8a6e45ae8edc97ULL },
+  { 0xea1575143cf97226ULL, 0xf52d09d71a3293bdULL },
+  { 0x924d692ca61be758ULL, 0x593c2626705f9c56ULL },
+  { 0xb6e0c377cfa2e12eULL, 0x6f8b2fb00c77836cULL },
+  { 0xe498f455c38b997aULL, 0x0b6dfb9c0f956447ULL },
+  { 0x8edf98b59a373fecULL, 0x4724bd4189bd5eacULL },
+  { 0xb2977ee300c50fe7ULL, 0x58edec91ec2cb657ULL },
+  { 0xdf3d5e9bc0f653e1ULL, 0x2f2967b66737e3edULL },
+  { 0x8b865b215899f46cULL, 0xbd79e0d20082ee74ULL },
+  { 0xae67f1e9aec07187ULL, 0xecd8590680a3aa11ULL },
+  { 0xda01ee641a708de9ULL, 0xe80e6f4820cc9495ULL },
+  { 0x884134fe908658b2ULL, 0x3109058d147fdcddULL },
+  { 0xaa51823e34a7eedeULL, 0xbd4b46f0599fd415ULL },
+  { 0xd4e5e2cdc1d1ea96ULL, 0x6c9e18ac7007c91aULL },
+  { 0x850fadc09923329eULL, 0x03e2cf6bc604ddb0ULL },
+  { 0xa6539930bf6bff45ULL, 0x84db8346b786151cULL },
+  { 0xcfe87f7cef46ff16ULL, 0xe612641865679a63ULL },
+  { 0x81f14fae158c5f6eULL, 0x4fcb7e8f3f60c07eULL },
+  { 0xa26da3999aef7749ULL, 0xe3be5e330f38f09dULL },
+  { 0xcb090c8001ab551cULL, 0x5cadf5bfd3072cc5ULL },
+  { 0xfdcb4fa002162a63ULL, 0x73d9732fc7c8f7f6ULL },
+  { 0x9e9f11c4014dda7eULL, 0x2867e7fddcdd9afaULL },
+  { 0xc646d63501a1511dULL, 0xb281e1fd541501b8ULL },
+  { 0xf7d88bc24209a565ULL, 0x1f225a7ca91a4226ULL },
+  { 0x9ae757596946075fULL, 0x3375788de9b06958ULL },
+  { 0xc1a12d2fc3978937ULL, 0x0052d6b1641c83aeULL },
+  { 0xf209787bb47d6b84ULL, 0xc0678c5dbd23a49aULL },
+  { 0x9745eb4d50ce6332ULL, 0xf840b7ba963646e0ULL },
+  { 0xbd176620a501fbffULL, 0xb650e5a93bc3d898ULL },
+  { 0xec5d3fa8ce427affULL, 0xa3e51f138ab4cebeULL },
+  { 0x93ba47c980e98cdfULL, 0xc66f336c36b10137ULL },
+  { 0xb8a8d9bbe123f017ULL, 0xb80b0047445d4184ULL },
+  { 0xe6d3102ad96cec1dULL, 0xa60dc059157491e5ULL },
+  { 0x9043ea1ac7e41392ULL, 0x87c89837ad68db2fULL },
+  { 0xb454e4a179dd1877ULL, 0x29babe4598c311fbULL },
+  { 0xe16a1dc9d8545e94ULL, 0xf4296dd6fef3d67aULL },
+  { 0x8ce2529e2734bb1dULL, 0x1899e4a65f58660cULL },
+  { 0xb01ae745b101e9e4ULL, 0x5ec05dcff72e7f8fULL },
+  { 0xdc21a1171d42645dULL, 0x76707543f4fa1f73ULL },
+  { 0x899504ae72497ebaULL, 0x6a06494a791c53a8ULL },
+  { 0xabfa45da0edbde69ULL, 0x0487db9d17636892ULL },
+  { 0xd6f8d7509292d603ULL, 0x45a9d2845d3c42b6ULL },
+  { 0x865b86925b9bc5c2ULL, 0x0b8a2392ba45a9b2ULL },
+  { 0xa7f26836f282b732ULL, 0x8e6cac7768d7141eULL },
+  { 0xd1ef0244af2364ffULL, 0x3207d795430cd926ULL },
+  { 0x8335616aed761f1fULL, 0x7f44e6bd49e807b8ULL },
+  { 0xa402b9c5a8d3a6e7ULL, 0x5f16206c9c6209a6ULL },
+  { 0xcd036837130890a1ULL, 0x36dba887c37a8c0fULL },
+  { 0x802221226be55a64ULL, 0xc2494954da2c9789ULL },
+  { 0xa02aa96b06deb0fdULL, 0xf2db9baa10b7bd6cULL },
+  { 0xc83553c5c8965d3dULL, 0x6f92829494e5acc7ULL },
+  { 0xfa42a8b73abbf48cULL, 0xcb772339ba1f17f9ULL },
+  { 0x9c69a97284b578d7ULL, 0xff2a760414536efbULL },
+  { 0xc38413cf25e2d70dULL, 0xfef5138519684abaULL },
+  { 0xf46518c2ef5b8cd1ULL, 0x7eb258665fc25d69ULL },
+  { 0x98bf2f79d5993802ULL, 0xef2f773ffbd97a61ULL },
+  { 0xbeeefb584aff8603ULL, 0xaafb550ffacfd8faULL },
+  { 0xeeaaba2e5dbf6784ULL, 0x95ba2a53f983cf38ULL },
+  { 0x952ab45cfa97a0b2ULL, 0xdd945a747bf26183ULL },
+  { 0xba756174393d88dfULL, 0x94f971119aeef9e4ULL },
+  { 0xe912b9d1478ceb17ULL, 0x7a37cd5601aab85dULL },
+  { 0x91abb422ccb812eeULL, 0xac62e055c10ab33aULL },
+  { 0xb616a12b7fe617aaULL, 0x577b986b314d6009ULL },
+  { 0xe39c49765fdf9d94ULL, 0xed5a7e85fda0b80bULL },
+  { 0x8e41ade9fbebc27dULL, 0x14588f13be847307ULL },
+  { 0xb1d219647ae6b31cULL, 0x596eb2d8ae258fc8ULL },
+  { 0xde469fbd99a05fe3ULL, 0x6fca5f8ed9aef3bbULL },
+  { 0x8aec23d680043beeULL, 0x25de7bb9480d5854ULL },
+  { 0xada72ccc20054ae9ULL, 0xaf561aa79a10ae6aULL },
+  { 0xd910f7ff28069da4ULL, 0x1b2ba1518094da04ULL },
+  { 0x87aa9aff79042286ULL, 0x90fb44d2f05d0842ULL },
+  { 0xa99541bf57452b28ULL, 0x353a1607ac744a53ULL },
+  { 0xd3fa922f2d1675f2ULL, 0x42889b8997915ce8ULL },
+  { 0x847c9b5d7c2e09b7ULL, 0x69956135febada11ULL },
+  { 0xa59bc234db398c25ULL, 0x43fab9837e699095ULL },
+  { 0xcf02b2c21207ef2eULL, 0x94f967e45e03f4bbULL },
+  { 0x8161afb94b44f57dULL, 0x1d1be0eebac278f5ULL },
+  { 0xa1ba1ba79e1632dcULL, 0x6462d92a69731732ULL },
+  { 0xca28a291859bbf93ULL, 0x7d7b8f7503cfdcfeULL },
+  { 0xfcb2cb35e702af78ULL, 0x5cda735244c3d43eULL },
+  { 0x9defbf01b061adabULL, 0x3a0888136afa64a7ULL },
+  { 0xc56baec21c7a1916ULL, 0x088aaa1845b8fdd0ULL },
+  { 0xf6c69a72a3989f5bULL, 0x8aad549e57273d45ULL },
+  { 0x9a3c2087a63f6399ULL, 0x36ac54e2f678864bULL },
+  { 0xc0cb28a98fcf3c7fULL, 0x84576a1bb416a7ddULL },
+  { 0xf0fdf2d3f3c30b9fULL, 0x656d44a2a11c51d5ULL },
+  { 0x969eb7c47859e743ULL, 0x9f644ae5a4b1b325ULL },
+  { 0xbc4665b596706114ULL, 0x873d5d9f0dde1feeULL },
+  { 0xeb57ff22fc0c7959ULL, 0xa90cb506d155a7eaULL },
+  { 0x9316ff75dd87cbd8ULL, 0x09a7f12442d588f2ULL },
+  { 0xb7dcbf5354e9beceULL, 0x0c11ed6d538aeb2fULL },
+  { 0xe5d3ef282a242e81ULL, 0x8f1668c8a86da5faULL },
+  { 0x8fa475791a569d10ULL, 0xf96e017d694487bcULL },
+  { 0xb38d92d760ec4455ULL, 0x37c981dcc395a9acULL },
+  { 0xe070f78d3927556aULL, 0x85bbe253f47b1417ULL },
+  { 0x8c469ab843b89562ULL, 0x93956d7478ccec8eULL },
+  { 0xaf58416654a6babbULL, 0x387ac8d1970027b2ULL },
+  { 0xdb2e51bfe9d0696aULL, 0x06997b05fcc0319eULL },
+  { 0x88fcf317f22241e2ULL, 0x441fece3bdf81f03ULL },
+  { 0xab3c2fddeeaad25aULL, 0xd527e81cad7626c3ULL },
+  { 0xd60b3bd56a5586f1ULL, 0x8a71e223d8d3b074ULL },
+  { 0x85c7056562757456ULL, 0xf6872d5667844e49ULL },
+  { 0xa738c6bebb12d16cULL, 0xb428f8ac016561dbULL },
+  { 0xd106f86e69d785c7ULL, 0xe13336d701beba52ULL },
+  { 0x82a45b450226b39cULL, 0xecc0024661173473ULL },
+  { 0xa34d721642b06084ULL, 0x27f002d7f95d0190ULL },
+  { 0xcc20ce9bd35c78a5ULL, 0x31ec038df7b441f4ULL },
+  { 0xff290242c83396ceULL, 0x7e67047175a15271ULL },
+  { 0x9f79a169bd203e41ULL, 0x0f0062c6e984d386ULL },
+  { 0xc75809c42c684dd1ULL, 0x52c07b78a3e60868ULL },
+  { 0xf92e0c3537826145ULL, 0xa7709a56ccdf8a82ULL },
+  { 0x9bbcc7a142b17ccbULL, 0x88a66076400bb691ULL },
+  { 0xc2abf989935ddbfeULL, 0x6acff893d00ea435ULL },
+  { 0xf356f7ebf83552feULL, 0x0583f6b8c4124d43ULL },
+  { 0x98165af37b2153deULL, 0xc3727a337a8b704aULL },
+  { 0xbe1bf1b059e9a8d6ULL, 0x744f18c0592e4c5cULL },
+  { 0xeda2ee1c7064130cULL, 0x1162def06f79df73ULL },
+  { 0x9485d4d1c63e8be7ULL, 0x8addcb5645ac2ba8ULL },
+  { 0xb9a74a0637ce2ee1ULL, 0x6d953e2bd7173692ULL },
+  { 0xe8111c87c5c1ba99ULL, 0xc8fa8db6ccdd0437ULL },
+  { 0x910ab1d4db9914a0ULL, 0x1d9c9892400a22a2ULL },
+  { 0xb54d5e4a127f59c8ULL, 0x2503beb6d00cab4bULL },
+  { 0xe2a0b5dc971f303aULL, 0x2e44ae64840fd61dULL },
+  { 0x8da471a9de737e24ULL, 0x5ceaecfed289e5d2ULL },
+  { 0xb10d8e1456105dadULL, 0x7425a83e872c5f47ULL },
+  { 0xdd50f1996b947518ULL, 0xd12f124e28f77719ULL },
+  { 0x8a5296ffe33cc92fULL, 0x82bd6b70d99aaa6fULL },
+  { 0xace73cbfdc0bfb7bULL, 0x636cc64d1001550bULL },
+  { 0xd8210befd30efa5aULL, 0x3c47f7e05401aa4eULL },
+  { 0x8714a775e3e95c78ULL, 0x65acfaec34810a71ULL },
+  { 0xa8d9d1535ce3b396ULL, 0x7f1839a741a14d0dULL },
+  { 0xd31045a8341ca07cULL, 0x1ede48111209a050ULL },
+  { 0x83ea2b892091e44dULL, 0x934aed0aab460432ULL },
+  { 0xa4e4b66b68b65d60ULL, 0xf81da84d5617853fULL },
+  { 0xce1de40642e3f4b9ULL, 0x36251260ab9d668eULL },
+  { 0x80d2ae83e9ce78f3ULL, 0xc1d72b7c6b426019ULL },
+  { 0xa1075a24e4421730ULL, 0xb24cf65b8612f81fULL },
+  { 0xc94930ae1d529cfcULL, 0xdee033f26797b627ULL },
+  { 0xfb9b7cd9a4a7443cULL, 0x169840ef017da3b1ULL },
+  { 0x9d412e0806e88aa5ULL, 0x8e1f289560ee864eULL },
+  { 0xc491798a08a2ad4eULL, 0xf1a6f2bab92a27e2ULL },
+  { 0xf5b5d7ec8acb58a2ULL, 0xae10af696774b1dbULL },
+  { 0x9991a6f3d6bf1765ULL, 0xacca6da1e0a8ef29ULL },
+  { 0xbff610b0cc6edd3fULL, 0x17fd090a58d32af3ULL },
+  { 0xeff394dcff8a948eULL, 0xddfc4b4cef07f5b0ULL },
+  { 0x95f83d0a1fb69cd9ULL, 0x4abdaf101564f98eULL },
+  { 0xbb764c4ca7a4440fULL, 0x9d6d1ad41abe37f1ULL },
+  { 0xea53df5fd18d5513ULL, 0x84c86189216dc5edULL },
+  { 0x92746b9be2f8552cULL, 0x32fd3cf5b4e49bb4ULL },
+  { 0xb7118682dbb66a77ULL, 0x3fbc8c33221dc2a1ULL },
+  { 0xe4d5e82392a40515ULL, 0x0fabaf3feaa5334aULL },
+  { 0x8f05b1163ba6832dULL, 0x29cb4d87f2a7400eULL },
+  { 0xb2c71d5bca9023f8ULL, 0x743e20e9ef511012ULL },
+  { 0xdf78e4b2bd342cf6ULL, 0x914da9246b255416ULL },
+  { 0x8bab8eefb6409c1aULL, 0x1ad089b6c2f7548eULL },
+  { 0xae9672aba3d0c320ULL, 0xa184ac2473b529b1ULL },
+  { 0xda3c0f568cc4f3e8ULL, 0xc9e5d72d90a2741eULL },
+  { 0x8865899617fb1871ULL, 0x7e2fa67c7a658892ULL },
+  { 0xaa7eebfb9df9de8dULL, 0xddbb901b98feeab7ULL },
+  { 0xd51ea6fa85785631ULL, 0x552a74227f3ea565ULL },
+  { 0x8533285c936b35deULL, 0xd53a88958f87275fULL },
+  { 0xa67ff273b8460356ULL, 0x8a892abaf368f137ULL },
+  { 0xd01fef10a657842cULL, 0x2d2b7569b0432d85ULL },
+  { 0x8213f56a67f6b29bULL, 0x9c3b29620e29fc73ULL },
+  { 0xa298f2c501f45f42ULL, 0x8349f3ba91b47b8fULL },
+  { 0xcb3f2f7642717713ULL, 0x241c70a936219a73ULL },
+  { 0xfe0efb53d30dd4d7ULL, 0xed238cd383aa0110ULL },
+  { 0x9ec95d1463e8a506ULL, 0xf4363804324a40aaULL },
+  { 0xc67bb4597ce2ce48ULL, 0xb143c6053edcd0d5ULL },
+  { 0xf81aa16fdc1b81daULL, 0xdd94b7868e94050aULL },
+  { 0x9b10a4e5e9913128ULL, 0xca7cf2b4191c8326ULL },
+  { 0xc1d4ce1f63f57d72ULL, 0xfd1c2f611f63a3f0ULL },
+  { 0xf24a01a73cf2dccfULL, 0xbc633b39673c8cecULL },
+  { 0x976e41088617ca01ULL, 0xd5be0503e085d813ULL },
+  { 0xbd49d14aa79dbc82ULL, 0x4b2d8644d8a74e18ULL },
+  { 0xec9c459d51852ba2ULL, 0xddf8e7d60ed1219eULL },
+  { 0x93e1ab8252f33b45ULL, 0xcabb90e5c942b503ULL },
+  { 0xb8da1662e7b00a17ULL, 0x3d6a751f3b936243ULL },
+  { 0xe7109bfba19c0c9dULL, 0x0cc512670a783ad4ULL },
+  { 0x906a617d450187e2ULL, 0x27fb2b80668b24c5ULL },
+  { 0xb484f9dc9641e9daULL, 0xb1f9f660802dedf6ULL },
+  { 0xe1a63853bbd26451ULL, 0x5e7873f8a0396973ULL },
+  { 0x8d07e33455637eb2ULL, 0xdb0b487b6423e1e8ULL },
+  { 0xb049dc016abc5e5fULL, 0x91ce1a9a3d2cda62ULL },
+  { 0xdc5c5301c56b75f7ULL, 0x7641a140cc7810fbULL },
+  { 0x89b9b3e11b6329baULL, 0xa9e904c87fcb0a9dULL },
+  { 0xac2820d9623bf429ULL, 0x546345fa9fbdcd44ULL },
+  { 0xd732290fbacaf133ULL, 0xa97c177947ad4095ULL },
+  { 0x867f59a9d4bed6c0ULL, 0x49ed8eabcccc485dULL },
+  { 0xa81f301449ee8c70ULL, 0x5c68f256bfff5a74ULL },
+  { 0xd226fc195c6a2f8cULL, 0x73832eec6fff3111ULL },
+  { 0x83585d8fd9c25db7ULL, 0xc831fd53c5ff7eabULL },
+  { 0xa42e74f3d032f525ULL, 0xba3e7ca8b77f5e55ULL },
+  { 0xcd3a1230c43fb26fULL, 0x28ce1bd2e55f35ebULL },
+  { 0x80444b5e7aa7cf85ULL, 0x7980d163cf5b81b3ULL },
+  { 0xa0555e361951c366ULL, 0xd7e105bcc332621fULL },
+  { 0xc86ab5c39fa63440ULL, 0x8dd9472bf3fefaa7ULL },
+  { 0xfa856334878fc150ULL, 0xb14f98f6f0feb951ULL },
+  { 0x9c935e00d4b9d8d2ULL, 0x6ed1bf9a569f33d3ULL },
+  { 0xc3b8358109e84f07ULL, 0x0a862f80ec4700c8ULL },
+  { 0xf4a642e14c6262c8ULL, 0xcd27bb612758c0faULL },
+  { 0x98e7e9cccfbd7dbdULL, 0x8038d51cb897789cULL },
+  { 0xbf21e44003acdd2cULL, 0xe0470a63e6bd56c3ULL },
+  { 0xeeea5d5004981478ULL, 0x1858ccfce06cac74ULL },
+  { 0x95527a5202df0ccbULL, 0x0f37801e0c43ebc8ULL },
+  { 0xbaa718e68396cffdULL, 0xd30560258f54e6baULL },
+  { 0xe950df20247c83fdULL, 0x47c6b82ef32a2069ULL },
+  { 0x91d28b7416cdd27eULL, 0x4cdc331d57fa5441ULL },
+  { 0xb6472e511c81471dULL, 0xe0133fe4adf8e952ULL },
+  { 0xe3d8f9e563a198e5ULL, 0x58180fddd97723a6ULL },
+  { 0x8e679c2f5e44ff8fULL, 0x570f09eaa7ea7648ULL },
+};
+
+/**
+ * Compute the IEEE 754 binary64 bits of w * 10^q, with round to
+ * nearest, ties to even, using the Eisel-Lemire algorithm (Daniel
+ * Lemire, "Number Parsing at a Gigabyte per Second", 2021).
+ *
+ * The result is correctly rounded for every exact w; the sign bit is
+ * not set.
+ */
+static uint64_t
+jiffy_number_eisel_lemire(
+  uint64_t w,
+  const int64_t q
+) {
+  if (!w || q < POW5_MIN) {
+    // zero
+    return 0;
+  } else if (q > POW5_MAX) {
+    // infinity
+    return (uint64_t) 0x7FF << 52;
+  }
+
+  // normalize w
+  const size_t lz = clz64(w);
+  w <<= lz;
+
+  // multiply by the high half of the power of five, and then by the
+  // low half if the result might be off by one in the bits we keep
+  const uint64_t * const pow5 = POW5[q - POW5_MIN];
+  jiffy_u128_t r = mul128(w, pow5[0]);
+  if ((r.hi & 0x1FF) == 0x1FF) {
+    const jiffy_u128_t lo = mul128(w, pow5[1]);
+    r.lo += lo.hi;
+    r.hi += (r.lo < lo.hi);
+  }
+
+  const int upper_bit = r.hi >> 63;
+  const int shift = upper_bit + 64 - 52 - 3;
+  uint64_t man = r.hi >> shift;
+
+  // floor(log2(10^q)) + 63, plus the exponent bias; note: relies on
+  // arithmetic right shift of negative values
+  int64_t exp2 = ((((152170 + 65536) * q) >> 16) + 63) + upper_bit - (int64_t) lz + 1023;
+
+  if (exp2 <= 0) {
+    // subnormal
+    if (-exp2 + 1 >= 64) {
+      return 0;
+    }
+
+    man >>= -exp2 + 1;
+    man += (man & 1);
+    man >>= 1;
+
+    // rounding may have produced the smallest normal number
+    exp2 = (man < ((uint64_t) 1 << 52)) ? 0 : 1;
+    return ((uint64_t) exp2 << 52) | (man & (((uint64_t) 1 << 52) - 1));
+  }
+
+  // exactly halfway between two doubles: round to even
+  if (r.lo <= 1 && q >= -4 && q <= 23 && (man & 3) == 1) {
+    if ((man << shift) == r.hi) {
+      man &= ~(uint64_t) 1;
+    }
+  }
+
+  // round to nearest
+  man += (man & 1);
+  man >>= 1;
+  if (man >= ((uint64_t) 2 << 52)) {
+    man = (uint64_t) 1 << 52;
+    exp2++;
+  }
+
+  if (exp2 >= 0x7FF) {
+    // infinity
+    return (uint64_t) 0x7FF << 52;
+  }
+
+  return ((uint64_t) exp2 << 52) | (man & (((uint64_t) 1 << 52) - 1));
+}
+
+/**
+ * Exact powers of ten which are representable as doubles.  Used by the
+ * fast path in jiffy_number_to_double().
+ */
+static const double
+POW10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+};
+
+/**
+ * Number of 32-bit limbs in a jiffy_bigint_t.  Large enough for the
+ * comparison in jiffy_number_round_slow(): 19 + 784 significant
+ * digits, or 2^54 scaled by 5^1126 and 2^51, both fit in under 2800
+ * bits.
+ */
+#define BIGINT_LIMBS 96
+
+/**
+ * Fixed-size unsigned big integer, least significant limb first.
+ */
+typedef struct {
+  uint32_t limbs[BIGINT_LIMBS];
+  size_t len;
+} jiffy_bigint_t;
+
+/**
+ * Set big integer to a 64-bit value.
+ */
+static void
+jiffy_bigint_set(
+  jiffy_bigint_t * const a,
+  const uint64_t val
+) {
+  a->limbs[0] = (uint32_t) val;
+  a->limbs[1] = (uint32_t) (val >> 32);
+  a->len = a->limbs[1] ? 2 : (a->limbs[0] ? 1 : 0);
+}
+
+/**
+ * Set a to a * mul + add.
+ */
+static void
+jiffy_bigint_mul_add(
+  jiffy_bigint_t * const a,
+  const uint32_t mul,
+  const uint32_t add
+) {
+  uint64_t carry = add;
+
+  for (size_t i = 0; i < a->len; i++) {
+    const uint64_t r = (uint64_t) a->limbs[i] * mul + carry;
+    a->limbs[i] = (uint32_t) r;
+    carry = r >> 32;
+  }
+
+  if (carry && a->len < BIGINT_LIMBS) {
+    a->limbs[a->len++] = (uint32_t) carry;
+  }
+}
+
+/**
+ * Set a to a * 5^e.
+ */
+static void
+jiffy_bigint_mul_pow5(
+  jiffy_bigint_t * const a,
+  size_t e
+) {
+  // 5^13 is the largest power of five which fits in 32 bits
+  for (; e >= 13; e -= 13) {
+    jiffy_bigint_mul_add(a, 1220703125, 0);
+  }
+
+  uint32_t mul = 1;
+  for (; e > 0; e--) {
+    mul *= 5;
+  }
+
+  jiffy_bigint_mul_add(a, mul, 0);
+}
+
+/**
+ * Set a to a * 2^e.
+ */
+static void
+jiffy_bigint_shl(
+  jiffy_bigint_t * const a,
+  const size_t e
+) {
+  const size_t limbs = e / 32, bits = e % 32;
+
+  if (!a->len || a->len + limbs + 1 > BIGINT_LIMBS) {
+    return;
+  }
+
+  a->limbs[a->len] = 0;
+  for (size_t i = a->len + 1; i > 0; i--) {
+    const uint32_t hi = a->limbs[i - 1],
+                   lo = (i > 1) ? a->limbs[i - 2] : 0;
+    a->limbs[i - 1 + limbs] = bits ? ((hi << bits) | (lo >> (32 - bits))) : hi;
+  }
+
+  memset(a->limbs, 0, limbs * sizeof(uint32_t));
+  a->len += limbs + 1;
+  while (a->len && !a->limbs[a->len - 1]) {
+    a->len--;
+  }
+}
+
+/**
+ * Compare big integers.  Returns a negative value, zero, or a positive
+ * value if a is less than, equal to, or greater than b.
+ */
+static int
+jiffy_bigint_cmp(
+  const jiffy_bigint_t * const a,
+  const jiffy_bigint_t * const b
+) {
+  if (a->len != b->len) {
+    return (a->len < b->len) ? -1 : 1;
+  }
+
+  for (size_t i = a->len; i > 0; i--) {
+    if (a->limbs[i - 1] != b->limbs[i - 1]) {
+      return (a->limbs[i - 1] < b->limbs[i - 1]) ? -1 : 1;
+    }
+  }
+
+  return 0;
+}
+
+/**
+ * Significant digits of a number which did not fit in the 64-bit
+ * significand.
+ */
+typedef struct {
+  // digits, packed two per byte, low nibble first
+  const uint8_t *ptr;
+
+  // number of digits
+  size_t len;
+
+  // was a non-zero digit dropped after these?
+  bool tail;
+} jiffy_number_digits_t;
+
+/**
+ * Round the number w.D * 10^q, where D is the given digits, given that
+ * it rounds to either the double with the given bits or the next one
+ * up.
+ *
+ * Compares the number with the halfway point between the two doubles
+ * using big integers (see the digit comparison in fast_float).
+ */
+static uint64_t
+jiffy_number_round_slow(
+  const uint64_t w,
+  const int64_t q,
+  const jiffy_number_digits_t * const digits,
+  const uint64_t bits
+) {
+  if ((bits >> 52) >= 0x7FF) {
+    // infinity
+    return bits;
+  }
+
+  // significand and exponent of the halfway point, h * 2^f
+  const uint64_t exp2 = bits >> 52,
+                 man = (bits & (((uint64_t) 1 << 52) - 1)) | (exp2 ? ((uint64_t) 1 << 52) : 0);
+  const int64_t f = (exp2 ? (int64_t) exp2 : 1) - 1075 - 1;
+
+  // number: n * 10^e, where n is the digits of w followed by D
+  jiffy_bigint_t n, h;
+  jiffy_bigint_set(&n, w);
+  for (size_t i = 0; i < digits->len; i++) {
+    const uint8_t pair = digits->ptr[i / 2];
+    jiffy_bigint_mul_add(&n, 10, (i & 1) ? (pair >> 4) : (pair & 0xF));
+  }
+  const int64_t e = q - (int64_t) digits->len;
+
+  // compare n * 5^e * 2^e with h * 2^f
+  jiffy_bigint_set(&h, 2 * man + 1);
+  if (e >= 0) {
+    jiffy_bigint_mul_pow5(&n, e);
+  } else {
+    jiffy_bigint_mul_pow5(&h, -e);
+  }
+
+  if (e >= f) {
+    jiffy_bigint_shl(&n, e - f);
+  } else {
+    jiffy_bigint_shl(&h, f - e);
+  }
+
+  const int cmp = jiffy_bigint_cmp(&n, &h);
+  if (cmp > 0 || (cmp == 0 && (digits->tail || (bits & 1)))) {
+    // above halfway, or exactly halfway and the next double is even
+    return bits + 1;
+  }
+
+  return bits;
+}
+
+/**
+ * Convert w * 10^q to a double.
+ *
+ * If truncated is true, then w holds only the leading significant
+ * digits of the number and the dropped digits were not all zero.  In
+ * that case the number lies strictly between w * 10^q and (w + 1) *
+ * 10^q; if both ends round to the same double then that double is
+ * returned.  Otherwise the number is rounded with the dropped digits.
+ */
+static double
+jiffy_number_to_double(
+  const bool neg,
+  const uint64_t w,
+  const int64_t q,
+  const bool truncated,
+  const jiffy_number_digits_t * const digits
+) {
+  double r;
+
+#if FLT_EVAL_METHOD == 0
+  if (!truncated && w <= ((uint64_t) 1 << 53) && q >= -22 && q <= 22) {
+    // fast path: w and 10^|q| are exact doubles, so the product or
+    // quotient is correctly rounded
+    r = (double) w;
+    r = (q < 0) ? (r / POW10[-q]) : (r * POW10[q]);
+    return neg ? -r : r;
+  }
+#endif // FLT_EVAL_METHOD == 0
+
+  uint64_t bits = jiffy_number_eisel_lemire(w, q);
+
+  if (truncated && (w == UINT64_MAX || jiffy_number_eisel_lemire(w + 1, q) != bits)) {
+    // slow path: the dropped digits matter
+    bits = jiffy_number_round_slow(w, q, digits, bits);
+  }
+
+  if (neg) {
+    bits |= (uint64_t) 1 << 63;
+  }
+
+  memcpy(&r, &bits, sizeof(r));
+  return r;
+}
+
 // whitespace characters (/[ \t\v\r\n]/)
 #define CASE_WHITESPACE \
   case ' ': \
@@ -61,6 +1190,90 @@
   CASE_HEX_AF_LO \
   CASE_HEX_AF_HI
 
+#ifdef JIFFY_PARSER_COMPUTED_GOTO
+/**
+ * Byte class flags.  Used by the computed goto engine (see
+ * jiffy_parser_push_run()) to classify bytes with a single table
+ * lookup.
+ */
+enum jiffy_byte_classes {
+  // whitespace (/[ \t\v\r\n]/)
+  BYTE_CLASS_WHITESPACE = (1 << 0),
+
+  // ASCII digit (/[0-9]/)
+  BYTE_CLASS_DIGIT = (1 << 1),
+
+  // first byte of a literal (/[tfn]/)
+  BYTE_CLASS_LITERAL = (1 << 2),
+
+  // ends a run of plain string bytes (quote, backslash, and control
+  // characters)
+  BYTE_CLASS_STRING_STOP = (1 << 3),
+
+  // ends a run of skipped container bytes (quote and brackets)
+  BYTE_CLASS_SKIP_STOP = (1 << 4),
+};
+
+/**
+ * Byte class table, indexed by byte.
+ */
+static const uint8_t
+JIFFY_BYTE_CLASSES[256] = {
+  [0x00] = BYTE_CLASS_STRING_STOP,
+  [0x01] = BYTE_CLASS_STRING_STOP,
+  [0x02] = BYTE_CLASS_STRING_STOP,
+  [0x03] = BYTE_CLASS_STRING_STOP,
+  [0x04] = BYTE_CLASS_STRING_STOP,
+  [0x05] = BYTE_CLASS_STRING_STOP,
+  [0x06] = BYTE_CLASS_STRING_STOP,
+  [0x07] = BYTE_CLASS_STRING_STOP,
+  [0x08] = BYTE_CLASS_STRING_STOP,
+  [0x0c] = BYTE_CLASS_STRING_STOP,
+  [0x0e] = BYTE_CLASS_STRING_STOP,
+  [0x0f] = BYTE_CLASS_STRING_STOP,
+  [0x10] = BYTE_CLASS_STRING_STOP,
+  [0x11] = BYTE_CLASS_STRING_STOP,
+  [0x12] = BYTE_CLASS_STRING_STOP,
+  [0x13] = BYTE_CLASS_STRING_STOP,
+  [0x14] = BYTE_CLASS_STRING_STOP,
+  [0x15] = BYTE_CLASS_STRING_STOP,
+  [0x16] = BYTE_CLASS_STRING_STOP,
+  [0x17] = BYTE_CLASS_STRING_STOP,
+  [0x18] = BYTE_CLASS_STRING_STOP,
+  [0x19] = BYTE_CLASS_STRING_STOP,
+  [0x1a] = BYTE_CLASS_STRING_STOP,
+  [0x1b] = BYTE_CLASS_STRING_STOP,
+  [0x1c] = BYTE_CLASS_STRING_STOP,
+  [0x1d] = BYTE_CLASS_STRING_STOP,
+  [0x1e] = BYTE_CLASS_STRING_STOP,
+  [0x1f] = BYTE_CLASS_STRING_STOP,
+  ['\t'] = BYTE_CLASS_WHITESPACE | BYTE_CLASS_STRING_STOP,
+  ['\n'] = BYTE_CLASS_WHITESPACE | BYTE_CLASS_STRING_STOP,
+  ['\v'] = BYTE_CLASS_WHITESPACE | BYTE_CLASS_STRING_STOP,
+  ['\r'] = BYTE_CLASS_WHITESPACE | BYTE_CLASS_STRING_STOP,
+  [' '] = BYTE_CLASS_WHITESPACE,
+  ['"'] = BYTE_CLASS_STRING_STOP | BYTE_CLASS_SKIP_STOP,
+  ['\\'] = BYTE_CLASS_STRING_STOP,
+  ['0'] = BYTE_CLASS_DIGIT,
+  ['1'] = BYTE_CLASS_DIGIT,
+  ['2'] = BYTE_CLASS_DIGIT,
+  ['3'] = BYTE_CLASS_DIGIT,
+  ['4'] = BYTE_CLASS_DIGIT,
+  ['5'] = BYTE_CLASS_DIGIT,
+  ['6'] = BYTE_CLASS_DIGIT,
+  ['7'] = BYTE_CLASS_DIGIT,
+  ['8'] = BYTE_CLASS_DIGIT,
+  ['9'] = BYTE_CLASS_DIGIT,
+  ['t'] = BYTE_CLASS_LITERAL,
+  ['f'] = BYTE_CLASS_LITERAL,
+  ['n'] = BYTE_CLASS_LITERAL,
+  ['['] = BYTE_CLASS_SKIP_STOP,
+  [']'] = BYTE_CLASS_SKIP_STOP,
+  ['{'] = BYTE_CLASS_SKIP_STOP,
+  ['}'] = BYTE_CLASS_SKIP_STOP,
+};
+#endif // JIFFY_PARSER_COMPUTED_GOTO
+
 /**
  * Decode a hex nibble and return it's value.
  */
@@ -141,6 +1354,12 @@ jiffy_err_to_s(
   JIFFY_DEF_PARSER_STATE(AFTER_OBJECT_KEY), \
   JIFFY_DEF_PARSER_STATE(BEFORE_OBJECT_KEY), \
   JIFFY_DEF_PARSER_STATE(AFTER_OBJECT_VALUE), \
+  JIFFY_DEF_PARSER_STATE(SKIP_OBJECT_VALUE), \
+  JIFFY_DEF_PARSER_STATE(SKIP_VALUE), \
+  JIFFY_DEF_PARSER_STATE(SKIP_SCALAR), \
+  JIFFY_DEF_PARSER_STATE(SKIP_STRING), \
+  JIFFY_DEF_PARSER_STATE(SKIP_STRING_ESC), \
+  JIFFY_DEF_PARSER_STATE(SKIP_CONTAINER), \
   JIFFY_DEF_PARSER_STATE(LAST),
 
 /**
@@ -171,32 +1390,58 @@ jiffy_parser_state_to_s(
 }
 
 // get the current state
-#define GET_STATE(p) ((p)->stack_ptr[(p)->stack_pos])
+#define GET_STATE(p) ((p)->state)
 
 // set the current state
-#define SWAP(p, state) (p)->stack_ptr[(p)->stack_pos] = (state)
+#define SWAP(p, val) (p)->state = (val)
+
+// number of container bits in each state stack entry
+#define STACK_BITS (8 * sizeof(jiffy_parser_state_t))
+
+// Note: the callback macros below take the callbacks as a separate
+// parameter rather than reading them from the parser context, so that
+// parsers specialized for a constant callback structure can be defined
+// with JIFFY_PARSER_DEF_SPECIALIZED().
+
+#ifdef JIFFY_PARSER_STATS
+// add value to parser statistics field
+#define STATS_ADD(p, field, val) ((p)->stats.field += (val))
+#else
+#define STATS_ADD(p, field, val) ((void) 0)
+#endif // JIFFY_PARSER_STATS
 
 // invoke on_error callback with error code, set the state to
 // PARSER_STATE_FAIL, and then return false.
-#define FAIL(p, err) do { \
-  if ((p)->cbs && (p)->cbs->on_error) { \
-    (p)->cbs->on_error((p), err); \
+#define FAIL(p, cbs, err) do { \
+  if ((cbs) && (cbs)->on_error) { \
+    STATS_ADD((p), events.on_error, 1); \
+    (cbs)->on_error((p), err); \
   } \
   SWAP((p), PARSER_STATE_FAIL); \
   return false; \
 } while (0)
 
 // call given callback, if it is non-NULL
-#define FIRE(p, cb_name) do { \
-  if ((p)->cbs && (p)->cbs->cb_name) { \
-    (p)->cbs->cb_name(p); \
+#define FIRE(p, cbs, cb_name) do { \
+  if ((cbs) && (cbs)->cb_name) { \
+    STATS_ADD((p), events.cb_name, 1); \
+    (cbs)->cb_name(p); \
   } \
 } while (0)
 
 // call given callback with value, if it is non-NULL
-#define EMIT(p, cb_name, val) do { \
-  if ((p)->cbs && (p)->cbs->cb_name) { \
-    (p)->cbs->cb_name(p, (val)); \
+#define EMIT(p, cbs, cb_name, val) do { \
+  if ((cbs) && (cbs)->cb_name) { \
+    STATS_ADD((p), events.cb_name, 1); \
+    (cbs)->cb_name(p, (val)); \
+  } \
+} while (0)
+
+// call given callback with pointer and length, if it is non-NULL
+#define EMIT_DATA(p, cbs, cb_name, ptr, len) do { \
+  if ((cbs) && (cbs)->cb_name) { \
+    STATS_ADD((p), events.cb_name, 1); \
+    (cbs)->cb_name(p, (ptr), (len)); \
   } \
 } while (0)
 
@@ -221,23 +1466,80 @@ jiffy_parser_init(
   p->cbs = cbs;
 
   // init stack
+  p->top_len = 0;
   p->stack_ptr = stack_ptr;
   p->stack_len = stack_len;
+  p->depth = 0;
   p->stack_pos = 0;
 
+  // stack does not grow by default
+  p->stack_realloc = NULL;
+  p->stack_max = stack_len;
+  p->stack_owned = false;
+
   // init state
   SWAP(p, PARSER_STATE_INIT);
 
   // clear number of bytes read
   p->num_bytes = 0;
 
+  // clear pending span
+  p->span.ptr = NULL;
+  p->span.len = 0;
+
+  // clear tape
+  p->tape = NULL;
+
+  // clear filter
+  p->filter = NULL;
+
+  // clear flags
+  p->flags = 0;
+  p->stopped = false;
+
   // save user data pointer
   p->user_data = user_data;
 
+#ifdef JIFFY_PARSER_STATS
+  // clear statistics
+  memset(&p->stats, 0, sizeof(p->stats));
+#endif // JIFFY_PARSER_STATS
+
+  // return success
+  return true;
+}
+
+bool
+jiffy_parser_set_stack_realloc(
+  jiffy_parser_t * const p,
+  const jiffy_parser_realloc_cb_t stack_realloc,
+  const size_t stack_max
+) {
+  // check parser and maximum stack size
+  if (!p || (stack_realloc && stack_max < p->stack_len)) {
+    // return failure
+    return false;
+  }
+
+  p->stack_realloc = stack_realloc;
+  p->stack_max = stack_realloc ? stack_max : p->stack_len;
+
   // return success
   return true;
 }
 
+void
+jiffy_parser_free_stack(
+  jiffy_parser_t * const p
+) {
+  if (p->stack_owned) {
+    p->stack_realloc(p->stack_ptr, 0, p->user_data);
+    p->stack_ptr = NULL;
+    p->stack_len = 0;
+    p->stack_owned = false;
+  }
+}
+
 void *
 jiffy_parser_get_user_data(
   const jiffy_parser_t * const p
@@ -252,67 +1554,320 @@ jiffy_parser_get_num_bytes(
   return p->num_bytes;
 }
 
-/**
- * Push parser state.  Returns false on stack overflow.
- *
- * Note: this is defined as an inline function rather than a macro to
- * give the compiler more flexibility in terms of inlining.
- */
-static inline bool
-jiffy_parser_push_state(
-  jiffy_parser_t * const p,
-  const jiffy_parser_state_t state
+bool
+jiffy_parser_get_stats(
+  const jiffy_parser_t * const p,
+  jiffy_parser_stats_t * const stats
 ) {
-  if (p->stack_pos < p->stack_len - 1) {
-    p->stack_ptr[++p->stack_pos] = state;
-    return true;
-  } else {
-    FAIL(p, JIFFY_ERR_STACK_OVERFLOW);
-  }
+#ifdef JIFFY_PARSER_STATS
+  *stats = p->stats;
+  return true;
+#else
+  (void) p;
+  (void) stats;
+  return false;
+#endif // JIFFY_PARSER_STATS
 }
 
-/**
- * Pop parser state.  Returns false on stack underflow.
- *
- * Note: this is defined as an inline function rather than a macro to
- * give the compiler more flexibility in terms of inlining.
- */
-static inline bool
-jiffy_parser_pop_state(
-  jiffy_parser_t * const p
+jiffy_parser_state_t
+jiffy_parser_get_state(
+  const jiffy_parser_t * const p
 ) {
-  // check for underflow
-  if (!p->stack_pos) {
-    // got underflow, return error
-    FAIL(p, JIFFY_ERR_STACK_UNDERFLOW);
-  }
-
-  // decriment position
-  p->stack_pos--;
+  return GET_STATE(p);
+}
 
-  // check for done
-  if (!p->stack_pos && GET_STATE(p) == PARSER_STATE_INIT) {
-    SWAP(p, PARSER_STATE_DONE);
-  }
+void
+jiffy_parser_set_flags(
+  jiffy_parser_t * const p,
+  const uint32_t flags
+) {
+  p->flags = flags;
+}
 
-  // return success
-  return true;
+uint32_t
+jiffy_parser_get_flags(
+  const jiffy_parser_t * const p
+) {
+  return p->flags;
+}
+
+bool
+jiffy_parser_skip_value(
+  const jiffy_parser_t * const cp
+) {
+  // callbacks are passed a const parser, but the parser itself is never
+  // const (see jiffy_parser_init())
+  jiffy_parser_t * const p = (jiffy_parser_t *) cp;
+
+  switch (GET_STATE(p)) {
+  case PARSER_STATE_VALUE:
+    // called from on_array_element_start or on_object_value_start
+    SWAP(p, PARSER_STATE_SKIP_VALUE);
+    return true;
+  case PARSER_STATE_AFTER_OBJECT_KEY:
+    // called from on_object_key_end
+    SWAP(p, PARSER_STATE_SKIP_OBJECT_VALUE);
+    return true;
+  default:
+    return false;
+  }
+}
+
+void
+jiffy_parser_stop(
+  const jiffy_parser_t * const cp
+) {
+  // callbacks are passed a const parser (see jiffy_parser_skip_value())
+  jiffy_parser_t * const p = (jiffy_parser_t *) cp;
+  p->stopped = true;
+}
+
+bool
+jiffy_parser_is_stopped(
+  const jiffy_parser_t * const p
+) {
+  return p->stopped;
+}
+
+/**
+ * Double the size of the state stack, up to the maximum size.  Returns
+ * false if the stack is already at the maximum size or if the
+ * reallocation fails.
+ *
+ * Only called when the stack is full, so it is kept out of line.
+ */
+static bool
+jiffy_parser_grow_stack(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  if (!p->stack_realloc || p->stack_len >= p->stack_max) {
+    FAIL(p, cbs, JIFFY_ERR_STACK_OVERFLOW);
+  }
+
+  // get new size, check for overflow
+  const size_t max_len = SIZE_MAX / sizeof(jiffy_parser_state_t);
+  const size_t cap = (p->stack_max < max_len) ? p->stack_max : max_len;
+  const size_t len = (p->stack_len < cap / 2) ? (2 * p->stack_len) : cap;
+  if (len <= p->stack_len) {
+    FAIL(p, cbs, JIFFY_ERR_STACK_OVERFLOW);
+  }
+
+  // grow stack; the initial memory belongs to the caller, so it is
+  // copied instead of being passed to the callback
+  jiffy_parser_state_t * const ptr = p->stack_realloc(
+    p->stack_owned ? p->stack_ptr : NULL,
+    len * sizeof(jiffy_parser_state_t),
+    p->user_data
+  );
+  if (!ptr) {
+    FAIL(p, cbs, JIFFY_ERR_STACK_REALLOC_FAILED);
+  }
+
+  if (!p->stack_owned) {
+    memcpy(ptr, p->stack_ptr, p->stack_len * sizeof(jiffy_parser_state_t));
+  }
+
+  p->stack_ptr = ptr;
+  p->stack_len = len;
+  p->stack_owned = true;
+
+  // return success
+  return true;
+}
+
+/**
+ * Push parser state.  Returns false on stack overflow.
+ *
+ * The logical state stack is stored in three parts: the current state,
+ * a short array of states above the innermost container (top), and a
+ * bitset of enclosing containers in the stack memory.  A container
+ * always occupies two logical entries (the start state followed by
+ * ARRAY_ELEMENT or AFTER_OBJECT_VALUE), so when a value is pushed
+ * inside a container, both entries are replaced by a single bit.  The
+ * bottom of the stack is always the init state, so it is not stored.
+ *
+ * Note: this is defined as an inline function rather than a macro to
+ * give the compiler more flexibility in terms of inlining.
+ */
+static inline bool
+jiffy_parser_push_state(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const jiffy_parser_state_t state
+) {
+  const jiffy_parser_state_t curr = GET_STATE(p);
+
+  if (state == PARSER_STATE_VALUE && (
+    curr == PARSER_STATE_ARRAY_ELEMENT ||
+    curr == PARSER_STATE_AFTER_OBJECT_VALUE
+  )) {
+    // value inside container: replace the container start state (the
+    // last entry in top) and the current state with a bit
+    if (p->depth >= STACK_BITS * p->stack_len && !jiffy_parser_grow_stack(p, cbs)) {
+      return false;
+    }
+
+    const size_t ofs = p->depth / STACK_BITS;
+    const jiffy_parser_state_t mask = (jiffy_parser_state_t) 1 << (p->depth % STACK_BITS);
+    if (curr == PARSER_STATE_AFTER_OBJECT_VALUE) {
+      p->stack_ptr[ofs] |= mask;
+    } else {
+      p->stack_ptr[ofs] &= ~mask;
+    }
+
+    p->depth++;
+    p->top_len--;
+  } else if (p->stack_pos) {
+    // save current state
+    if (p->top_len >= JIFFY_PARSER_MAX_TOP_STATES) {
+      FAIL(p, cbs, JIFFY_ERR_STACK_OVERFLOW);
+    }
+
+    p->top[p->top_len++] = curr;
+  }
+
+  p->stack_pos++;
+  SWAP(p, state);
+
+#ifdef JIFFY_PARSER_STATS
+  if (p->stack_pos > p->stats.max_stack_depth) {
+    p->stats.max_stack_depth = p->stack_pos;
+  }
+#endif // JIFFY_PARSER_STATS
+
+  return true;
+}
+
+/**
+ * Pop parser state.  Returns false on stack underflow.
+ *
+ * Note: this is defined as an inline function rather than a macro to
+ * give the compiler more flexibility in terms of inlining.
+ */
+static inline bool
+jiffy_parser_pop_state(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  // check for underflow
+  if (!p->stack_pos) {
+    // got underflow, return error
+    FAIL(p, cbs, JIFFY_ERR_STACK_UNDERFLOW);
+  }
+
+  // decriment position
+  p->stack_pos--;
+
+  if (p->top_len) {
+    // restore saved state
+    SWAP(p, p->top[--p->top_len]);
+  } else if (p->depth) {
+    // restore innermost container from bitset
+    p->depth--;
+    const size_t ofs = p->depth / STACK_BITS;
+    const bool is_object = (p->stack_ptr[ofs] >> (p->depth % STACK_BITS)) & 1;
+
+    p->top[0] = is_object ? PARSER_STATE_OBJECT_START : PARSER_STATE_ARRAY_START;
+    p->top_len = 1;
+    SWAP(p, is_object ? PARSER_STATE_AFTER_OBJECT_VALUE : PARSER_STATE_ARRAY_ELEMENT);
+  } else {
+    // back at the bottom of the stack; check for done
+    SWAP(p, PARSER_STATE_INIT);
+    if (p->flags & JIFFY_PARSER_FLAG_MULTI_DOCUMENT) {
+      // end of document; stay in init state for the next document
+      FIRE(p, cbs, on_document_end);
+    } else {
+      SWAP(p, PARSER_STATE_DONE);
+    }
+  }
+
+  // return success
+  return true;
 }
 
 // push parser state and return false if an error occurred.
-#define PUSH(p, state) do { \
-  if (!jiffy_parser_push_state((p), (state))) { \
+#define PUSH(p, cbs, state) do { \
+  if (!jiffy_parser_push_state((p), (cbs), (state))) { \
     return false; \
   } \
 } while (0)
 
 // pop parser state and return false if an error occurred.
-#define POP(p) do { \
-  if (!jiffy_parser_pop_state(p)) { \
+#define POP(p, cbs) do { \
+  if (!jiffy_parser_pop_state((p), (cbs))) { \
     return false; \
   } \
 } while (0)
 
+/**
+ * Emit span of decoded string data.  Fires on_string_data once for the
+ * whole span, and on_string_byte once for each byte in the span.
+ */
+static void
+jiffy_parser_emit_string(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  EMIT_DATA(p, cbs, on_string_data, ptr, len);
+
+  if (cbs && cbs->on_string_byte) {
+    STATS_ADD(p, events.on_string_byte, len);
+    for (size_t i = 0; i < len; i++) {
+      cbs->on_string_byte(p, ptr[i]);
+    }
+  }
+}
+
+/**
+ * Emit single byte of decoded string data (e.g., from an escape
+ * sequence).
+ */
+static inline void
+jiffy_parser_emit_string_byte(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const uint8_t byte
+) {
+  jiffy_parser_emit_string(p, cbs, &byte, 1);
+}
+
+/**
+ * Append bytes to the pending string span.
+ *
+ * The bytes must immediately follow the bytes already in the pending
+ * span; callers are responsible for flushing the span before anything
+ * that breaks contiguity (escape sequences, buffer boundaries).
+ */
+static inline void
+jiffy_parser_string_span(
+  jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  if (!p->span.len) {
+    p->span.ptr = ptr;
+  }
+
+  p->span.len += len;
+}
+
+/**
+ * Emit pending string span, if any.
+ */
+static inline void
+jiffy_parser_flush_string(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  if (p->span.len) {
+    jiffy_parser_emit_string(p, cbs, p->span.ptr, p->span.len);
+    p->span.len = 0;
+  }
+}
+
 /**
  * Emit given unicode code point as UTF-8.  Returns false if the given
  * code point is outside of the valid range of Unicode code points
@@ -321,27 +1876,34 @@ jiffy_parser_pop_state(
 static bool
 jiffy_parser_emit_utf8(
   jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
   const uint32_t code
 ) {
+  uint8_t buf[4];
+
   if (!code) {
     return false;
   } else if (code < 0x80) {
-    EMIT(p, on_string_byte, code);
+    buf[0] = code;
+    jiffy_parser_emit_string(p, cbs, buf, 1);
     return true;
   } else if (code < 0x0800) {
-    EMIT(p, on_string_byte, (0x03 << 6) | ((code >> 6) & 0x1f));
-    EMIT(p, on_string_byte, (0x01 << 7) | (code & 0x3f));
+    buf[0] = (0x03 << 6) | ((code >> 6) & 0x1f);
+    buf[1] = (0x01 << 7) | (code & 0x3f);
+    jiffy_parser_emit_string(p, cbs, buf, 2);
     return true;
   } else if (code < 0x10000) {
-    EMIT(p, on_string_byte, (0x0e << 4) | ((code >> 12) & 0x0f));
-    EMIT(p, on_string_byte, (0x01 << 7) | ((code >> 6) & 0x3f));
-    EMIT(p, on_string_byte, (0x01 << 7) | (code & 0x3f));
+    buf[0] = (0x0e << 4) | ((code >> 12) & 0x0f);
+    buf[1] = (0x01 << 7) | ((code >> 6) & 0x3f);
+    buf[2] = (0x01 << 7) | (code & 0x3f);
+    jiffy_parser_emit_string(p, cbs, buf, 3);
     return true;
   } else if (code < 0x110000) {
-    EMIT(p, on_string_byte, (0x0f << 4) | ((code >> 18) & 0x07));
-    EMIT(p, on_string_byte, (0x01 << 7) | ((code >> 12) & 0x3f));
-    EMIT(p, on_string_byte, (0x01 << 7) | ((code >> 6) & 0x3f));
-    EMIT(p, on_string_byte, (0x01 << 7) | (code & 0x3f));
+    buf[0] = (0x0f << 4) | ((code >> 18) & 0x07);
+    buf[1] = (0x01 << 7) | ((code >> 12) & 0x3f);
+    buf[2] = (0x01 << 7) | ((code >> 6) & 0x3f);
+    buf[3] = (0x01 << 7) | (code & 0x3f);
+    jiffy_parser_emit_string(p, cbs, buf, 4);
     return true;
   } else {
     // this should never be reached, but just in case
@@ -349,1728 +1911,6940 @@ jiffy_parser_emit_utf8(
   }
 }
 
-static bool
-jiffy_parser_push_byte(
+/**
+ * Number flags.  Used to track the parts of a number as it is parsed.
+ */
+enum jiffy_parser_number_flags {
+  // number has a minus sign
+  NUMBER_FLAG_NEG = (1 << 0),
+
+  // number has a fractional part
+  NUMBER_FLAG_FRAC = (1 << 1),
+
+  // number has an exponent
+  NUMBER_FLAG_EXP = (1 << 2),
+
+  // exponent has a minus sign
+  NUMBER_FLAG_EXP_NEG = (1 << 3),
+
+  // digits were dropped because the significand overflowed
+  NUMBER_FLAG_DROPPED = (1 << 4),
+
+  // at least one of the dropped digits was non-zero
+  NUMBER_FLAG_TRUNCATED = (1 << 5),
+
+  // a non-zero digit was dropped after the digit buffer was full
+  NUMBER_FLAG_TAIL = (1 << 6),
+
+  // value callbacks are set, so the value must be accumulated
+  NUMBER_FLAG_VALUE = (1 << 7),
+};
+
+/**
+ * Start a number: clear the accumulated value and fire
+ * on_number_start.
+ */
+static inline void
+jiffy_parser_number_start(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  p->v_num.man = 0;
+  p->v_num.exp10 = 0;
+  p->v_num.exp = 0;
+  p->v_num.num_digits = 0;
+  p->v_num.flags = (cbs && (
+    cbs->on_number_int64 ||
+    cbs->on_number_uint64 ||
+    cbs->on_number_double
+  )) ? NUMBER_FLAG_VALUE : 0;
+
+  FIRE(p, cbs, on_number_start);
+}
+
+/**
+ * Accumulate an integer or fraction digit into the significand.
+ *
+ * Once the significand would overflow, the remaining digits are
+ * dropped: dropped integer digits scale the number by ten, and dropped
+ * fraction digits are ignored.
+ */
+static inline void
+jiffy_parser_number_digit(
+  jiffy_parser_t * const p,
+  const uint8_t digit,
+  const bool is_int
+) {
+  const uint64_t man = p->v_num.man;
+
+  if (
+    !(p->v_num.flags & NUMBER_FLAG_DROPPED) &&
+    (man < UINT64_MAX / 10 || (man == UINT64_MAX / 10 && digit <= UINT64_MAX % 10))
+  ) {
+    p->v_num.man = man * 10 + digit;
+    p->v_num.exp10 -= is_int ? 0 : 1;
+  } else {
+    p->v_num.flags |= NUMBER_FLAG_DROPPED | (digit ? NUMBER_FLAG_TRUNCATED : 0);
+    p->v_num.exp10 += is_int ? 1 : 0;
+
+    // keep dropped digits for rounding
+    const uint32_t i = p->v_num.num_digits;
+    if (i < JIFFY_PARSER_MAX_NUMBER_DIGITS) {
+      uint8_t * const pair = p->v_num.digits + i / 2;
+      *pair = (i & 1) ? (*pair | (digit << 4)) : digit;
+      p->v_num.num_digits = i + 1;
+    } else if (digit) {
+      p->v_num.flags |= NUMBER_FLAG_TAIL;
+    }
+  }
+}
+
+/**
+ * Accumulate the value of a number byte.
+ *
+ * The state has already been advanced past the byte, so the state
+ * tells us what the byte is.
+ */
+static inline void
+jiffy_parser_number_value_byte(
   jiffy_parser_t * const p,
   const uint8_t byte
 ) {
-retry:
   switch (GET_STATE(p)) {
-  case PARSER_STATE_FAIL:
-    return false;
-  case PARSER_STATE_DONE:
-    switch (byte) {
-    CASE_WHITESPACE
-      // ignore
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
+  case PARSER_STATE_NUMBER_AFTER_SIGN:
+    if (byte == '-') {
+      p->v_num.flags |= NUMBER_FLAG_NEG;
     }
 
     break;
-  case PARSER_STATE_INIT:
-    switch (byte) {
-    case 0xFE:
-      PUSH(p, PARSER_STATE_BOM_UTF16_X);
-      break;
-    case 0xEF:
-      PUSH(p, PARSER_STATE_BOM_UTF8_X);
-      break;
-    default:
-      PUSH(p, PARSER_STATE_VALUE);
-      goto retry;
-    }
-
+  case PARSER_STATE_NUMBER_INT:
+    jiffy_parser_number_digit(p, byte - '0', true);
     break;
-  case PARSER_STATE_BOM_UTF16_X:
-    switch (byte) {
-    case 0xFF:
-      FIRE(p, on_utf16_bom);
-      SWAP(p, PARSER_STATE_VALUE);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_UTF16_BOM);
-    }
-
+  case PARSER_STATE_NUMBER_AFTER_DOT:
+    p->v_num.flags |= NUMBER_FLAG_FRAC;
     break;
-  case PARSER_STATE_BOM_UTF8_X:
-    switch (byte) {
-    case 0xBB:
-      SWAP(p, PARSER_STATE_BOM_UTF8_XX);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_UTF8_BOM);
+  case PARSER_STATE_NUMBER_FRAC:
+    jiffy_parser_number_digit(p, byte - '0', false);
+    break;
+  case PARSER_STATE_NUMBER_AFTER_EXP:
+    p->v_num.flags |= NUMBER_FLAG_EXP;
+    break;
+  case PARSER_STATE_NUMBER_AFTER_EXP_SIGN:
+    if (byte == '-') {
+      p->v_num.flags |= NUMBER_FLAG_EXP_NEG;
     }
 
     break;
-  case PARSER_STATE_BOM_UTF8_XX:
-    switch (byte) {
-    case 0xBF:
-      FIRE(p, on_utf8_bom);
-      SWAP(p, PARSER_STATE_VALUE);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_UTF8_BOM);
+  case PARSER_STATE_NUMBER_EXP_NUM:
+    // saturate exponent; anything this large is zero or infinity
+    if (p->v_num.exp < 100000000) {
+      p->v_num.exp = p->v_num.exp * 10 + (byte - '0');
     }
 
     break;
-  case PARSER_STATE_VALUE:
-    switch (byte) {
-    CASE_WHITESPACE
-      // ignore
-      break;
-    case 'n':
-      SWAP(p, PARSER_STATE_LIT_N);
-      break;
-    case 't':
-      SWAP(p, PARSER_STATE_LIT_T);
-      break;
-    case 'f':
-      SWAP(p, PARSER_STATE_LIT_F);
-      break;
-    case '+':
-    case '-':
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_SIGN);
-      FIRE(p, on_number_start);
-      EMIT(p, on_number_sign, byte);
-      EMIT(p, on_number_byte, byte);
+  default:
+    // leading zero
+    break;
+  }
+}
 
-      break;
-    case '0':
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_LEADING_ZERO);
-      FIRE(p, on_number_start);
-      EMIT(p, on_number_byte, byte);
+/**
+ * Append byte to the pending number span, fire on_number_byte, and
+ * accumulate the value of the byte.
+ *
+ * The byte must immediately follow the bytes already in the pending
+ * span.
+ */
+static inline void
+jiffy_parser_number_byte(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const uint8_t * const ptr
+) {
+  if (!p->span.len) {
+    p->span.ptr = ptr;
+  }
 
-      break;
-    CASE_NONZERO_NUMBER
-      SWAP(p, PARSER_STATE_NUMBER_INT);
-      FIRE(p, on_number_start);
-      EMIT(p, on_number_byte, byte);
+  p->span.len++;
+  EMIT(p, cbs, on_number_byte, *ptr);
 
-      break;
-    case '{':
-      SWAP(p, PARSER_STATE_OBJECT_START);
-      FIRE(p, on_object_start);
-      break;
-    case '[':
-      SWAP(p, PARSER_STATE_ARRAY_START);
-      FIRE(p, on_array_start);
-      break;
-    case '"':
-      SWAP(p, PARSER_STATE_STRING);
-      FIRE(p, on_string_start);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+  if (p->v_num.flags & NUMBER_FLAG_VALUE) {
+    jiffy_parser_number_value_byte(p, *ptr);
+  }
+}
 
-    break;
-  case PARSER_STATE_LIT_N:
-    if (byte == 'u') {
-      SWAP(p, PARSER_STATE_LIT_NU);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+/**
+ * Append run of digits to the pending number span.  Equivalent to
+ * calling jiffy_parser_number_byte() for each byte.
+ */
+static inline void
+jiffy_parser_number_digits(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  if (!p->span.len) {
+    p->span.ptr = ptr;
+  }
 
-    break;
-  case PARSER_STATE_LIT_NU:
-    if (byte == 'l') {
-      SWAP(p, PARSER_STATE_LIT_NUL);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+  p->span.len += len;
 
-    break;
-  case PARSER_STATE_LIT_NUL:
-    if (byte == 'l') {
-      FIRE(p, on_null);
-      POP(p);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
+  if (cbs && cbs->on_number_byte) {
+    STATS_ADD(p, events.on_number_byte, len);
+    for (size_t i = 0; i < len; i++) {
+      cbs->on_number_byte(p, ptr[i]);
     }
+  }
 
-    break;
-  case PARSER_STATE_LIT_T:
-    if (byte == 'r') {
-      SWAP(p, PARSER_STATE_LIT_TR);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
+  if (p->v_num.flags & NUMBER_FLAG_VALUE) {
+    for (size_t i = 0; i < len; i++) {
+      jiffy_parser_number_value_byte(p, ptr[i]);
     }
+  }
+}
 
-    break;
-  case PARSER_STATE_LIT_TR:
-    if (byte == 'u') {
-      SWAP(p, PARSER_STATE_LIT_TRU);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+/**
+ * Emit pending number span, if any.
+ */
+static inline void
+jiffy_parser_flush_number(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  if (p->span.len) {
+    EMIT_DATA(p, cbs, on_number_data, p->span.ptr, p->span.len);
+    p->span.len = 0;
+  }
+}
 
-    break;
-  case PARSER_STATE_LIT_TRU:
-    if (byte == 'e') {
-      FIRE(p, on_true);
-      POP(p);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
+/**
+ * Fire on_number_int64, on_number_uint64, and on_number_double for the
+ * accumulated number.
+ */
+static void
+jiffy_parser_emit_number_value(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  const uint32_t flags = p->v_num.flags;
+  const uint64_t man = p->v_num.man;
+  const bool neg = flags & NUMBER_FLAG_NEG;
+
+  if (!(flags & (NUMBER_FLAG_FRAC | NUMBER_FLAG_EXP | NUMBER_FLAG_DROPPED))) {
+    // integer which fits in 64 bits
+    if (neg && man <= (uint64_t) INT64_MAX + 1) {
+      EMIT(p, cbs, on_number_int64, (man > INT64_MAX) ? INT64_MIN : -(int64_t) man);
+    } else if (!neg && man <= INT64_MAX) {
+      EMIT(p, cbs, on_number_int64, (int64_t) man);
     }
 
-    break;
-  case PARSER_STATE_LIT_F:
-    if (byte == 'a') {
-      SWAP(p, PARSER_STATE_LIT_FA);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
+    if (!neg) {
+      EMIT(p, cbs, on_number_uint64, man);
     }
+  }
 
-    break;
-  case PARSER_STATE_LIT_FA:
-    if (byte == 'l') {
-      SWAP(p, PARSER_STATE_LIT_FAL);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+  if (cbs->on_number_double) {
+    const int64_t exp = p->v_num.exp;
+    const int64_t q = p->v_num.exp10 + ((flags & NUMBER_FLAG_EXP_NEG) ? -exp : exp);
+    const jiffy_number_digits_t digits = {
+      .ptr  = p->v_num.digits,
+      .len  = p->v_num.num_digits,
+      .tail = flags & NUMBER_FLAG_TAIL,
+    };
 
-    break;
-  case PARSER_STATE_LIT_FAL:
-    if (byte == 's') {
-      SWAP(p, PARSER_STATE_LIT_FALS);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+    STATS_ADD(p, events.on_number_double, 1);
+    cbs->on_number_double(p, jiffy_number_to_double(
+      neg, man, q, flags & NUMBER_FLAG_TRUNCATED, &digits
+    ));
+  }
+}
 
-    break;
-  case PARSER_STATE_LIT_FALS:
-    if (byte == 'e') {
-      FIRE(p, on_false);
-      POP(p);
-    } else {
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+/**
+ * End the current number: flush the pending number span, fire the
+ * value callbacks, and then fire on_number_end.
+ */
+static inline void
+jiffy_parser_end_number(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  jiffy_parser_flush_number(p, cbs);
 
-    break;
-  case PARSER_STATE_NUMBER_AFTER_SIGN:
-    switch (byte) {
-    case '0':
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_LEADING_ZERO);
-      EMIT(p, on_number_byte, byte);
-      break;
-    CASE_NONZERO_NUMBER
-      SWAP(p, PARSER_STATE_NUMBER_INT);
-      EMIT(p, on_number_byte, byte);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+  if (p->v_num.flags & NUMBER_FLAG_VALUE) {
+    jiffy_parser_emit_number_value(p, cbs);
+  }
 
-    break;
-  case PARSER_STATE_NUMBER_AFTER_LEADING_ZERO:
-    if (byte == '.') {
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_DOT);
-      FIRE(p, on_number_fraction);
-      EMIT(p, on_number_byte, byte);
-    } else if (byte == 'e' || byte == 'E') {
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_EXP);
-      FIRE(p, on_number_exponent);
-      EMIT(p, on_number_byte, byte);
-    } else {
-      FIRE(p, on_number_end);
-      POP(p);
-      goto retry;
-    }
+  FIRE(p, cbs, on_number_end);
+}
 
-    break;
+/**
+ * Emit pending string or number span, if any.  Called at the end of
+ * each buffer passed to jiffy_parser_push(), because a span cannot
+ * extend past the end of the buffer it points into.
+ */
+static void
+jiffy_parser_flush(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  switch (GET_STATE(p)) {
+  case PARSER_STATE_NUMBER_AFTER_SIGN:
+  case PARSER_STATE_NUMBER_AFTER_LEADING_ZERO:
   case PARSER_STATE_NUMBER_INT:
-    switch (byte) {
-    CASE_NUMBER
-      EMIT(p, on_number_byte, byte);
-      break;
-    case '.':
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_DOT);
-      FIRE(p, on_number_fraction);
-      EMIT(p, on_number_byte, byte);
-      break;
-    case 'e':
-    case 'E':
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_EXP);
-      FIRE(p, on_number_exponent);
-      EMIT(p, on_number_byte, byte);
-      break;
-    default:
-      FIRE(p, on_number_end);
-      POP(p);
-      goto retry;
-    }
-
-    break;
   case PARSER_STATE_NUMBER_AFTER_DOT:
-    switch (byte) {
-    CASE_NUMBER
-      SWAP(p, PARSER_STATE_NUMBER_FRAC);
-      EMIT(p, on_number_byte, byte);
+  case PARSER_STATE_NUMBER_FRAC:
+  case PARSER_STATE_NUMBER_AFTER_EXP:
+  case PARSER_STATE_NUMBER_AFTER_EXP_SIGN:
+  case PARSER_STATE_NUMBER_EXP_NUM:
+    jiffy_parser_flush_number(p, cbs);
+    break;
+  default:
+    jiffy_parser_flush_string(p, cbs);
+  }
+}
 
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
-    }
+/**
+ * Returns true if the given byte is whitespace.
+ */
+static inline bool
+is_whitespace(
+  const uint8_t byte
+) {
+  switch (byte) {
+  CASE_WHITESPACE
+    return true;
+  default:
+    return false;
+  }
+}
 
-    break;
-  case PARSER_STATE_NUMBER_FRAC:
-    switch (byte) {
-    CASE_NUMBER
-      EMIT(p, on_number_byte, byte);
-      break;
-    case 'e':
-    case 'E':
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_EXP);
-      FIRE(p, on_number_exponent);
-      EMIT(p, on_number_byte, byte);
-      break;
-    default:
-      FIRE(p, on_number_end);
-      POP(p);
-      goto retry;
+/**
+ * Returns true if the given byte is an ASCII digit.
+ */
+static inline bool
+is_digit(
+  const uint8_t byte
+) {
+  return byte >= '0' && byte <= '9';
+}
+
+/**
+ * Returns true if the given byte can be appended to a string as-is
+ * (that is, the byte is not a quote, a backslash, or a control
+ * character).
+ */
+static inline bool
+is_plain_string_byte(
+  const uint8_t byte
+) {
+  return byte != '"' && byte != '\\' && byte >= 0x20;
+}
+
+/**
+ * Returns true if the given byte is the first byte of a literal (true,
+ * false, or null).
+ */
+static inline bool
+is_literal_start(
+  const uint8_t byte
+) {
+  return byte == 't' || byte == 'f' || byte == 'n';
+}
+
+/**
+ * Get the number of decimal digits at the start of the given buffer.
+ */
+static inline size_t
+jiffy_parser_scan_digits(
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  size_t i = 0;
+
+  while (i < len && is_digit(ptr[i])) {
+    i++;
+  }
+
+  return i;
+}
+
+/**
+ * Get the number of whitespace bytes at the start of the given buffer.
+ */
+static inline size_t
+jiffy_parser_scan_whitespace(
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  size_t i = 0;
+
+#ifdef __SSE2__
+  {
+    const __m128i sp = _mm_set1_epi8(' '),
+                  ht = _mm_set1_epi8('\t'),
+                  vt = _mm_set1_epi8('\v'),
+                  lf = _mm_set1_epi8('\n'),
+                  cr = _mm_set1_epi8('\r');
+
+    // check 16 bytes at a time
+    for (; i + 16 <= len; i += 16) {
+      const __m128i v = _mm_loadu_si128((const __m128i*) (ptr + i));
+      const __m128i m = _mm_or_si128(
+        _mm_or_si128(
+          _mm_or_si128(_mm_cmpeq_epi8(v, sp), _mm_cmpeq_epi8(v, ht)),
+          _mm_or_si128(_mm_cmpeq_epi8(v, vt), _mm_cmpeq_epi8(v, lf))
+        ),
+        _mm_cmpeq_epi8(v, cr)
+      );
+
+      // get mask of non-whitespace bytes
+      const uint32_t bits = ~_mm_movemask_epi8(m) & 0xffff;
+      if (bits) {
+        return i + ctz32(bits);
+      }
     }
+  }
+#endif // __SSE2__
 
-    break;
-  case PARSER_STATE_NUMBER_AFTER_EXP:
-    switch (byte) {
-    case '+':
-    case '-':
-      SWAP(p, PARSER_STATE_NUMBER_AFTER_EXP_SIGN);
-      EMIT(p, on_number_byte, byte);
-      break;
-    CASE_NUMBER
-      SWAP(p, PARSER_STATE_NUMBER_EXP_NUM);
-      EMIT(p, on_number_byte, byte);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
+  // check remaining bytes
+  while (i < len && is_whitespace(ptr[i])) {
+    i++;
+  }
+
+  return i;
+}
+
+/**
+ * Get the number of bytes at the start of the given buffer which can be
+ * appended to a string as-is (that is, bytes which are not a quote, a
+ * backslash, or a control character).
+ */
+static inline size_t
+jiffy_parser_scan_string(
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  size_t i = 0;
+
+#ifdef __AVX2__
+  {
+    const __m256i quote = _mm256_set1_epi8('"'),
+                  slash = _mm256_set1_epi8('\\'),
+                  ctrl = _mm256_set1_epi8(0x1f);
+
+    // check 32 bytes at a time
+    for (; i + 32 <= len; i += 32) {
+      const __m256i v = _mm256_loadu_si256((const __m256i*) (ptr + i));
+      const __m256i m = _mm256_or_si256(
+        _mm256_or_si256(
+          _mm256_cmpeq_epi8(v, quote),
+          _mm256_cmpeq_epi8(v, slash)
+        ),
+
+        // v <= 0x1f (unsigned)
+        _mm256_cmpeq_epi8(_mm256_min_epu8(v, ctrl), v)
+      );
+
+      const uint32_t bits = _mm256_movemask_epi8(m);
+      if (bits) {
+        return i + ctz32(bits);
+      }
     }
+  }
+#endif // __AVX2__
+
+#ifdef __SSE2__
+  {
+    const __m128i quote = _mm_set1_epi8('"'),
+                  slash = _mm_set1_epi8('\\'),
+                  ctrl = _mm_set1_epi8(0x1f);
+
+    // check 16 bytes at a time
+    for (; i + 16 <= len; i += 16) {
+      const __m128i v = _mm_loadu_si128((const __m128i*) (ptr + i));
+      const __m128i m = _mm_or_si128(
+        _mm_or_si128(
+          _mm_cmpeq_epi8(v, quote),
+          _mm_cmpeq_epi8(v, slash)
+        ),
+
+        // v <= 0x1f (unsigned)
+        _mm_cmpeq_epi8(_mm_min_epu8(v, ctrl), v)
+      );
 
-    break;
-  case PARSER_STATE_NUMBER_AFTER_EXP_SIGN:
-    switch (byte) {
-    CASE_NUMBER
-      SWAP(p, PARSER_STATE_NUMBER_EXP_NUM);
-      EMIT(p, on_number_byte, byte);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
+      const uint32_t bits = _mm_movemask_epi8(m);
+      if (bits) {
+        return i + ctz32(bits);
+      }
     }
+  }
+#endif // __SSE2__
 
-    break;
-  case PARSER_STATE_NUMBER_EXP_NUM:
-    switch (byte) {
-    CASE_NUMBER
-      EMIT(p, on_number_byte, byte);
-      break;
-    default:
-      FIRE(p, on_number_end);
-      POP(p);
-      goto retry;
+  // check remaining bytes
+  while (i < len && is_plain_string_byte(ptr[i])) {
+    i++;
+  }
+
+  return i;
+}
+
+/**
+ * Returns true if the given byte is a quote or a bracket.  Used to skip
+ * values; see jiffy_parser_skip_value().
+ */
+static inline bool
+is_skip_stop(
+  const uint8_t byte
+) {
+  // '[' | 0x20 == '{', ']' | 0x20 == '}'
+  return byte == '"' || (byte | 0x20) == '{' || (byte | 0x20) == '}';
+}
+
+/**
+ * Get the number of bytes at the start of the given buffer which are
+ * not quotes or brackets.  Used to skip the inside of containers.
+ */
+static inline size_t
+jiffy_parser_scan_skip(
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  size_t i = 0;
+
+#ifdef __AVX2__
+  {
+    const __m256i quote = _mm256_set1_epi8('"'),
+                  lower = _mm256_set1_epi8(0x20),
+                  open = _mm256_set1_epi8('{'),
+                  close = _mm256_set1_epi8('}');
+
+    // check 32 bytes at a time
+    for (; i + 32 <= len; i += 32) {
+      const __m256i v = _mm256_loadu_si256((const __m256i*) (ptr + i));
+
+      // fold '[' and ']' into '{' and '}'
+      const __m256i lv = _mm256_or_si256(v, lower);
+      const __m256i m = _mm256_or_si256(
+        _mm256_cmpeq_epi8(v, quote),
+        _mm256_or_si256(
+          _mm256_cmpeq_epi8(lv, open),
+          _mm256_cmpeq_epi8(lv, close)
+        )
+      );
+
+      const uint32_t bits = _mm256_movemask_epi8(m);
+      if (bits) {
+        return i + ctz32(bits);
+      }
+    }
+  }
+#endif // __AVX2__
+
+#ifdef __SSE2__
+  {
+    const __m128i quote = _mm_set1_epi8('"'),
+                  lower = _mm_set1_epi8(0x20),
+                  open = _mm_set1_epi8('{'),
+                  close = _mm_set1_epi8('}');
+
+    // check 16 bytes at a time
+    for (; i + 16 <= len; i += 16) {
+      const __m128i v = _mm_loadu_si128((const __m128i*) (ptr + i));
+
+      // fold '[' and ']' into '{' and '}'
+      const __m128i lv = _mm_or_si128(v, lower);
+      const __m128i m = _mm_or_si128(
+        _mm_cmpeq_epi8(v, quote),
+        _mm_or_si128(
+          _mm_cmpeq_epi8(lv, open),
+          _mm_cmpeq_epi8(lv, close)
+        )
+      );
+
+      const uint32_t bits = _mm_movemask_epi8(m);
+      if (bits) {
+        return i + ctz32(bits);
+      }
     }
+  }
+#endif // __SSE2__
 
-    break;
-  case PARSER_STATE_STRING:
+  // check remaining bytes
+  while (i < len && !is_skip_stop(ptr[i])) {
+    i++;
+  }
+
+  return i;
+}
+
+/**
+ * Feed a byte to the scalar UTF-8 validator.  Returns false if the
+ * byte is not valid at this point of a UTF-8 sequence.
+ *
+ * The validator state is the number of continuation bytes still needed
+ * and the valid range of the next continuation byte; the range of the
+ * first continuation byte rules out overlong encodings, surrogates, and
+ * code points above U+10FFFF.
+ */
+static inline bool
+jiffy_parser_utf8_step(
+  jiffy_parser_t * const p,
+  const uint8_t byte
+) {
+  if (!p->v_str.utf8_need) {
+    if (byte < 0x80) {
+      // ASCII
+      return true;
+    } else if (byte < 0xC2) {
+      // continuation byte or overlong 2-byte lead
+      return false;
+    } else if (byte < 0xE0) {
+      p->v_str.utf8_need = 1;
+      p->v_str.utf8_lo = 0x80;
+      p->v_str.utf8_hi = 0xBF;
+    } else if (byte < 0xF0) {
+      p->v_str.utf8_need = 2;
+      p->v_str.utf8_lo = (byte == 0xE0) ? 0xA0 : 0x80;
+      p->v_str.utf8_hi = (byte == 0xED) ? 0x9F : 0xBF;
+    } else if (byte < 0xF5) {
+      p->v_str.utf8_need = 3;
+      p->v_str.utf8_lo = (byte == 0xF0) ? 0x90 : 0x80;
+      p->v_str.utf8_hi = (byte == 0xF4) ? 0x8F : 0xBF;
+    } else {
+      // code point above U+10FFFF
+      return false;
+    }
+
+    return true;
+  }
+
+  if (byte < p->v_str.utf8_lo || byte > p->v_str.utf8_hi) {
+    // bad continuation byte
+    return false;
+  }
+
+  p->v_str.utf8_need--;
+  p->v_str.utf8_lo = 0x80;
+  p->v_str.utf8_hi = 0xBF;
+  return true;
+}
+
+/**
+ * Returns true if UTF-8 validation is enabled and the string data seen
+ * so far ends in the middle of a UTF-8 sequence.
+ */
+static inline bool
+jiffy_parser_utf8_is_pending(
+  const jiffy_parser_t * const p
+) {
+  return (p->flags & JIFFY_PARSER_FLAG_VALIDATE_UTF8) && p->v_str.utf8_need;
+}
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+// error bits for the UTF-8 lookup tables.  Each bit is set in all
+// three tables for the combination of bytes which it describes.
+#define UTF8_TOO_SHORT (1 << 0) // 11______ 0_______ / 11______ 11______
+#define UTF8_TOO_LONG (1 << 1) // 0_______ 10______
+#define UTF8_OVERLONG_3 (1 << 2) // 11100000 100_____
+#define UTF8_TOO_LARGE (1 << 3) // 11110100 1001____ / 11110101+ ________
+#define UTF8_SURROGATE (1 << 4) // 11101101 101_____
+#define UTF8_OVERLONG_2 (1 << 5) // 1100000_ 10______
+#define UTF8_TOO_LARGE_1000 (1 << 6) // 11110101+ 1000____
+#define UTF8_OVERLONG_4 (1 << 6) // 11110000 1000____
+// (-0x80 rather than 0x80, so that the table entries fit in a char)
+#define UTF8_TWO_CONTS (-0x80) // 10______ 10______
+#define UTF8_CARRY (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+// lookup table for the high nibble of the previous byte
+#define UTF8_BYTE_1_HIGH \
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, \
+  UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, \
+  UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, \
+  UTF8_TOO_SHORT | UTF8_OVERLONG_2, \
+  UTF8_TOO_SHORT, \
+  UTF8_TOO_SHORT | UTF8_OVERLONG_3 | UTF8_SURROGATE, \
+  UTF8_TOO_SHORT | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4
+
+// lookup table for the low nibble of the previous byte
+#define UTF8_BYTE_1_LOW \
+  UTF8_CARRY | UTF8_OVERLONG_3 | UTF8_OVERLONG_2 | UTF8_OVERLONG_4, \
+  UTF8_CARRY | UTF8_OVERLONG_2, \
+  UTF8_CARRY, \
+  UTF8_CARRY, \
+  UTF8_CARRY | UTF8_TOO_LARGE, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000 | UTF8_SURROGATE, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000, \
+  UTF8_CARRY | UTF8_TOO_LARGE | UTF8_TOO_LARGE_1000
+
+// lookup table for the high nibble of the current byte
+#define UTF8_BYTE_2_HIGH \
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, \
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, \
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE_1000 | UTF8_OVERLONG_4, \
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_TOO_LARGE, \
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE, \
+  UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_SURROGATE | UTF8_TOO_LARGE, \
+  UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+#endif // __AVX2__ || __SSSE3__
+
+#ifdef __AVX2__
+// UTF-8 validation block size, in bytes
+#define UTF8_BLOCK_SIZE 32
+
+/**
+ * Check a block of bytes with the UTF-8 lookup tables (John Keiser and
+ * Daniel Lemire, "Validating UTF-8 In Less Than One Instruction Per
+ * Byte", 2021).  Returns a non-zero vector if the block contains an
+ * error, given the previous block.  Sequences which are incomplete at
+ * the end of the block are not errors.
+ */
+static inline __m256i
+jiffy_utf8_check(
+  const __m256i v,
+  const __m256i prev_v
+) {
+  const __m256i nibble = _mm256_set1_epi8(0x0F);
+
+  // previous block shifted into the current one (that is, the bytes
+  // at offset -1, -2, and -3 from each byte)
+  const __m256i shifted = _mm256_permute2x128_si256(prev_v, v, 0x21);
+  const __m256i prev1 = _mm256_alignr_epi8(v, shifted, 15),
+                prev2 = _mm256_alignr_epi8(v, shifted, 14),
+                prev3 = _mm256_alignr_epi8(v, shifted, 13);
+
+  const __m256i byte_1_high = _mm256_shuffle_epi8(
+    _mm256_setr_epi8(UTF8_BYTE_1_HIGH, UTF8_BYTE_1_HIGH),
+    _mm256_and_si256(_mm256_srli_epi16(prev1, 4), nibble)
+  );
+
+  const __m256i byte_1_low = _mm256_shuffle_epi8(
+    _mm256_setr_epi8(UTF8_BYTE_1_LOW, UTF8_BYTE_1_LOW),
+    _mm256_and_si256(prev1, nibble)
+  );
+
+  const __m256i byte_2_high = _mm256_shuffle_epi8(
+    _mm256_setr_epi8(UTF8_BYTE_2_HIGH, UTF8_BYTE_2_HIGH),
+    _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble)
+  );
+
+  const __m256i special = _mm256_and_si256(
+    _mm256_and_si256(byte_1_high, byte_1_low),
+    byte_2_high
+  );
+
+  // bytes which must be the second or third continuation byte of a 3-
+  // or 4-byte sequence
+  const __m256i must23 = _mm256_and_si256(
+    _mm256_or_si256(
+      _mm256_subs_epu8(prev2, _mm256_set1_epi8(0xE0 - 0x80)),
+      _mm256_subs_epu8(prev3, _mm256_set1_epi8(0xF0 - 0x80))
+    ),
+    _mm256_set1_epi8(-0x80)
+  );
+
+  return _mm256_xor_si256(must23, special);
+}
+
+/**
+ * Validate whole blocks of bytes at the start of the given buffer,
+ * which must not start in the middle of a UTF-8 sequence.  Returns the
+ * number of bytes checked, or SIZE_MAX if any of them are invalid.
+ */
+static inline size_t
+jiffy_utf8_check_blocks(
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  // bytes which end a block in the middle of a sequence are greater
+  // than these
+  const __m256i max_end = _mm256_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    (char) 0xEF, (char) 0xDF, (char) 0xBF
+  );
+
+  __m256i prev = _mm256_setzero_si256(),
+          prev_incomplete = _mm256_setzero_si256(),
+          err = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + 32 <= len; i += 32) {
+    const __m256i v = _mm256_loadu_si256((const __m256i*) (ptr + i));
+
+    if (_mm256_movemask_epi8(v)) {
+      err = _mm256_or_si256(err, jiffy_utf8_check(v, prev));
+    } else {
+      // ASCII block; error if the previous block ended in the middle
+      // of a sequence
+      err = _mm256_or_si256(err, prev_incomplete);
+    }
+
+    prev = v;
+    prev_incomplete = _mm256_subs_epu8(v, max_end);
+  }
+
+  return _mm256_testz_si256(err, err) ? i : SIZE_MAX;
+}
+#elif defined(__SSSE3__)
+// UTF-8 validation block size, in bytes
+#define UTF8_BLOCK_SIZE 16
+
+/**
+ * Check a block of bytes with the UTF-8 lookup tables (John Keiser and
+ * Daniel Lemire, "Validating UTF-8 In Less Than One Instruction Per
+ * Byte", 2021).  Returns a non-zero vector if the block contains an
+ * error, given the previous block.  Sequences which are incomplete at
+ * the end of the block are not errors.
+ */
+static inline __m128i
+jiffy_utf8_check(
+  const __m128i v,
+  const __m128i prev_v
+) {
+  const __m128i nibble = _mm_set1_epi8(0x0F);
+
+  // bytes at offset -1, -2, and -3 from each byte
+  const __m128i prev1 = _mm_alignr_epi8(v, prev_v, 15),
+                prev2 = _mm_alignr_epi8(v, prev_v, 14),
+                prev3 = _mm_alignr_epi8(v, prev_v, 13);
+
+  const __m128i byte_1_high = _mm_shuffle_epi8(
+    _mm_setr_epi8(UTF8_BYTE_1_HIGH),
+    _mm_and_si128(_mm_srli_epi16(prev1, 4), nibble)
+  );
+
+  const __m128i byte_1_low = _mm_shuffle_epi8(
+    _mm_setr_epi8(UTF8_BYTE_1_LOW),
+    _mm_and_si128(prev1, nibble)
+  );
+
+  const __m128i byte_2_high = _mm_shuffle_epi8(
+    _mm_setr_epi8(UTF8_BYTE_2_HIGH),
+    _mm_and_si128(_mm_srli_epi16(v, 4), nibble)
+  );
+
+  const __m128i special = _mm_and_si128(
+    _mm_and_si128(byte_1_high, byte_1_low),
+    byte_2_high
+  );
+
+  // bytes which must be the second or third continuation byte of a 3-
+  // or 4-byte sequence
+  const __m128i must23 = _mm_and_si128(
+    _mm_or_si128(
+      _mm_subs_epu8(prev2, _mm_set1_epi8(0xE0 - 0x80)),
+      _mm_subs_epu8(prev3, _mm_set1_epi8(0xF0 - 0x80))
+    ),
+    _mm_set1_epi8(-0x80)
+  );
+
+  return _mm_xor_si128(must23, special);
+}
+
+/**
+ * Validate whole blocks of bytes at the start of the given buffer,
+ * which must not start in the middle of a UTF-8 sequence.  Returns the
+ * number of bytes checked, or SIZE_MAX if any of them are invalid.
+ */
+static inline size_t
+jiffy_utf8_check_blocks(
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  // bytes which end a block in the middle of a sequence are greater
+  // than these
+  const __m128i max_end = _mm_setr_epi8(
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+    (char) 0xEF, (char) 0xDF, (char) 0xBF
+  );
+
+  __m128i prev = _mm_setzero_si128(),
+          prev_incomplete = _mm_setzero_si128(),
+          err = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + 16 <= len; i += 16) {
+    const __m128i v = _mm_loadu_si128((const __m128i*) (ptr + i));
+
+    if (_mm_movemask_epi8(v)) {
+      err = _mm_or_si128(err, jiffy_utf8_check(v, prev));
+    } else {
+      // ASCII block; error if the previous block ended in the middle
+      // of a sequence
+      err = _mm_or_si128(err, prev_incomplete);
+    }
+
+    prev = v;
+    prev_incomplete = _mm_subs_epu8(v, max_end);
+  }
+
+  return (_mm_movemask_epi8(_mm_cmpeq_epi8(err, _mm_setzero_si128())) == 0xFFFF) ? i : SIZE_MAX;
+}
+#endif // __AVX2__
+
+/**
+ * Validate UTF-8 in a run of plain string bytes, continuing from the
+ * validator state in the parser.  Returns the length of the valid
+ * prefix of the run; this is the offset of the first invalid byte if
+ * it is less than the length of the run.
+ *
+ * Whole blocks are checked with the vectorized lookup-table algorithm
+ * if AVX2 or SSSE3 is available.  ASCII is skipped 16 bytes at a time
+ * if only SSE2 is available.  Everything else, including any sequence
+ * which is cut off at the end of a block, goes through the scalar
+ * validator.
+ */
+static size_t
+jiffy_parser_validate_utf8(
+  jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  size_t i = 0;
+
+  // finish pending sequence
+  while (i < len && p->v_str.utf8_need) {
+    if (!jiffy_parser_utf8_step(p, ptr[i])) {
+      return i;
+    }
+
+    i++;
+  }
+
+#ifdef UTF8_BLOCK_SIZE
+  if (len - i >= UTF8_BLOCK_SIZE) {
+    const size_t run = jiffy_utf8_check_blocks(ptr + i, len - i);
+
+    if (run != SIZE_MAX) {
+      // blocks are valid, but the last one may end in the middle of a
+      // sequence; rewind to the lead byte of that sequence
+      size_t end = i + run;
+      for (size_t j = 1; j <= 3; j++) {
+        const uint8_t byte = ptr[end - j];
+
+        if (byte < 0x80) {
+          // ASCII, no pending sequence
+          break;
+        } else if (byte >= 0xC0) {
+          // lead byte; check length of sequence
+          const size_t seq_len = (byte >= 0xF0) ? 4 : ((byte >= 0xE0) ? 3 : 2);
+          end -= (seq_len > j) ? j : 0;
+          break;
+        }
+      }
+
+      i = end;
+    }
+
+    // on error, fall through to the scalar validator to find the
+    // offset of the first invalid byte
+  }
+#endif // UTF8_BLOCK_SIZE
+
+  while (i < len) {
+#ifdef __SSE2__
+    if (!p->v_str.utf8_need && len - i >= 16) {
+      // skip block of ASCII
+      const __m128i v = _mm_loadu_si128((const __m128i*) (ptr + i));
+      if (!_mm_movemask_epi8(v)) {
+        i += 16;
+        continue;
+      }
+    }
+#endif // __SSE2__
+
+    if (!jiffy_parser_utf8_step(p, ptr[i])) {
+      return i;
+    }
+
+    i++;
+  }
+
+  return i;
+}
+
+/**
+ * Start a string: clear the UTF-8 validator state and fire
+ * on_string_start.
+ */
+static inline void
+jiffy_parser_string_start(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  p->v_str.utf8_need = 0;
+  FIRE(p, cbs, on_string_start);
+}
+
+/**
+ * Start an array element.  Called when the first byte of the first
+ * element of an array is encountered.
+ */
+static inline bool
+jiffy_parser_array_element_start(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  PUSH(p, cbs, PARSER_STATE_ARRAY_ELEMENT);
+  PUSH(p, cbs, PARSER_STATE_VALUE);
+  FIRE(p, cbs, on_array_element_start);
+
+  // return success
+  return true;
+}
+
+/**
+ * Start an object value.  Called when the first byte of an object value
+ * is encountered.
+ */
+static inline bool
+jiffy_parser_object_value_start(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  SWAP(p, PARSER_STATE_AFTER_OBJECT_VALUE);
+  PUSH(p, cbs, PARSER_STATE_VALUE);
+  FIRE(p, cbs, on_object_value_start);
+
+  // return success
+  return true;
+}
+
+static bool
+jiffy_parser_push_byte(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const uint8_t * const ptr
+) {
+  const uint8_t byte = *ptr;
+
+retry:
+  switch (GET_STATE(p)) {
+  case PARSER_STATE_FAIL:
+    return false;
+  case PARSER_STATE_DONE:
     switch (byte) {
-    case '"':
-      FIRE(p, on_string_end);
-      POP(p);
-      break;
-    case '\\':
-      PUSH(p, PARSER_STATE_STRING_ESC);
+    CASE_WHITESPACE
+      // ignore
       break;
-    case 0:
-    case '\r':
-    case '\n':
-      FAIL(p, JIFFY_ERR_BAD_BYTE);
     default:
-      EMIT(p, on_string_byte, byte);
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
     }
 
     break;
-  case PARSER_STATE_STRING_ESC:
+  case PARSER_STATE_INIT:
     switch (byte) {
-    case '\\':
-      EMIT(p, on_string_byte, '\\');
-      POP(p);
-      break;
-    case '/':
-      EMIT(p, on_string_byte, '/');
-      POP(p);
-      break;
-    case '\"':
-      EMIT(p, on_string_byte, '\"');
-      POP(p);
-      break;
-    case 'n':
-      EMIT(p, on_string_byte, '\n');
-      POP(p);
-      break;
-    case 'r':
-      EMIT(p, on_string_byte, '\r');
-      POP(p);
-      break;
-    case 't':
-      EMIT(p, on_string_byte, '\t');
-      POP(p);
-      break;
-    case 'v':
-      EMIT(p, on_string_byte, '\v');
-      POP(p);
-      break;
-    case 'f':
-      EMIT(p, on_string_byte, '\f');
-      POP(p);
-      break;
-    case 'b':
-      EMIT(p, on_string_byte, '\b');
-      POP(p);
+    case 0xFE:
+      PUSH(p, cbs, PARSER_STATE_BOM_UTF16_X);
       break;
-    case 'u':
-      p->v_str.hex = 0;
-      SWAP(p, PARSER_STATE_STRING_UNICODE);
+    case 0xEF:
+      PUSH(p, cbs, PARSER_STATE_BOM_UTF8_X);
       break;
+    CASE_WHITESPACE
+      if (p->flags & JIFFY_PARSER_FLAG_MULTI_DOCUMENT) {
+        // ignore whitespace between documents
+        break;
+      }
+
+      PUSH(p, cbs, PARSER_STATE_VALUE);
+      goto retry;
     default:
-      FAIL(p, JIFFY_ERR_BAD_ESCAPE);
+      PUSH(p, cbs, PARSER_STATE_VALUE);
+      goto retry;
     }
 
     break;
-  case PARSER_STATE_STRING_UNICODE:
+  case PARSER_STATE_BOM_UTF16_X:
     switch (byte) {
-    CASE_HEX
-      p->v_str.hex = (p->v_str.hex << 4) + nibble(byte);
-      SWAP(p, PARSER_STATE_STRING_UNICODE_X);
+    case 0xFF:
+      FIRE(p, cbs, on_utf16_bom);
+      SWAP(p, PARSER_STATE_VALUE);
       break;
     default:
-      FAIL(p, JIFFY_ERR_BAD_UNICODE_ESCAPE);
+      FAIL(p, cbs, JIFFY_ERR_BAD_UTF16_BOM);
     }
 
     break;
-  case PARSER_STATE_STRING_UNICODE_X:
+  case PARSER_STATE_BOM_UTF8_X:
     switch (byte) {
-    CASE_HEX
-      p->v_str.hex = (p->v_str.hex << 4) + nibble(byte);
-      SWAP(p, PARSER_STATE_STRING_UNICODE_XX);
+    case 0xBB:
+      SWAP(p, PARSER_STATE_BOM_UTF8_XX);
       break;
     default:
-      FAIL(p, JIFFY_ERR_BAD_UNICODE_ESCAPE);
+      FAIL(p, cbs, JIFFY_ERR_BAD_UTF8_BOM);
     }
 
     break;
-  case PARSER_STATE_STRING_UNICODE_XX:
+  case PARSER_STATE_BOM_UTF8_XX:
     switch (byte) {
-    CASE_HEX
-      p->v_str.hex = (p->v_str.hex << 4) + nibble(byte);
-      SWAP(p, PARSER_STATE_STRING_UNICODE_XXX);
+    case 0xBF:
+      FIRE(p, cbs, on_utf8_bom);
+      SWAP(p, PARSER_STATE_VALUE);
       break;
     default:
-      FAIL(p, JIFFY_ERR_BAD_UNICODE_ESCAPE);
+      FAIL(p, cbs, JIFFY_ERR_BAD_UTF8_BOM);
     }
 
     break;
-  case PARSER_STATE_STRING_UNICODE_XXX:
+  case PARSER_STATE_VALUE:
     switch (byte) {
-    CASE_HEX
-      p->v_str.hex = (p->v_str.hex << 4) + nibble(byte);
-      if (!jiffy_parser_emit_utf8(p, p->v_str.hex)) {
-        FAIL(p, JIFFY_ERR_BAD_UNICODE_CODEPOINT);
-      }
-      POP(p);
-      break;
+    CASE_WHITESPACE
+      // ignore
+      break;
+    case 'n':
+      SWAP(p, PARSER_STATE_LIT_N);
+      break;
+    case 't':
+      SWAP(p, PARSER_STATE_LIT_T);
+      break;
+    case 'f':
+      SWAP(p, PARSER_STATE_LIT_F);
+      break;
+    case '+':
+    case '-':
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_SIGN);
+      jiffy_parser_number_start(p, cbs);
+      EMIT(p, cbs, on_number_sign, byte);
+      jiffy_parser_number_byte(p, cbs, ptr);
+
+      break;
+    case '0':
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_LEADING_ZERO);
+      jiffy_parser_number_start(p, cbs);
+      jiffy_parser_number_byte(p, cbs, ptr);
+
+      break;
+    CASE_NONZERO_NUMBER
+      SWAP(p, PARSER_STATE_NUMBER_INT);
+      jiffy_parser_number_start(p, cbs);
+      jiffy_parser_number_byte(p, cbs, ptr);
+
+      break;
+    case '{':
+      SWAP(p, PARSER_STATE_OBJECT_START);
+      FIRE(p, cbs, on_object_start);
+      break;
+    case '[':
+      SWAP(p, PARSER_STATE_ARRAY_START);
+      FIRE(p, cbs, on_array_start);
+      break;
+    case '"':
+      SWAP(p, PARSER_STATE_STRING);
+      jiffy_parser_string_start(p, cbs);
+      break;
     default:
-      FAIL(p, JIFFY_ERR_BAD_UNICODE_ESCAPE);
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
     }
 
     break;
-  case PARSER_STATE_ARRAY_START:
+  case PARSER_STATE_LIT_N:
+    if (byte == 'u') {
+      SWAP(p, PARSER_STATE_LIT_NU);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_NU:
+    if (byte == 'l') {
+      SWAP(p, PARSER_STATE_LIT_NUL);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_NUL:
+    if (byte == 'l') {
+      FIRE(p, cbs, on_null);
+      POP(p, cbs);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_T:
+    if (byte == 'r') {
+      SWAP(p, PARSER_STATE_LIT_TR);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_TR:
+    if (byte == 'u') {
+      SWAP(p, PARSER_STATE_LIT_TRU);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_TRU:
+    if (byte == 'e') {
+      FIRE(p, cbs, on_true);
+      POP(p, cbs);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_F:
+    if (byte == 'a') {
+      SWAP(p, PARSER_STATE_LIT_FA);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_FA:
+    if (byte == 'l') {
+      SWAP(p, PARSER_STATE_LIT_FAL);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_FAL:
+    if (byte == 's') {
+      SWAP(p, PARSER_STATE_LIT_FALS);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_LIT_FALS:
+    if (byte == 'e') {
+      FIRE(p, cbs, on_false);
+      POP(p, cbs);
+    } else {
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_NUMBER_AFTER_SIGN:
     switch (byte) {
-    CASE_WHITESPACE
-      // ignore
+    case '0':
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_LEADING_ZERO);
+      jiffy_parser_number_byte(p, cbs, ptr);
       break;
-    case ']':
-      FIRE(p, on_array_end);
-      POP(p);
+    CASE_NONZERO_NUMBER
+      SWAP(p, PARSER_STATE_NUMBER_INT);
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_NUMBER_AFTER_LEADING_ZERO:
+    if (byte == '.') {
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_DOT);
+      FIRE(p, cbs, on_number_fraction);
+      jiffy_parser_number_byte(p, cbs, ptr);
+    } else if (byte == 'e' || byte == 'E') {
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_EXP);
+      FIRE(p, cbs, on_number_exponent);
+      jiffy_parser_number_byte(p, cbs, ptr);
+    } else {
+      jiffy_parser_end_number(p, cbs);
+      POP(p, cbs);
+      goto retry;
+    }
+
+    break;
+  case PARSER_STATE_NUMBER_INT:
+    switch (byte) {
+    CASE_NUMBER
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    case '.':
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_DOT);
+      FIRE(p, cbs, on_number_fraction);
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    case 'e':
+    case 'E':
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_EXP);
+      FIRE(p, cbs, on_number_exponent);
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    default:
+      jiffy_parser_end_number(p, cbs);
+      POP(p, cbs);
+      goto retry;
+    }
+
+    break;
+  case PARSER_STATE_NUMBER_AFTER_DOT:
+    switch (byte) {
+    CASE_NUMBER
+      SWAP(p, PARSER_STATE_NUMBER_FRAC);
+      jiffy_parser_number_byte(p, cbs, ptr);
+
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_NUMBER_FRAC:
+    switch (byte) {
+    CASE_NUMBER
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    case 'e':
+    case 'E':
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_EXP);
+      FIRE(p, cbs, on_number_exponent);
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    default:
+      jiffy_parser_end_number(p, cbs);
+      POP(p, cbs);
+      goto retry;
+    }
+
+    break;
+  case PARSER_STATE_NUMBER_AFTER_EXP:
+    switch (byte) {
+    case '+':
+    case '-':
+      SWAP(p, PARSER_STATE_NUMBER_AFTER_EXP_SIGN);
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    CASE_NUMBER
+      SWAP(p, PARSER_STATE_NUMBER_EXP_NUM);
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_NUMBER_AFTER_EXP_SIGN:
+    switch (byte) {
+    CASE_NUMBER
+      SWAP(p, PARSER_STATE_NUMBER_EXP_NUM);
+      jiffy_parser_number_byte(p, cbs, ptr);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    }
+
+    break;
+  case PARSER_STATE_NUMBER_EXP_NUM:
+    switch (byte) {
+    CASE_NUMBER
+      jiffy_parser_number_byte(p, cbs, ptr);
       break;
-    case ',':
-      FAIL(p, JIFFY_ERR_EXPECTED_ARRAY_ELEMENT);
     default:
-      PUSH(p, PARSER_STATE_ARRAY_ELEMENT);
-      PUSH(p, PARSER_STATE_VALUE);
-      FIRE(p, on_array_element_start);
+      jiffy_parser_end_number(p, cbs);
+      POP(p, cbs);
       goto retry;
     }
 
-    break;
-  case PARSER_STATE_ARRAY_ELEMENT:
-    switch (byte) {
-    CASE_WHITESPACE
-      // ignore
-      break;
-    case ']':
-      // end element
-      FIRE(p, on_array_element_end);
-      POP(p);
+    break;
+  case PARSER_STATE_STRING:
+    switch (byte) {
+    case '"':
+      jiffy_parser_flush_string(p, cbs);
+      if (jiffy_parser_utf8_is_pending(p)) {
+        FAIL(p, cbs, JIFFY_ERR_BAD_UTF8);
+      }
+
+      FIRE(p, cbs, on_string_end);
+      POP(p, cbs);
+      break;
+    case '\\':
+      jiffy_parser_flush_string(p, cbs);
+      if (jiffy_parser_utf8_is_pending(p)) {
+        FAIL(p, cbs, JIFFY_ERR_BAD_UTF8);
+      }
+
+      PUSH(p, cbs, PARSER_STATE_STRING_ESC);
+      break;
+    case 0:
+    case '\r':
+    case '\n':
+      jiffy_parser_flush_string(p, cbs);
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    default:
+      if (jiffy_parser_utf8_is_pending(p)) {
+        jiffy_parser_flush_string(p, cbs);
+        FAIL(p, cbs, JIFFY_ERR_BAD_UTF8);
+      }
+
+      jiffy_parser_string_span(p, ptr, 1);
+    }
+
+    break;
+  case PARSER_STATE_STRING_ESC:
+    switch (byte) {
+    case '\\':
+      jiffy_parser_emit_string_byte(p, cbs, '\\');
+      POP(p, cbs);
+      break;
+    case '/':
+      jiffy_parser_emit_string_byte(p, cbs, '/');
+      POP(p, cbs);
+      break;
+    case '\"':
+      jiffy_parser_emit_string_byte(p, cbs, '\"');
+      POP(p, cbs);
+      break;
+    case 'n':
+      jiffy_parser_emit_string_byte(p, cbs, '\n');
+      POP(p, cbs);
+      break;
+    case 'r':
+      jiffy_parser_emit_string_byte(p, cbs, '\r');
+      POP(p, cbs);
+      break;
+    case 't':
+      jiffy_parser_emit_string_byte(p, cbs, '\t');
+      POP(p, cbs);
+      break;
+    case 'v':
+      jiffy_parser_emit_string_byte(p, cbs, '\v');
+      POP(p, cbs);
+      break;
+    case 'f':
+      jiffy_parser_emit_string_byte(p, cbs, '\f');
+      POP(p, cbs);
+      break;
+    case 'b':
+      jiffy_parser_emit_string_byte(p, cbs, '\b');
+      POP(p, cbs);
+      break;
+    case 'u':
+      p->v_str.hex = 0;
+      SWAP(p, PARSER_STATE_STRING_UNICODE);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_ESCAPE);
+    }
+
+    break;
+  case PARSER_STATE_STRING_UNICODE:
+    switch (byte) {
+    CASE_HEX
+      p->v_str.hex = (p->v_str.hex << 4) + nibble(byte);
+      SWAP(p, PARSER_STATE_STRING_UNICODE_X);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_UNICODE_ESCAPE);
+    }
+
+    break;
+  case PARSER_STATE_STRING_UNICODE_X:
+    switch (byte) {
+    CASE_HEX
+      p->v_str.hex = (p->v_str.hex << 4) + nibble(byte);
+      SWAP(p, PARSER_STATE_STRING_UNICODE_XX);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_UNICODE_ESCAPE);
+    }
+
+    break;
+  case PARSER_STATE_STRING_UNICODE_XX:
+    switch (byte) {
+    CASE_HEX
+      p->v_str.hex = (p->v_str.hex << 4) + nibble(byte);
+      SWAP(p, PARSER_STATE_STRING_UNICODE_XXX);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_UNICODE_ESCAPE);
+    }
+
+    break;
+  case PARSER_STATE_STRING_UNICODE_XXX:
+    switch (byte) {
+    CASE_HEX
+      p->v_str.hex = (p->v_str.hex << 4) + nibble(byte);
+      if (!jiffy_parser_emit_utf8(p, cbs, p->v_str.hex)) {
+        FAIL(p, cbs, JIFFY_ERR_BAD_UNICODE_CODEPOINT);
+      }
+      POP(p, cbs);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_BAD_UNICODE_ESCAPE);
+    }
+
+    break;
+  case PARSER_STATE_ARRAY_START:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    case ']':
+      FIRE(p, cbs, on_array_end);
+      POP(p, cbs);
+      break;
+    case ',':
+      FAIL(p, cbs, JIFFY_ERR_EXPECTED_ARRAY_ELEMENT);
+    default:
+      if (!jiffy_parser_array_element_start(p, cbs)) {
+        return false;
+      }
+
+      goto retry;
+    }
+
+    break;
+  case PARSER_STATE_ARRAY_ELEMENT:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    case ']':
+      // end element
+      FIRE(p, cbs, on_array_element_end);
+      POP(p, cbs);
+
+      // end array
+      FIRE(p, cbs, on_array_end);
+      POP(p, cbs);
+
+      break;
+    case ',':
+      // end element
+      FIRE(p, cbs, on_array_element_end);
+
+      // start element
+      PUSH(p, cbs, PARSER_STATE_VALUE);
+      FIRE(p, cbs, on_array_element_start);
+
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_EXPECTED_COMMA_OR_ARRAY_END);
+    }
+
+    break;
+  case PARSER_STATE_OBJECT_START:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    case '}':
+      // end object
+      FIRE(p, cbs, on_object_end);
+      POP(p, cbs);
+
+      break;
+    case '"':
+      PUSH(p, cbs, PARSER_STATE_OBJECT_KEY);
+      PUSH(p, cbs, PARSER_STATE_STRING);
+      FIRE(p, cbs, on_object_key_start);
+      jiffy_parser_string_start(p, cbs);
+
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_EXPECTED_STRING_OR_OBJECT_END);
+    }
+
+    break;
+  case PARSER_STATE_OBJECT_KEY:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    case ':':
+      // swap before firing on_object_key_end so that the callback can
+      // call jiffy_parser_skip_value()
+      SWAP(p, PARSER_STATE_AFTER_OBJECT_KEY);
+      FIRE(p, cbs, on_object_key_end);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_EXPECTED_COLON);
+    }
+
+    break;
+  case PARSER_STATE_AFTER_OBJECT_KEY:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    default:
+      if (!jiffy_parser_object_value_start(p, cbs)) {
+        return false;
+      }
+
+      goto retry;
+    }
+
+    break;
+  case PARSER_STATE_AFTER_OBJECT_VALUE:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    case ',':
+      FIRE(p, cbs, on_object_value_end);
+      SWAP(p, PARSER_STATE_BEFORE_OBJECT_KEY);
+      break;
+    case '}':
+      FIRE(p, cbs, on_object_value_end);
+      POP(p, cbs);
+      FIRE(p, cbs, on_object_end);
+      POP(p, cbs);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_EXPECTED_COMMA_OR_OBJECT_END);
+    }
+
+    break;
+  case PARSER_STATE_BEFORE_OBJECT_KEY:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    case '"':
+      SWAP(p, PARSER_STATE_OBJECT_KEY);
+      PUSH(p, cbs, PARSER_STATE_STRING);
+      FIRE(p, cbs, on_object_key_start);
+      jiffy_parser_string_start(p, cbs);
+      break;
+    default:
+      FAIL(p, cbs, JIFFY_ERR_EXPECTED_OBJECT_KEY);
+    }
+
+    break;
+  case PARSER_STATE_SKIP_OBJECT_VALUE:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    default:
+      if (!jiffy_parser_object_value_start(p, cbs)) {
+        return false;
+      }
+
+      SWAP(p, PARSER_STATE_SKIP_VALUE);
+      goto retry;
+    }
+
+    break;
+  case PARSER_STATE_SKIP_VALUE:
+    switch (byte) {
+    CASE_WHITESPACE
+      // ignore
+      break;
+    case '"':
+      p->v_skip.depth = 0;
+      SWAP(p, PARSER_STATE_SKIP_STRING);
+      break;
+    case '[':
+    case '{':
+      p->v_skip.depth = 1;
+      SWAP(p, PARSER_STATE_SKIP_CONTAINER);
+      break;
+    case ']':
+    case '}':
+    case ',':
+    case ':':
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    default:
+      SWAP(p, PARSER_STATE_SKIP_SCALAR);
+    }
+
+    break;
+  case PARSER_STATE_SKIP_SCALAR:
+    switch (byte) {
+    CASE_WHITESPACE
+    case ',':
+    case ']':
+    case '}':
+      // end of value
+      POP(p, cbs);
+      goto retry;
+    case '"':
+    case '[':
+    case '{':
+    case ':':
+      FAIL(p, cbs, JIFFY_ERR_BAD_BYTE);
+    default:
+      // ignore
+      break;
+    }
+
+    break;
+  case PARSER_STATE_SKIP_STRING:
+    switch (byte) {
+    case '"':
+      if (p->v_skip.depth) {
+        SWAP(p, PARSER_STATE_SKIP_CONTAINER);
+      } else {
+        POP(p, cbs);
+      }
+
+      break;
+    case '\\':
+      SWAP(p, PARSER_STATE_SKIP_STRING_ESC);
+      break;
+    default:
+      // ignore
+      break;
+    }
+
+    break;
+  case PARSER_STATE_SKIP_STRING_ESC:
+    SWAP(p, PARSER_STATE_SKIP_STRING);
+    break;
+  case PARSER_STATE_SKIP_CONTAINER:
+    switch (byte) {
+    case '"':
+      SWAP(p, PARSER_STATE_SKIP_STRING);
+      break;
+    case '[':
+    case '{':
+      p->v_skip.depth++;
+      break;
+    case ']':
+    case '}':
+      if (!--p->v_skip.depth) {
+        POP(p, cbs);
+      }
+
+      break;
+    default:
+      // ignore
+      break;
+    }
+
+    break;
+  default:
+    FAIL(p, cbs, JIFFY_ERR_BAD_STATE);
+  }
+
+  // increment byte count
+  p->num_bytes++;
+
+  // return success
+  return true;
+}
+
+/**
+ * Load 4 bytes from the given pointer as a native-endian 32-bit word.
+ */
+static inline uint32_t
+load32(
+  const void * const ptr
+) {
+  uint32_t r;
+  memcpy(&r, ptr, sizeof(r));
+  return r;
+}
+
+/**
+ * Parse a complete literal (true, false, or null) at the start of the
+ * given buffer in a single step.  The buffer must contain at least 5
+ * bytes.
+ *
+ * Must only be called in the VALUE, ARRAY_START, and AFTER_OBJECT_KEY
+ * states.  Returns the number of bytes consumed, or zero if the buffer
+ * does not start with a literal or if an error occurred; the byte-wise
+ * states handle (or report) both of those cases.
+ */
+static inline size_t
+jiffy_parser_push_literal(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const uint8_t * const ptr
+) {
+  const uint32_t word = load32(ptr);
+  const bool is_true = (word == load32("true")),
+             is_null = (word == load32("null")),
+             is_false = (word == load32("fals")) && (ptr[4] == 'e');
+
+  if (!is_true && !is_null && !is_false) {
+    // not a literal
+    return 0;
+  }
+
+  switch (GET_STATE(p)) {
+  case PARSER_STATE_ARRAY_START:
+    if (!jiffy_parser_array_element_start(p, cbs)) {
+      return 0;
+    }
+
+    break;
+  case PARSER_STATE_AFTER_OBJECT_KEY:
+    if (!jiffy_parser_object_value_start(p, cbs)) {
+      return 0;
+    }
+
+    break;
+  default:
+    break;
+  }
+
+  if (GET_STATE(p) != PARSER_STATE_VALUE) {
+    // callback called jiffy_parser_skip_value(); let the byte-wise
+    // states skip the literal
+    return 0;
+  }
+
+  // fire literal callback at the last byte of the literal, like the
+  // byte-wise states do
+  const size_t len = is_false ? 5 : 4;
+  p->num_bytes += len - 1;
+  STATS_ADD(p, bytes.literal, len);
+
+  if (is_true) {
+    FIRE(p, cbs, on_true);
+  } else if (is_null) {
+    FIRE(p, cbs, on_null);
+  } else {
+    FIRE(p, cbs, on_false);
+  }
+
+  if (!jiffy_parser_pop_state(p, cbs)) {
+    return 0;
+  }
+
+  p->num_bytes++;
+  return len;
+}
+
+/**
+ * Skip run of whitespace at the start of the given buffer.  Returns the
+ * number of bytes skipped.
+ */
+static inline size_t
+jiffy_parser_skip_whitespace(
+  jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  const size_t run = jiffy_parser_scan_whitespace(ptr, len);
+  p->num_bytes += run;
+  STATS_ADD(p, bytes.whitespace, run);
+  return run;
+}
+
+/**
+ * Returns true if the parser is in tape mode and the tape does not have
+ * room for the events of another parsing step.
+ */
+static inline bool
+jiffy_parser_tape_is_full(
+  const jiffy_parser_t * const p
+) {
+  return p->tape && (p->tape->cap - p->tape->len < JIFFY_TAPE_MIN_FREE);
+}
+
+/**
+ * Append run of plain string bytes (see jiffy_parser_scan_string()) to
+ * the pending string span, validating it if UTF-8 validation is
+ * enabled.  Must only be called in the STRING state.
+ *
+ * Returns false if the run is not valid UTF-8.
+ */
+static inline bool
+jiffy_parser_push_string_run(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const uint8_t * const ptr,
+  const size_t run
+) {
+  if (p->flags & JIFFY_PARSER_FLAG_VALIDATE_UTF8) {
+    // validate run, check for error
+    const size_t valid = jiffy_parser_validate_utf8(p, ptr, run);
+
+    if (valid < run) {
+      // emit valid prefix, then fail at the first invalid byte
+      jiffy_parser_string_span(p, ptr, valid);
+      p->num_bytes += valid;
+      STATS_ADD(p, bytes.string, valid);
+      jiffy_parser_flush_string(p, cbs);
+      FAIL(p, cbs, JIFFY_ERR_BAD_UTF8);
+    }
+  }
+
+  jiffy_parser_string_span(p, ptr, run);
+  p->num_bytes += run;
+  STATS_ADD(p, bytes.string, run);
+  return true;
+}
+
+#ifdef JIFFY_PARSER_STATS
+/**
+ * Count a byte which is about to be parsed by jiffy_parser_push_byte()
+ * in the byte statistics, based on the current state and the byte.
+ */
+static void
+jiffy_parser_stats_count_byte(
+  jiffy_parser_t * const p,
+  const uint8_t byte
+) {
+  switch (GET_STATE(p)) {
+  case PARSER_STATE_STRING:
+  case PARSER_STATE_STRING_ESC:
+  case PARSER_STATE_STRING_UNICODE:
+  case PARSER_STATE_STRING_UNICODE_X:
+  case PARSER_STATE_STRING_UNICODE_XX:
+  case PARSER_STATE_STRING_UNICODE_XXX:
+    p->stats.bytes.string++;
+    return;
+  case PARSER_STATE_LIT_N:
+  case PARSER_STATE_LIT_NU:
+  case PARSER_STATE_LIT_NUL:
+  case PARSER_STATE_LIT_T:
+  case PARSER_STATE_LIT_TR:
+  case PARSER_STATE_LIT_TRU:
+  case PARSER_STATE_LIT_F:
+  case PARSER_STATE_LIT_FA:
+  case PARSER_STATE_LIT_FAL:
+  case PARSER_STATE_LIT_FALS:
+    p->stats.bytes.literal++;
+    return;
+  case PARSER_STATE_SKIP_OBJECT_VALUE:
+  case PARSER_STATE_SKIP_VALUE:
+    if (!is_whitespace(byte)) {
+      p->stats.bytes.skipped++;
+      return;
+    }
+
+    break;
+  case PARSER_STATE_SKIP_SCALAR:
+    switch (byte) {
+    CASE_WHITESPACE
+    case ',':
+    case ']':
+    case '}':
+      // byte which ends the skipped value; classify it below
+      break;
+    default:
+      p->stats.bytes.skipped++;
+      return;
+    }
+
+    break;
+  case PARSER_STATE_SKIP_STRING:
+  case PARSER_STATE_SKIP_STRING_ESC:
+  case PARSER_STATE_SKIP_CONTAINER:
+    p->stats.bytes.skipped++;
+    return;
+  case PARSER_STATE_NUMBER_AFTER_SIGN:
+  case PARSER_STATE_NUMBER_AFTER_LEADING_ZERO:
+  case PARSER_STATE_NUMBER_INT:
+  case PARSER_STATE_NUMBER_AFTER_DOT:
+  case PARSER_STATE_NUMBER_FRAC:
+  case PARSER_STATE_NUMBER_AFTER_EXP:
+  case PARSER_STATE_NUMBER_AFTER_EXP_SIGN:
+  case PARSER_STATE_NUMBER_EXP_NUM:
+    switch (byte) {
+    CASE_NUMBER
+    case '.':
+    case 'e':
+    case 'E':
+    case '+':
+    case '-':
+      p->stats.bytes.number++;
+      return;
+    default:
+      // byte which ends the number; classify it below
+      break;
+    }
+
+    break;
+  default:
+    break;
+  }
+
+  // classify byte at the start of a value or between values
+  switch (byte) {
+  CASE_WHITESPACE
+    p->stats.bytes.whitespace++;
+    break;
+  case '"':
+    p->stats.bytes.string++;
+    break;
+  CASE_NUMBER
+  case '-':
+    p->stats.bytes.number++;
+    break;
+  case 't':
+  case 'f':
+  case 'n':
+    p->stats.bytes.literal++;
+    break;
+  default:
+    p->stats.bytes.structural++;
+    break;
+  }
+}
+#endif // JIFFY_PARSER_STATS
+
+#ifdef JIFFY_PARSER_COMPUTED_GOTO
+// computed gotos and label addresses are GNU extensions
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wpedantic"
+
+/**
+ * Parse run of bytes with the given callbacks, without flushing the
+ * pending string or number span at the end of the run.  Used by
+ * jiffy_parser_push_cbs() and jiffy_parser_push_index_cbs().
+ *
+ * This is the computed goto engine.  The current state is held in a
+ * local variable across the whole run, and each byte is dispatched by
+ * jumping through a table of state labels and classified with a single
+ * lookup in JIFFY_BYTE_CLASSES.  Runs of whitespace, plain string bytes,
+ * digits, skipped bytes, and whole literals are consumed in place;
+ * every other byte goes through jiffy_parser_push_byte(), which makes
+ * all state transitions for both engines, so they fire identical
+ * callbacks.
+ *
+ * The cached state is only reloaded, and the stopped and tape checks
+ * only repeated, after a call which can fire callbacks.
+ *
+ * Note: GCC never inlines functions which contain computed gotos, so
+ * the callbacks are not inlined into this engine.
+ */
+static bool
+jiffy_parser_push_run(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const void * const ptr,
+  const size_t len
+) {
+  // state labels, indexed by parser state
+  static const void * const STATE_LABELS[] = {
+#define JIFFY_DEF_PARSER_STATE(a) &&STATE_##a
+JIFFY_PARSER_STATE_LIST
+#undef JIFFY_DEF_PARSER_STATE
+  };
+
+  const uint8_t * const buf = ptr;
+  jiffy_parser_state_t state;
+  uint8_t cls;
+  size_t i = 0;
+
+// classify the byte at i and jump to the label of the current state
+#define DISPATCH() do { \
+  if (i >= len) { \
+    return true; \
+  } \
+  cls = JIFFY_BYTE_CLASSES[buf[i]]; \
+  goto *STATE_LABELS[(state < PARSER_STATE_LAST) ? state : PARSER_STATE_LAST]; \
+} while (0)
+
+check:
+  if (i >= len) {
+    // return success
+    return true;
+  }
+
+  if (p->stopped) {
+    // stopped by callback; drop pending data, see jiffy_parser_stop()
+    p->span.len = 0;
+    return true;
+  }
+
+  if (jiffy_parser_tape_is_full(p)) {
+    // stop early, leave remaining bytes for next push
+    return true;
+  }
+
+  // reload state, which callbacks may have changed
+  state = GET_STATE(p);
+  DISPATCH();
+
+STATE_STRING:
+  if (!(cls & BYTE_CLASS_STRING_STOP)) {
+    // consume run of plain string bytes; fires no callbacks unless
+    // the run is not valid UTF-8
+    const size_t run = jiffy_parser_scan_string(buf + i, len - i);
+    if (!jiffy_parser_push_string_run(p, cbs, buf + i, run)) {
+      // return failure
+      return false;
+    }
+
+    i += run;
+    DISPATCH();
+  }
+
+  goto byte;
+
+STATE_SKIP_STRING:
+  if (!(cls & BYTE_CLASS_STRING_STOP)) {
+    // skip run of plain string bytes
+    const size_t run = jiffy_parser_scan_string(buf + i, len - i);
+    p->num_bytes += run;
+    STATS_ADD(p, bytes.skipped, run);
+    i += run;
+    DISPATCH();
+  }
+
+  goto byte;
+
+STATE_SKIP_CONTAINER:
+  if (!(cls & BYTE_CLASS_SKIP_STOP)) {
+    // skip run of bytes which are not quotes or brackets
+    const size_t run = jiffy_parser_scan_skip(buf + i, len - i);
+    p->num_bytes += run;
+    STATS_ADD(p, bytes.skipped, run);
+    i += run;
+    DISPATCH();
+  }
+
+  goto byte;
+
+STATE_NUMBER_INT:
+STATE_NUMBER_FRAC:
+STATE_NUMBER_EXP_NUM:
+  if (cls & BYTE_CLASS_DIGIT) {
+    // consume run of digits; on_number_byte may be fired
+    const size_t run = jiffy_parser_scan_digits(buf + i, len - i);
+    jiffy_parser_number_digits(p, cbs, buf + i, run);
+    p->num_bytes += run;
+    STATS_ADD(p, bytes.number, run);
+    i += run;
+    goto check;
+  }
+
+  goto byte;
+
+STATE_VALUE:
+STATE_ARRAY_START:
+STATE_AFTER_OBJECT_KEY:
+  if (cls & BYTE_CLASS_WHITESPACE) {
+    // skip run of whitespace
+    i += jiffy_parser_skip_whitespace(p, buf + i, len - i);
+    DISPATCH();
+  }
+
+  if ((cls & BYTE_CLASS_LITERAL) && len - i >= 5) {
+    // match whole literal
+    const size_t lit = jiffy_parser_push_literal(p, cbs, buf + i);
+
+    if (lit > 0) {
+      i += lit;
+      goto check;
+    }
+  }
+
+  goto byte;
+
+STATE_DONE:
+STATE_ARRAY_ELEMENT:
+STATE_OBJECT_START:
+STATE_OBJECT_KEY:
+STATE_AFTER_OBJECT_VALUE:
+STATE_BEFORE_OBJECT_KEY:
+STATE_SKIP_OBJECT_VALUE:
+STATE_SKIP_VALUE:
+  if (cls & BYTE_CLASS_WHITESPACE) {
+    // skip run of whitespace
+    i += jiffy_parser_skip_whitespace(p, buf + i, len - i);
+    DISPATCH();
+  }
+
+  goto byte;
+
+STATE_INIT:
+STATE_FAIL:
+STATE_BOM_UTF16_X:
+STATE_BOM_UTF8_X:
+STATE_BOM_UTF8_XX:
+STATE_LIT_N:
+STATE_LIT_NU:
+STATE_LIT_NUL:
+STATE_LIT_T:
+STATE_LIT_TR:
+STATE_LIT_TRU:
+STATE_LIT_F:
+STATE_LIT_FA:
+STATE_LIT_FAL:
+STATE_LIT_FALS:
+STATE_NUMBER_AFTER_SIGN:
+STATE_NUMBER_AFTER_LEADING_ZERO:
+STATE_NUMBER_AFTER_DOT:
+STATE_NUMBER_AFTER_EXP:
+STATE_NUMBER_AFTER_EXP_SIGN:
+STATE_STRING_ESC:
+STATE_STRING_UNICODE:
+STATE_STRING_UNICODE_X:
+STATE_STRING_UNICODE_XX:
+STATE_STRING_UNICODE_XXX:
+STATE_SKIP_SCALAR:
+STATE_SKIP_STRING_ESC:
+STATE_LAST:
+byte:
+#ifdef JIFFY_PARSER_STATS
+  jiffy_parser_stats_count_byte(p, buf[i]);
+#endif // JIFFY_PARSER_STATS
+
+  // parse byte, check for error
+  if (!jiffy_parser_push_byte(p, cbs, buf + i)) {
+    // return failure
+    return false;
+  }
+
+  i++;
+  goto check;
+#undef DISPATCH
+}
+
+#pragma GCC diagnostic pop
+#else
+/**
+ * Parse run of bytes with the given callbacks, without flushing the
+ * pending string or number span at the end of the run.  Used by
+ * jiffy_parser_push_cbs() and jiffy_parser_push_index_cbs().
+ */
+static inline bool
+jiffy_parser_push_run(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const void * const ptr,
+  const size_t len
+) {
+  const uint8_t * const buf = ptr;
+
+  for (size_t i = 0; i < len;) {
+    if (p->stopped) {
+      // stopped by callback; drop pending data, see jiffy_parser_stop()
+      p->span.len = 0;
+      return true;
+    }
+
+    if (jiffy_parser_tape_is_full(p)) {
+      // stop early, leave remaining bytes for next push
+      break;
+    }
+
+    switch (GET_STATE(p)) {
+    case PARSER_STATE_STRING:
+      {
+        // consume run of plain string bytes
+        const size_t run = jiffy_parser_scan_string(buf + i, len - i);
+
+        if (run > 0) {
+          if (!jiffy_parser_push_string_run(p, cbs, buf + i, run)) {
+            // return failure
+            return false;
+          }
+
+          i += run;
+          continue;
+        }
+      }
+
+      break;
+    case PARSER_STATE_SKIP_STRING:
+      {
+        // skip run of plain string bytes
+        const size_t run = jiffy_parser_scan_string(buf + i, len - i);
+
+        if (run > 0) {
+          p->num_bytes += run;
+          STATS_ADD(p, bytes.skipped, run);
+          i += run;
+          continue;
+        }
+      }
+
+      break;
+    case PARSER_STATE_SKIP_CONTAINER:
+      {
+        // skip run of bytes which are not quotes or brackets
+        const size_t run = jiffy_parser_scan_skip(buf + i, len - i);
+
+        if (run > 0) {
+          p->num_bytes += run;
+          STATS_ADD(p, bytes.skipped, run);
+          i += run;
+          continue;
+        }
+      }
+
+      break;
+    case PARSER_STATE_NUMBER_INT:
+    case PARSER_STATE_NUMBER_FRAC:
+    case PARSER_STATE_NUMBER_EXP_NUM:
+      {
+        // consume run of digits
+        const size_t run = jiffy_parser_scan_digits(buf + i, len - i);
+
+        if (run > 0) {
+          jiffy_parser_number_digits(p, cbs, buf + i, run);
+          p->num_bytes += run;
+          STATS_ADD(p, bytes.number, run);
+          i += run;
+          continue;
+        }
+      }
+
+      break;
+    case PARSER_STATE_VALUE:
+    case PARSER_STATE_ARRAY_START:
+    case PARSER_STATE_AFTER_OBJECT_KEY:
+      if (is_whitespace(buf[i])) {
+        // skip run of whitespace
+        i += jiffy_parser_skip_whitespace(p, buf + i, len - i);
+        continue;
+      }
+
+      if (is_literal_start(buf[i]) && len - i >= 5) {
+        // match whole literal
+        const size_t lit = jiffy_parser_push_literal(p, cbs, buf + i);
+
+        if (lit > 0) {
+          i += lit;
+          continue;
+        }
+      }
+
+      break;
+    case PARSER_STATE_DONE:
+    case PARSER_STATE_ARRAY_ELEMENT:
+    case PARSER_STATE_OBJECT_START:
+    case PARSER_STATE_OBJECT_KEY:
+    case PARSER_STATE_AFTER_OBJECT_VALUE:
+    case PARSER_STATE_BEFORE_OBJECT_KEY:
+    case PARSER_STATE_SKIP_OBJECT_VALUE:
+    case PARSER_STATE_SKIP_VALUE:
+      if (is_whitespace(buf[i])) {
+        // skip run of whitespace
+        i += jiffy_parser_skip_whitespace(p, buf + i, len - i);
+        continue;
+      }
+
+      break;
+    }
+
+#ifdef JIFFY_PARSER_STATS
+    jiffy_parser_stats_count_byte(p, buf[i]);
+#endif // JIFFY_PARSER_STATS
+
+    // parse byte, check for error
+    if (!jiffy_parser_push_byte(p, cbs, buf + i)) {
+      // return failure
+      return false;
+    }
+
+    i++;
+  }
+
+  // return success
+  return true;
+}
+#endif // JIFFY_PARSER_COMPUTED_GOTO
+
+/**
+ * Parse buffer of data with the given callbacks.
+ *
+ * This is the body of jiffy_parser_push().  The callbacks are passed
+ * separately from the parser so that parsers specialized for a constant
+ * callback structure can be stamped out with
+ * JIFFY_PARSER_DEF_SPECIALIZED().
+ */
+static inline bool
+jiffy_parser_push_cbs(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const void * const ptr,
+  const size_t len
+) {
+  if (!jiffy_parser_push_run(p, cbs, ptr, len)) {
+    // return failure
+    return false;
+  }
+
+  if (p->stopped) {
+    // stopped by callback on the last byte
+    p->span.len = 0;
+    return true;
+  }
+
+  // flush pending string or number data
+  jiffy_parser_flush(p, cbs);
+
+  // return success
+  return true;
+}
+
+// tape mode parser functions, specialized for the tape callbacks (see
+// TAPE_CBS, below)
+static bool jiffy_tape_parser_push(jiffy_parser_t *, const void *, size_t);
+static bool jiffy_tape_parser_push_index(jiffy_parser_t *, const jiffy_index_t *, const void *, size_t);
+static bool jiffy_tape_parser_fini(jiffy_parser_t *);
+
+bool
+jiffy_parser_push(
+  jiffy_parser_t * const p,
+  const void * const ptr,
+  const size_t len
+) {
+  if (p->tape) {
+    // tape mode
+    return jiffy_tape_parser_push(p, ptr, len);
+  }
+
+  STATS_ADD(p, num_pushes, 1);
+  return jiffy_parser_push_cbs(p, p->cbs, ptr, len);
+}
+
+/**
+ * Finish parsing with the given callbacks.  This is the body of
+ * jiffy_parser_fini(); see jiffy_parser_push_cbs().
+ */
+static inline bool
+jiffy_parser_fini_cbs(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  if (p->stopped) {
+    // stopped by callback; see jiffy_parser_stop()
+    return true;
+  }
+
+  if (jiffy_parser_tape_is_full(p)) {
+    // no room for final events
+    return false;
+  }
+
+  // push a single space; this will flush any pending numbers
+  static const uint8_t SPACE = ' ';
+  if (!jiffy_parser_push_byte(p, cbs, &SPACE)) {
+    return false;
+  }
+
+  // flush pending string data (unterminated string)
+  jiffy_parser_flush(p, cbs);
+
+  // check to see if parsing is done; in multi-document mode the parser
+  // returns to the init state at the end of each document
+  const jiffy_parser_state_t done_state = (p->flags & JIFFY_PARSER_FLAG_MULTI_DOCUMENT) ? PARSER_STATE_INIT : PARSER_STATE_DONE;
+  if (p->stack_pos || GET_STATE(p) != done_state) {
+    FAIL(p, cbs, JIFFY_ERR_NOT_DONE);
+  }
+
+  // return success
+  return true;
+}
+
+bool
+jiffy_parser_fini(
+  jiffy_parser_t * const p
+) {
+  if (p->tape) {
+    // tape mode
+    return jiffy_tape_parser_fini(p);
+  }
+
+  return jiffy_parser_fini_cbs(p, p->cbs);
+}
+
+bool
+jiffy_parse(
+  const jiffy_parser_cbs_t * const cbs,
+  jiffy_parser_state_t * const stack_ptr,
+  const size_t stack_len,
+  const void * const buf,
+  const size_t len,
+  void * const user_data
+) {
+  jiffy_parser_t p;
+
+  // init parser, check for error
+  if (!jiffy_parser_init(&p, cbs, stack_ptr, stack_len, user_data)) {
+    // return failure
+    return false;
+  }
+
+  // write data, check for error
+  if (!jiffy_parser_push(&p, buf, len)) {
+    // return failure
+    return false;
+  }
+
+  // finalize parser, check for error
+  if (!jiffy_parser_fini(&p)) {
+    // return failure
+    return false;
+  }
+
+  // return success
+  return true;
+}
+
+/**
+ * Read-only file mapping used by jiffy_parse_file() and the
+ * *_new_from_file() functions.
+ */
+typedef struct {
+  // file descriptor
+  int fd;
+
+  // size of file, in bytes
+  uint64_t size;
+
+  // number of bytes mapped at once (a multiple of the page size, unless
+  // the whole file fits in one window)
+  size_t window;
+} jiffy_file_t;
+
+/**
+ * Open the given file and pick the window size.  On failure, returns
+ * false and sets the error code; errno is preserved.
+ */
+static bool
+jiffy_file_open(
+  jiffy_file_t * const file,
+  const char * const path,
+  jiffy_err_t * const err
+) {
+  // open file, check for error
+  file->fd = path ? open(path, O_RDONLY | O_CLOEXEC) : -1;
+  if (file->fd < 0) {
+    *err = JIFFY_ERR_FILE_OPEN_FAILED;
+    return false;
+  }
+
+  // get file size, check for error
+  struct stat st;
+  if (fstat(file->fd, &st) || !S_ISREG(st.st_mode)) {
+    const int saved_errno = errno;
+    close(file->fd);
+    errno = saved_errno;
+    *err = JIFFY_ERR_FILE_STAT_FAILED;
+    return false;
+  }
+  file->size = st.st_size;
+
+  if (file->size <= JIFFY_FILE_MAP_MAX) {
+    // map whole file at once
+    file->window = file->size;
+  } else {
+    // map sliding window; mmap() offsets must be page-aligned
+    const long page_size = sysconf(_SC_PAGESIZE);
+    const size_t page = (page_size > 0) ? (size_t) page_size : 4096;
+    file->window = MAX(JIFFY_FILE_MAP_MAX / page, 1) * page;
+  }
+
+  // return success
+  return true;
+}
+
+static void
+jiffy_file_close(
+  const jiffy_file_t * const file
+) {
+  close(file->fd);
+}
+
+/**
+ * Map the given range of a file read-only and advise the kernel that
+ * it will be read sequentially.  Returns NULL on error.
+ */
+static const uint8_t *
+jiffy_file_map(
+  const jiffy_file_t * const file,
+  const uint64_t ofs,
+  const size_t len
+) {
+  void * const ptr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, file->fd, ofs);
+  if (ptr == MAP_FAILED) {
+    return NULL;
+  }
+
+  // advice is only a hint, so errors are ignored
+#ifdef MADV_SEQUENTIAL
+  madvise(ptr, len, MADV_SEQUENTIAL);
+#endif // MADV_SEQUENTIAL
+#ifdef MADV_HUGEPAGE
+  madvise(ptr, len, MADV_HUGEPAGE);
+#endif // MADV_HUGEPAGE
+
+  return ptr;
+}
+
+static void
+jiffy_file_unmap(
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  munmap((void*) ptr, len);
+}
+
+/**
+ * Push the contents of a file through the given push function, one
+ * window at a time.  Mapping errors are passed to the on_error callback
+ * of the given callback structure.
+ */
+static bool
+jiffy_file_push(
+  const jiffy_file_t * const file,
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  bool (*push)(jiffy_parser_t *, const void *, size_t)
+) {
+  for (uint64_t ofs = 0; ofs < file->size && !p->stopped; ofs += file->window) {
+    const size_t len = (file->size - ofs < file->window) ? file->size - ofs : file->window;
+
+    // map window, check for error
+    const uint8_t * const ptr = jiffy_file_map(file, ofs, len);
+    if (!ptr) {
+      FAIL(p, cbs, JIFFY_ERR_FILE_MMAP_FAILED);
+    }
+
+    // parse window, then unmap it
+    const bool ok = push(p, ptr, len);
+    jiffy_file_unmap(ptr, len);
+
+    if (!ok) {
+      // return failure
+      return false;
+    }
+  }
+
+  // return success
+  return true;
+}
+
+/**
+ * Build function for jiffy_file_build().  Called either with the whole
+ * file mapped at src and a NULL file, or with the file to push through
+ * a sliding window and a NULL src.
+ */
+typedef bool (*jiffy_file_build_fn_t)(
+  void *ctx,
+  const jiffy_file_t *file,
+  const void *src,
+  size_t len
+);
+
+/**
+ * Open the given file and pass it to the build function, mapped whole
+ * if it fits in one window.  Used by the *_new_from_file() functions.
+ *
+ * If the file cannot be opened or mapped, then this function sets the
+ * error code and returns false without calling the build function.
+ * Otherwise it returns the result of the build function and leaves the
+ * error code unchanged.
+ */
+static bool
+jiffy_file_build(
+  const char * const path,
+  const jiffy_file_build_fn_t build,
+  void * const ctx,
+  jiffy_err_t * const err
+) {
+  // open file, check for error
+  jiffy_file_t file;
+  if (!jiffy_file_open(&file, path, err)) {
+    return false;
+  }
+
+  bool r;
+  if (file.window == file.size && file.size > 0) {
+    // map whole file at once, check for error
+    const uint8_t * const ptr = jiffy_file_map(&file, 0, file.size);
+    if (!ptr) {
+      jiffy_file_close(&file);
+      *err = JIFFY_ERR_FILE_MMAP_FAILED;
+      return false;
+    }
+
+    r = build(ctx, NULL, ptr, file.size);
+    jiffy_file_unmap(ptr, file.size);
+  } else {
+    // map file through a sliding window
+    r = build(ctx, &file, NULL, 0);
+  }
+
+  // close file, return result
+  jiffy_file_close(&file);
+  return r;
+}
+
+bool
+jiffy_parse_file(
+  const jiffy_parser_cbs_t * const cbs,
+  jiffy_parser_state_t * const stack_ptr,
+  const size_t stack_len,
+  const char * const path,
+  void * const user_data
+) {
+  jiffy_parser_t p;
+
+  // init parser, check for error
+  if (!jiffy_parser_init(&p, cbs, stack_ptr, stack_len, user_data)) {
+    // return failure
+    return false;
+  }
+
+  // open file, check for error
+  jiffy_file_t file;
+  jiffy_err_t err;
+  if (!jiffy_file_open(&file, path, &err)) {
+    FAIL(&p, cbs, err);
+  }
+
+  // parse file, close it
+  const bool ok = jiffy_file_push(&file, &p, cbs, jiffy_parser_push);
+  jiffy_file_close(&file);
+
+  // finalize parser, return result
+  return ok && jiffy_parser_fini(&p);
+}
+
+bool
+jiffy_index_init(
+  jiffy_index_t * const index,
+  uint64_t * const ptr,
+  const size_t cap
+) {
+  // check for required parameters
+  if (!index || !ptr) {
+    // return failure
+    return false;
+  }
+
+  index->ptr = ptr;
+  index->cap = cap;
+  index->len = 0;
+
+  // return success
+  return true;
+}
+
+const uint64_t *
+jiffy_index_get_bits(
+  const jiffy_index_t * const index,
+  size_t * const r_len
+) {
+  if (r_len) {
+    *r_len = JIFFY_INDEX_NUM_WORDS(index->len);
+  }
+
+  return index->ptr;
+}
+
+/**
+ * Classified bytes of a 64 byte block.  Bit N of each mask is set if
+ * byte N of the block is in the given class.
+ */
+typedef struct {
+  // quotes
+  uint64_t quote;
+
+  // backslashes
+  uint64_t slash;
+
+  // structural characters ({, }, [, ], :, and ,)
+  uint64_t op;
+
+  // whitespace
+  uint64_t ws;
+} jiffy_index_block_t;
+
+#if defined(__AVX2__)
+/**
+ * Get mask of bytes in 64 byte block which are equal to the given
+ * byte.
+ */
+static inline uint64_t
+jiffy_index_eq(
+  const __m256i lo,
+  const __m256i hi,
+  const uint8_t byte
+) {
+  const __m256i v = _mm256_set1_epi8(byte);
+  const uint32_t lo_bits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, v)),
+                 hi_bits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, v));
+  return ((uint64_t) hi_bits << 32) | lo_bits;
+}
+
+static inline void
+jiffy_index_classify(
+  jiffy_index_block_t * const block,
+  const uint8_t * const ptr
+) {
+  const __m256i lo = _mm256_loadu_si256((const __m256i*) ptr),
+                hi = _mm256_loadu_si256((const __m256i*) (ptr + 32));
+
+  // fold '[' and ']' into '{' and '}'
+  const __m256i case_bit = _mm256_set1_epi8(0x20);
+  const __m256i lo_op = _mm256_or_si256(lo, case_bit),
+                hi_op = _mm256_or_si256(hi, case_bit);
+
+  block->quote = jiffy_index_eq(lo, hi, '"');
+  block->slash = jiffy_index_eq(lo, hi, '\\');
+  block->op = (
+    jiffy_index_eq(lo_op, hi_op, '{') |
+    jiffy_index_eq(lo_op, hi_op, '}') |
+    jiffy_index_eq(lo, hi, ':') |
+    jiffy_index_eq(lo, hi, ',')
+  );
+  block->ws = (
+    jiffy_index_eq(lo, hi, ' ') |
+    jiffy_index_eq(lo, hi, '\t') |
+    jiffy_index_eq(lo, hi, '\v') |
+    jiffy_index_eq(lo, hi, '\n') |
+    jiffy_index_eq(lo, hi, '\r')
+  );
+}
+#elif defined(__SSE2__)
+/**
+ * Get mask of bytes in 64 byte block which are equal to the given
+ * byte.
+ */
+static inline uint64_t
+jiffy_index_eq(
+  const __m128i * const vs,
+  const uint8_t byte
+) {
+  const __m128i v = _mm_set1_epi8(byte);
+  uint64_t r = 0;
+
+  for (size_t i = 0; i < 4; i++) {
+    const uint64_t bits = _mm_movemask_epi8(_mm_cmpeq_epi8(vs[i], v));
+    r |= bits << (16 * i);
+  }
+
+  return r;
+}
+
+static inline void
+jiffy_index_classify(
+  jiffy_index_block_t * const block,
+  const uint8_t * const ptr
+) {
+  const __m128i case_bit = _mm_set1_epi8(0x20);
+  __m128i vs[4], ops[4];
+
+  for (size_t i = 0; i < 4; i++) {
+    vs[i] = _mm_loadu_si128((const __m128i*) (ptr + 16 * i));
+
+    // fold '[' and ']' into '{' and '}'
+    ops[i] = _mm_or_si128(vs[i], case_bit);
+  }
+
+  block->quote = jiffy_index_eq(vs, '"');
+  block->slash = jiffy_index_eq(vs, '\\');
+  block->op = (
+    jiffy_index_eq(ops, '{') |
+    jiffy_index_eq(ops, '}') |
+    jiffy_index_eq(vs, ':') |
+    jiffy_index_eq(vs, ',')
+  );
+  block->ws = (
+    jiffy_index_eq(vs, ' ') |
+    jiffy_index_eq(vs, '\t') |
+    jiffy_index_eq(vs, '\v') |
+    jiffy_index_eq(vs, '\n') |
+    jiffy_index_eq(vs, '\r')
+  );
+}
+#else
+static inline void
+jiffy_index_classify(
+  jiffy_index_block_t * const block,
+  const uint8_t * const ptr
+) {
+  block->quote = 0;
+  block->slash = 0;
+  block->op = 0;
+  block->ws = 0;
+
+  for (size_t i = 0; i < 64; i++) {
+    const uint64_t bit = (uint64_t) 1 << i;
+
+    switch (ptr[i]) {
+    case '"':
+      block->quote |= bit;
+      break;
+    case '\\':
+      block->slash |= bit;
+      break;
+    case '{':
+    case '}':
+    case '[':
+    case ']':
+    case ':':
+    case ',':
+      block->op |= bit;
+      break;
+    CASE_WHITESPACE
+      block->ws |= bit;
+      break;
+    }
+  }
+}
+#endif // __AVX2__
+
+/**
+ * Get mask of bytes which are preceded by an odd-length run of
+ * backslashes (e.g., escaped bytes).
+ *
+ * The carry is set if the block ends with an odd-length run of
+ * backslashes (e.g., if the first byte of the next block is escaped).
+ */
+static inline uint64_t
+jiffy_index_find_escaped(
+  uint64_t slash,
+  uint64_t * const carry
+) {
+  const uint64_t EVEN_BITS = 0x5555555555555555ULL;
+
+  // an escaped backslash does not start an escape sequence
+  slash &= ~*carry;
+
+  const uint64_t follows_escape = (slash << 1) | *carry;
+
+  // get the start of runs of backslashes which begin on odd bits
+  const uint64_t odd_starts = slash & ~EVEN_BITS & ~follows_escape;
+
+  // add the odd starts to the backslashes; the carry flips the parity
+  // of each run, and the bit after the run is set
+  const uint64_t seqs = odd_starts + slash;
+  *carry = (seqs < odd_starts) ? 1 : 0;
+
+  // bits after runs which started on even bits
+  const uint64_t invert = seqs << 1;
+
+  return (EVEN_BITS ^ invert) & follows_escape;
+}
+
+/**
+ * Get the prefix XOR of the given mask (e.g., bit N of the result is
+ * the XOR of bits 0 through N of the given mask).
+ *
+ * Used to convert a mask of quotes to a mask of bytes inside of
+ * strings.
+ */
+static inline uint64_t
+jiffy_index_prefix_xor(
+  uint64_t mask
+) {
+#ifdef __PCLMUL__
+  // carry-less multiply by all ones
+  const __m128i r = _mm_clmulepi64_si128(
+    _mm_set_epi64x(0, mask),
+    _mm_set1_epi8(-1),
+    0
+  );
+
+  return _mm_cvtsi128_si64(r);
+#else
+  mask ^= mask << 1;
+  mask ^= mask << 2;
+  mask ^= mask << 4;
+  mask ^= mask << 8;
+  mask ^= mask << 16;
+  mask ^= mask << 32;
+  return mask;
+#endif // __PCLMUL__
+}
+
+bool
+jiffy_index_build(
+  jiffy_index_t * const index,
+  const void * const ptr,
+  const size_t len
+) {
+  const uint8_t * const src = ptr;
+
+  // carries between blocks
+  uint64_t escaped = 0, // last byte of previous block was an escape
+           in_str = 0, // all ones if last byte of previous block is in a string
+           sep = 1; // last byte of previous block was a separator
+
+  // check for overflow
+  if (index->cap < JIFFY_INDEX_NUM_WORDS(len)) {
+    // return failure
+    return false;
+  }
+
+  index->len = len;
+
+  for (size_t base = 0; base < len; base += 64) {
+    jiffy_index_block_t block;
+
+    if (len - base >= 64) {
+      jiffy_index_classify(&block, src + base);
+    } else {
+      // pad final block with whitespace
+      uint8_t tail[64];
+      memset(tail, ' ', sizeof(tail));
+      memcpy(tail, src + base, len - base);
+      jiffy_index_classify(&block, tail);
+    }
+
+    // get unescaped quotes
+    const uint64_t quotes = block.quote & ~jiffy_index_find_escaped(block.slash, &escaped);
+
+    // get bytes inside of strings (includes opening quotes, excludes
+    // closing quotes)
+    const uint64_t str = jiffy_index_prefix_xor(quotes) ^ in_str;
+    in_str = (str >> 63) ? ~(uint64_t) 0 : 0;
+
+    // get bytes which end the previous token
+    const uint64_t seps = block.op | block.ws | quotes;
+
+    // get first byte of every literal and number
+    const uint64_t starts = ~(seps | str) & ((seps << 1) | sep);
+    sep = seps >> 63;
+
+    // store indexed bytes
+    index->ptr[base / 64] = (block.op & ~str) | quotes | starts;
+  }
+
+  // return failure if the buffer ends inside of a string
+  return !in_str;
+}
+
+/**
+ * Returns true if the given byte is a structural character.
+ */
+static inline bool
+is_structural(
+  const uint8_t byte
+) {
+  switch (byte) {
+  case '{':
+  case '}':
+  case '[':
+  case ']':
+  case ':':
+  case ',':
+    return true;
+  default:
+    return false;
+  }
+}
+
+/**
+ * Returns true if jiffy_parser_push_index() should stop early, either
+ * because a callback stopped the parser (see jiffy_parser_stop()) or
+ * because the tape is full (see jiffy_parser_init_tape()).  Drops or
+ * flushes pending string data, like jiffy_parser_push() does.
+ */
+static inline bool
+jiffy_parser_index_stop(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs
+) {
+  if (p->stopped) {
+    p->span.len = 0;
+    return true;
+  }
+
+  if (jiffy_parser_tape_is_full(p)) {
+    jiffy_parser_flush(p, cbs);
+    return true;
+  }
+
+  return false;
+}
+
+/**
+ * Parse buffer using a structural index with the given callbacks.  This
+ * is the body of jiffy_parser_push_index(); see
+ * jiffy_parser_push_cbs().
+ *
+ * Structural characters and quotes are passed straight to
+ * jiffy_parser_push_byte(), and the whitespace between them is skipped
+ * without being examined.  String bodies end at the next indexed
+ * position, so bodies without escapes are appended as a single span.
+ * Literals and numbers are parsed by jiffy_parser_push_run() along
+ * with any whitespace up to the next indexed position, so that the
+ * parser sees where they end.
+ *
+ * Pending spans are only flushed at the end of the buffer, so the
+ * callbacks fired are the same as for a single jiffy_parser_push() of
+ * the whole buffer.
+ */
+static inline bool
+jiffy_parser_push_index_cbs(
+  jiffy_parser_t * const p,
+  const jiffy_parser_cbs_t * const cbs,
+  const jiffy_index_t * const index,
+  const void * const ptr,
+  const size_t len
+) {
+  const uint8_t * const buf = ptr;
+
+  // start of bytes which have not been parsed yet
+  size_t ofs = 0;
+
+  // what are the unparsed bytes?
+  enum { PENDING_WHITESPACE, PENDING_STRING, PENDING_TOKEN } pending = PENDING_WHITESPACE;
+
+  if (p->stopped) {
+    // stopped by callback; see jiffy_parser_stop()
+    return true;
+  }
+
+  const size_t num_words = JIFFY_INDEX_NUM_WORDS((len < index->len) ? len : index->len);
+  for (size_t w = 0; w < num_words; w++) {
+    for (uint64_t bits = index->ptr[w]; bits; bits &= bits - 1) {
+      const size_t pos = 64 * w + ctz64(bits);
+
+      if (jiffy_parser_index_stop(p, cbs)) {
+        // stop early
+        return true;
+      }
+
+      switch (pending) {
+      case PENDING_WHITESPACE:
+        if (GET_STATE(p) == PARSER_STATE_INIT) {
+          // leading whitespace moves the parser out of the initial
+          // state, so that a BOM after it is rejected
+          if (!jiffy_parser_push_run(p, cbs, buf + ofs, pos - ofs)) {
+            // return failure
+            return false;
+          }
+
+          break;
+        }
+
+        // skip whitespace up to this position
+        p->num_bytes += pos - ofs;
+        STATS_ADD(p, bytes.whitespace, pos - ofs);
+        break;
+      case PENDING_STRING:
+        // string body, up to the closing quote
+        if (pos > ofs) {
+          const size_t run = (GET_STATE(p) == PARSER_STATE_STRING) ? jiffy_parser_scan_string(buf + ofs, pos - ofs) : 0;
+
+          if (run == pos - ofs) {
+            // no escapes; append body as a single span
+            if (!jiffy_parser_push_string_run(p, cbs, buf + ofs, run)) {
+              // return failure
+              return false;
+            }
+          } else if (!jiffy_parser_push_run(p, cbs, buf + ofs, pos - ofs)) {
+            // return failure
+            return false;
+          }
+
+          if (jiffy_parser_index_stop(p, cbs)) {
+            // stop early
+            return true;
+          }
+        }
+
+        break;
+      case PENDING_TOKEN:
+        // literal or number, and trailing whitespace
+        if (!jiffy_parser_push_run(p, cbs, buf + ofs, pos - ofs)) {
+          // return failure
+          return false;
+        }
+
+        if (jiffy_parser_index_stop(p, cbs)) {
+          // stop early
+          return true;
+        }
+
+        break;
+      }
+
+      if (pending != PENDING_STRING && buf[pos] != '"' && !is_structural(buf[pos])) {
+        // start of literal or number; parse it with the bytes up to
+        // the next indexed position
+        ofs = pos;
+        pending = PENDING_TOKEN;
+        continue;
+      }
+
+#ifdef JIFFY_PARSER_STATS
+      jiffy_parser_stats_count_byte(p, buf[pos]);
+#endif // JIFFY_PARSER_STATS
+
+      // parse structural character or quote, check for error
+      if (!jiffy_parser_push_byte(p, cbs, buf + pos)) {
+        // return failure
+        return false;
+      }
+
+      // an opening quote is followed by the string body; everything
+      // else is followed by whitespace
+      pending = (pending != PENDING_STRING && buf[pos] == '"') ? PENDING_STRING : PENDING_WHITESPACE;
+      ofs = pos + 1;
+    }
+  }
+
+  if (jiffy_parser_index_stop(p, cbs)) {
+    // stop early
+    return true;
+  }
+
+  if (pending == PENDING_WHITESPACE && GET_STATE(p) != PARSER_STATE_INIT) {
+    // skip trailing whitespace
+    p->num_bytes += len - ofs;
+    STATS_ADD(p, bytes.whitespace, len - ofs);
+    return true;
+  }
+
+  // parse remaining bytes
+  return jiffy_parser_push_cbs(p, cbs, buf + ofs, len - ofs);
+}
+
+bool
+jiffy_parser_push_index(
+  jiffy_parser_t * const p,
+  const jiffy_index_t * const index,
+  const void * const ptr,
+  const size_t len
+) {
+  if (p->tape) {
+    // tape mode
+    return jiffy_tape_parser_push_index(p, index, ptr, len);
+  }
+
+  STATS_ADD(p, num_pushes, 1);
+  return jiffy_parser_push_index_cbs(p, p->cbs, index, ptr, len);
+}
+
+#ifdef __GNUC__
+// inline everything called by the function, so that constant callbacks
+// are propagated through the parser
+#define JIFFY_FLATTEN __attribute__((flatten))
+#else
+#define JIFFY_FLATTEN
+#endif // __GNUC__
+
+/**
+ * Define parser functions which are specialized for a constant callback
+ * structure:
+ *
+ * - NAME_push(): equivalent to jiffy_parser_push()
+ * - NAME_push_index(): equivalent to jiffy_parser_push_index()
+ * - NAME_fini(): equivalent to jiffy_parser_fini()
+ *
+ * The functions ignore the callbacks in the parser context and use the
+ * given callbacks instead, so tests for absent callbacks compile away
+ * and present callbacks can be inlined into the parser.  Initialize the
+ * parser with the same callbacks so that the other parser functions
+ * behave the same way.
+ */
+#define JIFFY_PARSER_DEF_SPECIALIZED(name, cbs) \
+  static inline JIFFY_FLATTEN bool \
+  name##_push( \
+    jiffy_parser_t * const p, \
+    const void * const ptr, \
+    const size_t len \
+  ) { \
+    STATS_ADD(p, num_pushes, 1); \
+    return jiffy_parser_push_cbs(p, (cbs), ptr, len); \
+  } \
+  \
+  static inline JIFFY_FLATTEN bool \
+  name##_push_index( \
+    jiffy_parser_t * const p, \
+    const jiffy_index_t * const index, \
+    const void * const ptr, \
+    const size_t len \
+  ) { \
+    STATS_ADD(p, num_pushes, 1); \
+    return jiffy_parser_push_index_cbs(p, (cbs), index, ptr, len); \
+  } \
+  \
+  static inline JIFFY_FLATTEN bool \
+  name##_fini( \
+    jiffy_parser_t * const p \
+  ) { \
+    return jiffy_parser_fini_cbs(p, (cbs)); \
+  }
+
+static const char *
+JIFFY_TAPE_EVENTS[] = {
+#define JIFFY_DEF_TAPE_EVENT(a, b) b
+JIFFY_TAPE_EVENT_LIST
+#undef JIFFY_DEF_TAPE_EVENT
+};
+
+const char *
+jiffy_tape_event_type_to_s(
+  const jiffy_tape_event_type_t type
+) {
+  const size_t ofs = (type < JIFFY_TAPE_EVENT_LAST) ? type : JIFFY_TAPE_EVENT_LAST;
+  return JIFFY_TAPE_EVENTS[ofs];
+}
+
+bool
+jiffy_tape_init(
+  jiffy_tape_t * const tape,
+  jiffy_tape_event_t * const ptr,
+  const size_t cap
+) {
+  // verify that the tape and event memory are non-null, and that there
+  // is room for at least one parsing step
+  if (!tape || !ptr || cap < JIFFY_TAPE_MIN_FREE) {
+    // return failure
+    return false;
+  }
+
+  tape->ptr = ptr;
+  tape->cap = cap;
+  tape->len = 0;
+  tape->depth = 0;
+  tape->ofs = 0;
+
+  // return success
+  return true;
+}
+
+const jiffy_tape_event_t *
+jiffy_tape_get_events(
+  const jiffy_tape_t * const tape,
+  size_t * const r_len
+) {
+  if (r_len) {
+    *r_len = tape->len;
+  }
+
+  return tape->ptr;
+}
+
+void
+jiffy_tape_clear(
+  jiffy_tape_t * const tape
+) {
+  tape->len = 0;
+}
+
+/**
+ * Append event to the tape of the given parser.
+ *
+ * jiffy_parser_push() stops while there are still JIFFY_TAPE_MIN_FREE
+ * free events, and a single parsing step appends at most 4 events, so
+ * the tape never overflows.  The bounds check is a safety net.
+ */
+static inline void
+jiffy_tape_append(
+  const jiffy_parser_t * const p,
+  const jiffy_tape_event_type_t type,
+  const size_t ofs,
+  const size_t len
+) {
+  jiffy_tape_t * const tape = p->tape;
+
+  if (tape->len < tape->cap) {
+    tape->ptr[tape->len++] = (jiffy_tape_event_t) {
+      .type   = type,
+      .depth  = tape->depth,
+      .ofs    = ofs,
+      .len    = len,
+    };
+  }
+}
+
+// define tape callback which appends an event for the given number of
+// bytes ending at the current byte
+#define DEF_TAPE_CB(name, type, len) \
+  static void \
+  on_tape_##name( \
+    const jiffy_parser_t * const p \
+  ) { \
+    jiffy_tape_append(p, JIFFY_TAPE_EVENT_##type, p->num_bytes + 1 - (len), (len)); \
+  }
+
+// define tape callback which appends a zero-length event at the
+// current byte
+#define DEF_TAPE_POS_CB(name, type) \
+  static void \
+  on_tape_##name( \
+    const jiffy_parser_t * const p \
+  ) { \
+    jiffy_tape_append(p, JIFFY_TAPE_EVENT_##type, p->num_bytes, 0); \
+  }
+
+DEF_TAPE_CB(utf8_bom, UTF8_BOM, 3)
+DEF_TAPE_CB(utf16_bom, UTF16_BOM, 2)
+DEF_TAPE_CB(null, NULL, 4)
+DEF_TAPE_CB(true, TRUE, 4)
+DEF_TAPE_CB(false, FALSE, 5)
+DEF_TAPE_POS_CB(array_element_start, ARRAY_ELEMENT_START)
+DEF_TAPE_POS_CB(array_element_end, ARRAY_ELEMENT_END)
+DEF_TAPE_POS_CB(object_key_start, OBJECT_KEY_START)
+DEF_TAPE_POS_CB(object_key_end, OBJECT_KEY_END)
+DEF_TAPE_POS_CB(object_value_start, OBJECT_VALUE_START)
+DEF_TAPE_POS_CB(object_value_end, OBJECT_VALUE_END)
+DEF_TAPE_POS_CB(document_end, DOCUMENT_END)
+
+#undef DEF_TAPE_CB
+#undef DEF_TAPE_POS_CB
+
+static void
+on_tape_array_start(
+  const jiffy_parser_t * const p
+) {
+  jiffy_tape_append(p, JIFFY_TAPE_EVENT_ARRAY_START, p->num_bytes, 1);
+  p->tape->depth++;
+}
+
+static void
+on_tape_array_end(
+  const jiffy_parser_t * const p
+) {
+  p->tape->depth--;
+  jiffy_tape_append(p, JIFFY_TAPE_EVENT_ARRAY_END, p->num_bytes, 1);
+}
+
+static void
+on_tape_object_start(
+  const jiffy_parser_t * const p
+) {
+  jiffy_tape_append(p, JIFFY_TAPE_EVENT_OBJECT_START, p->num_bytes, 1);
+  p->tape->depth++;
+}
+
+static void
+on_tape_object_end(
+  const jiffy_parser_t * const p
+) {
+  p->tape->depth--;
+  jiffy_tape_append(p, JIFFY_TAPE_EVENT_OBJECT_END, p->num_bytes, 1);
+}
+
+static void
+on_tape_string_start(
+  const jiffy_parser_t * const p
+) {
+  // save offset of opening quote
+  p->tape->ofs = p->num_bytes;
+}
+
+static void
+on_tape_string_end(
+  const jiffy_parser_t * const p
+) {
+  // string ends at closing quote
+  const size_t ofs = p->tape->ofs;
+  jiffy_tape_append(p, JIFFY_TAPE_EVENT_STRING, ofs, p->num_bytes + 1 - ofs);
+}
+
+static void
+on_tape_number_start(
+  const jiffy_parser_t * const p
+) {
+  // save offset of first byte
+  p->tape->ofs = p->num_bytes;
+}
+
+static void
+on_tape_number_end(
+  const jiffy_parser_t * const p
+) {
+  // number ends before current byte
+  const size_t ofs = p->tape->ofs;
+  jiffy_tape_append(p, JIFFY_TAPE_EVENT_NUMBER, ofs, p->num_bytes - ofs);
+}
+
+static void
+on_tape_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  jiffy_tape_append(p, JIFFY_TAPE_EVENT_ERROR, p->num_bytes, err);
+}
+
+/**
+ * Tape mode parser callbacks.
+ */
+static const jiffy_parser_cbs_t
+TAPE_CBS = {
+  .on_utf8_bom            = on_tape_utf8_bom,
+  .on_utf16_bom           = on_tape_utf16_bom,
+  .on_null                = on_tape_null,
+  .on_true                = on_tape_true,
+  .on_false               = on_tape_false,
+  .on_array_start         = on_tape_array_start,
+  .on_array_end           = on_tape_array_end,
+  .on_array_element_start = on_tape_array_element_start,
+  .on_array_element_end   = on_tape_array_element_end,
+  .on_object_start        = on_tape_object_start,
+  .on_object_end          = on_tape_object_end,
+  .on_object_key_start    = on_tape_object_key_start,
+  .on_object_key_end      = on_tape_object_key_end,
+  .on_object_value_start  = on_tape_object_value_start,
+  .on_object_value_end    = on_tape_object_value_end,
+  .on_string_start        = on_tape_string_start,
+  .on_string_end          = on_tape_string_end,
+  .on_number_start        = on_tape_number_start,
+  .on_number_end          = on_tape_number_end,
+  .on_document_end        = on_tape_document_end,
+  .on_error               = on_tape_error,
+};
+
+// tape mode parser; jiffy_parser_push(), jiffy_parser_push_index(),
+// and jiffy_parser_fini() dispatch here so that the tape callbacks are
+// inlined into the parser
+JIFFY_PARSER_DEF_SPECIALIZED(jiffy_tape_parser, &TAPE_CBS)
+
+bool
+jiffy_parser_init_tape(
+  jiffy_parser_t * const p,
+  jiffy_tape_t * const tape,
+  jiffy_parser_state_t * const stack_ptr,
+  const size_t stack_len,
+  void * const user_data
+) {
+  // check tape, init parser
+  if (!tape || !jiffy_parser_init(p, &TAPE_CBS, stack_ptr, stack_len, user_data)) {
+    // return failure
+    return false;
+  }
+
+  // clear tape
+  tape->len = 0;
+  tape->depth = 0;
+  tape->ofs = 0;
+
+  // attach tape
+  p->tape = tape;
+
+  // return success
+  return true;
+}
+
+/**
+ * Replay a string or number event by parsing the source text of the
+ * event with a temporary parser.  Returns false on error.
+ */
+static bool
+jiffy_tape_replay_value(
+  const jiffy_parser_cbs_t * const cbs,
+  const uint8_t * const src,
+  const jiffy_tape_event_t * const ev,
+  void * const user_data
+) {
+  // enough for the value, string escape, and unicode escape states
+  jiffy_parser_state_t stack[8];
+  jiffy_parser_t p;
+
+  if (!jiffy_parser_init(&p, cbs, stack, 8, user_data)) {
+    return false;
+  }
+
+  // report offsets relative to the original source
+  p.num_bytes = ev->ofs;
+
+  return (
+    jiffy_parser_push(&p, src + ev->ofs, ev->len) &&
+    jiffy_parser_fini(&p)
+  );
+}
+
+bool
+jiffy_tape_replay(
+  const jiffy_tape_t * const tape,
+  const jiffy_parser_cbs_t * const cbs,
+  const void * const ptr,
+  const size_t len,
+  void * const user_data
+) {
+  const uint8_t * const src = ptr;
+
+  // parser passed to structural callbacks
+  jiffy_parser_state_t stack[2];
+  jiffy_parser_t p;
+  if (!jiffy_parser_init(&p, cbs, stack, 2, user_data)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < tape->len; i++) {
+    const jiffy_tape_event_t * const ev = tape->ptr + i;
+
+    // callbacks for tokens fire at the last byte of the token
+    p.num_bytes = ev->ofs + (ev->len ? ev->len - 1 : 0);
+
+    switch (ev->type) {
+    case JIFFY_TAPE_EVENT_UTF8_BOM:
+      FIRE(&p, cbs, on_utf8_bom);
+      break;
+    case JIFFY_TAPE_EVENT_UTF16_BOM:
+      FIRE(&p, cbs, on_utf16_bom);
+      break;
+    case JIFFY_TAPE_EVENT_NULL:
+      FIRE(&p, cbs, on_null);
+      break;
+    case JIFFY_TAPE_EVENT_TRUE:
+      FIRE(&p, cbs, on_true);
+      break;
+    case JIFFY_TAPE_EVENT_FALSE:
+      FIRE(&p, cbs, on_false);
+      break;
+    case JIFFY_TAPE_EVENT_ARRAY_START:
+      FIRE(&p, cbs, on_array_start);
+      break;
+    case JIFFY_TAPE_EVENT_ARRAY_END:
+      FIRE(&p, cbs, on_array_end);
+      break;
+    case JIFFY_TAPE_EVENT_ARRAY_ELEMENT_START:
+      FIRE(&p, cbs, on_array_element_start);
+      break;
+    case JIFFY_TAPE_EVENT_ARRAY_ELEMENT_END:
+      FIRE(&p, cbs, on_array_element_end);
+      break;
+    case JIFFY_TAPE_EVENT_OBJECT_START:
+      FIRE(&p, cbs, on_object_start);
+      break;
+    case JIFFY_TAPE_EVENT_OBJECT_END:
+      FIRE(&p, cbs, on_object_end);
+      break;
+    case JIFFY_TAPE_EVENT_OBJECT_KEY_START:
+      FIRE(&p, cbs, on_object_key_start);
+      break;
+    case JIFFY_TAPE_EVENT_OBJECT_KEY_END:
+      FIRE(&p, cbs, on_object_key_end);
+      break;
+    case JIFFY_TAPE_EVENT_OBJECT_VALUE_START:
+      FIRE(&p, cbs, on_object_value_start);
+      break;
+    case JIFFY_TAPE_EVENT_OBJECT_VALUE_END:
+      FIRE(&p, cbs, on_object_value_end);
+      break;
+    case JIFFY_TAPE_EVENT_DOCUMENT_END:
+      FIRE(&p, cbs, on_document_end);
+      break;
+    case JIFFY_TAPE_EVENT_STRING:
+    case JIFFY_TAPE_EVENT_NUMBER:
+      // check bounds
+      if (ev->ofs > len || ev->len > len - ev->ofs) {
+        p.num_bytes = 0;
+        FAIL(&p, cbs, JIFFY_ERR_BAD_TAPE_EVENT);
+      }
+
+      if (!jiffy_tape_replay_value(cbs, src, ev, user_data)) {
+        // return failure
+        return false;
+      }
+
+      break;
+    case JIFFY_TAPE_EVENT_ERROR:
+      // error offsets are not tokens, and errors found by
+      // jiffy_parser_fini() are one past the end of the source, so
+      // error events are not bounds checked; the length field holds
+      // the error code
+      p.num_bytes = ev->ofs;
+      FAIL(&p, cbs, (jiffy_err_t) ev->len);
+    default:
+      FAIL(&p, cbs, JIFFY_ERR_BAD_TAPE_EVENT);
+    }
+  }
+
+  // return success
+  return true;
+}
+
+/**
+ * Compile a reference token.  Returns false if the token contains a
+ * bad escape sequence or is too long.
+ */
+static bool
+jiffy_filter_step_init(
+  jiffy_filter_step_t * const step,
+  const char * const ptr,
+  const size_t len
+) {
+  // check escape sequences, count decoded length
+  size_t key_len = 0;
+  for (size_t i = 0; i < len; i++, key_len++) {
+    if (ptr[i] == '~') {
+      if (i + 1 >= len || (ptr[i + 1] != '0' && ptr[i + 1] != '1')) {
+        // return failure
+        return false;
+      }
+
+      i++;
+    }
+  }
+
+  if (key_len > JIFFY_FILTER_MAX_KEY_LEN) {
+    // return failure
+    return false;
+  }
+
+  step->ptr = ptr;
+  step->len = len;
+  step->wildcard = (len == 1 && ptr[0] == '*');
+
+  // parse array index: decimal number without leading zeros, limited
+  // to 18 digits so that it cannot overflow
+  step->index = SIZE_MAX;
+  if (len > 0 && len < 19 && (len == 1 || ptr[0] != '0')) {
+    uint64_t val = 0;
+    size_t i = 0;
+
+    for (; i < len && ptr[i] >= '0' && ptr[i] <= '9'; i++) {
+      val = 10 * val + (ptr[i] - '0');
+    }
+
+    if (i == len && val < SIZE_MAX) {
+      step->index = val;
+    }
+  }
+
+  // return success
+  return true;
+}
+
+bool
+jiffy_filter_init(
+  jiffy_filter_t * const f,
+  const jiffy_parser_cbs_t * const cbs,
+  const char * const * const paths,
+  const size_t num_paths
+) {
+  // check filter, path array, and number of paths
+  if (!f || (!paths && num_paths) || num_paths > JIFFY_FILTER_MAX_PATHS) {
+    // return failure
+    return false;
+  }
+
+  size_t num_steps = 0;
+  for (size_t i = 0; i < num_paths; i++) {
+    const char * const path = paths[i];
+    if (!path || (path[0] && path[0] != '/')) {
+      // return failure
+      return false;
+    }
+
+    f->paths[i].ofs = num_steps;
+
+    // split path into reference tokens
+    for (const char *s = path; *s; ) {
+      const char * const ptr = s + 1;
+      const char * const end = strchr(ptr, '/');
+      const size_t len = end ? (size_t) (end - ptr) : strlen(ptr);
+
+      if (
+        num_steps >= JIFFY_FILTER_MAX_STEPS ||
+        num_steps - f->paths[i].ofs >= JIFFY_FILTER_MAX_DEPTH ||
+        !jiffy_filter_step_init(f->steps + num_steps, ptr, len)
+      ) {
+        // return failure
+        return false;
+      }
+
+      num_steps++;
+      s = ptr + len;
+    }
+
+    f->paths[i].len = num_steps - f->paths[i].ofs;
+  }
+
+  f->cbs = cbs;
+  f->num_paths = num_paths;
+
+  // return success
+  return true;
+}
+
+size_t
+jiffy_filter_get_match(
+  const jiffy_filter_t * const f
+) {
+  return f->match;
+}
+
+/**
+ * Reset the position of the given filter to the start of a document.
+ */
+static void
+jiffy_filter_reset(
+  jiffy_filter_t * const f
+) {
+  f->depth = 0;
+  f->pending = (f->num_paths < 64) ? ((1ULL << f->num_paths) - 1) : UINT64_MAX;
+  f->fwd = false;
+  f->fwd_depth = 0;
+  f->match = 0;
+  f->key_len = 0;
+  f->in_key = false;
+}
+
+/**
+ * Returns true if the given reference token matches the given object
+ * key.
+ */
+static bool
+jiffy_filter_step_match_key(
+  const jiffy_filter_step_t * const step,
+  const uint8_t * const key,
+  const size_t key_len
+) {
+  if (step->wildcard) {
+    return true;
+  }
+
+  // compare key against token, decoding "~0" and "~1"
+  size_t j = 0;
+  for (size_t i = 0; i < step->len; i++, j++) {
+    uint8_t byte = step->ptr[i];
+    if (byte == '~') {
+      byte = (step->ptr[++i] == '0') ? '~' : '/';
+    }
+
+    if (j >= key_len || key[j] != byte) {
+      return false;
+    }
+  }
+
+  return j == key_len;
+}
+
+/**
+ * Get the live paths whose reference token at the current depth matches
+ * the given object key (if key is non-NULL) or array index.
+ */
+static uint64_t
+jiffy_filter_match(
+  const jiffy_filter_t * const f,
+  const uint8_t * const key,
+  const size_t key_len,
+  const size_t index
+) {
+  const size_t ofs = f->depth - 1;
+  uint64_t r = 0;
+
+  for (uint64_t bits = f->live[f->depth]; bits; bits &= bits - 1) {
+    const size_t i = ctz64(bits);
+    const jiffy_filter_step_t * const step = f->steps + f->paths[i].ofs + ofs;
+
+    if (key ? jiffy_filter_step_match_key(step, key, key_len) : (step->wildcard || step->index == index)) {
+      r |= (1ULL << i);
+    }
+  }
+
+  return r;
+}
+
+/**
+ * Called at the start of a value.  Starts forwarding if the value
+ * matches a path, and enters arrays and objects which are on a path.
+ *
+ * Returns true if the value is forwarded.
+ */
+static bool
+jiffy_filter_value_start(
+  jiffy_filter_t * const f,
+  const bool is_container
+) {
+  if (f->fwd) {
+    // value inside of forwarded value
+    f->fwd_depth += is_container;
+    return true;
+  }
+
+  // find paths which end at this value
+  for (uint64_t bits = f->pending; bits; bits &= bits - 1) {
+    const size_t i = ctz64(bits);
+
+    if (f->paths[i].len == f->depth) {
+      // start forwarding
+      f->fwd = true;
+      f->fwd_depth = is_container;
+      f->match = i;
+      return true;
+    }
+  }
+
+  if (is_container) {
+    // enter array or object; only paths which are longer than the
+    // current depth remain in pending, so this cannot overflow
+    f->depth++;
+    f->live[f->depth] = f->pending;
+    f->index[f->depth] = 0;
+  }
+
+  return false;
+}
+
+/**
+ * Called at the end of a value.  Stops forwarding at the end of the
+ * forwarded value, and leaves arrays and objects which are on a path.
+ *
+ * Returns true if the value is forwarded.
+ */
+static bool
+jiffy_filter_value_end(
+  jiffy_filter_t * const f,
+  const bool is_container
+) {
+  if (f->fwd) {
+    f->fwd_depth -= is_container;
+    f->fwd = (f->fwd_depth > 0);
+    return true;
+  }
+
+  f->depth -= is_container;
+  return false;
+}
+
+// pass event on to user callback in filter mode, if it is non-NULL.
+// Unlike FIRE(), EMIT(), and EMIT_DATA(), these do not count the event
+// in the parser statistics, because the parser already counted it when
+// it invoked the filter mode parser callback.
+#define FORWARD(p, cbs, cb_name) do { \
+  if ((cbs) && (cbs)->cb_name) { \
+    (cbs)->cb_name(p); \
+  } \
+} while (0)
+
+#define FORWARD_VAL(p, cbs, cb_name, val) do { \
+  if ((cbs) && (cbs)->cb_name) { \
+    (cbs)->cb_name(p, (val)); \
+  } \
+} while (0)
+
+#define FORWARD_DATA(p, cbs, cb_name, ptr, len) do { \
+  if ((cbs) && (cbs)->cb_name) { \
+    (cbs)->cb_name(p, (ptr), (len)); \
+  } \
+} while (0)
+
+// define filter callback for the start of a value
+#define DEF_FILTER_START_CB(name, is_container) \
+  static void \
+  on_filter_##name( \
+    const jiffy_parser_t * const p \
+  ) { \
+    if (jiffy_filter_value_start(p->filter, (is_container))) { \
+      FORWARD(p, p->filter->cbs, on_##name); \
+    } \
+  }
+
+// define filter callback for the end of a value
+#define DEF_FILTER_END_CB(name, is_container) \
+  static void \
+  on_filter_##name( \
+    const jiffy_parser_t * const p \
+  ) { \
+    jiffy_filter_t * const f = p->filter; \
+    const jiffy_parser_cbs_t * const cbs = f->cbs; \
+    if (jiffy_filter_value_end(f, (is_container))) { \
+      FORWARD(p, cbs, on_##name); \
+    } \
+  }
+
+// define filter callback for the whole of a value
+#define DEF_FILTER_LITERAL_CB(name) \
+  static void \
+  on_filter_##name( \
+    const jiffy_parser_t * const p \
+  ) { \
+    jiffy_filter_t * const f = p->filter; \
+    if (jiffy_filter_value_start(f, false)) { \
+      jiffy_filter_value_end(f, false); \
+      FORWARD(p, f->cbs, on_##name); \
+    } \
+  }
+
+// define filter callback which is only fired inside of a forwarded
+// value
+#define DEF_FILTER_FWD_CB(name) \
+  static void \
+  on_filter_##name( \
+    const jiffy_parser_t * const p \
+  ) { \
+    if (p->filter->fwd) { \
+      FORWARD(p, p->filter->cbs, on_##name); \
+    } \
+  }
+
+// define filter callback with a value which is only fired inside of a
+// forwarded value
+#define DEF_FILTER_FWD_VAL_CB(name, type) \
+  static void \
+  on_filter_##name( \
+    const jiffy_parser_t * const p, \
+    const type val \
+  ) { \
+    if (p->filter->fwd) { \
+      FORWARD_VAL(p, p->filter->cbs, on_##name, val); \
+    } \
+  }
+
+DEF_FILTER_START_CB(array_start, true)
+DEF_FILTER_START_CB(object_start, true)
+DEF_FILTER_START_CB(number_start, false)
+DEF_FILTER_END_CB(array_end, true)
+DEF_FILTER_END_CB(object_end, true)
+DEF_FILTER_END_CB(number_end, false)
+DEF_FILTER_LITERAL_CB(null)
+DEF_FILTER_LITERAL_CB(true)
+DEF_FILTER_LITERAL_CB(false)
+DEF_FILTER_FWD_CB(array_element_end)
+DEF_FILTER_FWD_CB(object_value_start)
+DEF_FILTER_FWD_CB(object_value_end)
+DEF_FILTER_FWD_CB(number_fraction)
+DEF_FILTER_FWD_CB(number_exponent)
+DEF_FILTER_FWD_VAL_CB(number_byte, uint8_t)
+DEF_FILTER_FWD_VAL_CB(number_sign, uint8_t)
+DEF_FILTER_FWD_VAL_CB(number_int64, int64_t)
+DEF_FILTER_FWD_VAL_CB(number_uint64, uint64_t)
+DEF_FILTER_FWD_VAL_CB(number_double, double)
+
+static void
+on_filter_number_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  if (p->filter->fwd) {
+    FORWARD_DATA(p, p->filter->cbs, on_number_data, ptr, len);
+  }
+}
+
+#undef DEF_FILTER_START_CB
+#undef DEF_FILTER_END_CB
+#undef DEF_FILTER_LITERAL_CB
+#undef DEF_FILTER_FWD_CB
+#undef DEF_FILTER_FWD_VAL_CB
+
+static void
+on_filter_array_element_start(
+  const jiffy_parser_t * const p
+) {
+  jiffy_filter_t * const f = p->filter;
+
+  if (f->fwd) {
+    FORWARD(p, f->cbs, on_array_element_start);
+    return;
+  }
+
+  // match element index, skip element if no path matches
+  f->pending = jiffy_filter_match(f, NULL, 0, f->index[f->depth]++);
+  if (!f->pending) {
+    jiffy_parser_skip_value(p);
+  }
+}
+
+static void
+on_filter_object_key_start(
+  const jiffy_parser_t * const p
+) {
+  jiffy_filter_t * const f = p->filter;
+
+  if (f->fwd) {
+    FORWARD(p, f->cbs, on_object_key_start);
+    return;
+  }
+
+  // start collecting key
+  f->in_key = true;
+  f->key_len = 0;
+}
+
+static void
+on_filter_object_key_end(
+  const jiffy_parser_t * const p
+) {
+  jiffy_filter_t * const f = p->filter;
+
+  if (f->fwd) {
+    FORWARD(p, f->cbs, on_object_key_end);
+    return;
+  }
+
+  // match key, skip value if no path matches
+  f->in_key = false;
+  f->pending = (f->key_len <= JIFFY_FILTER_MAX_KEY_LEN) ? jiffy_filter_match(f, f->key, f->key_len, SIZE_MAX) : 0;
+  if (!f->pending) {
+    jiffy_parser_skip_value(p);
+  }
+}
+
+static void
+on_filter_string_start(
+  const jiffy_parser_t * const p
+) {
+  jiffy_filter_t * const f = p->filter;
+
+  if (f->in_key) {
+    // start of object key; handled by on_object_key_start
+    return;
+  }
+
+  if (jiffy_filter_value_start(f, false)) {
+    FORWARD(p, f->cbs, on_string_start);
+  }
+}
+
+static void
+on_filter_string_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  jiffy_filter_t * const f = p->filter;
+
+  if (f->fwd) {
+    // forward data; the parser only fires on_string_data for filters,
+    // so fire on_string_byte here, in the same order as the parser
+    const jiffy_parser_cbs_t * const cbs = f->cbs;
+    FORWARD_DATA(p, cbs, on_string_data, ptr, len);
+
+    if (cbs && cbs->on_string_byte) {
+      for (size_t i = 0; i < len; i++) {
+        cbs->on_string_byte(p, ptr[i]);
+      }
+    }
+  } else if (f->in_key) {
+    // append to key; keys which are too long are truncated, but
+    // key_len still grows so that they never match
+    if (f->key_len < JIFFY_FILTER_MAX_KEY_LEN) {
+      const size_t n = JIFFY_FILTER_MAX_KEY_LEN - f->key_len;
+      memcpy(f->key + f->key_len, ptr, (len < n) ? len : n);
+    }
+
+    f->key_len += len;
+  }
+}
+
+static void
+on_filter_string_end(
+  const jiffy_parser_t * const p
+) {
+  jiffy_filter_t * const f = p->filter;
+  const jiffy_parser_cbs_t * const cbs = f->cbs;
+
+  if (f->in_key) {
+    // end of object key; handled by on_object_key_end
+    return;
+  }
+
+  if (jiffy_filter_value_end(f, false)) {
+    FORWARD(p, cbs, on_string_end);
+  }
+}
+
+static void
+on_filter_document_end(
+  const jiffy_parser_t * const p
+) {
+  jiffy_filter_reset(p->filter);
+  FORWARD(p, p->filter->cbs, on_document_end);
+}
+
+static void
+on_filter_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  FORWARD_VAL(p, p->filter->cbs, on_error, err);
+}
+
+/**
+ * Filter mode parser callbacks.
+ *
+ * Note: on_string_byte is left out so that the parser only fires
+ * on_string_data; on_filter_string_data() fires both.
+ */
+static const jiffy_parser_cbs_t
+FILTER_CBS = {
+  .on_null                = on_filter_null,
+  .on_true                = on_filter_true,
+  .on_false               = on_filter_false,
+  .on_array_start         = on_filter_array_start,
+  .on_array_end           = on_filter_array_end,
+  .on_array_element_start = on_filter_array_element_start,
+  .on_array_element_end   = on_filter_array_element_end,
+  .on_object_start        = on_filter_object_start,
+  .on_object_end          = on_filter_object_end,
+  .on_object_key_start    = on_filter_object_key_start,
+  .on_object_key_end      = on_filter_object_key_end,
+  .on_object_value_start  = on_filter_object_value_start,
+  .on_object_value_end    = on_filter_object_value_end,
+  .on_string_start        = on_filter_string_start,
+  .on_string_data         = on_filter_string_data,
+  .on_string_end          = on_filter_string_end,
+  .on_number_start        = on_filter_number_start,
+  .on_number_byte         = on_filter_number_byte,
+  .on_number_data         = on_filter_number_data,
+  .on_number_end          = on_filter_number_end,
+  .on_number_sign         = on_filter_number_sign,
+  .on_number_fraction     = on_filter_number_fraction,
+  .on_number_exponent     = on_filter_number_exponent,
+  .on_number_int64        = on_filter_number_int64,
+  .on_number_uint64       = on_filter_number_uint64,
+  .on_number_double       = on_filter_number_double,
+  .on_document_end        = on_filter_document_end,
+  .on_error               = on_filter_error,
+};
+
+bool
+jiffy_parser_init_filter(
+  jiffy_parser_t * const p,
+  jiffy_filter_t * const f,
+  jiffy_parser_state_t * const stack_ptr,
+  const size_t stack_len,
+  void * const user_data
+) {
+  // check filter, init parser
+  if (!f || !jiffy_parser_init(p, &FILTER_CBS, stack_ptr, stack_len, user_data)) {
+    // return failure
+    return false;
+  }
+
+  // reset filter position
+  jiffy_filter_reset(f);
+
+  // attach filter
+  p->filter = f;
+
+  // return success
+  return true;
+}
+
+/**
+ * State shared by the workers of jiffy_parse_ndjson_parallel().
+ */
+typedef struct {
+  // options and source buffer
+  const jiffy_ndjson_opts_t *opts;
+  const uint8_t *src;
+  size_t len;
+  void *user_data;
+
+  // chunk size and stack size, with defaults applied
+  size_t chunk_size, stack_len;
+
+  // parse chunks into tapes?
+  bool use_tape;
+
+  // protects the fields below
+  pthread_mutex_t mutex;
+
+  // signalled when next_deliver or stop_at changes
+  pthread_cond_t cond;
+
+  // offset and number of the next unclaimed chunk
+  size_t next_ofs, next_num;
+
+  // number of the next chunk to deliver (ordered mode)
+  size_t next_deliver;
+
+  // number of the first failed chunk, or SIZE_MAX
+  size_t stop_at;
+
+  // did a worker fail to allocate memory?
+  bool alloc_failed;
+} jiffy_ndjson_ctx_t;
+
+/**
+ * Claim the next chunk.  Returns false if there are no chunks left, or
+ * if an earlier chunk failed.
+ */
+static bool
+jiffy_ndjson_claim(
+  jiffy_ndjson_ctx_t * const ctx,
+  jiffy_ndjson_chunk_t * const chunk
+) {
+  bool r = false;
+
+  pthread_mutex_lock(&ctx->mutex);
+
+  if (ctx->next_ofs < ctx->len && ctx->next_num <= ctx->stop_at) {
+    const size_t ofs = ctx->next_ofs;
+    size_t end = ctx->len;
+
+    if (ctx->len - ofs > ctx->chunk_size) {
+      // end chunk after the first newline past the chunk size
+      const uint8_t * const nl = memchr(ctx->src + ofs + ctx->chunk_size, '\n', ctx->len - ofs - ctx->chunk_size);
+      end = nl ? (size_t) (nl - ctx->src) + 1 : ctx->len;
+    }
+
+    chunk->num = ctx->next_num++;
+    chunk->ofs = ofs;
+    chunk->len = end - ofs;
+    ctx->next_ofs = end;
+    r = true;
+  }
+
+  pthread_mutex_unlock(&ctx->mutex);
+
+  return r;
+}
+
+/**
+ * Double the capacity of a worker tape.  Returns false if memory
+ * allocation fails.
+ */
+static bool
+jiffy_ndjson_tape_grow(
+  jiffy_tape_t * const tape
+) {
+  const size_t cap = 2 * tape->cap;
+  jiffy_tape_event_t * const ptr = realloc(tape->ptr, cap * sizeof(jiffy_tape_event_t));
+  if (!ptr) {
+    return false;
+  }
+
+  tape->ptr = ptr;
+  tape->cap = cap;
+  return true;
+}
+
+/**
+ * Parse a chunk into the worker tape, growing the tape as needed.
+ * Returns false on parse error or if memory allocation fails; sets
+ * alloc_failed in the latter case.
+ */
+static bool
+jiffy_ndjson_parse_tape(
+  const jiffy_ndjson_ctx_t * const ctx,
+  jiffy_tape_t * const tape,
+  jiffy_parser_state_t * const stack,
+  const jiffy_ndjson_chunk_t * const chunk,
+  bool * const alloc_failed
+) {
+  const size_t end = chunk->ofs + chunk->len;
+  jiffy_parser_t p;
+
+  if (!jiffy_parser_init_tape(&p, tape, stack, ctx->stack_len, ctx->user_data)) {
+    return false;
+  }
+
+  jiffy_parser_set_flags(&p, ctx->opts->parser_flags | JIFFY_PARSER_FLAG_MULTI_DOCUMENT);
+
+  // report offsets relative to the start of the source buffer
+  p.num_bytes = chunk->ofs;
+
+  // parse chunk; the parser stops early when the tape is full
+  while (p.num_bytes < end) {
+    if (!jiffy_parser_push(&p, ctx->src + p.num_bytes, end - p.num_bytes)) {
+      return false;
+    }
+
+    if (jiffy_parser_tape_is_full(&p) && !jiffy_ndjson_tape_grow(tape)) {
+      *alloc_failed = true;
+      return false;
+    }
+  }
+
+  // make room for final events
+  if (jiffy_parser_tape_is_full(&p) && !jiffy_ndjson_tape_grow(tape)) {
+    *alloc_failed = true;
+    return false;
+  }
+
+  return jiffy_parser_fini(&p);
+}
+
+/**
+ * Parse a chunk with the parser callbacks.  Returns false on error.
+ */
+static bool
+jiffy_ndjson_parse_cbs(
+  const jiffy_ndjson_ctx_t * const ctx,
+  jiffy_parser_state_t * const stack,
+  const jiffy_ndjson_chunk_t * const chunk
+) {
+  jiffy_parser_t p;
+
+  if (!jiffy_parser_init(&p, ctx->opts->cbs, stack, ctx->stack_len, ctx->user_data)) {
+    return false;
+  }
+
+  jiffy_parser_set_flags(&p, ctx->opts->parser_flags | JIFFY_PARSER_FLAG_MULTI_DOCUMENT);
+
+  // report offsets relative to the start of the source buffer
+  p.num_bytes = chunk->ofs;
+
+  return (
+    jiffy_parser_push(&p, ctx->src + chunk->ofs, chunk->len) &&
+    jiffy_parser_fini(&p)
+  );
+}
+
+/**
+ * Deliver a chunk which was parsed into a tape.
+ */
+static void
+jiffy_ndjson_deliver(
+  const jiffy_ndjson_ctx_t * const ctx,
+  const jiffy_ndjson_chunk_t * const chunk
+) {
+  if (ctx->opts->on_chunk) {
+    ctx->opts->on_chunk(chunk, ctx->user_data);
+  } else {
+    // replay fires on_error for tapes which end in an error
+    jiffy_tape_replay(chunk->tape, ctx->opts->cbs, ctx->src, ctx->len, ctx->user_data);
+  }
+}
+
+/**
+ * Worker thread for jiffy_parse_ndjson_parallel().
+ */
+static void *
+jiffy_ndjson_worker(
+  void * const arg
+) {
+  jiffy_ndjson_ctx_t * const ctx = arg;
+  jiffy_tape_t tape = { 0 };
+
+  // alloc state stack
+  jiffy_parser_state_t * const stack = malloc(ctx->stack_len * sizeof(jiffy_parser_state_t));
+  if (!stack) {
+    goto fail;
+  }
+
+  // alloc tape
+  if (ctx->use_tape) {
+    tape.cap = 1024;
+    tape.ptr = malloc(tape.cap * sizeof(jiffy_tape_event_t));
+    if (!tape.ptr) {
+      goto fail;
+    }
+  }
+
+  jiffy_ndjson_chunk_t chunk;
+  while (jiffy_ndjson_claim(ctx, &chunk)) {
+    bool ok, alloc_failed = false;
+    if (ctx->use_tape) {
+      ok = jiffy_ndjson_parse_tape(ctx, &tape, stack, &chunk, &alloc_failed);
+      chunk.tape = &tape;
+    } else {
+      ok = jiffy_ndjson_parse_cbs(ctx, stack, &chunk);
+      chunk.tape = NULL;
+    }
+
+    bool deliver = ctx->use_tape;
+    pthread_mutex_lock(&ctx->mutex);
+    if (!ok) {
+      // stop claiming chunks after this one
+      if (chunk.num < ctx->stop_at) {
+        ctx->stop_at = chunk.num;
+      }
+
+      ctx->alloc_failed |= alloc_failed;
+      pthread_cond_broadcast(&ctx->cond);
+    }
+
+    if (ctx->opts->ordered) {
+      // wait for earlier chunks, even if this chunk is skipped, so that
+      // next_deliver only advances in chunk order; skip chunks after a
+      // failed chunk
+      while (ctx->next_deliver != chunk.num) {
+        pthread_cond_wait(&ctx->cond, &ctx->mutex);
+      }
+
+      deliver = deliver && chunk.num <= ctx->stop_at;
+    }
+    pthread_mutex_unlock(&ctx->mutex);
+
+    if (deliver) {
+      jiffy_ndjson_deliver(ctx, &chunk);
+    }
+
+    if (ctx->opts->ordered) {
+      // let the next chunk through
+      pthread_mutex_lock(&ctx->mutex);
+      ctx->next_deliver++;
+      pthread_cond_broadcast(&ctx->cond);
+      pthread_mutex_unlock(&ctx->mutex);
+    }
+  }
+
+  free(tape.ptr);
+  free(stack);
+  return NULL;
+
+fail:
+  free(tape.ptr);
+  free(stack);
+
+  // stop the other workers
+  pthread_mutex_lock(&ctx->mutex);
+  ctx->alloc_failed = true;
+  ctx->stop_at = 0;
+  pthread_cond_broadcast(&ctx->cond);
+  pthread_mutex_unlock(&ctx->mutex);
+
+  return NULL;
+}
+
+bool
+jiffy_parse_ndjson_parallel(
+  const jiffy_ndjson_opts_t * const opts,
+  const void * const ptr,
+  const size_t len,
+  void * const user_data
+) {
+  // check options and buffer
+  if (!opts || !opts->num_threads || (!ptr && len > 0)) {
+    // return failure
+    return false;
+  }
+
+  jiffy_ndjson_ctx_t ctx = {
+    .opts         = opts,
+    .src          = ptr,
+    .len          = len,
+    .user_data    = user_data,
+    .chunk_size   = opts->chunk_size ? opts->chunk_size : JIFFY_NDJSON_DEFAULT_CHUNK_SIZE,
+    .stack_len    = opts->stack_len ? opts->stack_len : JIFFY_NDJSON_DEFAULT_STACK_LEN,
+    .use_tape     = opts->on_chunk || opts->ordered,
+    .stop_at      = SIZE_MAX,
+  };
+
+  if (pthread_mutex_init(&ctx.mutex, NULL)) {
+    return false;
+  }
+
+  if (pthread_cond_init(&ctx.cond, NULL)) {
+    pthread_mutex_destroy(&ctx.mutex);
+    return false;
+  }
+
+  // start workers; if thread creation fails, carry on with the workers
+  // which did start
+  pthread_t * const threads = malloc((opts->num_threads - 1) * sizeof(pthread_t));
+  size_t num_started = 0;
+  for (size_t i = 1; threads && i < opts->num_threads; i++) {
+    if (!pthread_create(threads + num_started, NULL, jiffy_ndjson_worker, &ctx)) {
+      num_started++;
+    }
+  }
+
+  // the calling thread is a worker too
+  jiffy_ndjson_worker(&ctx);
+
+  // wait for workers
+  for (size_t i = 0; i < num_started; i++) {
+    pthread_join(threads[i], NULL);
+  }
+  free(threads);
+
+  pthread_cond_destroy(&ctx.cond);
+  pthread_mutex_destroy(&ctx.mutex);
+
+  // return result
+  return ctx.stop_at == SIZE_MAX && !ctx.alloc_failed;
+}
+
+static const char *
+JIFFY_TYPES[] = {
+#define JIFFY_DEF_TYPE(a, b) b
+JIFFY_TYPE_LIST
+#undef JIFFY_DEF_TYPE
+};
+
+const char *
+jiffy_type_to_s(
+  const jiffy_type_t type
+) {
+  const size_t ofs = (type < JIFFY_TYPE_LAST) ? type : JIFFY_TYPE_LAST;
+  return JIFFY_TYPES[ofs];
+}
+
+jiffy_type_t
+jiffy_value_get_type(
+  const jiffy_value_t * const val
+) {
+  return val->type;
+}
+
+const uint8_t *
+jiffy_number_get_bytes(
+  const jiffy_value_t * const val,
+  size_t * const r_len
+) {
+  // value is a number
+  const bool is_valid = jiffy_value_get_type(val) == JIFFY_TYPE_NUMBER;
+
+  if (is_valid && r_len) {
+    *r_len = val->v_num.len;
+  }
+
+  return is_valid ? val->v_num.ptr : NULL;
+}
+
+/**
+ * Number value captured by jiffy_number_get_*().
+ */
+typedef struct {
+  bool found;
+  int64_t i64;
+  uint64_t u64;
+  double f64;
+} jiffy_number_value_t;
+
+static void
+on_number_value_int64(
+  const jiffy_parser_t * const p,
+  const int64_t val
+) {
+  jiffy_number_value_t * const r = jiffy_parser_get_user_data(p);
+  r->i64 = val;
+  r->found = true;
+}
+
+static void
+on_number_value_uint64(
+  const jiffy_parser_t * const p,
+  const uint64_t val
+) {
+  jiffy_number_value_t * const r = jiffy_parser_get_user_data(p);
+  r->u64 = val;
+  r->found = true;
+}
+
+static void
+on_number_value_double(
+  const jiffy_parser_t * const p,
+  const double val
+) {
+  jiffy_number_value_t * const r = jiffy_parser_get_user_data(p);
+  r->f64 = val;
+  r->found = true;
+}
+
+static const jiffy_parser_cbs_t
+NUMBER_INT64_CBS = {
+  .on_number_int64 = on_number_value_int64,
+};
+
+static const jiffy_parser_cbs_t
+NUMBER_UINT64_CBS = {
+  .on_number_uint64 = on_number_value_uint64,
+};
+
+static const jiffy_parser_cbs_t
+NUMBER_DOUBLE_CBS = {
+  .on_number_double = on_number_value_double,
+};
+
+/**
+ * Parse the text of the given number value with the given callbacks.
+ * Returns false if the value is not a number or if none of the
+ * callbacks fired.
+ */
+static bool
+jiffy_number_parse(
+  const jiffy_value_t * const val,
+  const jiffy_parser_cbs_t * const cbs,
+  jiffy_number_value_t * const r
+) {
+  if (jiffy_value_get_type(val) != JIFFY_TYPE_NUMBER) {
+    return false;
+  }
+
+  jiffy_parser_state_t stack[4];
+
+  r->found = false;
+  return jiffy_parse(cbs, stack, 4, val->v_num.ptr, val->v_num.len, r) && r->found;
+}
+
+bool
+jiffy_number_get_int64(
+  const jiffy_value_t * const val,
+  int64_t * const r_val
+) {
+  jiffy_number_value_t r;
+  if (!jiffy_number_parse(val, &NUMBER_INT64_CBS, &r)) {
+    return false;
+  }
+
+  if (r_val) {
+    *r_val = r.i64;
+  }
+
+  return true;
+}
+
+bool
+jiffy_number_get_uint64(
+  const jiffy_value_t * const val,
+  uint64_t * const r_val
+) {
+  jiffy_number_value_t r;
+  if (!jiffy_number_parse(val, &NUMBER_UINT64_CBS, &r)) {
+    return false;
+  }
+
+  if (r_val) {
+    *r_val = r.u64;
+  }
+
+  return true;
+}
+
+bool
+jiffy_number_get_double(
+  const jiffy_value_t * const val,
+  double * const r_val
+) {
+  jiffy_number_value_t r;
+  if (!jiffy_number_parse(val, &NUMBER_DOUBLE_CBS, &r)) {
+    return false;
+  }
+
+  if (r_val) {
+    *r_val = r.f64;
+  }
+
+  return true;
+}
+
+const uint8_t *
+jiffy_string_get_bytes(
+  const jiffy_value_t * const val,
+  size_t * const r_len
+) {
+  // value is a string
+  const bool is_valid = jiffy_value_get_type(val) == JIFFY_TYPE_STRING;
+
+  if (is_valid && r_len) {
+    *r_len = val->v_str.len;
+  }
+
+  return is_valid ? val->v_str.ptr : NULL;
+}
+
+size_t
+jiffy_array_get_size(
+  const jiffy_value_t * const val
+) {
+  return val->v_ary.len;
+}
+
+#define ARY_NTH_VAL(ary, ofs) ((ary)->v_ary.vals + (ofs))
+
+const jiffy_value_t *
+jiffy_array_unsafe_get_nth(
+  const jiffy_value_t * const val,
+  const size_t ofs
+) {
+  return ARY_NTH_VAL(val, ofs);
+}
+
+const jiffy_value_t *
+jiffy_array_get_nth(
+  const jiffy_value_t * const val,
+  const size_t ofs
+) {
+  const bool is_valid = (
+    // value is an array
+    (jiffy_value_get_type(val) == JIFFY_TYPE_ARRAY) &&
+
+    // offset is in bounds
+    (ofs < val->v_ary.len)
+  );
+
+  return is_valid ? ARY_NTH_VAL(val, ofs) : NULL;
+}
+
+bool
+jiffy_array_each(
+  const jiffy_value_t * const ary,
+  void (*each_cb)(const size_t, const jiffy_value_t *, void *),
+  void * const user_data
+) {
+  if (jiffy_value_get_type(ary) != JIFFY_TYPE_ARRAY) {
+    // return failure
+    return false;
+  }
+
+  if (each_cb) {
+    for (size_t i = 0; i < jiffy_array_get_size(ary); i++) {
+      each_cb(i, ARY_NTH_VAL(ary, i), user_data);
+    }
+  }
+
+  // return success
+  return true;
+}
+
+size_t
+jiffy_object_get_size(
+  const jiffy_value_t * const val
+) {
+  return val->v_obj.len;
+}
+
+#define OBJ_NTH_KEY(obj, ofs) ((obj)->v_obj.vals + 2 * (ofs))
+#define OBJ_NTH_VAL(obj, ofs) ((obj)->v_obj.vals + 2 * (ofs) + 1)
+
+const jiffy_value_t *
+jiffy_object_unsafe_get_nth_key(
+  const jiffy_value_t * const val,
+  const size_t ofs
+) {
+  return OBJ_NTH_KEY(val, ofs);
+}
+
+const jiffy_value_t *
+jiffy_object_get_nth_key(
+  const jiffy_value_t * const val,
+  const size_t ofs
+) {
+  const bool is_valid = (
+    // value is an object
+    (jiffy_value_get_type(val) == JIFFY_TYPE_OBJECT) &&
+
+    // offset is in bounds
+    (ofs < val->v_obj.len)
+  );
+
+  return is_valid ? OBJ_NTH_KEY(val, ofs) : NULL;
+}
+
+const jiffy_value_t *
+jiffy_object_unsafe_get_nth_value(
+  const jiffy_value_t * const val,
+  const size_t ofs
+) {
+  return OBJ_NTH_VAL(val, ofs);
+}
+
+const jiffy_value_t *
+jiffy_object_get_nth_value(
+  const jiffy_value_t * const val,
+  const size_t ofs
+) {
+  const bool is_valid = (
+    // value is an object
+    (jiffy_value_get_type(val) == JIFFY_TYPE_OBJECT) &&
+
+    // offset is in bounds
+    (ofs < val->v_obj.len)
+  );
+
+  return is_valid ? OBJ_NTH_VAL(val, ofs) : NULL;
+}
+
+bool
+jiffy_object_each(
+  const jiffy_value_t * const obj,
+  void (*each_cb)(const jiffy_value_t *, const jiffy_value_t *, void *),
+  void * const user_data
+) {
+  if (jiffy_value_get_type(obj) != JIFFY_TYPE_OBJECT) {
+    // return failure
+    return false;
+  }
+
+  if (each_cb) {
+    for (size_t i = 0; i < jiffy_object_get_size(obj); i++) {
+      each_cb(
+        OBJ_NTH_KEY(obj, i),
+        OBJ_NTH_VAL(obj, i),
+        user_data
+      );
+    }
+  }
+
+  // return success
+  return true;
+}
+
+static void *
+jiffy_tree_data_malloc(
+  const jiffy_tree_t * const tree,
+  const size_t num_bytes
+) {
+  if (tree->cbs && tree->cbs->malloc) {
+    return tree->cbs->malloc(num_bytes, tree->user_data);
+  } else {
+    return malloc(num_bytes);
+  }
+}
+
+static void
+jiffy_tree_data_free(
+  const jiffy_tree_t * const tree,
+  void * const ptr
+) {
+  if (tree->cbs && tree->cbs->free) {
+    tree->cbs->free(ptr, tree->user_data);
+  } else {
+    free(ptr);
+  }
+}
+
+/**
+ * Allocator adapter, so that the tree parser, its chunk lists, and its
+ * state stack can use the malloc and free callbacks of a flat or
+ * compact tree.
+ *
+ * Initialize with jiffy_tree_alloc_init(), and do not copy it
+ * afterwards, since the tree points at the callbacks.
+ */
+typedef struct {
+  jiffy_tree_cbs_t cbs;
+  jiffy_tree_t tree;
+} jiffy_tree_alloc_t;
+
+static void
+jiffy_tree_alloc_init(
+  jiffy_tree_alloc_t * const alloc,
+  void *(* const malloc_cb)(const size_t, void * const),
+  void (* const free_cb)(void * const, void * const),
+  void * const user_data
+) {
+  alloc->cbs = (jiffy_tree_cbs_t) {
+    .malloc = malloc_cb,
+    .free   = free_cb,
+  };
+
+  alloc->tree = (jiffy_tree_t) {
+    .cbs        = &alloc->cbs,
+    .user_data  = user_data,
+  };
+}
+
+/**
+ * Initial number of entries in the state stack of jiffy_tree_new().
+ */
+#define TREE_STACK_LEN 64
+
+/**
+ * Minimum and maximum size of the chunks used by the tree parser, in
+ * bytes.  Each chunk of a list is twice the size of the previous one,
+ * up to the maximum.
+ */
+#define TREE_CHUNK_MIN_SIZE 4096
+#define TREE_CHUNK_MAX_SIZE (64 << 20)
+
+/**
+ * State stack of the tree parser.
+ *
+ * If grow is set, then the parser grows the stack on demand with the
+ * tree allocator (see jiffy_tree_stack_resize()).
+ */
+typedef struct {
+  // tree (used to allocate memory)
+  const jiffy_tree_t *tree;
+
+  // stack memory
+  jiffy_parser_state_t *ptr;
+
+  // number of entries in stack memory
+  size_t len;
+
+  // can the stack grow?
+  bool grow;
+
+  // was the stack memory allocated with the tree allocator?
+  bool owned;
+} jiffy_tree_stack_t;
+
+// forward declaration
+typedef struct jiffy_tree_chunk_t_ jiffy_tree_chunk_t;
+
+/**
+ * Chunk of memory used while parsing a tree.
+ */
+struct jiffy_tree_chunk_t_ {
+  // next chunk in list
+  jiffy_tree_chunk_t *next;
+
+  // number of bytes used and allocated
+  size_t len, cap;
+
+  // chunk data
+  uint8_t data[];
+};
+
+/**
+ * List of chunks used while parsing a tree.
+ *
+ * Chunks are never moved or resized, so pointers into a chunk list
+ * stay valid while the list grows.  The contents of each list are
+ * compacted into the tree once the whole document has been parsed.
+ */
+typedef struct {
+  // first and last chunk
+  jiffy_tree_chunk_t *head, *tail;
+
+  // total number of bytes used
+  size_t len;
+} jiffy_tree_chunks_t;
+
+/**
+ * Value recorded while parsing a tree.  Converted to a jiffy_value_t
+ * when the tree is compacted.
+ */
+typedef struct jiffy_tree_parse_val_t_ {
+  // value type
+  jiffy_type_t type;
+
+  // offset of byte data (numbers and strings)
+  size_t ofs;
+
+  // number of bytes (numbers and strings) or children (arrays and
+  // objects; object keys and values are counted separately)
+  size_t len;
+
+  // enclosing array or object (NULL for the root value)
+  struct jiffy_tree_parse_val_t_ *parent;
+} jiffy_tree_parse_val_t;
+
+/**
+ * Initial number of entries in the container stack of the tree parser.
+ */
+#define TREE_CONTAINERS_MIN_LEN 64
+
+typedef struct {
+  // output tree
+  jiffy_tree_t *tree;
+
+  // state stack
+  jiffy_tree_stack_t *stack;
+
+  // values (jiffy_tree_parse_val_t)
+  jiffy_tree_chunks_t vals;
+
+  // number of values, and most recently added value
+  size_t num_vals;
+  jiffy_tree_parse_val_t *last_val;
+
+  // byte data of numbers and strings
+  jiffy_tree_chunks_t bytes;
+
+  // stack of open arrays and objects.  Grows by doubling, since it only
+  // grows with the nesting depth.
+  jiffy_tree_parse_val_t **containers;
+  size_t containers_len, containers_cap;
+
+  jiffy_err_t err;
+} jiffy_tree_parse_data_t;
+
+/**
+ * Resize the state stack of the tree parser.
+ *
+ * The tree allocator has no realloc(), so this allocates new memory,
+ * copies the old stack, and frees the old memory.  The new memory is
+ * saved in the tree stack so that jiffy_tree_new() can free it.
+ */
+static void *
+jiffy_tree_stack_resize(
+  jiffy_tree_stack_t * const stack,
+  void * const ptr,
+  const size_t num_bytes
+) {
+  jiffy_parser_state_t *new_ptr = NULL;
+
+  if (num_bytes > 0) {
+    // alloc new stack, check for error
+    new_ptr = jiffy_tree_data_malloc(stack->tree, num_bytes);
+    if (!new_ptr) {
+      return NULL;
+    }
+
+    if (ptr) {
+      // copy old stack
+      memcpy(new_ptr, ptr, stack->len * sizeof(jiffy_parser_state_t));
+    }
+  }
+
+  if (ptr) {
+    // free old stack
+    jiffy_tree_data_free(stack->tree, ptr);
+  }
+
+  stack->ptr = new_ptr;
+  stack->len = num_bytes / sizeof(jiffy_parser_state_t);
+  stack->owned = (new_ptr != NULL);
+
+  return new_ptr;
+}
+
+/**
+ * Stack reallocation callback for the tree parser.
+ */
+static void *
+jiffy_tree_stack_realloc(
+  void * const ptr,
+  const size_t num_bytes,
+  void * const user_data
+) {
+  jiffy_tree_parse_data_t * const data = user_data;
+  return jiffy_tree_stack_resize(data->stack, ptr, num_bytes);
+}
+
+/**
+ * Add a chunk with room for at least the given number of bytes to the
+ * end of a chunk list.  Returns false if memory could not be allocated.
+ */
+static bool
+jiffy_tree_chunks_grow(
+  const jiffy_tree_t * const tree,
+  jiffy_tree_chunks_t * const chunks,
+  const size_t num_bytes
+) {
+  // get size of new chunk, check for overflow
+  size_t cap = chunks->tail ? 2 * chunks->tail->cap : TREE_CHUNK_MIN_SIZE;
+  if (cap > TREE_CHUNK_MAX_SIZE) {
+    cap = TREE_CHUNK_MAX_SIZE;
+  }
+  cap = MAX(cap, num_bytes);
+  if (cap > SIZE_MAX - sizeof(jiffy_tree_chunk_t)) {
+    return false;
+  }
+
+  // alloc chunk, check for error
+  jiffy_tree_chunk_t * const chunk = jiffy_tree_data_malloc(tree, sizeof(jiffy_tree_chunk_t) + cap);
+  if (!chunk) {
+    return false;
+  }
+
+  chunk->next = NULL;
+  chunk->len = 0;
+  chunk->cap = cap;
+
+  // append chunk to list
+  if (chunks->tail) {
+    chunks->tail->next = chunk;
+  } else {
+    chunks->head = chunk;
+  }
+  chunks->tail = chunk;
+
+  // return success
+  return true;
+}
+
+static void
+jiffy_tree_chunks_free(
+  const jiffy_tree_t * const tree,
+  jiffy_tree_chunks_t * const chunks
+) {
+  jiffy_tree_chunk_t *chunk = chunks->head;
+  while (chunk) {
+    jiffy_tree_chunk_t * const next = chunk->next;
+    jiffy_tree_data_free(tree, chunk);
+    chunk = next;
+  }
+
+  chunks->head = NULL;
+  chunks->tail = NULL;
+  chunks->len = 0;
+}
+
+/**
+ * Append the given number of bytes to a chunk list, and return a
+ * pointer to them.  The bytes are always contiguous.
+ *
+ * Returns NULL if memory could not be allocated.
+ */
+static inline void *
+jiffy_tree_chunks_append(
+  const jiffy_tree_t * const tree,
+  jiffy_tree_chunks_t * const chunks,
+  const size_t num_bytes
+) {
+  jiffy_tree_chunk_t *tail = chunks->tail;
+  if (!tail || tail->cap - tail->len < num_bytes) {
+    if (!jiffy_tree_chunks_grow(tree, chunks, num_bytes)) {
+      return NULL;
+    }
+
+    tail = chunks->tail;
+  }
+
+  void * const r = tail->data + tail->len;
+  tail->len += num_bytes;
+  chunks->len += num_bytes;
+  return r;
+}
+
+/**
+ * Append the given number of bytes to a chunk list of the tree parser.
+ *
+ * If memory cannot be allocated, then this function records the error,
+ * stops the parser, and returns NULL.  Once an error has been recorded,
+ * this function always returns NULL, because a stopped parser may still
+ * finish the current token.
+ */
+static inline void *
+jiffy_tree_parse_append(
+  const jiffy_parser_t * const p,
+  jiffy_tree_parse_data_t * const data,
+  jiffy_tree_chunks_t * const chunks,
+  const size_t num_bytes
+) {
+  if (data->err != JIFFY_ERR_OK) {
+    // earlier allocation failed
+    return NULL;
+  }
+
+  void * const r = jiffy_tree_chunks_append(data->tree, chunks, num_bytes);
+  if (!r) {
+    // save error, stop parser
+    data->err = JIFFY_ERR_TREE_PARSE_MALLOC_FAILED;
+    jiffy_parser_stop(p);
+  }
+
+  return r;
+}
+
+static inline jiffy_tree_parse_val_t *
+jiffy_tree_parse_add_val(
+  const jiffy_parser_t * const p,
+  jiffy_tree_parse_data_t * const data,
+  const jiffy_type_t type
+) {
+  jiffy_tree_parse_val_t * const val = jiffy_tree_parse_append(p, data, &data->vals, sizeof(jiffy_tree_parse_val_t));
+  if (val) {
+    val->type = type;
+    val->ofs = 0;
+    val->len = 0;
+    val->parent = data->containers_len ? data->containers[data->containers_len - 1] : NULL;
+
+    if (val->parent) {
+      // increment child count of enclosing container
+      val->parent->len++;
+    }
+
+    data->num_vals++;
+    data->last_val = val;
+  }
+
+  return val;
+}
+
+/**
+ * Double the size of a container stack with entries of the given size,
+ * keeping the first len entries.  Used by the tree and flat tree
+ * parsers.
+ *
+ * Returns the new stack and updates the capacity, or returns NULL and
+ * leaves the old stack intact if memory could not be allocated.
+ */
+static void *
+jiffy_tree_containers_grow(
+  const jiffy_tree_t * const tree,
+  void * const containers,
+  const size_t len,
+  const size_t size,
+  size_t * const cap
+) {
+  const size_t new_cap = *cap ? 2 * *cap : TREE_CONTAINERS_MIN_LEN;
+  if (new_cap > SIZE_MAX / size) {
+    return NULL;
+  }
+
+  // alloc new stack, check for error
+  void * const ptr = jiffy_tree_data_malloc(tree, new_cap * size);
+  if (!ptr) {
+    return NULL;
+  }
+
+  if (containers) {
+    // copy and free old stack
+    memcpy(ptr, containers, len * size);
+    jiffy_tree_data_free(tree, containers);
+  }
+
+  *cap = new_cap;
+  return ptr;
+}
+
+static inline void
+jiffy_tree_parse_container_start(
+  const jiffy_parser_t * const p,
+  const jiffy_type_t type
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_tree_parse_val_t * const val = jiffy_tree_parse_add_val(p, data, type);
+  if (!val) {
+    return;
+  }
+
+  if (data->containers_len == data->containers_cap) {
+    // grow container stack, check for error
+    jiffy_tree_parse_val_t ** const containers = jiffy_tree_containers_grow(data->tree, data->containers, data->containers_len, sizeof(*containers), &data->containers_cap);
+    if (!containers) {
+      // save error, stop parser
+      data->err = JIFFY_ERR_TREE_PARSE_MALLOC_FAILED;
+      jiffy_parser_stop(p);
+      return;
+    }
+
+    data->containers = containers;
+  }
+
+  // push container
+  data->containers[data->containers_len++] = val;
+}
+
+static inline void
+jiffy_tree_parse_container_end(
+  const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+
+  if (data->err != JIFFY_ERR_OK) {
+    // earlier allocation failed
+    return;
+  } else if (data->containers_len > 0) {
+    // pop container
+    data->containers_len--;
+  } else {
+    // unreachable: the parser only fires container end events which
+    // match a container start, so the stack cannot underflow
+    data->err = JIFFY_ERR_STACK_UNDERFLOW;
+    jiffy_parser_stop(p);
+  }
+}
+
+static void
+on_tree_parse_null(
+ const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_tree_parse_add_val(p, data, JIFFY_TYPE_NULL);
+}
+
+static void
+on_tree_parse_true(
+ const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_tree_parse_add_val(p, data, JIFFY_TYPE_TRUE);
+}
+
+static void
+on_tree_parse_false(
+ const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_tree_parse_add_val(p, data, JIFFY_TYPE_FALSE);
+}
+
+static void
+on_tree_parse_number_start(
+ const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_tree_parse_val_t * const val = jiffy_tree_parse_add_val(p, data, JIFFY_TYPE_NUMBER);
+
+  if (val) {
+    val->ofs = data->bytes.len;
+  }
+}
 
-      // end array
-      FIRE(p, on_array_end);
-      POP(p);
+static void
+on_tree_parse_string_start(
+ const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_tree_parse_val_t * const val = jiffy_tree_parse_add_val(p, data, JIFFY_TYPE_STRING);
 
-      break;
-    case ',':
-      // end element
-      FIRE(p, on_array_element_end);
+  if (val) {
+    val->ofs = data->bytes.len;
+  }
+}
 
-      // start element
-      PUSH(p, PARSER_STATE_VALUE);
-      FIRE(p, on_array_element_start);
+static void
+on_tree_parse_scalar_end(
+ const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
 
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_EXPECTED_COMMA_OR_ARRAY_END);
-    }
+  if (data->err == JIFFY_ERR_OK) {
+    data->last_val->len = data->bytes.len - data->last_val->ofs;
+  }
+}
 
-    break;
-  case PARSER_STATE_OBJECT_START:
-    switch (byte) {
-    CASE_WHITESPACE
-      // ignore
-      break;
-    case '}':
-      // end object
-      FIRE(p, on_object_end);
-      POP(p);
+static void
+on_tree_parse_data(
+ const jiffy_parser_t * const p,
+ const uint8_t * const ptr,
+ const size_t len
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+  uint8_t * const dst = jiffy_tree_parse_append(p, data, &data->bytes, len);
+  if (dst) {
+    memcpy(dst, ptr, len);
+  }
+}
 
-      break;
-    case '"':
-      PUSH(p, PARSER_STATE_OBJECT_KEY);
-      PUSH(p, PARSER_STATE_STRING);
-      FIRE(p, on_object_key_start);
-      FIRE(p, on_string_start);
+static void
+on_tree_parse_array_start(
+ const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_container_start(p, JIFFY_TYPE_ARRAY);
+}
 
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_EXPECTED_STRING_OR_OBJECT_END);
-    }
+static void
+on_tree_parse_object_start(
+ const jiffy_parser_t * const p
+) {
+  jiffy_tree_parse_container_start(p, JIFFY_TYPE_OBJECT);
+}
 
-    break;
-  case PARSER_STATE_OBJECT_KEY:
-    switch (byte) {
-    CASE_WHITESPACE
-      // ignore
-      break;
-    case ':':
-      FIRE(p, on_object_key_end);
-      SWAP(p, PARSER_STATE_AFTER_OBJECT_KEY);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_EXPECTED_COLON);
-    }
+static void
+on_tree_parse_error(
+ const jiffy_parser_t * const p,
+ const jiffy_err_t err
+) {
+  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
+  data->err = err;
+}
 
-    break;
-  case PARSER_STATE_AFTER_OBJECT_KEY:
-    switch (byte) {
-    CASE_WHITESPACE
-      // ignore
-      break;
-    default:
-      SWAP(p, PARSER_STATE_AFTER_OBJECT_VALUE);
-      PUSH(p, PARSER_STATE_VALUE);
-      FIRE(p, on_object_value_start);
-      goto retry;
-    }
+static const jiffy_parser_cbs_t
+TREE_PARSE_CBS = {
+  .on_null                = on_tree_parse_null,
+  .on_true                = on_tree_parse_true,
+  .on_false               = on_tree_parse_false,
 
-    break;
-  case PARSER_STATE_AFTER_OBJECT_VALUE:
-    switch (byte) {
-    CASE_WHITESPACE
-      // ignore
-      break;
-    case ',':
-      FIRE(p, on_object_value_end);
-      SWAP(p, PARSER_STATE_BEFORE_OBJECT_KEY);
-      break;
-    case '}':
-      FIRE(p, on_object_value_end);
-      POP(p);
-      FIRE(p, on_object_end);
-      POP(p);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_EXPECTED_COMMA_OR_OBJECT_END);
-    }
+  .on_number_start        = on_tree_parse_number_start,
+  .on_number_end          = on_tree_parse_scalar_end,
+  .on_number_data         = on_tree_parse_data,
 
-    break;
-  case PARSER_STATE_BEFORE_OBJECT_KEY:
-    switch (byte) {
-    CASE_WHITESPACE
-      // ignore
-      break;
-    case '"':
-      SWAP(p, PARSER_STATE_OBJECT_KEY);
-      PUSH(p, PARSER_STATE_STRING);
-      FIRE(p, on_object_key_start);
-      FIRE(p, on_string_start);
-      break;
-    default:
-      FAIL(p, JIFFY_ERR_EXPECTED_OBJECT_KEY);
-    }
+  .on_string_start        = on_tree_parse_string_start,
+  .on_string_end          = on_tree_parse_scalar_end,
+  .on_string_data         = on_tree_parse_data,
 
-    break;
-  default:
-    FAIL(p, JIFFY_ERR_BAD_STATE);
-  }
+  .on_array_start         = on_tree_parse_array_start,
+  .on_array_end           = jiffy_tree_parse_container_end,
 
-  // increment byte count
-  p->num_bytes++;
+  .on_object_start        = on_tree_parse_object_start,
+  .on_object_end          = jiffy_tree_parse_container_end,
 
-  // return success
-  return true;
-}
+  .on_error               = on_tree_parse_error,
+};
 
-bool
-jiffy_parser_push(
-  jiffy_parser_t * const p,
-  const void * const ptr,
+// tree parser, specialized for TREE_PARSE_CBS
+JIFFY_PARSER_DEF_SPECIALIZED(jiffy_tree_parse_parser, &TREE_PARSE_CBS)
+
+/**
+ * Parse the input in a single pass, recording values, rows, and byte
+ * data in the chunk lists of the parse data.
+ *
+ * If the structural index is non-NULL, then it is used to drive the
+ * parser.  If the file is non-NULL, then it is pushed one window at a
+ * time instead of the source buffer.
+ */
+static bool
+jiffy_tree_parse(
+  jiffy_tree_parse_data_t * const data,
+  const jiffy_index_t * const index,
+  const jiffy_file_t * const file,
+  const void * const src,
   const size_t len
 ) {
-  const uint8_t * const buf = ptr;
+  jiffy_tree_stack_t * const stack = data->stack;
+  jiffy_parser_t p;
+  return (
+    jiffy_parser_init(&p, &TREE_PARSE_CBS, stack->ptr, stack->len, data) &&
+    (!stack->grow || jiffy_parser_set_stack_realloc(&p, jiffy_tree_stack_realloc, SIZE_MAX)) &&
+    (file ? jiffy_file_push(file, &p, &TREE_PARSE_CBS, jiffy_tree_parse_parser_push) :
+      index ? jiffy_tree_parse_parser_push_index(&p, index, src, len) :
+      jiffy_tree_parse_parser_push(&p, src, len)) &&
+    jiffy_tree_parse_parser_fini(&p) &&
+
+    // parser is stopped by callbacks which fail to allocate memory
+    (data->err == JIFFY_ERR_OK)
+  );
+}
 
-  for (size_t i = 0; i < len; i++) {
-    // parse byte, check for error
-    if (!jiffy_parser_push_byte(p, buf[i])) {
-      // return failure
-      return false;
-    }
-  }
+static void *
+jiffy_tree_output_malloc(
+  const jiffy_tree_t * const tree,
+  const size_t num_vals,
+  const size_t num_bytes
+) {
+  // calculate total number of bytes needed for output data
+  const size_t bytes_needed = (
+    // space needed for all values
+    sizeof(jiffy_value_t) * num_vals +
 
-  // return success
-  return true;
+    // space needed for byte data (numbers and strings)
+    num_bytes
+  );
+
+  // allocate and return memory
+  return jiffy_tree_data_malloc(tree, bytes_needed);
 }
 
-bool
-jiffy_parser_fini(
-  jiffy_parser_t * const p
+/**
+ * Copy the contents of a chunk list to contiguous memory.
+ */
+static void
+jiffy_tree_chunks_copy(
+  const jiffy_tree_chunks_t * const chunks,
+  uint8_t *dst
 ) {
-  // push a single space; this will flush any pending numbers
-  if (!jiffy_parser_push_byte(p, ' ')) {
-    return false;
-  }
-
-  // check to see if parsing is done
-  if (p->stack_pos || GET_STATE(p) != PARSER_STATE_DONE) {
-    FAIL(p, JIFFY_ERR_NOT_DONE);
+  for (const jiffy_tree_chunk_t *chunk = chunks->head; chunk; chunk = chunk->next) {
+    memcpy(dst, chunk->data, chunk->len);
+    dst += chunk->len;
   }
-
-  // return success
-  return true;
 }
 
-bool
-jiffy_parse(
-  const jiffy_parser_cbs_t * const cbs,
-  jiffy_parser_state_t * const stack_ptr,
-  const size_t stack_len,
-  const void * const buf,
-  const size_t len,
-  void * const user_data
+/**
+ * Compact the values and byte data recorded by jiffy_tree_parse() into
+ * a single allocation, and save it in the tree.
+ *
+ * The root value is stored first, and the children of each container
+ * are stored contiguously, in document order of the containers.  The
+ * recorded values are visited in document order, so each container is
+ * visited before its children: it is assigned its slice of output
+ * values, and the offset of the slice is then used as the cursor for
+ * placing its children.
+ */
+static bool
+jiffy_tree_compact(
+  jiffy_tree_parse_data_t * const parse_data
 ) {
-  jiffy_parser_t p;
+  jiffy_tree_t * const tree = parse_data->tree;
+  const size_t num_vals = parse_data->num_vals;
+  const size_t num_bytes = parse_data->bytes.len;
 
-  // init parser, check for error
-  if (!jiffy_parser_init(&p, cbs, stack_ptr, stack_len, user_data)) {
-    // return failure
-    return false;
+  if (!num_vals) {
+    // empty tree
+    return true;
   }
 
-  // write data, check for error
-  if (!jiffy_parser_push(&p, buf, len)) {
-    // return failure
+  // allocate output data, check for error
+  tree->data = jiffy_tree_output_malloc(tree, num_vals, num_bytes);
+  if (!tree->data) {
+    parse_data->err = JIFFY_ERR_TREE_OUTPUT_MALLOC_FAILED;
     return false;
   }
 
-  // finalize parser, check for error
-  if (!jiffy_parser_fini(&p)) {
-    // return failure
-    return false;
+  // populate output tree data
+  tree->vals = (jiffy_value_t*) tree->data;
+  tree->num_vals = num_vals;
+
+  // copy byte data
+  uint8_t * const bytes = (uint8_t*) (tree->vals + num_vals);
+  jiffy_tree_chunks_copy(&parse_data->bytes, bytes);
+
+  // offset of next unassigned slice (the root value is at offset 0)
+  size_t next = 1;
+
+  // convert values
+  for (const jiffy_tree_chunk_t *chunk = parse_data->vals.head; chunk; chunk = chunk->next) {
+    jiffy_tree_parse_val_t * const src = (jiffy_tree_parse_val_t*) chunk->data;
+    const size_t len = chunk->len / sizeof(jiffy_tree_parse_val_t);
+
+    for (size_t i = 0; i < len; i++) {
+      // get output value from cursor of enclosing container
+      jiffy_value_t * const dst = tree->vals + (src[i].parent ? src[i].parent->ofs++ : 0);
+
+      dst->type = src[i].type;
+      switch (src[i].type) {
+      case JIFFY_TYPE_NUMBER:
+        dst->v_num.ptr = bytes + src[i].ofs;
+        dst->v_num.len = src[i].len;
+        break;
+      case JIFFY_TYPE_STRING:
+        dst->v_str.ptr = bytes + src[i].ofs;
+        dst->v_str.len = src[i].len;
+        break;
+      case JIFFY_TYPE_ARRAY:
+        dst->v_ary.vals = src[i].len ? (tree->vals + next) : NULL;
+        dst->v_ary.len = src[i].len;
+
+        // assign slice, save cursor
+        src[i].ofs = next;
+        next += src[i].len;
+        break;
+      case JIFFY_TYPE_OBJECT:
+        dst->v_obj.vals = src[i].len ? (tree->vals + next) : NULL;
+        dst->v_obj.len = src[i].len / 2;
+
+        // assign slice, save cursor
+        src[i].ofs = next;
+        next += src[i].len;
+        break;
+      default:
+        break;
+      }
+    }
   }
 
   // return success
   return true;
 }
 
-static const char *
-JIFFY_TYPES[] = {
-#define JIFFY_DEF_TYPE(a, b) b
-JIFFY_TYPE_LIST
-#undef JIFFY_DEF_TYPE
-};
-
-const char *
-jiffy_type_to_s(
-  const jiffy_type_t type
-) {
-  const size_t ofs = (type < JIFFY_TYPE_LAST) ? type : JIFFY_TYPE_LAST;
-  return JIFFY_TYPES[ofs];
-}
-
-jiffy_type_t
-jiffy_value_get_type(
-  const jiffy_value_t * const val
+/**
+ * Free the chunk lists and container stack of the tree parser.
+ */
+static void
+jiffy_tree_parse_data_free(
+  jiffy_tree_parse_data_t * const data
 ) {
-  return val->type;
+  jiffy_tree_chunks_free(data->tree, &data->vals);
+  jiffy_tree_chunks_free(data->tree, &data->bytes);
+  if (data->containers) {
+    jiffy_tree_data_free(data->tree, data->containers);
+    data->containers = NULL;
+  }
 }
 
-const uint8_t *
-jiffy_number_get_bytes(
-  const jiffy_value_t * const val,
-  size_t * const r_len
-) {
-  // value is a number
-  const bool is_valid = jiffy_value_get_type(val) == JIFFY_TYPE_NUMBER;
+// invoke on_error callback with error code
+#define TREE_FAIL(tree, err) do { \
+  if ((tree)->cbs && (tree)->cbs->on_error) { \
+    (tree)->cbs->on_error((tree), err); \
+  } \
+  return false; \
+} while (0)
 
-  if (is_valid && r_len) {
-    *r_len = val->v_num.len;
+static bool
+jiffy_tree_build(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  jiffy_tree_stack_t * const stack,
+  const jiffy_index_t * const index,
+  const jiffy_file_t * const file,
+  const void * const src,
+  const size_t len,
+  void * const user_data
+) {
+  // check to make sure tree, is not null
+  if (!tree) {
+    // return failure
+    return false;
   }
 
-  return is_valid ? val->v_num.ptr : NULL;
-}
+  // populate initial tree values
+  tree->cbs = cbs;
+  tree->user_data = user_data;
+  tree->data = NULL;
+  tree->vals = NULL;
+  tree->num_vals = 0;
+
+  // populate parse data
+  jiffy_tree_parse_data_t parse_data = {
+    .tree   = tree,
+    .stack  = stack,
+    .err    = JIFFY_ERR_OK,
+  };
+  stack->tree = tree;
+
+  // parse input in a single pass, then compact the result into the
+  // tree
+  const bool ok = (
+    jiffy_tree_parse(&parse_data, index, file, src, len) &&
+    jiffy_tree_compact(&parse_data)
+  );
 
-const uint8_t *
-jiffy_string_get_bytes(
-  const jiffy_value_t * const val,
-  size_t * const r_len
-) {
-  // value is a string
-  const bool is_valid = jiffy_value_get_type(val) == JIFFY_TYPE_STRING;
+  // free parse memory
+  jiffy_tree_parse_data_free(&parse_data);
 
-  if (is_valid && r_len) {
-    *r_len = val->v_str.len;
+  if (!ok) {
+    TREE_FAIL(tree, parse_data.err);
   }
 
-  return is_valid ? val->v_str.ptr : NULL;
+  // return success
+  return true;
 }
 
-size_t
-jiffy_array_get_size(
-  const jiffy_value_t * const val
+bool
+jiffy_tree_new_ex(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  jiffy_parser_state_t * const stack,
+  const size_t stack_len,
+  const void * const src,
+  const size_t len,
+  void * const user_data
 ) {
-  return val->v_ary.len;
+  jiffy_tree_stack_t tree_stack = { .ptr = stack, .len = stack_len };
+  return jiffy_tree_build(tree, cbs, &tree_stack, NULL, NULL, src, len, user_data);
 }
 
-#define ARY_NTH_VAL(ary, ofs) ((ary)->v_ary.vals[ofs])
-
-const jiffy_value_t *
-jiffy_array_unsafe_get_nth(
-  const jiffy_value_t * const val,
-  const size_t ofs
+bool
+jiffy_tree_new_index(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  jiffy_parser_state_t * const stack,
+  const size_t stack_len,
+  const jiffy_index_t * const index,
+  const void * const src,
+  const size_t len,
+  void * const user_data
 ) {
-  return ARY_NTH_VAL(val, ofs);
+  jiffy_tree_stack_t tree_stack = { .ptr = stack, .len = stack_len };
+  return jiffy_tree_build(tree, cbs, &tree_stack, index, NULL, src, len, user_data);
 }
 
-const jiffy_value_t *
-jiffy_array_get_nth(
-  const jiffy_value_t * const val,
-  const size_t ofs
+/**
+ * Build a tree with a growable state stack.  Used by jiffy_tree_new()
+ * and jiffy_tree_new_from_file().
+ */
+static bool
+jiffy_tree_build_grow(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  const jiffy_file_t * const file,
+  const void * const src,
+  const size_t len,
+  void * const user_data
 ) {
-  const bool is_valid = (
-    // value is an array
-    (jiffy_value_get_type(val) == JIFFY_TYPE_ARRAY) &&
+  // start with a small stack; the parser grows it with the tree
+  // allocator if the document is nested more deeply
+  jiffy_parser_state_t stack_mem[TREE_STACK_LEN];
+  jiffy_tree_stack_t stack = {
+    .ptr  = stack_mem,
+    .len  = TREE_STACK_LEN,
+    .grow = true,
+  };
 
-    // offset is in bounds
-    (ofs < val->v_ary.len)
-  );
+  // parse tree, get result
+  const bool r = jiffy_tree_build(tree, cbs, &stack, NULL, file, src, len, user_data);
 
-  return is_valid ? ARY_NTH_VAL(val, ofs) : NULL;
+  if (stack.owned) {
+    // free grown stack
+    jiffy_tree_data_free(tree, stack.ptr);
+  }
+
+  // return result
+  return r;
 }
 
 bool
-jiffy_array_each(
-  const jiffy_value_t * const ary,
-  void (*each_cb)(const size_t, const jiffy_value_t *, void *),
+jiffy_tree_new(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  const void * const src,
+  const size_t len,
   void * const user_data
 ) {
-  if (jiffy_value_get_type(ary) != JIFFY_TYPE_ARRAY) {
+  // check to make sure tree, is not null
+  if (!tree) {
     // return failure
     return false;
   }
 
-  if (each_cb) {
-    for (size_t i = 0; i < jiffy_array_get_size(ary); i++) {
-      each_cb(i, ARY_NTH_VAL(ary, i), user_data);
-    }
-  }
-
-  // return success
-  return true;
+  return jiffy_tree_build_grow(tree, cbs, NULL, src, len, user_data);
 }
 
-size_t
-jiffy_object_get_size(
-  const jiffy_value_t * const val
+/**
+ * Build function for jiffy_tree_new_from_file().  See
+ * jiffy_file_build().
+ */
+static bool
+jiffy_tree_build_file(
+  void * const ctx,
+  const jiffy_file_t * const file,
+  const void * const src,
+  const size_t len
 ) {
-  return val->v_obj.len;
+  jiffy_tree_t * const tree = ctx;
+  return jiffy_tree_build_grow(tree, tree->cbs, file, src, len, tree->user_data);
 }
 
-#define OBJ_NTH_KEY(obj, ofs) ((obj)->v_obj.vals[2 * (ofs)])
-#define OBJ_NTH_VAL(obj, ofs) ((obj)->v_obj.vals[2 * (ofs) + 1])
-
-const jiffy_value_t *
-jiffy_object_unsafe_get_nth_key(
-  const jiffy_value_t * const val,
-  const size_t ofs
+bool
+jiffy_tree_new_from_file(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  const char * const path,
+  void * const user_data
 ) {
-  return OBJ_NTH_KEY(val, ofs);
-}
+  // check to make sure tree, is not null
+  if (!tree) {
+    // return failure
+    return false;
+  }
 
-const jiffy_value_t *
-jiffy_object_get_nth_key(
-  const jiffy_value_t * const val,
-  const size_t ofs
-) {
-  const bool is_valid = (
-    // value is an object
-    (jiffy_value_get_type(val) == JIFFY_TYPE_OBJECT) &&
+  // populate initial tree values (used by TREE_FAIL() and
+  // jiffy_tree_build_file())
+  tree->cbs = cbs;
+  tree->user_data = user_data;
 
-    // offset is in bounds
-    (ofs < val->v_obj.len)
-  );
+  // build tree from file, check for open or map error
+  jiffy_err_t err = JIFFY_ERR_OK;
+  const bool r = jiffy_file_build(path, jiffy_tree_build_file, tree, &err);
+  if (err != JIFFY_ERR_OK) {
+    TREE_FAIL(tree, err);
+  }
 
-  return is_valid ? OBJ_NTH_KEY(val, ofs) : NULL;
+  // return result
+  return r;
 }
 
-const jiffy_value_t *
-jiffy_object_unsafe_get_nth_value(
-  const jiffy_value_t * const val,
-  const size_t ofs
+void *
+jiffy_tree_get_user_data(
+  const jiffy_tree_t * const tree
 ) {
-  return OBJ_NTH_VAL(val, ofs);
+  return tree->user_data;
 }
 
 const jiffy_value_t *
-jiffy_object_get_nth_value(
-  const jiffy_value_t * const val,
-  const size_t ofs
+jiffy_tree_get_root_value(
+  const jiffy_tree_t * const tree
 ) {
-  const bool is_valid = (
-    // value is an object
-    (jiffy_value_get_type(val) == JIFFY_TYPE_OBJECT) &&
-
-    // offset is in bounds
-    (ofs < val->v_obj.len)
-  );
-
-  return is_valid ? OBJ_NTH_VAL(val, ofs) : NULL;
+  return (tree->num_vals > 0) ? tree->vals : NULL;
 }
 
-bool
-jiffy_object_each(
-  const jiffy_value_t * const obj,
-  void (*each_cb)(const jiffy_value_t *, const jiffy_value_t *, void *),
-  void * const user_data
+void
+jiffy_tree_free(
+  jiffy_tree_t * const tree
 ) {
-  if (jiffy_value_get_type(obj) != JIFFY_TYPE_OBJECT) {
-    // return failure
-    return false;
-  }
+  if (tree->data) {
+    // free tree data
+    jiffy_tree_data_free(tree, tree->data);
+    tree->data = NULL;
+    tree->vals = NULL;
 
-  if (each_cb) {
-    for (size_t i = 0; i < jiffy_object_get_size(obj); i++) {
-      each_cb(
-        OBJ_NTH_KEY(obj, i),
-        OBJ_NTH_VAL(obj, i),
-        user_data
-      );
-    }
+    // clear value count
+    tree->num_vals = 0;
   }
-
-  // return success
-  return true;
 }
 
+/**
+ * Number of payload bits in each word of a flat tree.  The remaining
+ * upper bits hold the tag.
+ */
+#define FLAT_PAYLOAD_BITS 56
+#define FLAT_PAYLOAD_MASK ((UINT64_C(1) << FLAT_PAYLOAD_BITS) - 1)
+
+// tag of container end words.  Other words are tagged with the type of
+// their value.
+#define FLAT_TAG_END 0xFF
+
+#define FLAT_WORD(tag, payload) (((uint64_t) (tag) << FLAT_PAYLOAD_BITS) | (uint64_t) (payload))
+#define FLAT_TAG(word) ((word) >> FLAT_PAYLOAD_BITS)
+#define FLAT_PAYLOAD(word) ((word) & FLAT_PAYLOAD_MASK)
+
 typedef struct {
-  // number of bytes in numbers and strings
-  size_t num_bytes;
+  // output flat tree
+  jiffy_flat_t *flat;
 
-  // total number of values (including objects)
-  size_t num_vals;
+  // allocator adapter, so that the chunk lists and state stack can use
+  // the callbacks of the flat tree
+  jiffy_tree_alloc_t alloc;
+
+  // state stack
+  jiffy_tree_stack_t *stack;
 
-  // total number of objects
-  size_t num_objs;
+  // words and byte data of numbers and strings
+  jiffy_tree_chunks_t words, bytes;
 
-  // total number of object key/value pairs
-  size_t num_obj_rows;
+  // number of words
+  size_t num_words;
 
-  // total number of array values across all arrays
-  size_t num_ary_rows;
+  // words of the current number or string
+  uint64_t *scalar;
 
-  // current and maximum depth
-  size_t curr_depth,
-         max_depth;
+  // stack of pointers to the start words of open arrays and objects.
+  // Grows by doubling, since it only grows with the nesting depth.
+  uint64_t **containers;
+  size_t containers_len, containers_cap;
 
-  // error encountered during scan
   jiffy_err_t err;
-} jiffy_tree_scan_data_t;
+} jiffy_flat_parse_data_t;
 
-typedef struct {
-  jiffy_value_t *ary;
-  jiffy_value_t *val;
-} jiffy_tree_parse_ary_row_t;
+/**
+ * Stack reallocation callback for the flat tree parser.
+ */
+static void *
+jiffy_flat_stack_realloc(
+  void * const ptr,
+  const size_t num_bytes,
+  void * const user_data
+) {
+  jiffy_flat_parse_data_t * const data = user_data;
+  return jiffy_tree_stack_resize(data->stack, ptr, num_bytes);
+}
 
-typedef struct {
-  jiffy_value_t *obj;
-  jiffy_value_t *key;
-  jiffy_value_t *val;
-} jiffy_tree_parse_obj_row_t;
+/**
+ * Append the given number of bytes to a chunk list of the flat tree
+ * parser.  See jiffy_tree_parse_append().
+ */
+static inline void *
+jiffy_flat_parse_append(
+  const jiffy_parser_t * const p,
+  jiffy_flat_parse_data_t * const data,
+  jiffy_tree_chunks_t * const chunks,
+  const size_t num_bytes
+) {
+  if (data->err != JIFFY_ERR_OK) {
+    // earlier allocation failed
+    return NULL;
+  }
 
-typedef struct {
-  // scan data
-  const jiffy_tree_scan_data_t *scan_data;
+  void * const r = jiffy_tree_chunks_append(&data->alloc.tree, chunks, num_bytes);
+  if (!r) {
+    // save error, stop parser
+    data->err = JIFFY_ERR_TREE_PARSE_MALLOC_FAILED;
+    jiffy_parser_stop(p);
+  }
 
-  // output tree
-  jiffy_tree_t *tree;
+  return r;
+}
+
+/**
+ * Append the words of a value, and increment the child count of the
+ * enclosing container.
+ */
+static inline uint64_t *
+jiffy_flat_parse_add_val(
+  const jiffy_parser_t * const p,
+  jiffy_flat_parse_data_t * const data,
+  const jiffy_type_t type,
+  const size_t num_words
+) {
+  uint64_t * const words = jiffy_flat_parse_append(p, data, &data->words, num_words * sizeof(uint64_t));
+  if (words) {
+    words[0] = FLAT_WORD(type, 0);
+    if (num_words > 1) {
+      words[1] = 0;
+    }
+
+    if (data->containers_len) {
+      // increment child count of enclosing container
+      data->containers[data->containers_len - 1][1]++;
+    }
 
-  // allocated data for parsing
-  uint8_t *data;
+    data->num_words += num_words;
+  }
+
+  return words;
+}
 
-  // current offset into vals
-  size_t vals_ofs;
+static inline void
+jiffy_flat_parse_container_start(
+  const jiffy_parser_t * const p,
+  const jiffy_type_t type
+) {
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
+  const size_t ofs = data->num_words;
 
-  // array/value pairs (pointer into data)
-  jiffy_tree_parse_ary_row_t *ary_rows;
+  // add start word and count word
+  uint64_t * const words = jiffy_flat_parse_add_val(p, data, type, 2);
+  if (!words) {
+    return;
+  }
 
-  // current offset into ary_rows
-  size_t ary_rows_ofs;
+  if (data->containers_len == data->containers_cap) {
+    // grow container stack, check for error
+    uint64_t ** const containers = jiffy_tree_containers_grow(&data->alloc.tree, data->containers, data->containers_len, sizeof(*containers), &data->containers_cap);
+    if (!containers) {
+      // save error, stop parser
+      data->err = JIFFY_ERR_TREE_PARSE_MALLOC_FAILED;
+      jiffy_parser_stop(p);
+      return;
+    }
 
-  // object/key/value tuples (pointer into data)
-  jiffy_tree_parse_obj_row_t *obj_rows;
+    data->containers = containers;
+  }
 
-  // current offset into obj_rows
-  size_t obj_rows_ofs;
+  // save offset of start word until the end word is known, push
+  // container
+  words[0] = FLAT_WORD(type, ofs);
+  data->containers[data->containers_len++] = words;
+}
 
-  // container stack (pointer into data)
-  jiffy_value_t **stack;
-  size_t stack_pos;
+static inline void
+jiffy_flat_parse_container_end(
+  const jiffy_parser_t * const p
+) {
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
 
-  // pointer to byte data (stored in tree memory)
-  uint8_t *bytes;
+  if (data->err != JIFFY_ERR_OK) {
+    // earlier allocation failed
+    return;
+  } else if (data->containers_len == 0) {
+    // unreachable: the parser only fires container end events which
+    // match a container start, so the stack cannot underflow
+    data->err = JIFFY_ERR_STACK_UNDERFLOW;
+    jiffy_parser_stop(p);
+    return;
+  }
 
-  // current offset into bytes
-  size_t bytes_ofs;
+  // pop container
+  uint64_t * const start = data->containers[--data->containers_len];
+  const uint64_t tag = FLAT_TAG(start[0]);
+  const size_t ofs = FLAT_PAYLOAD(start[0]);
+  const size_t end = data->num_words;
 
-  jiffy_err_t err;
-} jiffy_tree_parse_data_t;
+  // add end word (not counted as a child)
+  uint64_t * const word = jiffy_flat_parse_append(p, data, &data->words, sizeof(uint64_t));
+  if (!word) {
+    return;
+  }
+  *word = FLAT_WORD(FLAT_TAG_END, ofs);
+  data->num_words++;
+
+  // link start word to end word; object keys and values were counted
+  // separately
+  start[0] = FLAT_WORD(tag, end);
+  if (tag == JIFFY_TYPE_OBJECT) {
+    start[1] /= 2;
+  }
+}
 
 static void
-on_tree_scan_byte(
- const jiffy_parser_t * const p,
- const uint8_t byte
+on_flat_parse_null(
+ const jiffy_parser_t * const p
 ) {
-  (void) byte;
-  jiffy_tree_scan_data_t * const scan_data = jiffy_parser_get_user_data(p);
-  scan_data->num_bytes++;
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_flat_parse_add_val(p, data, JIFFY_TYPE_NULL, 1);
 }
 
 static void
-on_tree_scan_val(
+on_flat_parse_true(
  const jiffy_parser_t * const p
 ) {
-  jiffy_tree_scan_data_t * const scan_data = jiffy_parser_get_user_data(p);
-  scan_data->num_vals++;
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_flat_parse_add_val(p, data, JIFFY_TYPE_TRUE, 1);
 }
 
 static void
-on_tree_scan_container_start(
+on_flat_parse_false(
  const jiffy_parser_t * const p
 ) {
-  jiffy_tree_scan_data_t * const scan_data = jiffy_parser_get_user_data(p);
-  scan_data->curr_depth++;
-  scan_data->max_depth = MAX(scan_data->curr_depth, scan_data->max_depth);
-  on_tree_scan_val(p);
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
+  jiffy_flat_parse_add_val(p, data, JIFFY_TYPE_FALSE, 1);
+}
+
+static inline void
+jiffy_flat_parse_scalar_start(
+  const jiffy_parser_t * const p,
+  const jiffy_type_t type
+) {
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
+  uint64_t * const words = jiffy_flat_parse_add_val(p, data, type, 2);
+
+  if (words) {
+    // save offset of byte data
+    words[0] = FLAT_WORD(type, data->bytes.len);
+    data->scalar = words;
+  }
 }
 
 static void
-on_tree_scan_container_end(
+on_flat_parse_number_start(
  const jiffy_parser_t * const p
 ) {
-  jiffy_tree_scan_data_t * const scan_data = jiffy_parser_get_user_data(p);
-  scan_data->curr_depth--;
+  jiffy_flat_parse_scalar_start(p, JIFFY_TYPE_NUMBER);
 }
 
 static void
-on_tree_scan_array_start(
+on_flat_parse_string_start(
  const jiffy_parser_t * const p
 ) {
-  on_tree_scan_container_start(p);
+  jiffy_flat_parse_scalar_start(p, JIFFY_TYPE_STRING);
 }
 
 static void
-on_tree_scan_array_element_start(
+on_flat_parse_scalar_end(
  const jiffy_parser_t * const p
 ) {
-  jiffy_tree_scan_data_t * const scan_data = jiffy_parser_get_user_data(p);
-  scan_data->num_ary_rows++;
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
+
+  if (data->err == JIFFY_ERR_OK) {
+    // save number of bytes
+    data->scalar[1] = data->bytes.len - FLAT_PAYLOAD(data->scalar[0]);
+  }
+}
+
+static void
+on_flat_parse_data(
+ const jiffy_parser_t * const p,
+ const uint8_t * const ptr,
+ const size_t len
+) {
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
+  uint8_t * const dst = jiffy_flat_parse_append(p, data, &data->bytes, len);
+  if (dst) {
+    memcpy(dst, ptr, len);
+  }
 }
 
 static void
-on_tree_scan_object_start(
+on_flat_parse_array_start(
  const jiffy_parser_t * const p
 ) {
-  jiffy_tree_scan_data_t * const scan_data = jiffy_parser_get_user_data(p);
-  on_tree_scan_container_start(p);
-  scan_data->num_objs++;
+  jiffy_flat_parse_container_start(p, JIFFY_TYPE_ARRAY);
 }
 
 static void
-on_tree_scan_object_key_start(
+on_flat_parse_object_start(
  const jiffy_parser_t * const p
 ) {
-  jiffy_tree_scan_data_t * const scan_data = jiffy_parser_get_user_data(p);
-  scan_data->num_obj_rows++;
+  jiffy_flat_parse_container_start(p, JIFFY_TYPE_OBJECT);
 }
 
 static void
-on_tree_scan_error(
+on_flat_parse_error(
  const jiffy_parser_t * const p,
  const jiffy_err_t err
 ) {
-  jiffy_tree_scan_data_t * const scan_data = jiffy_parser_get_user_data(p);
-  scan_data->err = err;
+  jiffy_flat_parse_data_t *data = jiffy_parser_get_user_data(p);
+  data->err = err;
 }
 
 static const jiffy_parser_cbs_t
-TREE_SCAN_CBS = {
-  .on_null                = on_tree_scan_val,
-  .on_true                = on_tree_scan_val,
-  .on_false               = on_tree_scan_val,
-  .on_number_start        = on_tree_scan_val,
-  .on_string_start        = on_tree_scan_val,
+FLAT_PARSE_CBS = {
+  .on_null          = on_flat_parse_null,
+  .on_true          = on_flat_parse_true,
+  .on_false         = on_flat_parse_false,
+
+  .on_number_start  = on_flat_parse_number_start,
+  .on_number_end    = on_flat_parse_scalar_end,
+  .on_number_data   = on_flat_parse_data,
 
-  .on_array_start         = on_tree_scan_array_start,
-  .on_array_end           = on_tree_scan_container_end,
-  .on_array_element_start = on_tree_scan_array_element_start,
+  .on_string_start  = on_flat_parse_string_start,
+  .on_string_end    = on_flat_parse_scalar_end,
+  .on_string_data   = on_flat_parse_data,
 
-  .on_object_start        = on_tree_scan_object_start,
-  .on_object_end          = on_tree_scan_container_end,
-  .on_object_key_start    = on_tree_scan_object_key_start,
+  .on_array_start   = on_flat_parse_array_start,
+  .on_array_end     = jiffy_flat_parse_container_end,
 
-  .on_number_byte         = on_tree_scan_byte,
-  .on_string_byte         = on_tree_scan_byte,
+  .on_object_start  = on_flat_parse_object_start,
+  .on_object_end    = jiffy_flat_parse_container_end,
 
-  .on_error               = on_tree_scan_error,
+  .on_error         = on_flat_parse_error,
 };
 
+// flat tree parser, specialized for FLAT_PARSE_CBS
+JIFFY_PARSER_DEF_SPECIALIZED(jiffy_flat_parse_parser, &FLAT_PARSE_CBS)
+
+/**
+ * Parse the input, recording words and byte data in the chunk lists of
+ * the parse data.  If the file is non-NULL, then it is pushed one
+ * window at a time instead of the source buffer.
+ */
 static bool
-jiffy_tree_scan(
-  jiffy_tree_scan_data_t * const scan_data,
-  jiffy_parser_state_t * const stack,
-  const size_t stack_len,
+jiffy_flat_parse(
+  jiffy_flat_parse_data_t * const data,
+  const jiffy_file_t * const file,
   const void * const src,
   const size_t len
 ) {
-  scan_data->num_bytes = 0;
-  scan_data->num_vals = 0;
-  scan_data->num_objs = 0;
-  scan_data->num_ary_rows = 0;
-  scan_data->num_obj_rows = 0;
-  scan_data->curr_depth = 0;
-  scan_data->max_depth = 0;
-  scan_data->err = JIFFY_ERR_OK;
-
-  // populate scan data
-  return jiffy_parse(&TREE_SCAN_CBS, stack, stack_len, src, len, scan_data);
+  jiffy_tree_stack_t * const stack = data->stack;
+  jiffy_parser_t p;
+  return (
+    jiffy_parser_init(&p, &FLAT_PARSE_CBS, stack->ptr, stack->len, data) &&
+    jiffy_parser_set_stack_realloc(&p, jiffy_flat_stack_realloc, SIZE_MAX) &&
+    (file ? jiffy_file_push(file, &p, &FLAT_PARSE_CBS, jiffy_flat_parse_parser_push) :
+      jiffy_flat_parse_parser_push(&p, src, len)) &&
+    jiffy_flat_parse_parser_fini(&p) &&
+
+    // parser is stopped by callbacks which fail to allocate memory
+    (data->err == JIFFY_ERR_OK)
+  );
 }
 
-static inline jiffy_value_t *
-jiffy_tree_parse_add_val(
-  jiffy_tree_parse_data_t * const data,
-  const jiffy_type_t type
+/**
+ * Copy the words and byte data recorded by jiffy_flat_parse() into a
+ * single allocation, and save it in the flat tree.
+ */
+static bool
+jiffy_flat_compact(
+  jiffy_flat_parse_data_t * const data
 ) {
-  jiffy_value_t *val = data->tree->vals + data->vals_ofs++;
-  val->type = type;
-  return val;
-}
+  jiffy_flat_t * const flat = data->flat;
 
-static inline void
-jiffy_tree_parse_stack_push(
-  jiffy_tree_parse_data_t * const data,
-  jiffy_value_t * const val
-) {
-  data->stack[data->stack_pos++] = val;
-}
+  if (!data->num_words) {
+    // empty tree
+    return true;
+  }
 
-static inline void
-jiffy_tree_parse_stack_pop(
-  jiffy_tree_parse_data_t * const data
-) {
-  if (data->stack_pos > 0) {
-    data->stack_pos--;
-  } else if (data->tree->cbs && data->tree->cbs->on_error) {
-    // FIXME
-    data->tree->cbs->on_error(data->tree, JIFFY_ERR_STACK_UNDERFLOW);
+  // allocate output data, check for error
+  flat->words = jiffy_tree_data_malloc(&data->alloc.tree, data->words.len + data->bytes.len);
+  if (!flat->words) {
+    data->err = JIFFY_ERR_TREE_OUTPUT_MALLOC_FAILED;
+    return false;
   }
-}
 
-static void
-on_tree_parse_null(
- const jiffy_parser_t * const p
-) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_tree_parse_add_val(data, JIFFY_TYPE_NULL);
-}
+  // copy words and byte data
+  flat->num_words = data->num_words;
+  flat->bytes = (uint8_t*) (flat->words + flat->num_words);
+  jiffy_tree_chunks_copy(&data->words, (uint8_t*) flat->words);
+  jiffy_tree_chunks_copy(&data->bytes, flat->bytes);
 
-static void
-on_tree_parse_true(
- const jiffy_parser_t * const p
-) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_tree_parse_add_val(data, JIFFY_TYPE_TRUE);
+  // return success
+  return true;
 }
 
-static void
-on_tree_parse_false(
- const jiffy_parser_t * const p
-) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_tree_parse_add_val(data, JIFFY_TYPE_FALSE);
-}
+// invoke on_error callback with error code
+#define FLAT_FAIL(flat, err) do { \
+  if ((flat)->cbs && (flat)->cbs->on_error) { \
+    (flat)->cbs->on_error((flat), err); \
+  } \
+  return false; \
+} while (0)
 
-static void
-on_tree_parse_number_start(
- const jiffy_parser_t * const p
+static bool
+jiffy_flat_build(
+  jiffy_flat_t * const flat,
+  const jiffy_flat_cbs_t * const cbs,
+  const jiffy_file_t * const file,
+  const void * const src,
+  const size_t len,
+  void * const user_data
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_value_t * const val = jiffy_tree_parse_add_val(data, JIFFY_TYPE_NUMBER);
+  // populate initial flat tree values
+  flat->cbs = cbs;
+  flat->user_data = user_data;
+  flat->words = NULL;
+  flat->num_words = 0;
+  flat->bytes = NULL;
+
+  // populate parse data
+  jiffy_flat_parse_data_t data = {
+    .flat = flat,
+    .err  = JIFFY_ERR_OK,
+  };
+  jiffy_tree_alloc_init(&data.alloc, cbs ? cbs->malloc : NULL, cbs ? cbs->free : NULL, user_data);
+
+  // start with a small stack; the parser grows it with the tree
+  // allocator if the document is nested more deeply
+  jiffy_parser_state_t stack_mem[TREE_STACK_LEN];
+  jiffy_tree_stack_t stack = {
+    .tree = &data.alloc.tree,
+    .ptr  = stack_mem,
+    .len  = TREE_STACK_LEN,
+    .grow = true,
+  };
+  data.stack = &stack;
+
+  // parse input, then compact the result into the flat tree
+  const bool ok = (
+    jiffy_flat_parse(&data, file, src, len) &&
+    jiffy_flat_compact(&data)
+  );
 
-  val->v_num.ptr = data->bytes + data->bytes_ofs;
-  val->v_num.len = 0;
-}
+  // free parse memory
+  jiffy_tree_chunks_free(&data.alloc.tree, &data.words);
+  jiffy_tree_chunks_free(&data.alloc.tree, &data.bytes);
+  if (data.containers) {
+    jiffy_tree_data_free(&data.alloc.tree, data.containers);
+  }
 
-static void
-on_tree_parse_number_end(
- const jiffy_parser_t * const p
-) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_value_t * const val = data->tree->vals + data->vals_ofs - 1;
-  val->v_num.len = data->bytes + data->bytes_ofs - val->v_num.ptr;
-}
+  if (stack.owned) {
+    // free grown stack
+    jiffy_tree_data_free(&data.alloc.tree, stack.ptr);
+  }
 
-static void
-on_tree_parse_number_byte(
- const jiffy_parser_t * const p,
- const uint8_t byte
-) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  data->bytes[data->bytes_ofs++] = byte;
+  if (!ok) {
+    FLAT_FAIL(flat, data.err);
+  }
+
+  // return success
+  return true;
 }
 
-static void
-on_tree_parse_string_start(
- const jiffy_parser_t * const p
+bool
+jiffy_flat_new(
+  jiffy_flat_t * const flat,
+  const jiffy_flat_cbs_t * const cbs,
+  const void * const src,
+  const size_t len,
+  void * const user_data
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_value_t * const val = jiffy_tree_parse_add_val(data, JIFFY_TYPE_STRING);
+  // check to make sure flat tree is not null
+  if (!flat) {
+    // return failure
+    return false;
+  }
 
-  val->v_str.ptr = data->bytes + data->bytes_ofs;
-  val->v_str.len = 0;
+  return jiffy_flat_build(flat, cbs, NULL, src, len, user_data);
 }
 
-static void
-on_tree_parse_string_end(
- const jiffy_parser_t * const p
+/**
+ * Build function for jiffy_flat_new_from_file().  See
+ * jiffy_file_build().
+ */
+static bool
+jiffy_flat_build_file(
+  void * const ctx,
+  const jiffy_file_t * const file,
+  const void * const src,
+  const size_t len
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_value_t * const val = data->tree->vals + data->vals_ofs - 1;
-  val->v_str.len = data->bytes + data->bytes_ofs - val->v_str.ptr;
+  jiffy_flat_t * const flat = ctx;
+  return jiffy_flat_build(flat, flat->cbs, file, src, len, flat->user_data);
 }
 
-static void
-on_tree_parse_string_byte(
- const jiffy_parser_t * const p,
- const uint8_t byte
+bool
+jiffy_flat_new_from_file(
+  jiffy_flat_t * const flat,
+  const jiffy_flat_cbs_t * const cbs,
+  const char * const path,
+  void * const user_data
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  data->bytes[data->bytes_ofs++] = byte;
-}
+  // check to make sure flat tree is not null
+  if (!flat) {
+    // return failure
+    return false;
+  }
 
-static void
-on_tree_parse_array_start(
- const jiffy_parser_t * const p
-) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_value_t * const val = jiffy_tree_parse_add_val(data, JIFFY_TYPE_ARRAY);
-  jiffy_tree_parse_stack_push(data, val);
+  // populate initial flat tree values (used by FLAT_FAIL() and
+  // jiffy_flat_build_file())
+  flat->cbs = cbs;
+  flat->user_data = user_data;
 
-  val->v_ary.len = 0;
+  // build flat tree from file, check for open or map error
+  jiffy_err_t err = JIFFY_ERR_OK;
+  const bool r = jiffy_file_build(path, jiffy_flat_build_file, flat, &err);
+  if (err != JIFFY_ERR_OK) {
+    FLAT_FAIL(flat, err);
+  }
+
+  // return result
+  return r;
 }
 
-static void
-on_tree_parse_array_end(
- const jiffy_parser_t * const p
+void *
+jiffy_flat_get_user_data(
+  const jiffy_flat_t * const flat
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_tree_parse_stack_pop(data);
+  return flat->user_data;
 }
 
-static void
-on_tree_parse_array_element_start(
- const jiffy_parser_t * const p
+size_t
+jiffy_flat_get_root(
+  const jiffy_flat_t * const flat
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_tree_parse_ary_row_t * const row = data->ary_rows + data->ary_rows_ofs;
-
-  // populate array row
-  row->ary = data->stack[data->stack_pos - 1];
-  row->val = data->tree->vals + data->vals_ofs;
-
-  // increment array element count
-  row->ary->v_ary.len++;
-
-  // increment total array row count
-  data->ary_rows_ofs++;
+  return (flat->num_words > 0) ? 0 : JIFFY_FLAT_NONE;
 }
 
-static void
-on_tree_parse_object_start(
- const jiffy_parser_t * const p
+jiffy_type_t
+jiffy_flat_get_type(
+  const jiffy_flat_t * const flat,
+  const size_t ofs
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_value_t * const val = jiffy_tree_parse_add_val(data, JIFFY_TYPE_OBJECT);
-  jiffy_tree_parse_stack_push(data, val);
-
-  val->v_obj.len = 0;
+  return (ofs < flat->num_words) ? FLAT_TAG(flat->words[ofs]) : JIFFY_TYPE_LAST;
 }
 
-static void
-on_tree_parse_object_end(
- const jiffy_parser_t * const p
+size_t
+jiffy_flat_skip(
+  const jiffy_flat_t * const flat,
+  const size_t ofs
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_tree_parse_stack_pop(data);
+  const uint64_t word = flat->words[ofs];
+
+  switch (FLAT_TAG(word)) {
+  case JIFFY_TYPE_NUMBER:
+  case JIFFY_TYPE_STRING:
+    return ofs + 2;
+  case JIFFY_TYPE_ARRAY:
+  case JIFFY_TYPE_OBJECT:
+    // skip to word after matching end word
+    return FLAT_PAYLOAD(word) + 1;
+  default:
+    return ofs + 1;
+  }
 }
 
-static void
-on_tree_parse_object_key_start(
- const jiffy_parser_t * const p
+/**
+ * Get a pointer to bytes and the number of bytes of the given number or
+ * string value.
+ */
+static const uint8_t *
+jiffy_flat_get_bytes(
+  const jiffy_flat_t * const flat,
+  const size_t ofs,
+  const jiffy_type_t type,
+  size_t * const len
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  jiffy_tree_parse_obj_row_t * const row = data->obj_rows + data->obj_rows_ofs;
-
-  // populate object row
-  row->obj = data->stack[data->stack_pos - 1];
-  row->key = data->tree->vals + data->vals_ofs;
-  row->val = data->tree->vals + data->vals_ofs + 1;
+  if (jiffy_flat_get_type(flat, ofs) != type) {
+    return NULL;
+  }
 
-  // increment object row count
-  row->obj->v_obj.len++;
+  if (len) {
+    *len = flat->words[ofs + 1];
+  }
 
-  // increment total object row count
-  data->obj_rows_ofs++;
+  return flat->bytes + FLAT_PAYLOAD(flat->words[ofs]);
 }
 
-static void
-on_tree_parse_error(
- const jiffy_parser_t * const p,
- const jiffy_err_t err
+const uint8_t *
+jiffy_flat_number_get_bytes(
+  const jiffy_flat_t * const flat,
+  const size_t ofs,
+  size_t * const len
 ) {
-  jiffy_tree_parse_data_t *data = jiffy_parser_get_user_data(p);
-  data->err = err;
+  return jiffy_flat_get_bytes(flat, ofs, JIFFY_TYPE_NUMBER, len);
 }
 
-static const jiffy_parser_cbs_t
-TREE_PARSE_CBS = {
-  .on_null                = on_tree_parse_null,
-  .on_true                = on_tree_parse_true,
-  .on_false               = on_tree_parse_false,
-
-  .on_number_start        = on_tree_parse_number_start,
-  .on_number_end          = on_tree_parse_number_end,
-  .on_number_byte         = on_tree_parse_number_byte,
-
-  .on_string_start        = on_tree_parse_string_start,
-  .on_string_end          = on_tree_parse_string_end,
-  .on_string_byte         = on_tree_parse_string_byte,
-
-  .on_array_start         = on_tree_parse_array_start,
-  .on_array_end           = on_tree_parse_array_end,
-  .on_array_element_start = on_tree_parse_array_element_start,
-
-  .on_object_start        = on_tree_parse_object_start,
-  .on_object_end          = on_tree_parse_object_end,
-  .on_object_key_start    = on_tree_parse_object_key_start,
-
-  .on_error               = on_tree_parse_error,
-};
-
-static bool
-jiffy_tree_parse(
-  jiffy_tree_parse_data_t * const parse_data,
-  jiffy_parser_state_t * const stack,
-  const size_t stack_len,
-  const void * const src,
-  const size_t len
+const uint8_t *
+jiffy_flat_string_get_bytes(
+  const jiffy_flat_t * const flat,
+  const size_t ofs,
+  size_t * const len
 ) {
-  return jiffy_parse(&TREE_PARSE_CBS, stack, stack_len, src, len, parse_data);
+  return jiffy_flat_get_bytes(flat, ofs, JIFFY_TYPE_STRING, len);
 }
 
-static void *
-jiffy_tree_data_malloc(
-  const jiffy_tree_t * const tree,
-  const size_t num_bytes
+size_t
+jiffy_flat_array_get_size(
+  const jiffy_flat_t * const flat,
+  const size_t ofs
 ) {
-  if (tree->cbs && tree->cbs->malloc) {
-    return tree->cbs->malloc(num_bytes, tree->user_data);
-  } else {
-    return malloc(num_bytes);
-  }
+  return flat->words[ofs + 1];
 }
 
-static void
-jiffy_tree_data_free(
-  const jiffy_tree_t * const tree,
-  void * const ptr
+size_t
+jiffy_flat_array_get_nth(
+  const jiffy_flat_t * const flat,
+  const size_t ofs,
+  const size_t nth
 ) {
-  if (tree->cbs && tree->cbs->free) {
-    tree->cbs->free(ptr, tree->user_data);
-  } else {
-    free(ptr);
+  const bool is_valid = (
+    // value is an array
+    (jiffy_flat_get_type(flat, ofs) == JIFFY_TYPE_ARRAY) &&
+
+    // offset is in bounds
+    (nth < flat->words[ofs + 1])
+  );
+
+  if (!is_valid) {
+    return JIFFY_FLAT_NONE;
+  }
+
+  // skip preceding elements
+  size_t r = ofs + 2;
+  for (size_t i = 0; i < nth; i++) {
+    r = jiffy_flat_skip(flat, r);
   }
+
+  return r;
 }
 
-static void *
-jiffy_tree_output_malloc(
-  const jiffy_tree_t * const tree,
-  const jiffy_tree_scan_data_t * const scan_data
+bool
+jiffy_flat_array_each(
+  const jiffy_flat_t * const flat,
+  const size_t ofs,
+  void (*each_cb)(const jiffy_flat_t *, const size_t, const size_t, void *),
+  void * const user_data
 ) {
-  // calculate total number of bytes needed for output data
-  const size_t bytes_needed = (
-    // space needed for array rows
-    sizeof(jiffy_value_t*) * scan_data->num_ary_rows +
+  if (jiffy_flat_get_type(flat, ofs) != JIFFY_TYPE_ARRAY) {
+    // return failure
+    return false;
+  }
 
-    // space needed for object key/value rows
-    sizeof(jiffy_value_t*) * 2 * scan_data->num_obj_rows +
+  if (each_cb) {
+    const size_t len = flat->words[ofs + 1];
+    size_t val = ofs + 2;
 
-    // space needed for all values
-    sizeof(jiffy_value_t) * scan_data->num_vals +
+    for (size_t i = 0; i < len; i++) {
+      each_cb(flat, i, val, user_data);
+      val = jiffy_flat_skip(flat, val);
+    }
+  }
 
-    // space needed for byte data (numbers and strings)
-    scan_data->num_bytes
-  );
+  // return success
+  return true;
+}
 
-  // allocate and return memory
-  return jiffy_tree_data_malloc(tree, bytes_needed);
+size_t
+jiffy_flat_object_get_size(
+  const jiffy_flat_t * const flat,
+  const size_t ofs
+) {
+  return flat->words[ofs + 1];
 }
 
-static void *
-jiffy_tree_parse_data_malloc(
-  const jiffy_tree_t * const tree,
-  const jiffy_tree_scan_data_t * const scan_data
+size_t
+jiffy_flat_object_get_nth_key(
+  const jiffy_flat_t * const flat,
+  const size_t ofs,
+  const size_t nth
 ) {
-  // calculate total number of bytes needed for parse data
-  const size_t bytes_needed = (
-    // space for array rows
-    sizeof(jiffy_tree_parse_ary_row_t) * scan_data->num_ary_rows +
-
-    // space for object rows
-    sizeof(jiffy_tree_parse_obj_row_t) * scan_data->num_obj_rows +
+  const bool is_valid = (
+    // value is an object
+    (jiffy_flat_get_type(flat, ofs) == JIFFY_TYPE_OBJECT) &&
 
-    // space for object stack
-    sizeof(jiffy_value_t*) * scan_data->max_depth
+    // offset is in bounds
+    (nth < flat->words[ofs + 1])
   );
 
-  // allocate and return memory
-  return jiffy_tree_data_malloc(tree, bytes_needed);
+  if (!is_valid) {
+    return JIFFY_FLAT_NONE;
+  }
+
+  // skip preceding pairs (keys are always strings)
+  size_t r = ofs + 2;
+  for (size_t i = 0; i < nth; i++) {
+    r = jiffy_flat_skip(flat, r + 2);
+  }
+
+  return r;
 }
 
-static int
-tree_parse_ary_row_sort_cb(
-  const void * const a_ptr,
-  const void * const b_ptr
+size_t
+jiffy_flat_object_get_nth_value(
+  const jiffy_flat_t * const flat,
+  const size_t ofs,
+  const size_t nth
 ) {
-  const jiffy_tree_parse_ary_row_t *a = a_ptr;
-  const jiffy_tree_parse_ary_row_t *b = b_ptr;
-
-  if (a->ary == b->ary) {
-    return (a->val < b->val) ? -1 : 1;
-  } else {
-    return (a->ary < b->ary) ? -1 : 1;
-  }
+  const size_t key = jiffy_flat_object_get_nth_key(flat, ofs, nth);
+  return (key != JIFFY_FLAT_NONE) ? (key + 2) : JIFFY_FLAT_NONE;
 }
 
-static void
-tree_parse_fill_ary_rows(
-  const jiffy_tree_parse_data_t * const parse_data
+bool
+jiffy_flat_object_each(
+  const jiffy_flat_t * const flat,
+  const size_t ofs,
+  void (*each_cb)(const jiffy_flat_t *, const size_t, const size_t, void *),
+  void * const user_data
 ) {
-  if (!parse_data->ary_rows_ofs) {
-    return;
+  if (jiffy_flat_get_type(flat, ofs) != JIFFY_TYPE_OBJECT) {
+    // return failure
+    return false;
   }
 
-  // sort array rows
-  qsort(
-    parse_data->ary_rows,
-    parse_data->ary_rows_ofs,
-    sizeof(jiffy_tree_parse_ary_row_t),
-    tree_parse_ary_row_sort_cb
-  );
-
-  // get output row pointer
-  jiffy_value_t ** const dst = (jiffy_value_t**) (
-    parse_data->tree->data
-  );
+  if (each_cb) {
+    const size_t len = flat->words[ofs + 1];
+    size_t key = ofs + 2;
 
-  jiffy_value_t *curr = NULL;
-  for (size_t i = 0; i < parse_data->ary_rows_ofs; i++) {
-    if (curr != parse_data->ary_rows[i].ary) {
-      // get current ary, set array vals pointer
-      curr = parse_data->ary_rows[i].ary;
-      curr->v_ary.vals = dst + i;
+    for (size_t i = 0; i < len; i++) {
+      // keys are always strings, so the value follows the two key words
+      each_cb(flat, key, key + 2, user_data);
+      key = jiffy_flat_skip(flat, key + 2);
     }
-
-    // populate value
-    dst[i] = parse_data->ary_rows[i].val;
   }
+
+  // return success
+  return true;
 }
 
-static int
-tree_parse_obj_row_sort_cb(
-  const void * const a_ptr,
-  const void * const b_ptr
+void
+jiffy_flat_free(
+  jiffy_flat_t * const flat
 ) {
-  const jiffy_tree_parse_obj_row_t *a = a_ptr;
-  const jiffy_tree_parse_obj_row_t *b = b_ptr;
+  if (flat->words) {
+    // free flat tree data
+    if (flat->cbs && flat->cbs->free) {
+      flat->cbs->free(flat->words, flat->user_data);
+    } else {
+      free(flat->words);
+    }
 
-  if (a->obj == b->obj) {
-    return (a->val < b->val) ? -1 : 1;
-  } else {
-    return (a->obj < b->obj) ? -1 : 1;
+    flat->words = NULL;
+    flat->bytes = NULL;
+
+    // clear word count
+    flat->num_words = 0;
   }
 }
 
-static void
-tree_parse_fill_obj_rows(
-  const jiffy_tree_parse_data_t * const parse_data
+// number of bits used for the type of compact tree values
+#define TREE32_TYPE_BITS 3
+#define TREE32_TYPE_MASK ((UINT32_C(1) << TREE32_TYPE_BITS) - 1)
+
+#define TREE32_INFO(type, len) (((uint32_t) (len) << TREE32_TYPE_BITS) | (uint32_t) (type))
+#define TREE32_TYPE(val) ((jiffy_type_t) ((val)->info & TREE32_TYPE_MASK))
+#define TREE32_LEN(val) ((val)->info >> TREE32_TYPE_BITS)
+
+// get pointer into compact tree data
+#define TREE32_PTR(tree, val) ((tree)->data + (val)->ofs)
+
+/**
+ * Convert the values and byte data recorded by jiffy_tree_parse() into
+ * a single allocation, and save it in the compact tree.
+ *
+ * Works like jiffy_tree_compact(), except that it checks that all
+ * offsets and lengths fit in the compact value fields.
+ */
+static bool
+jiffy_tree32_compact(
+  jiffy_tree32_t * const tree,
+  jiffy_tree_parse_data_t * const parse_data
 ) {
-  if (!parse_data->obj_rows_ofs) {
-    return;
+  const size_t num_vals = parse_data->num_vals;
+  const size_t num_bytes = parse_data->bytes.len;
+
+  if (!num_vals) {
+    // empty tree
+    return true;
   }
 
-  // get output pointer
-  jiffy_value_t ** const dst = (jiffy_value_t**) (
-    parse_data->tree->data +
-    sizeof(jiffy_value_t*) * parse_data->ary_rows_ofs
-  );
+  // check that all data is addressable by a 32-bit offset
+  if (
+    num_vals > UINT32_MAX / sizeof(jiffy_value32_t) ||
+    num_bytes > UINT32_MAX - num_vals * sizeof(jiffy_value32_t)
+  ) {
+    parse_data->err = JIFFY_ERR_TREE32_TOO_LARGE;
+    return false;
+  }
 
-  // sort object rows
-  qsort(
-    parse_data->obj_rows,
-    parse_data->obj_rows_ofs,
-    sizeof(jiffy_tree_parse_obj_row_t),
-    tree_parse_obj_row_sort_cb
-  );
+  // allocate output data, check for error
+  const size_t size = num_vals * sizeof(jiffy_value32_t) + num_bytes;
+  tree->data = jiffy_tree_data_malloc(parse_data->tree, size);
+  if (!tree->data) {
+    parse_data->err = JIFFY_ERR_TREE_OUTPUT_MALLOC_FAILED;
+    return false;
+  }
 
-  jiffy_value_t *curr = NULL;
-  for (size_t i = 0; i < parse_data->obj_rows_ofs; i++) {
-    const jiffy_tree_parse_obj_row_t * const row = parse_data->obj_rows + i;
+  // copy byte data
+  jiffy_value32_t * const vals = (jiffy_value32_t*) tree->data;
+  const uint32_t bytes_ofs = (uint32_t) (num_vals * sizeof(jiffy_value32_t));
+  jiffy_tree_chunks_copy(&parse_data->bytes, tree->data + bytes_ofs);
+
+  // offset of next unassigned slice (the root value is at offset 0)
+  size_t next = 1;
+
+  // convert values
+  for (const jiffy_tree_chunk_t *chunk = parse_data->vals.head; chunk; chunk = chunk->next) {
+    jiffy_tree_parse_val_t * const src = (jiffy_tree_parse_val_t*) chunk->data;
+    const size_t len = chunk->len / sizeof(jiffy_tree_parse_val_t);
+
+    for (size_t i = 0; i < len; i++) {
+      // get output value from cursor of enclosing container
+      jiffy_value32_t * const dst = vals + (src[i].parent ? src[i].parent->ofs++ : 0);
+
+      // get length (object keys and values were counted separately)
+      const size_t val_len = (src[i].type == JIFFY_TYPE_OBJECT) ? (src[i].len / 2) : src[i].len;
+      if (val_len > JIFFY_TREE32_MAX_LEN) {
+        // free output data, return failure
+        jiffy_tree_data_free(parse_data->tree, tree->data);
+        tree->data = NULL;
+        parse_data->err = JIFFY_ERR_TREE32_TOO_LARGE;
+        return false;
+      }
 
-    if (curr != row->obj) {
-      // get current object, set object vals pointer
-      curr = row->obj;
-      curr->v_obj.vals = dst + 2 * i;
-    }
+      dst->info = TREE32_INFO(src[i].type, val_len);
+      switch (src[i].type) {
+      case JIFFY_TYPE_NUMBER:
+      case JIFFY_TYPE_STRING:
+        dst->ofs = bytes_ofs + src[i].ofs;
+        break;
+      case JIFFY_TYPE_ARRAY:
+      case JIFFY_TYPE_OBJECT:
+        dst->ofs = src[i].len ? (next * sizeof(jiffy_value32_t)) : 0;
 
-    // populate key/value
-    dst[2 * i] = row->key;
-    dst[2 * i + 1] = row->val;
+        // assign slice, save cursor
+        src[i].ofs = next;
+        next += src[i].len;
+        break;
+      default:
+        dst->ofs = 0;
+        break;
+      }
+    }
   }
+
+  tree->size = size;
+  tree->num_vals = num_vals;
+
+  // return success
+  return true;
 }
 
 // invoke on_error callback with error code
-#define TREE_FAIL(tree, err) do { \
+#define TREE32_FAIL(tree, err) do { \
   if ((tree)->cbs && (tree)->cbs->on_error) { \
     (tree)->cbs->on_error((tree), err); \
   } \
   return false; \
 } while (0)
 
-bool
-jiffy_tree_new_ex(
-  jiffy_tree_t * const tree,
-  const jiffy_tree_cbs_t * const cbs,
-  jiffy_parser_state_t * const stack,
-  const size_t stack_len,
+static bool
+jiffy_tree32_build(
+  jiffy_tree32_t * const tree,
+  const jiffy_tree32_cbs_t * const cbs,
+  const jiffy_file_t * const file,
   const void * const src,
   const size_t len,
   void * const user_data
 ) {
-  // check to make sure tree, is not null
-  if (!tree) {
-    // return failure
-    return false;
-  }
-
   // populate initial tree values
   tree->cbs = cbs;
   tree->user_data = user_data;
+  tree->data = NULL;
+  tree->size = 0;
+  tree->num_vals = 0;
+
+  // allocator adapter, so that the tree parser can use the callbacks of
+  // the compact tree
+  jiffy_tree_alloc_t alloc;
+  jiffy_tree_alloc_init(&alloc, cbs ? cbs->malloc : NULL, cbs ? cbs->free : NULL, user_data);
+
+  // start with a small stack; the parser grows it with the tree
+  // allocator if the document is nested more deeply
+  jiffy_parser_state_t stack_mem[TREE_STACK_LEN];
+  jiffy_tree_stack_t stack = {
+    .tree = &alloc.tree,
+    .ptr  = stack_mem,
+    .len  = TREE_STACK_LEN,
+    .grow = true,
+  };
+
+  // populate parse data
+  jiffy_tree_parse_data_t parse_data = {
+    .tree   = &alloc.tree,
+    .stack  = &stack,
+    .err    = JIFFY_ERR_OK,
+  };
+
+  // parse input in a single pass, then compact the result into the
+  // tree
+  const bool ok = (
+    jiffy_tree_parse(&parse_data, NULL, file, src, len) &&
+    jiffy_tree32_compact(tree, &parse_data)
+  );
 
-  // populate scan data
-  jiffy_tree_scan_data_t scan_data;
-  if (!jiffy_tree_scan(&scan_data, stack, stack_len, src, len)) {
-    TREE_FAIL(tree, scan_data.err);
+  // free parse memory
+  jiffy_tree_parse_data_free(&parse_data);
+  if (stack.owned) {
+    // free grown stack
+    jiffy_tree_data_free(&alloc.tree, stack.ptr);
   }
 
-  // save tree value count
-  tree->data = NULL;
-  tree->vals = NULL;
-  tree->num_vals = scan_data.num_vals;
-
-  if (tree->num_vals > 0) {
-    // allocate output data, check for error
-    tree->data = jiffy_tree_output_malloc(tree, &scan_data);
-    if (!tree->data) {
-      TREE_FAIL(tree, JIFFY_ERR_TREE_OUTPUT_MALLOC_FAILED);
-    }
+  if (!ok) {
+    TREE32_FAIL(tree, parse_data.err);
+  }
 
-    // populate output tree data
-    tree->vals = (jiffy_value_t*) (
-      tree->data +
+  // return success
+  return true;
+}
 
-      // space needed for array rows
-      sizeof(jiffy_value_t*) * scan_data.num_ary_rows +
+bool
+jiffy_tree32_new(
+  jiffy_tree32_t * const tree,
+  const jiffy_tree32_cbs_t * const cbs,
+  const void * const src,
+  const size_t len,
+  void * const user_data
+) {
+  // check to make sure tree is not null
+  if (!tree) {
+    // return failure
+    return false;
+  }
 
-      // space needed for object key/value rows
-      sizeof(jiffy_value_t*) * 2 * scan_data.num_obj_rows
-    );
+  return jiffy_tree32_build(tree, cbs, NULL, src, len, user_data);
+}
 
-    // allocate parse data memory, check for error
-    uint8_t * const parse_mem = jiffy_tree_parse_data_malloc(tree, &scan_data);
-    if (!parse_mem) {
-      TREE_FAIL(tree, JIFFY_ERR_TREE_PARSE_MALLOC_FAILED);
-    }
+/**
+ * Build function for jiffy_tree32_new_from_file().  See
+ * jiffy_file_build().
+ */
+static bool
+jiffy_tree32_build_file(
+  void * const ctx,
+  const jiffy_file_t * const file,
+  const void * const src,
+  const size_t len
+) {
+  jiffy_tree32_t * const tree = ctx;
+  return jiffy_tree32_build(tree, tree->cbs, file, src, len, tree->user_data);
+}
 
-    // populate parse data
-    jiffy_tree_parse_data_t parse_data = {
-      // scan data
-      .scan_data = &scan_data,
+bool
+jiffy_tree32_new_from_file(
+  jiffy_tree32_t * const tree,
+  const jiffy_tree32_cbs_t * const cbs,
+  const char * const path,
+  void * const user_data
+) {
+  // check to make sure tree is not null
+  if (!tree) {
+    // return failure
+    return false;
+  }
 
-      // output tree
-      .tree = tree,
+  // populate initial tree values (used by TREE32_FAIL() and
+  // jiffy_tree32_build_file())
+  tree->cbs = cbs;
+  tree->user_data = user_data;
 
-      // allocated parse memory
-      .data = parse_mem,
+  // build tree from file, check for open or map error
+  jiffy_err_t err = JIFFY_ERR_OK;
+  const bool r = jiffy_file_build(path, jiffy_tree32_build_file, tree, &err);
+  if (err != JIFFY_ERR_OK) {
+    TREE32_FAIL(tree, err);
+  }
 
-      // current offset into tree->vals
-      .vals_ofs = 0,
+  // return result
+  return r;
+}
 
-      // array rows (subset of parse_mem)
-      .ary_rows = (jiffy_tree_parse_ary_row_t*) (
-        parse_mem
-      ),
+void *
+jiffy_tree32_get_user_data(
+  const jiffy_tree32_t * const tree
+) {
+  return tree->user_data;
+}
 
-      // number of array rows
-      .ary_rows_ofs = 0,
+const jiffy_value32_t *
+jiffy_tree32_get_root_value(
+  const jiffy_tree32_t * const tree
+) {
+  return (tree->num_vals > 0) ? (const jiffy_value32_t*) tree->data : NULL;
+}
 
-      // object rows (subset of parse_mem)
-      .obj_rows = (jiffy_tree_parse_obj_row_t*) (
-        parse_mem +
-        sizeof(jiffy_tree_parse_ary_row_t) * scan_data.num_ary_rows
-      ),
+jiffy_type_t
+jiffy_tree32_value_get_type(
+  const jiffy_value32_t * const val
+) {
+  return val ? TREE32_TYPE(val) : JIFFY_TYPE_LAST;
+}
 
-      // number of object rows
-      .obj_rows_ofs = 0,
+const uint8_t *
+jiffy_tree32_number_get_bytes(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const val,
+  size_t * const len
+) {
+  if (jiffy_tree32_value_get_type(val) != JIFFY_TYPE_NUMBER) {
+    return NULL;
+  }
 
-      // container stack memory (subset of parse_mem)
-      .stack = (jiffy_value_t**) (
-        parse_mem +
-        sizeof(jiffy_tree_parse_ary_row_t) * scan_data.num_ary_rows +
-        sizeof(jiffy_tree_parse_obj_row_t) * scan_data.num_obj_rows
-      ),
+  if (len) {
+    *len = TREE32_LEN(val);
+  }
 
-      // container stack depth
-      .stack_pos = 0,
+  return TREE32_PTR(tree, val);
+}
 
-      // byte data
-      .bytes = (
-        // output data pointer
-        tree->data +
+const uint8_t *
+jiffy_tree32_string_get_bytes(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const val,
+  size_t * const len
+) {
+  if (jiffy_tree32_value_get_type(val) != JIFFY_TYPE_STRING) {
+    return NULL;
+  }
 
-        // space needed for array rows
-        sizeof(jiffy_value_t*) * scan_data.num_ary_rows +
+  if (len) {
+    *len = TREE32_LEN(val);
+  }
 
-        // space needed for object key/value rows
-        sizeof(jiffy_value_t*) * 2 * scan_data.num_obj_rows +
+  return TREE32_PTR(tree, val);
+}
 
-        // space needed for all values
-        sizeof(jiffy_value_t) * scan_data.num_vals
-      ),
+size_t
+jiffy_tree32_array_get_size(
+  const jiffy_value32_t * const val
+) {
+  return TREE32_LEN(val);
+}
 
-      // number of bytes
-      .bytes_ofs = 0,
+#define ARY32_NTH_VAL(tree, ary, ofs) ((const jiffy_value32_t*) TREE32_PTR((tree), (ary)) + (ofs))
 
-      // default error
-      .err = JIFFY_ERR_OK,
-    };
+const jiffy_value32_t *
+jiffy_tree32_array_get_nth(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const val,
+  const size_t ofs
+) {
+  const bool is_valid = (
+    // value is an array
+    (jiffy_tree32_value_get_type(val) == JIFFY_TYPE_ARRAY) &&
 
-    // parse tree, check for error
-    if (!jiffy_tree_parse(&parse_data, stack, stack_len, src, len)) {
-      TREE_FAIL(tree, parse_data.err);
-    }
+    // offset is in bounds
+    (ofs < TREE32_LEN(val))
+  );
 
-    // fill array rows
-    tree_parse_fill_ary_rows(&parse_data);
+  return is_valid ? ARY32_NTH_VAL(tree, val, ofs) : NULL;
+}
 
-    // fill object rows
-    tree_parse_fill_obj_rows(&parse_data);
+bool
+jiffy_tree32_array_each(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const ary,
+  void (*each_cb)(const jiffy_tree32_t *, const size_t, const jiffy_value32_t *, void *),
+  void * const user_data
+) {
+  if (jiffy_tree32_value_get_type(ary) != JIFFY_TYPE_ARRAY) {
+    // return failure
+    return false;
+  }
 
-    // free parser memory
-    jiffy_tree_data_free(tree, parse_mem);
+  if (each_cb) {
+    for (size_t i = 0; i < TREE32_LEN(ary); i++) {
+      each_cb(tree, i, ARY32_NTH_VAL(tree, ary, i), user_data);
+    }
   }
 
   // return success
   return true;
 }
 
-static size_t
-jiffy_tree_get_required_stack_depth(
-  jiffy_tree_t * const tree,
-  const void * const src_ptr,
-  const size_t len,
-  size_t *ret_depth
+size_t
+jiffy_tree32_object_get_size(
+  const jiffy_value32_t * const val
 ) {
-  const uint8_t * const src = src_ptr;
-  size_t depth = 0;
-  size_t max_depth = 16;
-  bool in_str = false;
-
-  for (size_t i = 0; i < len; i++) {
-    if (in_str) {
-      switch (src[i]) {
-      case '"':
-        // decriment depth
-        depth -= 2;
-        in_str = false;
-
-        break;
-      case '\\':
-        if ((i < len - 1) && src[i + 1] == '"') {
-          // skip escaped quote
-          i++;
-        }
-
-        break;
-      }
-    } else {
-      switch (src[i]) {
-      case '{':
-        depth += 4;
-        max_depth = MAX(depth, max_depth);
-
-        break;
-      case '}':
-        depth -= 4;
+  return TREE32_LEN(val);
+}
 
-        break;
-      case '[':
-        depth += 3;
-        max_depth = MAX(depth, max_depth);
+#define OBJ32_NTH_KEY(tree, obj, ofs) ((const jiffy_value32_t*) TREE32_PTR((tree), (obj)) + 2 * (ofs))
+#define OBJ32_NTH_VAL(tree, obj, ofs) ((const jiffy_value32_t*) TREE32_PTR((tree), (obj)) + 2 * (ofs) + 1)
 
-        break;
-      case ']':
-        depth -= 3;
+const jiffy_value32_t *
+jiffy_tree32_object_get_nth_key(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const val,
+  const size_t ofs
+) {
+  const bool is_valid = (
+    // value is an object
+    (jiffy_tree32_value_get_type(val) == JIFFY_TYPE_OBJECT) &&
 
-        break;
-      case '"':
-        depth += 2;
-        max_depth = MAX(depth, max_depth);
-        in_str = true;
+    // offset is in bounds
+    (ofs < TREE32_LEN(val))
+  );
 
-        break;
-      }
-    }
-  }
+  return is_valid ? OBJ32_NTH_KEY(tree, val, ofs) : NULL;
+}
 
-  if (depth != 0) {
-    // depth is nonzero, which means string isn't valid json
-    TREE_FAIL(tree, JIFFY_ERR_TREE_STACK_SCAN_FAILED);
-  }
+const jiffy_value32_t *
+jiffy_tree32_object_get_nth_value(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const val,
+  const size_t ofs
+) {
+  const bool is_valid = (
+    // value is an object
+    (jiffy_tree32_value_get_type(val) == JIFFY_TYPE_OBJECT) &&
 
-  if (ret_depth) {
-    // save result
-    *ret_depth = max_depth;
-  }
+    // offset is in bounds
+    (ofs < TREE32_LEN(val))
+  );
 
-  // return success
-  return true;
+  return is_valid ? OBJ32_NTH_VAL(tree, val, ofs) : NULL;
 }
 
 bool
-jiffy_tree_new(
-  jiffy_tree_t * const tree,
-  const jiffy_tree_cbs_t * const cbs,
-  const void * const src,
-  const size_t len,
+jiffy_tree32_object_each(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const obj,
+  void (*each_cb)(const jiffy_tree32_t *, const jiffy_value32_t *, const jiffy_value32_t *, void *),
   void * const user_data
 ) {
-  // check to make sure tree, is not null
-  if (!tree) {
-    // return failure
-    return false;
-  }
-
-  // populate initial tree values
-  tree->cbs = cbs;
-  tree->user_data = user_data;
-
-  // get needed stack size
-  size_t stack_len;
-  if (!jiffy_tree_get_required_stack_depth(tree, src, len, &stack_len)) {
+  if (jiffy_tree32_value_get_type(obj) != JIFFY_TYPE_OBJECT) {
     // return failure
     return false;
   }
 
-  // get number of bytes needed for stack
-  const size_t num_bytes = sizeof(jiffy_parser_state_t) * stack_len;
-
-  // alloc stack, check for error
-  jiffy_parser_state_t *stack = jiffy_tree_data_malloc(tree, num_bytes);
-  if (!stack) {
-    TREE_FAIL(tree, JIFFY_ERR_TREE_STACK_MALLOC_FAILED);
+  if (each_cb) {
+    for (size_t i = 0; i < TREE32_LEN(obj); i++) {
+      each_cb(tree, OBJ32_NTH_KEY(tree, obj, i), OBJ32_NTH_VAL(tree, obj, i), user_data);
+    }
   }
 
-  // parse tree, get result
-  const bool r = jiffy_tree_new_ex(tree, cbs, stack, stack_len, src, len, user_data);
-
-  // free stack
-  jiffy_tree_data_free(tree, stack);
-
-  // return result
-  return r;
-}
-
-void *
-jiffy_tree_get_user_data(
-  const jiffy_tree_t * const tree
-) {
-  return tree->user_data;
-}
-
-const jiffy_value_t *
-jiffy_tree_get_root_value(
-  const jiffy_tree_t * const tree
-) {
-  return (tree->num_vals > 0) ? tree->vals : NULL;
+  // return success
+  return true;
 }
 
 void
-jiffy_tree_free(
-  jiffy_tree_t * const tree
+jiffy_tree32_free(
+  jiffy_tree32_t * const tree
 ) {
   if (tree->data) {
     // free tree data
-    jiffy_tree_data_free(tree, tree->data);
+    if (tree->cbs && tree->cbs->free) {
+      tree->cbs->free(tree->data, tree->user_data);
+    } else {
+      free(tree->data);
+    }
+
     tree->data = NULL;
-    tree->vals = NULL;
 
-    // clear value count
+    // clear size and value count
+    tree->size = 0;
     tree->num_vals = 0;
   }
 }
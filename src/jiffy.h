@@ -29,10 +29,17 @@ extern "C" {
   JIFFY_DEF_ERR(EXPECTED_OBJECT_KEY, "expected object key"), \
   JIFFY_DEF_ERR(EXPECTED_COLON, "expected colon"), \
   JIFFY_DEF_ERR(NOT_DONE, "not done"), \
+  JIFFY_DEF_ERR(BAD_TAPE_EVENT, "bad tape event"), \
+  JIFFY_DEF_ERR(BAD_UTF8, "bad UTF-8"), \
+  JIFFY_DEF_ERR(STACK_REALLOC_FAILED, "stack realloc failed"), \
   JIFFY_DEF_ERR(TREE_STACK_SCAN_FAILED, "tree stack scan failed"), \
   JIFFY_DEF_ERR(TREE_STACK_MALLOC_FAILED, "tree stack malloc() failed"), \
   JIFFY_DEF_ERR(TREE_OUTPUT_MALLOC_FAILED, "tree output malloc() failed"), \
   JIFFY_DEF_ERR(TREE_PARSE_MALLOC_FAILED, "tree parse malloc() failed"), \
+  JIFFY_DEF_ERR(FILE_OPEN_FAILED, "file open() failed"), \
+  JIFFY_DEF_ERR(FILE_STAT_FAILED, "file fstat() failed or not a regular file"), \
+  JIFFY_DEF_ERR(FILE_MMAP_FAILED, "file mmap() failed"), \
+  JIFFY_DEF_ERR(TREE32_TOO_LARGE, "tree too large for 32-bit offsets"), \
   JIFFY_DEF_ERR(LAST, "unknown error"),
 
 /**
@@ -82,6 +89,12 @@ const char *jiffy_parser_state_to_s(
 // forward declaration
 typedef struct jiffy_parser_t_ jiffy_parser_t;
 
+// forward declaration
+typedef struct jiffy_tape_t_ jiffy_tape_t;
+
+// forward declaration (see below)
+typedef struct jiffy_filter_t_ jiffy_filter_t;
+
 /**
  * Parser event callback.
  */
@@ -104,6 +117,78 @@ typedef void (*jiffy_parser_byte_cb_t)(
   const uint8_t
 );
 
+/**
+ * Parser data callback.
+ *
+ * Used for parser callbacks which pass a span of data (on_string_data,
+ * on_number_data, etc).  The span is only valid for the duration of the
+ * callback.
+ */
+typedef void (*jiffy_parser_data_cb_t)(
+  // pointer to parser callback structure
+  const jiffy_parser_t *,
+
+  // pointer to parsed data
+  const uint8_t *,
+
+  // number of bytes of parsed data
+  const size_t
+);
+
+/**
+ * Parser stack reallocation callback.  Set with
+ * jiffy_parser_set_stack_realloc().
+ *
+ * Called like realloc(): with a NULL pointer to allocate memory, with
+ * a non-NULL pointer to resize memory which was returned by an earlier
+ * call (preserving its contents), and with a size of zero to free
+ * memory, in which case it should return NULL.  Returns NULL if the
+ * memory could not be allocated.
+ */
+typedef void *(*jiffy_parser_realloc_cb_t)(
+  // pointer to memory to resize or free, or NULL
+  void * const,
+
+  // new size, in bytes
+  const size_t,
+
+  // opaque pointer to user data of parser
+  void * const
+);
+
+/**
+ * Parser signed integer callback.  Used by on_number_int64.
+ */
+typedef void (*jiffy_parser_int64_cb_t)(
+  // pointer to parser callback structure
+  const jiffy_parser_t *,
+
+  // parsed value
+  const int64_t
+);
+
+/**
+ * Parser unsigned integer callback.  Used by on_number_uint64.
+ */
+typedef void (*jiffy_parser_uint64_cb_t)(
+  // pointer to parser callback structure
+  const jiffy_parser_t *,
+
+  // parsed value
+  const uint64_t
+);
+
+/**
+ * Parser double callback.  Used by on_number_double.
+ */
+typedef void (*jiffy_parser_double_cb_t)(
+  // pointer to parser callback structure
+  const jiffy_parser_t *,
+
+  // parsed value
+  const double
+);
+
 /**
  * Parser callbacks.
  *
@@ -193,8 +278,120 @@ typedef struct {
     // error code
     const jiffy_err_t
   );
+
+  // span of string value.  Unescaped runs are passed directly from the
+  // buffer given to jiffy_parser_push(); runs are only split by escape
+  // sequences and by buffer boundaries.
+  const jiffy_parser_data_cb_t on_string_data;
+
+  // span of number value, including the sign.  The whole number is
+  // passed as a single span unless it crosses a buffer boundary, in
+  // which case it is passed as one span per buffer.
+  const jiffy_parser_data_cb_t on_number_data;
+
+  // value of a number without a fraction or exponent which fits in a
+  // int64_t.  Fired before on_number_end.
+  const jiffy_parser_int64_cb_t on_number_int64;
+
+  // value of a number without a minus sign, fraction, or exponent which
+  // fits in a uint64_t.  Fired before on_number_end.
+  const jiffy_parser_uint64_cb_t on_number_uint64;
+
+  // value of a number as a double, correctly rounded (round to
+  // nearest, ties to even).  Fired for every number, before
+  // on_number_end.  Numbers which are too large are passed as
+  // infinity.
+  const jiffy_parser_double_cb_t on_number_double;
+
+  // end of a top-level value.  Only fired in multi-document mode (see
+  // JIFFY_PARSER_FLAG_MULTI_DOCUMENT).
+  const jiffy_parser_cb_t on_document_end;
 } jiffy_parser_cbs_t;
 
+/**
+ * Maximum number of parser states stored between the innermost
+ * container and the current parser state.
+ */
+#define JIFFY_PARSER_MAX_TOP_STATES 4
+
+/**
+ * Maximum number of significant digits past the first 19 which the
+ * parser keeps for a number, so that the number can be correctly
+ * rounded to a double.  Digits past these only matter if they are
+ * non-zero.
+ */
+#define JIFFY_PARSER_MAX_NUMBER_DIGITS 784
+
+/**
+ * Number of times the parser invoked each callback (see
+ * jiffy_parser_cbs_t).  Callbacks which are not set are not counted.
+ */
+typedef struct {
+  uint64_t on_utf8_bom,
+           on_utf16_bom,
+           on_null,
+           on_true,
+           on_false,
+           on_array_start,
+           on_array_end,
+           on_array_element_start,
+           on_array_element_end,
+           on_object_start,
+           on_object_end,
+           on_object_key_start,
+           on_object_key_end,
+           on_object_value_start,
+           on_object_value_end,
+           on_string_start,
+           on_string_byte,
+           on_string_data,
+           on_string_end,
+           on_number_start,
+           on_number_byte,
+           on_number_data,
+           on_number_end,
+           on_number_sign,
+           on_number_fraction,
+           on_number_exponent,
+           on_number_int64,
+           on_number_uint64,
+           on_number_double,
+           on_document_end,
+           on_error;
+} jiffy_parser_events_t;
+
+/**
+ * Parser statistics.  Returned by jiffy_parser_get_stats().
+ *
+ * Statistics are only collected if JIFFY_PARSER_STATS is defined when
+ * compiling jiffy.c and everything which includes jiffy.h, because it
+ * changes the size of the parser context.
+ */
+typedef struct {
+  // number of bytes consumed, by class.  Quotes count as string bytes,
+  // and bytes which end a number or literal count as structural or
+  // whitespace bytes.  Bytes consumed by jiffy_parser_skip_value()
+  // count as skipped bytes.
+  struct {
+    uint64_t whitespace,
+             structural,
+             string,
+             number,
+             literal,
+             skipped;
+  } bytes;
+
+  // number of times each callback was invoked
+  jiffy_parser_events_t events;
+
+  // maximum depth of the state stack
+  uint64_t max_stack_depth;
+
+  // number of calls to jiffy_parser_push() and
+  // jiffy_parser_push_index()
+  uint64_t num_pushes;
+} jiffy_parser_stats_t;
+
 /**
  * Parser context.
  *
@@ -206,32 +403,119 @@ struct jiffy_parser_t_ {
   // jiffy_parser_init() parameter.
   const jiffy_parser_cbs_t *cbs;
 
+  // current parser state (top of the state stack).  Accessible via
+  // the jiffy_parser_get_state() function.
+  jiffy_parser_state_t state;
+
+  // states between the innermost container and the current state, such
+  // as the start state of the innermost container and the key and
+  // string states of an object key.
+  jiffy_parser_state_t top[JIFFY_PARSER_MAX_TOP_STATES];
+
+  // number of states in top
+  size_t top_len;
+
   // pointer to memory for state stack.  Provided by user via a
   // jiffy_parser_init() parameter.
+  //
+  // Enclosing containers are stored as a bitset with one bit per
+  // nesting level (set for objects, clear for arrays), so each entry
+  // holds 32 nesting levels.
   jiffy_parser_state_t *stack_ptr;
 
   // number of entries in stack memory.  Provided by user via a
   // jiffy_parser_init() parameter.
   size_t stack_len;
 
-  // stack position
+  // number of enclosing containers in the bitset
+  size_t depth;
+
+  // logical stack position
   size_t stack_pos;
 
+  // stack reallocation callback, and maximum number of entries in
+  // state stack.  Set by jiffy_parser_set_stack_realloc().
+  jiffy_parser_realloc_cb_t stack_realloc;
+  size_t stack_max;
+
+  // true if the stack memory was allocated by stack_realloc.
+  _Bool stack_owned;
+
   // number of bytes parsed so far.  Accessible via the
   // jiffy_parser_et_num_bytes() function.
   size_t num_bytes;
 
+  // pending span of string or number data (internal).  Points into the
+  // buffer passed to jiffy_parser_push().
+  struct {
+    const uint8_t *ptr;
+    size_t len;
+  } span;
+
   union {
     struct {
       // parsed hex value.  used to decode unicode escape sequences.
       uint32_t hex;
+
+      // UTF-8 validator state: number of continuation bytes needed, and
+      // the valid range of the next continuation byte.
+      uint8_t utf8_need, utf8_lo, utf8_hi;
     } v_str;
+
+    struct {
+      // accumulated significand digits.
+      uint64_t man;
+
+      // decimal exponent adjustment for fraction digits and dropped
+      // integer digits.
+      int64_t exp10;
+
+      // parsed exponent (saturated).
+      uint32_t exp;
+
+      // number flags (internal).
+      uint32_t flags;
+
+      // number of significant digits which did not fit in man
+      uint32_t num_digits;
+
+      // significant digits which did not fit in man, packed two per
+      // byte, low nibble first.
+      uint8_t digits[JIFFY_PARSER_MAX_NUMBER_DIGITS / 2];
+    } v_num;
+
+    struct {
+      // bracket depth of skipped value.
+      size_t depth;
+    } v_skip;
   };
 
+  // pointer to event tape.  Set by jiffy_parser_init_tape(); NULL for
+  // parsers which were initialized with jiffy_parser_init().
+  jiffy_tape_t *tape;
+
+  // pointer to path filter.  Set by jiffy_parser_init_filter(); NULL
+  // for parsers which were initialized with jiffy_parser_init().
+  jiffy_filter_t *filter;
+
+  // parser flags (JIFFY_PARSER_FLAG_*).  Accessible via the
+  // jiffy_parser_set_flags() and jiffy_parser_get_flags() functions.
+  uint32_t flags;
+
+  // true if parsing was stopped by jiffy_parser_stop().  Accessible via
+  // the jiffy_parser_is_stopped() function.
+  _Bool stopped;
+
   // opaque pointer to user data.  Provided by user via a
   // jiffy_parser_init() parameter.  Accessible via the
   // jiffy_parser_get_user_data() function.
   void *user_data;
+
+#ifdef JIFFY_PARSER_STATS
+  // parser statistics.  Accessible via the jiffy_parser_get_stats()
+  // function.
+  jiffy_parser_stats_t stats;
+#endif // JIFFY_PARSER_STATS
 };
 
 /**
@@ -253,13 +537,56 @@ _Bool jiffy_parser_init(
   // memory for state stack (required)
   jiffy_parser_state_t * const,
 
-  // number of entries in state stack (required, must be non-zero)
+  // number of entries in state stack (required, at least 2).
+  // Each entry holds 32 nesting levels, so 32 entries (128 bytes) are
+  // enough for a document nested 1000 levels deep.
   const size_t,
 
   // opaque pointer to user data (optional)
   void * const
 );
 
+/**
+ * Let the state stack of a parser grow on demand.
+ *
+ * When the state stack is full, the parser doubles its size with the
+ * given callback, up to the given maximum number of entries; deeper
+ * documents fail with JIFFY_ERR_STACK_OVERFLOW, and failed allocations
+ * fail with JIFFY_ERR_STACK_REALLOC_FAILED.  The memory passed to
+ * jiffy_parser_init() is copied into the first allocation and is never
+ * passed to the callback.  Call jiffy_parser_free_stack() to free the
+ * allocated memory when you are done with the parser.
+ *
+ * Call this function after initializing the parser and before parsing
+ * any data.  Pass a NULL callback to disable growing.
+ *
+ * Returns false if any of the following errors occur:
+ *
+ * - the parser context is NULL
+ * - the callback is non-NULL and the maximum number of entries is less
+ *   than the number of entries in the current state stack
+ */
+_Bool jiffy_parser_set_stack_realloc(
+  // pointer to parser context (required)
+  jiffy_parser_t * const,
+
+  // stack reallocation callback (optional, may be NULL)
+  const jiffy_parser_realloc_cb_t,
+
+  // maximum number of entries in state stack
+  const size_t
+);
+
+/**
+ * Free the state stack memory allocated with the callback set by
+ * jiffy_parser_set_stack_realloc(), if any.  The parser must not be
+ * used afterwards.
+ */
+void jiffy_parser_free_stack(
+  // pointer to parser context (required)
+  jiffy_parser_t * const
+);
+
 /**
  * Return user data associated with parser.
  */
@@ -276,6 +603,117 @@ size_t jiffy_parser_get_num_bytes(
   const jiffy_parser_t * const
 );
 
+/**
+ * Copy the parser statistics into the given structure.  Returns false
+ * if the library was compiled without JIFFY_PARSER_STATS.
+ */
+_Bool jiffy_parser_get_stats(
+  // pointer to parser context (required)
+  const jiffy_parser_t * const,
+
+  // pointer to statistics (required)
+  jiffy_parser_stats_t * const
+);
+
+/**
+ * Return the current state of the parser.  Useful for debugging; use
+ * jiffy_parser_state_to_s() to get the name of the state.
+ */
+jiffy_parser_state_t jiffy_parser_get_state(
+  // pointer to parser context (required)
+  const jiffy_parser_t * const
+);
+
+/**
+ * Parser flags.  Set with jiffy_parser_set_flags().
+ */
+typedef enum {
+  // validate the UTF-8 encoding of string data.  Invalid UTF-8 (bad or
+  // missing continuation bytes, overlong encodings, surrogates, and
+  // code points above U+10FFFF) fails with JIFFY_ERR_BAD_UTF8, and
+  // jiffy_parser_get_num_bytes() returns the offset of the first
+  // invalid byte.  Bytes produced by escape sequences are not checked.
+  JIFFY_PARSER_FLAG_VALIDATE_UTF8 = (1 << 0),
+
+  // parse a stream of documents (for example, newline-delimited JSON).
+  // The parser fires on_document_end after each top-level value and
+  // then starts over, so each document may be preceded by whitespace
+  // and a BOM.  jiffy_parser_fini() succeeds at the end of any
+  // document, including an empty stream.
+  JIFFY_PARSER_FLAG_MULTI_DOCUMENT = (1 << 1),
+} jiffy_parser_flag_t;
+
+/**
+ * Set parser flags (a bitmask of JIFFY_PARSER_FLAG_* values).  Call
+ * this function after initializing the parser and before parsing any
+ * data.
+ */
+void jiffy_parser_set_flags(
+  // pointer to parser context (required)
+  jiffy_parser_t * const,
+
+  // flags
+  const uint32_t
+);
+
+/**
+ * Return parser flags.
+ */
+uint32_t jiffy_parser_get_flags(
+  // pointer to parser context (required)
+  const jiffy_parser_t * const
+);
+
+/**
+ * Skip the next value.
+ *
+ * Call this function from the on_array_element_start,
+ * on_object_key_end, or on_object_value_start callback.  The parser
+ * skips the array element or object value with a fast scan which only
+ * tracks strings and bracket depth, and fires no callbacks for it.
+ * The surrounding on_array_element_end, on_object_value_start, and
+ * on_object_value_end callbacks are still fired.
+ *
+ * Note: Skipped values are not validated beyond matching quotes and
+ * brackets.  For example, a skipped "[1,,2}" is accepted.
+ *
+ * Returns true if the value will be skipped, or false if this function
+ * was called at any other point.
+ */
+_Bool jiffy_parser_skip_value(
+  // pointer to parser context (required)
+  const jiffy_parser_t * const
+);
+
+/**
+ * Stop parsing.
+ *
+ * Call this function from any callback.  The parser finishes the byte
+ * or token which fired the callback, and then jiffy_parser_push()
+ * returns true immediately without parsing the rest of the buffer.
+ * Finishing the byte may fire a few more callbacks; for example, the
+ * closing bracket which fires on_object_value_end also fires
+ * on_object_end.  Pending string or number data is dropped.  Use
+ * jiffy_parser_get_num_bytes() to get the number of bytes consumed.
+ *
+ * Stopping is not an error: once stopped, jiffy_parser_push() and
+ * jiffy_parser_push_index() return true without parsing anything, and
+ * jiffy_parser_fini() returns true.  Use jiffy_parser_is_stopped() to
+ * tell a stopped parser from a finished one.
+ */
+void jiffy_parser_stop(
+  // pointer to parser context (required)
+  const jiffy_parser_t * const
+);
+
+/**
+ * Returns true if parsing was stopped with jiffy_parser_stop().
+ */
+_Bool jiffy_parser_is_stopped(
+  // pointer to parser context (required)
+  const jiffy_parser_t * const
+);
+
 /**
  * Parse buffer of data.
  *
@@ -322,7 +760,7 @@ _Bool jiffy_parse(
   // memory for state stack (required)
   jiffy_parser_state_t * const,
 
-  // number of entries in state stack (required, must be non-zero)
+  // number of entries in state stack (required, at least 2)
   const size_t,
 
   // pointer to input buffer (required)
@@ -335,113 +773,973 @@ _Bool jiffy_parse(
   void * const
 );
 
-#define JIFFY_TYPE_LIST \
-  JIFFY_DEF_TYPE(NULL, "null"), \
-  JIFFY_DEF_TYPE(TRUE, "true"), \
-  JIFFY_DEF_TYPE(FALSE, "false"), \
-  JIFFY_DEF_TYPE(NUMBER, "number"), \
-  JIFFY_DEF_TYPE(STRING, "string"), \
-  JIFFY_DEF_TYPE(ARRAY, "array"), \
-  JIFFY_DEF_TYPE(OBJECT, "object"), \
-  JIFFY_DEF_TYPE(LAST, "invalid"),
-
-typedef enum {
-#define JIFFY_DEF_TYPE(a, b) JIFFY_TYPE_##a
-JIFFY_TYPE_LIST
-#undef JIFFY_DEF_TYPE
-} jiffy_type_t;
+/**
+ * Maximum number of bytes of a file which jiffy_parse_file() and
+ * jiffy_tree_new_from_file() map at once.  Files up to this size are
+ * mapped in a single piece; larger files are mapped as a sliding window
+ * of this size (rounded down to the page size).
+ *
+ * Define this when compiling jiffy.c to change the address-space budget.
+ */
+#ifndef JIFFY_FILE_MAP_MAX
+#define JIFFY_FILE_MAP_MAX \
+  ((sizeof(size_t) > 4) ? ((size_t) 1 << 40) : ((size_t) 1 << 28))
+#endif // JIFFY_FILE_MAP_MAX
 
 /**
- * Convert value type to human-readable text.
+ * Convenience function to parse a file in a single call.
  *
- * Note: The string returned by this method is read-only.
+ * The file is mapped read-only with mmap() and passed straight to
+ * jiffy_parser_push(), so it is never copied into a heap buffer.  The
+ * mapping is advised for sequential access (and for huge pages, where
+ * available).  Files larger than JIFFY_FILE_MAP_MAX are parsed through
+ * a sliding window, so pointers passed to the data callbacks are only
+ * valid for the duration of the callback.
+ *
+ * Returns true on success.  If an error occurs, then the on_error
+ * callback is called with an error code, and this function returns
+ * false.  Errors opening, checking, or mapping the file are reported
+ * as JIFFY_ERR_FILE_OPEN_FAILED, JIFFY_ERR_FILE_STAT_FAILED, and
+ * JIFFY_ERR_FILE_MMAP_FAILED; errno is preserved for open(), fstat(),
+ * and mmap() failures.
  */
-const char *jiffy_type_to_s(
-  const jiffy_type_t
-);
+_Bool jiffy_parse_file(
+  // pointer to parser callback structure (optional, may be NULL)
+  const jiffy_parser_cbs_t * const,
 
-// forward declaration
-typedef struct jiffy_value_t_ jiffy_value_t;
+  // memory for state stack (required)
+  jiffy_parser_state_t * const,
 
-struct jiffy_value_t_ {
-  jiffy_type_t type;
+  // number of entries in state stack (required, at least 2)
+  const size_t,
 
-  union {
-    struct {
-      uint8_t *ptr;
-      size_t len;
-    } v_num;
+  // path to input file (required)
+  const char * const,
 
-    struct {
-      uint8_t *ptr;
-      size_t len;
-    } v_str;
+  // opaque pointer to user data (optional)
+  void * const
+);
 
-    struct {
-      jiffy_value_t **vals;
-      size_t len;
-    } v_obj;
+/**
+ * Structural index.
+ *
+ * Holds a bitmap with one bit for each byte of a buffer.  The bits of
+ * the following bytes are set:
+ *
+ * - structural characters (`{`, `}`, `[`, `]`, `:`, and `,`) which
+ *   are outside of strings
+ * - the opening and closing quote of every string
+ * - the first byte of every literal or number
+ *
+ * Any bytes between the indexed positions are either whitespace, the
+ * remainder of a literal or number, or the body of a string.  This
+ * lets jiffy_parser_push_index() jump from one position to the next
+ * instead of visiting every byte.
+ *
+ * Build an index with jiffy_index_build().
+ *
+ * Note: You should not access the fields of this structure directly.
+ * Use the jiffy_index_get_*() functions instead.
+ */
+typedef struct {
+  // pointer to memory for bitmap.  Provided by user via a
+  // jiffy_index_init() parameter.
+  uint64_t *ptr;
 
-    struct {
-      jiffy_value_t **vals;
-      size_t len;
-    } v_ary;
-  };
-};
+  // number of words in bitmap memory.  Provided by user via a
+  // jiffy_index_init() parameter.
+  size_t cap;
+
+  // number of bytes in indexed buffer.
+  size_t len;
+} jiffy_index_t;
 
 /**
- * Get the type of the given value.
+ * Number of bitmap words needed to index a buffer of the given size.
  */
-jiffy_type_t jiffy_value_get_type(
-  const jiffy_value_t * const
-);
+#define JIFFY_INDEX_NUM_WORDS(len) (((len) + 63) / 64)
 
 /**
- * Get a pointer to bytes and the number of bytes of the given number
- * value.
+ * Initialize a structural index.
  *
- * Returns NULL if the given value is not a number.
+ * The bitmap memory needs one word for each 64 bytes of input (see
+ * JIFFY_INDEX_NUM_WORDS()).
+ *
+ * Returns false if the index or the bitmap memory pointer is NULL.
  */
-const uint8_t *jiffy_number_get_bytes(
-  // value
-  const jiffy_value_t * const,
+_Bool jiffy_index_init(
+  // pointer to index (required)
+  jiffy_index_t * const,
 
-  // pointer to store byte length
-  size_t * const
+  // memory for bitmap (required)
+  uint64_t * const,
+
+  // number of words in bitmap memory
+  const size_t
 );
 
 /**
- * Get a pointer to bytes and the number of bytes of the given string
- * value.
+ * Populate index from the given buffer.
  *
- * Returns NULL if the given value is not a string.
+ * Uses SSE2 (or AVX2, if available) to classify 64 bytes at a time,
+ * and a carry-less multiply (if available) to find the bytes which are
+ * inside of strings.
+ *
+ * Returns false if the bitmap memory is too small, or if the buffer
+ * ends inside of a string.
  */
-const uint8_t *jiffy_string_get_bytes(
-  // string value
-  const jiffy_value_t * const,
+_Bool jiffy_index_build(
+  // pointer to index (required)
+  jiffy_index_t * const,
 
-  // pointer to returned byte count
-  size_t * const
+  // pointer to input buffer (required)
+  const void * const,
+
+  // size of input buffer, in bytes
+  const size_t
 );
 
 /**
- * Get the number of elements in the given array value.
+ * Get the bitmap of the given index.  Bit N of word W is set if byte
+ * 64 * W + N of the buffer is indexed.
  *
- * Note: Results are undefined if the given value is not an array.
+ * Note: The array returned by this method is read-only.
  */
-size_t jiffy_array_get_size(
-  // array value
-  const jiffy_value_t * const
+const uint64_t *jiffy_index_get_bits(
+  // pointer to index (required)
+  const jiffy_index_t * const,
+
+  // pointer to returned word count
+  size_t * const
+);
+
+/**
+ * Parse buffer of data using a structural index.
+ *
+ * The index must have been built from the same buffer, and the parser
+ * must not be inside of a string.  The callbacks fired are identical
+ * to those fired by jiffy_parser_push(), but whitespace between tokens
+ * is skipped without being examined, structural characters are parsed
+ * without scanning for them, and string bodies without escapes are
+ * passed on in one span.
+ *
+ * Returns true on success.  If an error occurs, the on_error callback
+ * is called with an error code, and this function return false.
+ */
+_Bool jiffy_parser_push_index(
+  // pointer to parser context (required)
+  jiffy_parser_t * const,
+
+  // pointer to index (required)
+  const jiffy_index_t * const,
+
+  // pointer to input buffer (required)
+  const void * const,
+
+  // size of input buffer, in bytes
+  const size_t
+);
+
+/**
+ * Tape event types.
+ */
+#define JIFFY_TAPE_EVENT_LIST \
+  JIFFY_DEF_TAPE_EVENT(UTF8_BOM, "utf8 bom"), \
+  JIFFY_DEF_TAPE_EVENT(UTF16_BOM, "utf16 bom"), \
+  JIFFY_DEF_TAPE_EVENT(NULL, "null"), \
+  JIFFY_DEF_TAPE_EVENT(TRUE, "true"), \
+  JIFFY_DEF_TAPE_EVENT(FALSE, "false"), \
+  JIFFY_DEF_TAPE_EVENT(ARRAY_START, "array start"), \
+  JIFFY_DEF_TAPE_EVENT(ARRAY_END, "array end"), \
+  JIFFY_DEF_TAPE_EVENT(ARRAY_ELEMENT_START, "array element start"), \
+  JIFFY_DEF_TAPE_EVENT(ARRAY_ELEMENT_END, "array element end"), \
+  JIFFY_DEF_TAPE_EVENT(OBJECT_START, "object start"), \
+  JIFFY_DEF_TAPE_EVENT(OBJECT_END, "object end"), \
+  JIFFY_DEF_TAPE_EVENT(OBJECT_KEY_START, "object key start"), \
+  JIFFY_DEF_TAPE_EVENT(OBJECT_KEY_END, "object key end"), \
+  JIFFY_DEF_TAPE_EVENT(OBJECT_VALUE_START, "object value start"), \
+  JIFFY_DEF_TAPE_EVENT(OBJECT_VALUE_END, "object value end"), \
+  JIFFY_DEF_TAPE_EVENT(DOCUMENT_END, "document end"), \
+  JIFFY_DEF_TAPE_EVENT(STRING, "string"), \
+  JIFFY_DEF_TAPE_EVENT(NUMBER, "number"), \
+  JIFFY_DEF_TAPE_EVENT(ERROR, "error"), \
+  JIFFY_DEF_TAPE_EVENT(LAST, "unknown tape event"),
+
+/**
+ * Tape event type.  Each parser callback except for the per-byte and
+ * per-span callbacks has a matching tape event type; a whole string or
+ * number is recorded as a single STRING or NUMBER event.
+ */
+typedef enum {
+#define JIFFY_DEF_TAPE_EVENT(a, b) JIFFY_TAPE_EVENT_##a
+JIFFY_TAPE_EVENT_LIST
+#undef JIFFY_DEF_TAPE_EVENT
+} jiffy_tape_event_type_t;
+
+/**
+ * Convert a tape event type to human-readable text.
+ *
+ * Note: The string returned by this method is read-only.
+ */
+const char *jiffy_tape_event_type_to_s(
+  // tape event type
+  const jiffy_tape_event_type_t
+);
+
+/**
+ * Tape event.
+ *
+ * The offset and length refer to the source text of the event, and
+ * the offset is counted from the first byte passed to the parser:
+ *
+ * - strings: the whole string, including both quotes.  Escape
+ *   sequences are not decoded.
+ * - numbers, literals, and byte order marks: the whole token.
+ * - array and object start and end: the bracket (length 1).
+ * - element, key, and value start and end: the position where the
+ *   event occurred (length 0).
+ * - errors: the position of the byte which caused the error.  The
+ *   length field holds the error code (a jiffy_err_t).
+ */
+typedef struct {
+  // event type
+  jiffy_tape_event_type_t type;
+
+  // nesting depth (number of enclosing arrays and objects)
+  uint32_t depth;
+
+  // offset of source text
+  size_t ofs;
+
+  // length of source text, in bytes
+  size_t len;
+} jiffy_tape_event_t;
+
+/**
+ * Minimum number of free events which a tape must have before each
+ * parsing step.  jiffy_parser_push() returns early when the free space
+ * in the tape drops below this value.
+ */
+#define JIFFY_TAPE_MIN_FREE 8
+
+/**
+ * Event tape.
+ *
+ * Filled by a parser which was initialized with
+ * jiffy_parser_init_tape().
+ *
+ * Note: You should not access the fields of this structure directly.
+ * Use the jiffy_tape_*() functions instead.
+ */
+struct jiffy_tape_t_ {
+  // pointer to memory for events.  Provided by user via a
+  // jiffy_tape_init() parameter.
+  jiffy_tape_event_t *ptr;
+
+  // number of entries in event memory.  Provided by user via a
+  // jiffy_tape_init() parameter.
+  size_t cap;
+
+  // number of events in tape.
+  size_t len;
+
+  // current nesting depth (internal)
+  uint32_t depth;
+
+  // offset of pending string or number (internal)
+  size_t ofs;
+};
+
+/**
+ * Initialize an event tape.
+ *
+ * Returns false if any of the following errors occur:
+ *
+ * - the tape is NULL
+ * - the event memory pointer is NULL
+ * - the number of event memory entries is less than
+ *   JIFFY_TAPE_MIN_FREE
+ */
+_Bool jiffy_tape_init(
+  // pointer to tape (required)
+  jiffy_tape_t * const,
+
+  // memory for events (required)
+  jiffy_tape_event_t * const,
+
+  // number of entries in event memory
+  const size_t
+);
+
+/**
+ * Get the events in the given tape.
+ *
+ * Note: The array returned by this method is read-only.
+ */
+const jiffy_tape_event_t *jiffy_tape_get_events(
+  // pointer to tape (required)
+  const jiffy_tape_t * const,
+
+  // pointer to returned event count
+  size_t * const
+);
+
+/**
+ * Remove all events from the given tape.  Call this function after
+ * draining the tape and before pushing more data.
+ */
+void jiffy_tape_clear(
+  // pointer to tape (required)
+  jiffy_tape_t * const
+);
+
+/**
+ * Initialize a parser in tape mode.
+ *
+ * Instead of firing callbacks, a parser in tape mode appends events to
+ * the given tape.  Errors are recorded as JIFFY_TAPE_EVENT_ERROR
+ * events.
+ *
+ * When the tape is full, jiffy_parser_push() and
+ * jiffy_parser_push_index() stop early and return true.  Use
+ * jiffy_parser_get_num_bytes() to find the number of bytes consumed,
+ * drain and clear the tape, and then push the remaining bytes with
+ * jiffy_parser_push().
+ *
+ * jiffy_parser_fini() returns false without recording an error if the
+ * tape has fewer than JIFFY_TAPE_MIN_FREE free events.
+ *
+ * Returns false if any of the following errors occur:
+ *
+ * - the parser context is NULL
+ * - the tape is NULL
+ * - the stack memory pointer is NULL
+ * - the number of stack memory elements is less than 2
+ */
+_Bool jiffy_parser_init_tape(
+  // pointer to parser context (required)
+  jiffy_parser_t * const,
+
+  // pointer to tape (required)
+  jiffy_tape_t * const,
+
+  // memory for state stack (required)
+  jiffy_parser_state_t * const,
+
+  // number of entries in state stack (required, at least 2)
+  const size_t,
+
+  // opaque pointer to user data (optional)
+  void * const
+);
+
+/**
+ * Replay the events in a tape through the given parser callbacks.
+ *
+ * Fires the same callbacks, in the same order, as parsing the source
+ * text directly with jiffy_parser_push(); string and number events are
+ * expanded into their per-byte, per-span, sign, fraction, and exponent
+ * callbacks.  The exception is a string or number which is cut short
+ * by an error: the tape only records the error, so the on_string_start
+ * or on_number_start callback and any byte or span callbacks which
+ * were fired for the partial value before the error are not replayed.
+ *
+ * The parser passed to the callbacks is a temporary parser with the
+ * given user data; jiffy_parser_get_num_bytes() returns the same value
+ * as it did during the original parse.  A tape can be replayed any
+ * number of times.
+ *
+ * Returns true on success.  Returns false if the tape contains an error
+ * event, or if an event is invalid or out of bounds of the source
+ * buffer.  In both cases the on_error callback is called with the
+ * error code.
+ */
+_Bool jiffy_tape_replay(
+  // pointer to tape (required)
+  const jiffy_tape_t * const,
+
+  // pointer to parser callback structure (optional, may be NULL)
+  const jiffy_parser_cbs_t * const,
+
+  // pointer to source buffer (required)
+  const void * const,
+
+  // size of source buffer, in bytes
+  const size_t,
+
+  // opaque pointer to user data (optional)
+  void * const
+);
+
+/**
+ * Maximum number of paths in a filter.
+ */
+#define JIFFY_FILTER_MAX_PATHS 64
+
+/**
+ * Maximum number of reference tokens in a filter path.
+ */
+#define JIFFY_FILTER_MAX_DEPTH 32
+
+/**
+ * Maximum total number of reference tokens in all of the paths of a
+ * filter.
+ */
+#define JIFFY_FILTER_MAX_STEPS 256
+
+/**
+ * Maximum length of a reference token in a filter path, in bytes,
+ * after decoding escape sequences.
+ */
+#define JIFFY_FILTER_MAX_KEY_LEN 256
+
+/**
+ * Reference token of a compiled filter path.
+ *
+ * Note: You should not access the fields of this structure directly.
+ */
+typedef struct {
+  // pointer to token text, not including the leading slash.  Points
+  // into the path given to jiffy_filter_init().
+  const char *ptr;
+
+  // length of token text, in bytes (before decoding "~0" and "~1").
+  size_t len;
+
+  // array index, or SIZE_MAX if the token is not an array index.
+  size_t index;
+
+  // true if the token is "*", which matches any key or index.
+  _Bool wildcard;
+} jiffy_filter_step_t;
+
+/**
+ * Path filter.
+ *
+ * A filter is compiled once from a set of JSON Pointer paths (RFC
+ * 6901) with jiffy_filter_init(), and then attached to a parser with
+ * jiffy_parser_init_filter().  The parser only fires callbacks for the
+ * values which match one of the paths, and skips everything else with
+ * jiffy_parser_skip_value().
+ *
+ * Note: You should not access the fields of this structure directly.
+ * Use the jiffy_filter_*() functions instead.
+ */
+struct jiffy_filter_t_ {
+  // pointer to parser callback structure. Provided by user via a
+  // jiffy_filter_init() parameter.
+  const jiffy_parser_cbs_t *cbs;
+
+  // compiled reference tokens of all paths.
+  jiffy_filter_step_t steps[JIFFY_FILTER_MAX_STEPS];
+
+  // offset of first step and number of steps of each path.
+  struct {
+    uint16_t ofs, len;
+  } paths[JIFFY_FILTER_MAX_PATHS];
+
+  // number of paths.
+  size_t num_paths;
+
+  // paths which are live in each open array or object (internal).
+  uint64_t live[JIFFY_FILTER_MAX_DEPTH + 1];
+
+  // index of next element of each open array (internal).
+  size_t index[JIFFY_FILTER_MAX_DEPTH + 1];
+
+  // number of open arrays and objects which are on a path (internal).
+  size_t depth;
+
+  // paths which may match the next value (internal).
+  uint64_t pending;
+
+  // true while forwarding a matching value (internal).
+  _Bool fwd;
+
+  // nesting depth of forwarded value (internal).
+  size_t fwd_depth;
+
+  // index of the path matched by the forwarded value.  Accessible via
+  // the jiffy_filter_get_match() function.
+  size_t match;
+
+  // current object key (internal).  Keys which are longer than
+  // JIFFY_FILTER_MAX_KEY_LEN are truncated, and never match.
+  uint8_t key[JIFFY_FILTER_MAX_KEY_LEN];
+  size_t key_len;
+  _Bool in_key;
+};
+
+/**
+ * Compile a set of paths into a filter.
+ *
+ * Each path is a JSON Pointer (RFC 6901): either an empty string,
+ * which matches the whole document, or a sequence of reference tokens
+ * which each start with a slash (for example, "/user/id").  A token
+ * matches an object key with the same text, where "~0" stands for "~"
+ * and "~1" stands for "/".  A token which is a decimal number without
+ * leading zeros also matches the array element with that index.  The
+ * token "*" matches any object key and any array element; for example,
+ * a path with the tokens "items", "*", and "price" selects the price of
+ * every element of the "items" array.
+ *
+ * The filter keeps pointers to the given path strings, so they must
+ * remain valid for the lifetime of the filter.
+ *
+ * Returns false if any of the following errors occur:
+ *
+ * - the filter is NULL
+ * - the path array is NULL and the number of paths is non-zero
+ * - there are more than JIFFY_FILTER_MAX_PATHS paths
+ * - a path is NULL, or does not start with a slash and is not empty
+ * - a path contains a "~" which is not followed by "0" or "1"
+ * - a path has more than JIFFY_FILTER_MAX_DEPTH reference tokens
+ * - the paths have more than JIFFY_FILTER_MAX_STEPS reference tokens
+ *   in total
+ * - a reference token is longer than JIFFY_FILTER_MAX_KEY_LEN bytes
+ */
+_Bool jiffy_filter_init(
+  // pointer to filter (required)
+  jiffy_filter_t * const,
+
+  // pointer to parser callback structure (optional, may be NULL)
+  const jiffy_parser_cbs_t * const,
+
+  // array of paths (required if the number of paths is non-zero)
+  const char * const * const,
+
+  // number of paths
+  const size_t
+);
+
+/**
+ * Get the index of the path which matched the value being forwarded.
+ * If several paths match the value, then the index of the first one
+ * is returned.
+ *
+ * Only valid inside of callbacks fired by a parser which was
+ * initialized with jiffy_parser_init_filter().
+ */
+size_t jiffy_filter_get_match(
+  // pointer to filter (required)
+  const jiffy_filter_t * const
+);
+
+/**
+ * Initialize a parser in filter mode.
+ *
+ * A parser in filter mode fires the callbacks of the given filter for
+ * each value which matches one of the paths of the filter, as if each
+ * matching value was parsed as a separate document.  The callbacks
+ * for the array elements, object keys, and object values which enclose
+ * a matching value are not fired.  The on_error callback and, in
+ * multi-document mode, the on_document_end callback are always fired.
+ *
+ * Values which cannot match any of the paths are skipped with
+ * jiffy_parser_skip_value(), so they are only checked for matching
+ * quotes and brackets.
+ *
+ * The filter tracks its position in the document in fixed-size memory
+ * inside of the filter, so parsing does not allocate memory.  A filter
+ * can be attached to one parser at a time; attaching it resets its
+ * position.
+ *
+ * Returns false if any of the following errors occur:
+ *
+ * - the parser context is NULL
+ * - the filter is NULL
+ * - the stack memory pointer is NULL
+ * - the number of stack memory elements is less than 2
+ */
+_Bool jiffy_parser_init_filter(
+  // pointer to parser context (required)
+  jiffy_parser_t * const,
+
+  // pointer to filter (required)
+  jiffy_filter_t * const,
+
+  // memory for state stack (required)
+  jiffy_parser_state_t * const,
+
+  // number of entries in state stack (required, at least 2)
+  const size_t,
+
+  // opaque pointer to user data (optional)
+  void * const
+);
+
+/**
+ * Chunk of a newline-delimited JSON buffer, passed to the on_chunk
+ * callback of jiffy_parse_ndjson_parallel().
+ */
+typedef struct {
+  // chunk number, counting from zero in input order
+  size_t num;
+
+  // offset and size of chunk in the source buffer, in bytes.  Chunks
+  // start at the beginning of a line and end after a newline (or at the
+  // end of the buffer).
+  size_t ofs, len;
+
+  // events for this chunk.  Event offsets are relative to the start of
+  // the source buffer, so the tape can be replayed against the whole
+  // buffer with jiffy_tape_replay().  The tape is only valid for the
+  // duration of the callback.
+  const jiffy_tape_t *tape;
+} jiffy_ndjson_chunk_t;
+
+/**
+ * Options for jiffy_parse_ndjson_parallel().
+ */
+typedef struct {
+  // parser callbacks (optional).  Fired for each record unless on_chunk
+  // is set.  In unordered mode, callbacks are fired concurrently from
+  // the worker threads.
+  const jiffy_parser_cbs_t *cbs;
+
+  // chunk callback (optional).  If set, each chunk is parsed into an
+  // event tape and passed to this callback instead of firing the
+  // parser callbacks.  In unordered mode, this callback is called
+  // concurrently from the worker threads.
+  void (*on_chunk)(const jiffy_ndjson_chunk_t *, void *);
+
+  // number of worker threads (required, must be non-zero).  The calling
+  // thread is one of the workers.
+  size_t num_threads;
+
+  // approximate size of each chunk, in bytes (optional).  Defaults to
+  // JIFFY_NDJSON_DEFAULT_CHUNK_SIZE if zero.
+  size_t chunk_size;
+
+  // number of entries in the state stack of each worker (optional,
+  // at least 2 if set).  Defaults to JIFFY_NDJSON_DEFAULT_STACK_LEN if
+  // zero.
+  size_t stack_len;
+
+  // additional parser flags (optional).  JIFFY_PARSER_FLAG_MULTI_DOCUMENT
+  // is always set.
+  uint32_t parser_flags;
+
+  // deliver results in input order (optional).  Callbacks for a chunk
+  // are delivered after all earlier chunks, one chunk at a time, from
+  // whichever worker parsed the chunk.
+  _Bool ordered;
+} jiffy_ndjson_opts_t;
+
+// default chunk size for jiffy_parse_ndjson_parallel(), in bytes
+#define JIFFY_NDJSON_DEFAULT_CHUNK_SIZE (1 << 20)
+
+// default number of state stack entries for each worker of
+// jiffy_parse_ndjson_parallel()
+#define JIFFY_NDJSON_DEFAULT_STACK_LEN 128
+
+/**
+ * Parse a buffer of newline-delimited JSON (JSON Lines) on a pool of
+ * worker threads.
+ *
+ * The buffer is split into chunks at newline boundaries, so each record
+ * must be on a single line.  Each worker has its own parser and state
+ * stack, and parses one chunk at a time in multi-document mode (see
+ * JIFFY_PARSER_FLAG_MULTI_DOCUMENT).  Parser offsets are relative to the
+ * start of the buffer.
+ *
+ * In ordered mode, and when on_chunk is set, chunks are parsed into
+ * event tapes which are allocated with malloc().
+ *
+ * Returns true on success.  Returns false if any chunk fails to parse
+ * or if memory allocation fails.  On a parse error, remaining chunks
+ * are skipped; in ordered mode, every chunk before the first failing
+ * chunk is delivered in full.
+ */
+_Bool jiffy_parse_ndjson_parallel(
+  // pointer to options (required)
+  const jiffy_ndjson_opts_t * const,
+
+  // pointer to source buffer (required)
+  const void * const,
+
+  // size of source buffer, in bytes
+  const size_t,
+
+  // opaque pointer to user data (optional)
+  void * const
+);
+
+#define JIFFY_TYPE_LIST \
+  JIFFY_DEF_TYPE(NULL, "null"), \
+  JIFFY_DEF_TYPE(TRUE, "true"), \
+  JIFFY_DEF_TYPE(FALSE, "false"), \
+  JIFFY_DEF_TYPE(NUMBER, "number"), \
+  JIFFY_DEF_TYPE(STRING, "string"), \
+  JIFFY_DEF_TYPE(ARRAY, "array"), \
+  JIFFY_DEF_TYPE(OBJECT, "object"), \
+  JIFFY_DEF_TYPE(LAST, "invalid"),
+
+typedef enum {
+#define JIFFY_DEF_TYPE(a, b) JIFFY_TYPE_##a
+JIFFY_TYPE_LIST
+#undef JIFFY_DEF_TYPE
+} jiffy_type_t;
+
+/**
+ * Convert value type to human-readable text.
+ *
+ * Note: The string returned by this method is read-only.
+ */
+const char *jiffy_type_to_s(
+  const jiffy_type_t
+);
+
+// forward declaration
+typedef struct jiffy_value_t_ jiffy_value_t;
+
+struct jiffy_value_t_ {
+  jiffy_type_t type;
+
+  union {
+    struct {
+      uint8_t *ptr;
+      size_t len;
+    } v_num;
+
+    struct {
+      uint8_t *ptr;
+      size_t len;
+    } v_str;
+
+    struct {
+      // key/value pairs, stored contiguously (key at 2 * N, value at
+      // 2 * N + 1)
+      jiffy_value_t *vals;
+
+      // number of key/value pairs
+      size_t len;
+    } v_obj;
+
+    struct {
+      // elements, stored contiguously
+      jiffy_value_t *vals;
+
+      // number of elements
+      size_t len;
+    } v_ary;
+  };
+};
+
+/**
+ * Get the type of the given value.
+ */
+jiffy_type_t jiffy_value_get_type(
+  const jiffy_value_t * const
+);
+
+/**
+ * Get a pointer to bytes and the number of bytes of the given number
+ * value.
+ *
+ * Returns NULL if the given value is not a number.
+ */
+const uint8_t *jiffy_number_get_bytes(
+  // value
+  const jiffy_value_t * const,
+
+  // pointer to store byte length
+  size_t * const
+);
+
+/**
+ * Get the value of the given number value as an int64_t.
+ *
+ * Returns false if the given value is not a number, or if the number
+ * has a fraction or exponent or does not fit in an int64_t.
+ */
+_Bool jiffy_number_get_int64(
+  // value
+  const jiffy_value_t * const,
+
+  // pointer to store value
+  int64_t * const
+);
+
+/**
+ * Get the value of the given number value as a uint64_t.
+ *
+ * Returns false if the given value is not a number, or if the number
+ * is negative, has a fraction or exponent, or does not fit in a
+ * uint64_t.
+ */
+_Bool jiffy_number_get_uint64(
+  // value
+  const jiffy_value_t * const,
+
+  // pointer to store value
+  uint64_t * const
+);
+
+/**
+ * Get the value of the given number value as a double, correctly
+ * rounded.  See on_number_double.
+ *
+ * Returns false if the given value is not a number.
+ */
+_Bool jiffy_number_get_double(
+  // value
+  const jiffy_value_t * const,
+
+  // pointer to store value
+  double * const
+);
+
+/**
+ * Get a pointer to bytes and the number of bytes of the given string
+ * value.
+ *
+ * Returns NULL if the given value is not a string.
+ */
+const uint8_t *jiffy_string_get_bytes(
+  // string value
+  const jiffy_value_t * const,
+
+  // pointer to returned byte count
+  size_t * const
+);
+
+/**
+ * Get the number of elements in the given array value.
+ *
+ * Note: Results are undefined if the given value is not an array.
+ */
+size_t jiffy_array_get_size(
+  // array value
+  const jiffy_value_t * const
 );
 
 /**
  * Get the Nth value of the given array.
  *
- * Returns NULL if the given value is not an array or the given offset
- * is out of bounds.
+ * Returns NULL if the given value is not an array or the given offset
+ * is out of bounds.
+ */
+const jiffy_value_t *jiffy_array_get_nth(
+  // array value
+  const jiffy_value_t * const,
+
+  // offset
+  const size_t
+);
+
+/**
+ * Iterate through each value in the given array.
+ *
+ * Returns false if the given value is not an object.
+ */
+_Bool jiffy_array_each(
+  // array value
+  const jiffy_value_t * const,
+
+  // callback
+  void (*each_cb)(
+    // element index
+    const size_t,
+
+    // element value
+    const jiffy_value_t * const,
+
+    // callback data
+    void *
+  ),
+
+  // callback data
+  void *
+);
+
+/**
+ * Get the Nth value of the given array (unsafe)
+ *
+ * This method performs no type or bounds check, and will return garbage
+ * if called on a non-array value or with an index that is out of
+ * range.
+ */
+const jiffy_value_t *jiffy_array_unsafe_get_nth(
+  // array value
+  const jiffy_value_t * const,
+
+  // offset
+  const size_t
+);
+
+/**
+ * Get the number of elements in the given object value.
+ *
+ * Note: Results are undefined if the given value is not an object.
+ */
+size_t jiffy_object_get_size(
+  // object value
+  const jiffy_value_t * const
+);
+
+/**
+ * Get the Nth key of the given object.
+ *
+ * Returns NULL if the given value is not an object or the given offset
+ * is out of bounds.
+ */
+const jiffy_value_t *jiffy_object_get_nth_key(
+  // object value
+  const jiffy_value_t * const,
+
+  // offset
+  const size_t
+);
+
+/**
+ * Get the Nth value of the given object.
+ *
+ * Returns NULL if the given value is not an object or the given offset
+ * is out of bounds.
+ */
+const jiffy_value_t *jiffy_object_get_nth_value(
+  // object value
+  const jiffy_value_t * const,
+
+  // offset
+  const size_t ofs
+);
+
+/**
+ * Iterate through each key/value pair in the given object.
+ *
+ * Returns false if the given value is not an object.
+ */
+_Bool jiffy_object_each(
+  // object value
+  const jiffy_value_t * const,
+
+  // callback
+  void (*each_cb)(
+    // key of value pair
+    const jiffy_value_t * const,
+
+    // value of value pair
+    const jiffy_value_t * const,
+
+    // callback data
+    void *
+  ),
+
+  // callback data
+  void *
+);
+
+/**
+ * Get the Nth key of the given object (unsafe).
+ *
+ * This method performs no type or bounds check, and will return garbage
+ * if called on a non-object value or with an index that is out of
+ * range.
  */
-const jiffy_value_t *jiffy_array_get_nth(
-  // array value
+const jiffy_value_t *jiffy_object_unsafe_get_nth_key(
+  // object value
   const jiffy_value_t * const,
 
   // offset
@@ -449,21 +1747,373 @@ const jiffy_value_t *jiffy_array_get_nth(
 );
 
 /**
- * Iterate through each value in the given array.
+ * Get the Nth value of the given object (unsafe).
  *
- * Returns false if the given value is not an object.
+ * This method performs no type or bounds check, and will return garbage
+ * if called on a non-object value or with an index that is out of
+ * range.
  */
-_Bool jiffy_array_each(
-  // array value
+const jiffy_value_t *jiffy_object_unsafe_get_nth_value(
+  // object value
   const jiffy_value_t * const,
 
+  // offset
+  const size_t ofs
+);
+
+// forward reference
+typedef struct jiffy_tree_t_ jiffy_tree_t;
+
+/**
+ * Tree parser callbacks.
+ *
+ * Used by the tree parser to allocate memory, free memory, and to
+ * notify the user about error conditions.
+ *
+ * Note: Any or all of these callback pointers may be NULL.
+ */
+typedef struct {
+  // Memory allocation callback (optional, defaults to malloc() if
+  // unspecified).
+  void *(*malloc)(const size_t, void * const);
+
+  // Memory free callback (optional, defaults to free() if unspecified).
+  void (*free)(void * const, void * const);
+
+  // Error callback (optional).  Called by the tree parser if an error
+  // occurs during parsing.
+  void (*on_error)(const jiffy_tree_t *, const jiffy_err_t);
+} jiffy_tree_cbs_t;
+
+struct jiffy_tree_t_ {
+  // callbacks
+  const jiffy_tree_cbs_t *cbs;
+
+  // opaque user data pointer
+  void *user_data;
+
+  // all allocated data, ordered like so:
+  // * vals (array of values; the root value comes first, followed by
+  //   the children of each array and object, stored contiguously)
+  // * bytes (byte data for numbers and strings)
+  uint8_t *data;
+
+  // list of values (pointer into data)
+  jiffy_value_t *vals;
+  size_t num_vals;
+};
+
+/**
+ * TODO: document this
+ */
+_Bool jiffy_tree_new(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  const void * const src,
+  const size_t len,
+  void * const user_data
+);
+
+/**
+ * TODO: document this
+ */
+_Bool jiffy_tree_new_ex(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  jiffy_parser_state_t * const stack,
+  const size_t stack_len,
+  const void * const src,
+  const size_t len,
+  void * const user_data
+);
+
+/**
+ * Create a tree from the given buffer using a structural index built
+ * with jiffy_index_build().
+ *
+ * Identical to jiffy_tree_new_ex(), except that the parser is driven
+ * by jiffy_parser_push_index().
+ */
+_Bool jiffy_tree_new_index(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  jiffy_parser_state_t * const stack,
+  const size_t stack_len,
+  const jiffy_index_t * const index,
+  const void * const src,
+  const size_t len,
+  void * const user_data
+);
+
+/**
+ * Create a tree from the given file.
+ *
+ * Identical to jiffy_tree_new(), except that the input is mapped
+ * read-only with mmap() instead of being read into a buffer (see
+ * jiffy_parse_file()).  Files larger than JIFFY_FILE_MAP_MAX are
+ * mapped through a sliding window.  The mapping is
+ * released before this function returns; the tree does not refer to
+ * it.
+ */
+_Bool jiffy_tree_new_from_file(
+  jiffy_tree_t * const tree,
+  const jiffy_tree_cbs_t * const cbs,
+  const char * const path,
+  void * const user_data
+);
+
+/**
+ * Get user data associated with given tree.
+ */
+void *jiffy_tree_get_user_data(
+  const jiffy_tree_t * const tree
+);
+
+/**
+ * Get the root value for the given tree.
+ *
+ * Returns NULL if the given tree is empty.
+ */
+const jiffy_value_t *jiffy_tree_get_root_value(
+  const jiffy_tree_t * const
+);
+
+/**
+ * Free memory associated with tree.
+ */
+void jiffy_tree_free(
+  jiffy_tree_t * const
+);
+
+/**
+ * Value offset returned by the jiffy_flat_*() accessors when there is
+ * no matching value.
+ */
+#define JIFFY_FLAT_NONE ((size_t) -1)
+
+// forward reference
+typedef struct jiffy_flat_t_ jiffy_flat_t;
+
+/**
+ * Flat tree callbacks.
+ *
+ * Identical to jiffy_tree_cbs_t, except for the type of the tree passed
+ * to on_error.
+ *
+ * Note: Any or all of these callback pointers may be NULL.
+ */
+typedef struct {
+  // Memory allocation callback (optional, defaults to malloc() if
+  // unspecified).
+  void *(*malloc)(const size_t, void * const);
+
+  // Memory free callback (optional, defaults to free() if unspecified).
+  void (*free)(void * const, void * const);
+
+  // Error callback (optional).  Called if an error occurs during
+  // parsing.
+  void (*on_error)(const jiffy_flat_t *, const jiffy_err_t);
+} jiffy_flat_cbs_t;
+
+/**
+ * Flat tree.
+ *
+ * An alternative to jiffy_tree_t which stores the document as a tape of
+ * 64-bit words in document order.  The upper 8 bits of each word hold a
+ * tag, and the lower 56 bits hold a payload:
+ *
+ * - null, true, false: one word.
+ * - number, string: two words; the offset of the byte data in bytes,
+ *   followed by the number of bytes.
+ * - array, object: a start word with the offset of the matching end
+ *   word, a word with the number of elements or key/value pairs, the
+ *   children (keys and values alternate in objects), and an end word
+ *   with the offset of the start word.
+ *
+ * Values are referred to by the offset of their first word, and any
+ * value can be skipped in constant time (see jiffy_flat_skip()).  All
+ * offsets are relative, so the data can be copied or saved as-is.
+ *
+ * Use the jiffy_flat_*() functions instead of accessing the words
+ * directly.
+ */
+struct jiffy_flat_t_ {
+  // callbacks
+  const jiffy_flat_cbs_t *cbs;
+
+  // opaque user data pointer
+  void *user_data;
+
+  // all allocated data: the words, followed by the byte data for
+  // numbers and strings
+  uint64_t *words;
+  size_t num_words;
+
+  // byte data (pointer into the words allocation)
+  uint8_t *bytes;
+};
+
+/**
+ * Create a flat tree from the given buffer.
+ *
+ * Returns false and invokes the on_error callback if the buffer could
+ * not be parsed or memory could not be allocated.
+ */
+_Bool jiffy_flat_new(
+  jiffy_flat_t * const flat,
+  const jiffy_flat_cbs_t * const cbs,
+  const void * const src,
+  const size_t len,
+  void * const user_data
+);
+
+/**
+ * Create a flat tree from the given file.
+ *
+ * Identical to jiffy_flat_new(), except that the input is mapped
+ * read-only with mmap() (see jiffy_tree_new_from_file()).
+ */
+_Bool jiffy_flat_new_from_file(
+  jiffy_flat_t * const flat,
+  const jiffy_flat_cbs_t * const cbs,
+  const char * const path,
+  void * const user_data
+);
+
+/**
+ * Get user data associated with given flat tree.
+ */
+void *jiffy_flat_get_user_data(
+  const jiffy_flat_t * const flat
+);
+
+/**
+ * Get the offset of the root value of the given flat tree.
+ *
+ * Returns JIFFY_FLAT_NONE if the given flat tree is empty.
+ */
+size_t jiffy_flat_get_root(
+  const jiffy_flat_t * const
+);
+
+/**
+ * Get the type of the value at the given offset.
+ *
+ * Returns JIFFY_TYPE_LAST if the offset is JIFFY_FLAT_NONE.
+ */
+jiffy_type_t jiffy_flat_get_type(
+  // flat tree
+  const jiffy_flat_t * const,
+
+  // value offset
+  const size_t
+);
+
+/**
+ * Get the offset of the word following the value at the given offset.
+ * For array elements and object keys and values other than the last
+ * one, this is the offset of the next sibling.
+ *
+ * Runs in constant time, regardless of the size of the value.
+ */
+size_t jiffy_flat_skip(
+  // flat tree
+  const jiffy_flat_t * const,
+
+  // value offset
+  const size_t
+);
+
+/**
+ * Get a pointer to bytes and the number of bytes of the given number
+ * value.
+ *
+ * Returns NULL if the given value is not a number.
+ */
+const uint8_t *jiffy_flat_number_get_bytes(
+  // flat tree
+  const jiffy_flat_t * const,
+
+  // value offset
+  const size_t,
+
+  // pointer to store byte length
+  size_t * const
+);
+
+/**
+ * Get a pointer to bytes and the number of bytes of the given string
+ * value.
+ *
+ * Returns NULL if the given value is not a string.
+ */
+const uint8_t *jiffy_flat_string_get_bytes(
+  // flat tree
+  const jiffy_flat_t * const,
+
+  // value offset
+  const size_t,
+
+  // pointer to returned byte count
+  size_t * const
+);
+
+/**
+ * Get the number of elements in the given array value.
+ *
+ * Note: Results are undefined if the given value is not an array.
+ */
+size_t jiffy_flat_array_get_size(
+  // flat tree
+  const jiffy_flat_t * const,
+
+  // array value offset
+  const size_t
+);
+
+/**
+ * Get the offset of the Nth value of the given array.
+ *
+ * Takes time proportional to the offset, since each preceding element
+ * is skipped in turn.  Use jiffy_flat_array_each() to visit every
+ * element.
+ *
+ * Returns JIFFY_FLAT_NONE if the given value is not an array or the
+ * given offset is out of bounds.
+ */
+size_t jiffy_flat_array_get_nth(
+  // flat tree
+  const jiffy_flat_t * const,
+
+  // array value offset
+  const size_t,
+
+  // element index
+  const size_t
+);
+
+/**
+ * Iterate through each value in the given array.
+ *
+ * Returns false if the given value is not an array.
+ */
+_Bool jiffy_flat_array_each(
+  // flat tree
+  const jiffy_flat_t * const,
+
+  // array value offset
+  const size_t,
+
   // callback
   void (*each_cb)(
+    // flat tree
+    const jiffy_flat_t * const,
+
     // element index
     const size_t,
 
-    // element value
-    const jiffy_value_t * const,
+    // element value offset
+    const size_t,
 
     // callback data
     void *
@@ -474,56 +2124,56 @@ _Bool jiffy_array_each(
 );
 
 /**
- * Get the Nth value of the given array (unsafe)
+ * Get the number of key/value pairs in the given object value.
  *
- * This method performs no type or bounds check, and will return garbage
- * if called on a non-array value or with an index that is out of
- * range.
+ * Note: Results are undefined if the given value is not an object.
  */
-const jiffy_value_t *jiffy_array_unsafe_get_nth(
-  // array value
-  const jiffy_value_t * const,
+size_t jiffy_flat_object_get_size(
+  // flat tree
+  const jiffy_flat_t * const,
 
-  // offset
+  // object value offset
   const size_t
 );
 
 /**
- * Get the number of elements in the given object value.
+ * Get the offset of the Nth key of the given object.
  *
- * Note: Results are undefined if the given value is not an object.
- */
-size_t jiffy_object_get_size(
-  // object value
-  const jiffy_value_t * const
-);
-
-/**
- * Get the Nth key of the given object.
+ * Takes time proportional to the offset (see
+ * jiffy_flat_array_get_nth()).
  *
- * Returns NULL if the given value is not an object or the given offset
- * is out of bounds.
+ * Returns JIFFY_FLAT_NONE if the given value is not an object or the
+ * given offset is out of bounds.
  */
-const jiffy_value_t *jiffy_object_get_nth_key(
-  // object value
-  const jiffy_value_t * const,
+size_t jiffy_flat_object_get_nth_key(
+  // flat tree
+  const jiffy_flat_t * const,
 
-  // offset
+  // object value offset
+  const size_t,
+
+  // pair index
   const size_t
 );
 
 /**
- * Get the Nth value of the given object.
+ * Get the offset of the Nth value of the given object.
  *
- * Returns NULL if the given value is not an object or the given offset
- * is out of bounds.
+ * Takes time proportional to the offset (see
+ * jiffy_flat_array_get_nth()).
+ *
+ * Returns JIFFY_FLAT_NONE if the given value is not an object or the
+ * given offset is out of bounds.
  */
-const jiffy_value_t *jiffy_object_get_nth_value(
-  // object value
-  const jiffy_value_t * const,
+size_t jiffy_flat_object_get_nth_value(
+  // flat tree
+  const jiffy_flat_t * const,
 
-  // offset
-  const size_t ofs
+  // object value offset
+  const size_t,
+
+  // pair index
+  const size_t
 );
 
 /**
@@ -531,17 +2181,23 @@ const jiffy_value_t *jiffy_object_get_nth_value(
  *
  * Returns false if the given value is not an object.
  */
-_Bool jiffy_object_each(
-  // object value
-  const jiffy_value_t * const,
+_Bool jiffy_flat_object_each(
+  // flat tree
+  const jiffy_flat_t * const,
+
+  // object value offset
+  const size_t,
 
   // callback
   void (*each_cb)(
-    // key of value pair
-    const jiffy_value_t * const,
+    // flat tree
+    const jiffy_flat_t * const,
 
-    // value of value pair
-    const jiffy_value_t * const,
+    // key value offset
+    const size_t,
+
+    // value offset
+    const size_t,
 
     // callback data
     void *
@@ -552,43 +2208,51 @@ _Bool jiffy_object_each(
 );
 
 /**
- * Get the Nth key of the given object (unsafe).
- *
- * This method performs no type or bounds check, and will return garbage
- * if called on a non-object value or with an index that is out of
- * range.
+ * Free memory associated with flat tree.
  */
-const jiffy_value_t *jiffy_object_unsafe_get_nth_key(
-  // object value
-  const jiffy_value_t * const,
-
-  // offset
-  const size_t
+void jiffy_flat_free(
+  jiffy_flat_t * const
 );
 
 /**
- * Get the Nth value of the given object (unsafe).
+ * Compact tree value.
  *
- * This method performs no type or bounds check, and will return garbage
- * if called on a non-object value or with an index that is out of
- * range.
+ * An alternative to jiffy_value_t for trees whose data is smaller than
+ * 4GB.  Each value is 8 bytes: a 32-bit offset relative to the start of
+ * the tree data, and a 32-bit word which holds the type in the lower 3
+ * bits and the length in the upper 29 bits.
+ *
+ * The offset refers to the byte data of numbers and strings, and to the
+ * first child of arrays and objects.  Children are stored contiguously
+ * (see jiffy_tree_t), so the data has no pointers and can be copied or
+ * saved as-is.
+ *
+ * Use the jiffy_tree32_*() functions instead of accessing the fields
+ * directly.
  */
-const jiffy_value_t *jiffy_object_unsafe_get_nth_value(
-  // object value
-  const jiffy_value_t * const,
+typedef struct {
+  // offset of byte data or first child, relative to the tree data
+  uint32_t ofs;
 
-  // offset
-  const size_t ofs
-);
+  // type (lower 3 bits) and number of bytes, elements, or key/value
+  // pairs (upper 29 bits)
+  uint32_t info;
+} jiffy_value32_t;
+
+/**
+ * Maximum number of bytes in a compact tree value, or elements or
+ * key/value pairs in a compact array or object.
+ */
+#define JIFFY_TREE32_MAX_LEN ((UINT32_C(1) << 29) - 1)
 
 // forward reference
-typedef struct jiffy_tree_t_ jiffy_tree_t;
+typedef struct jiffy_tree32_t_ jiffy_tree32_t;
 
 /**
- * Tree parser callbacks.
+ * Compact tree callbacks.
  *
- * Used by the tree parser to allocate memory, free memory, and to
- * notify the user about error conditions.
+ * Identical to jiffy_tree_cbs_t, except for the type of the tree passed
+ * to on_error.
  *
  * Note: Any or all of these callback pointers may be NULL.
  */
@@ -600,76 +2264,259 @@ typedef struct {
   // Memory free callback (optional, defaults to free() if unspecified).
   void (*free)(void * const, void * const);
 
-  // Error callback (optional).  Called by the tree parser if an error
-  // occurs during parsing.
-  void (*on_error)(const jiffy_tree_t *, const jiffy_err_t);
-} jiffy_tree_cbs_t;
+  // Error callback (optional).  Called if an error occurs during
+  // parsing.
+  void (*on_error)(const jiffy_tree32_t *, const jiffy_err_t);
+} jiffy_tree32_cbs_t;
 
-struct jiffy_tree_t_ {
+/**
+ * Compact tree.
+ *
+ * Same layout as jiffy_tree_t, except that values are jiffy_value32_t.
+ * The values and byte data must fit in 4GB; larger documents fail with
+ * JIFFY_ERR_TREE32_TOO_LARGE.
+ */
+struct jiffy_tree32_t_ {
   // callbacks
-  const jiffy_tree_cbs_t *cbs;
+  const jiffy_tree32_cbs_t *cbs;
 
   // opaque user data pointer
   void *user_data;
 
-  // all allocated data, ordered like so:
-  // * vals (array of values)
-  // * array rows (array of json_value_t*, pointing into vals)
-  // * object rows (array of json_value_t*, two entries per key/value
-  //   pair, and the pointers point into vals above)
-  // * bytes (byte data for numbers and strings)
+  // all allocated data: the values (the root value comes first),
+  // followed by the byte data for numbers and strings
   uint8_t *data;
 
-  // list of values (pointer into data)
-  jiffy_value_t *vals;
+  // total number of bytes in data
+  size_t size;
+
+  // number of values
   size_t num_vals;
 };
 
 /**
- * TODO: document this
+ * Create a compact tree from the given buffer.
+ *
+ * Returns false and invokes the on_error callback if the buffer could
+ * not be parsed, memory could not be allocated, or the tree does not
+ * fit in 32-bit offsets.
  */
-_Bool jiffy_tree_new(
-  jiffy_tree_t * const tree,
-  const jiffy_tree_cbs_t * const cbs,
+_Bool jiffy_tree32_new(
+  jiffy_tree32_t * const tree,
+  const jiffy_tree32_cbs_t * const cbs,
   const void * const src,
   const size_t len,
   void * const user_data
 );
 
 /**
- * TODO: document this
+ * Create a compact tree from the given file.
+ *
+ * Identical to jiffy_tree32_new(), except that the input is mapped
+ * read-only with mmap() (see jiffy_tree_new_from_file()).
  */
-_Bool jiffy_tree_new_ex(
-  jiffy_tree_t * const tree,
-  const jiffy_tree_cbs_t * const cbs,
-  jiffy_parser_state_t * const stack,
-  const size_t stack_len,
-  const void * const src,
-  const size_t len,
+_Bool jiffy_tree32_new_from_file(
+  jiffy_tree32_t * const tree,
+  const jiffy_tree32_cbs_t * const cbs,
+  const char * const path,
   void * const user_data
 );
 
 /**
- * Get user data associated with given tree.
+ * Get user data associated with given compact tree.
  */
-void *jiffy_tree_get_user_data(
-  const jiffy_tree_t * const tree
+void *jiffy_tree32_get_user_data(
+  const jiffy_tree32_t * const tree
 );
 
 /**
- * Get the root value for the given tree.
+ * Get the root value for the given compact tree.
  *
  * Returns NULL if the given tree is empty.
  */
-const jiffy_value_t *jiffy_tree_get_root_value(
-  const jiffy_tree_t * const
+const jiffy_value32_t *jiffy_tree32_get_root_value(
+  const jiffy_tree32_t * const
 );
 
 /**
- * Free memory associated with tree.
+ * Get the type of the given compact value.
  */
-void jiffy_tree_free(
-  jiffy_tree_t * const
+jiffy_type_t jiffy_tree32_value_get_type(
+  const jiffy_value32_t * const
+);
+
+/**
+ * Get a pointer to bytes and the number of bytes of the given number
+ * value.
+ *
+ * Returns NULL if the given value is not a number.
+ */
+const uint8_t *jiffy_tree32_number_get_bytes(
+  // compact tree
+  const jiffy_tree32_t * const,
+
+  // value
+  const jiffy_value32_t * const,
+
+  // pointer to store byte length
+  size_t * const
+);
+
+/**
+ * Get a pointer to bytes and the number of bytes of the given string
+ * value.
+ *
+ * Returns NULL if the given value is not a string.
+ */
+const uint8_t *jiffy_tree32_string_get_bytes(
+  // compact tree
+  const jiffy_tree32_t * const,
+
+  // string value
+  const jiffy_value32_t * const,
+
+  // pointer to returned byte count
+  size_t * const
+);
+
+/**
+ * Get the number of elements in the given array value.
+ *
+ * Note: Results are undefined if the given value is not an array.
+ */
+size_t jiffy_tree32_array_get_size(
+  // array value
+  const jiffy_value32_t * const
+);
+
+/**
+ * Get the Nth value of the given array.
+ *
+ * Returns NULL if the given value is not an array or the given offset
+ * is out of bounds.
+ */
+const jiffy_value32_t *jiffy_tree32_array_get_nth(
+  // compact tree
+  const jiffy_tree32_t * const,
+
+  // array value
+  const jiffy_value32_t * const,
+
+  // offset
+  const size_t
+);
+
+/**
+ * Iterate through each value in the given array.
+ *
+ * Returns false if the given value is not an array.
+ */
+_Bool jiffy_tree32_array_each(
+  // compact tree
+  const jiffy_tree32_t * const,
+
+  // array value
+  const jiffy_value32_t * const,
+
+  // callback
+  void (*each_cb)(
+    // compact tree
+    const jiffy_tree32_t * const,
+
+    // element index
+    const size_t,
+
+    // element value
+    const jiffy_value32_t * const,
+
+    // callback data
+    void *
+  ),
+
+  // callback data
+  void *
+);
+
+/**
+ * Get the number of key/value pairs in the given object value.
+ *
+ * Note: Results are undefined if the given value is not an object.
+ */
+size_t jiffy_tree32_object_get_size(
+  // object value
+  const jiffy_value32_t * const
+);
+
+/**
+ * Get the Nth key of the given object.
+ *
+ * Returns NULL if the given value is not an object or the given offset
+ * is out of bounds.
+ */
+const jiffy_value32_t *jiffy_tree32_object_get_nth_key(
+  // compact tree
+  const jiffy_tree32_t * const,
+
+  // object value
+  const jiffy_value32_t * const,
+
+  // offset
+  const size_t
+);
+
+/**
+ * Get the Nth value of the given object.
+ *
+ * Returns NULL if the given value is not an object or the given offset
+ * is out of bounds.
+ */
+const jiffy_value32_t *jiffy_tree32_object_get_nth_value(
+  // compact tree
+  const jiffy_tree32_t * const,
+
+  // object value
+  const jiffy_value32_t * const,
+
+  // offset
+  const size_t
+);
+
+/**
+ * Iterate through each key/value pair in the given object.
+ *
+ * Returns false if the given value is not an object.
+ */
+_Bool jiffy_tree32_object_each(
+  // compact tree
+  const jiffy_tree32_t * const,
+
+  // object value
+  const jiffy_value32_t * const,
+
+  // callback
+  void (*each_cb)(
+    // compact tree
+    const jiffy_tree32_t * const,
+
+    // key of value pair
+    const jiffy_value32_t * const,
+
+    // value of value pair
+    const jiffy_value32_t * const,
+
+    // callback data
+    void *
+  ),
+
+  // callback data
+  void *
+);
+
+/**
+ * Free memory associated with compact tree.
+ */
+void jiffy_tree32_free(
+  jiffy_tree32_t * const
 );
 
 /**
@@ -0,0 +1,474 @@
+#define _POSIX_C_SOURCE 199309L // clock_gettime()
+#include <stdbool.h> // bool
+#include <stdint.h> // uint64_t
+#include <stdio.h> // printf(), fopen()
+#include <string.h> // memcpy()
+#include <stdlib.h> // EXIT_*, realloc(), free()
+#include <time.h> // clock_gettime()
+#include <err.h> // err(), errx()
+#include "../jiffy.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h> // __rdtsc()
+#define HAVE_RDTSC 1
+#endif // __x86_64__ || __i386__
+
+// approximate size of each generated document, in bytes
+#define DOC_SIZE (8 << 20)
+
+// number of times each document is parsed
+#define NUM_RUNS 10
+
+#define STACK_LEN 128
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+static size_t num_values = 0;
+
+static void on_value(const jiffy_parser_t * const p) {
+  (void) p;
+  num_values++;
+}
+
+static void on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  (void) p;
+  errx(EXIT_FAILURE, "bench: parse error: %s", jiffy_err_to_s(err));
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_object_end  = on_value,
+  .on_array_end   = on_value,
+  .on_string_end  = on_value,
+  .on_number_end  = on_value,
+  .on_true        = on_value,
+  .on_false       = on_value,
+  .on_null        = on_value,
+  .on_error       = on_error,
+};
+
+typedef struct {
+  char *ptr;
+  size_t len;
+  size_t cap;
+} buf_t;
+
+static void buf_puts(buf_t * const buf, const char * const s) {
+  const size_t len = strlen(s);
+
+  if (buf->len + len + 1 > buf->cap) {
+    buf->cap = 2 * (buf->cap + len + 1);
+    buf->ptr = realloc(buf->ptr, buf->cap);
+    if (!buf->ptr) {
+      err(EXIT_FAILURE, "realloc()");
+    }
+  }
+
+  memcpy(buf->ptr + buf->len, s, len + 1);
+  buf->len += len;
+}
+
+// generate array of small records, optionally pretty-printed
+static void gen_records(buf_t * const buf, const bool pretty) {
+  char tmp[256];
+
+  buf_puts(buf, pretty ? "[\n" : "[");
+  for (size_t i = 0; buf->len < DOC_SIZE; i++) {
+    snprintf(tmp, sizeof(tmp), pretty ?
+      "%s  {\n    \"id\": %zu,\n    \"name\": \"user %zu\",\n"
+      "    \"score\": %zu.%02zu,\n    \"active\": %s,\n"
+      "    \"tags\": [1, 2, 3],\n    \"parent\": null\n  }" :
+      "%s{\"id\":%zu,\"name\":\"user %zu\",\"score\":%zu.%02zu,"
+      "\"active\":%s,\"tags\":[1,2,3],\"parent\":null}",
+      i ? (pretty ? ",\n" : ",") : "",
+      i, i, i % 1000, i % 100, (i & 1) ? "true" : "false"
+    );
+    buf_puts(buf, tmp);
+  }
+  buf_puts(buf, pretty ? "\n]\n" : "]");
+}
+
+static void gen_minified(buf_t * const buf) {
+  gen_records(buf, false);
+}
+
+static void gen_pretty(buf_t * const buf) {
+  gen_records(buf, true);
+}
+
+// generate object with long string values
+static void gen_strings(buf_t * const buf) {
+  char tmp[256];
+
+  buf_puts(buf, "{");
+  for (size_t i = 0; buf->len < DOC_SIZE; i++) {
+    snprintf(tmp, sizeof(tmp),
+      "%s\"key %zu\":\"The quick brown fox jumps over the lazy dog; "
+      "pack my box with five dozen liquor jugs (%zu).\"",
+      i ? "," : "", i, i
+    );
+    buf_puts(buf, tmp);
+  }
+  buf_puts(buf, "}");
+}
+
+// generate array of numbers
+static void gen_numbers(buf_t * const buf) {
+  char tmp[128];
+
+  buf_puts(buf, "[");
+  for (size_t i = 0; buf->len < DOC_SIZE; i++) {
+    snprintf(tmp, sizeof(tmp), "%s%zu,-%zu.%zu,%zue-%zu",
+      i ? "," : "", i * 7919, i, i * 31 % 1000, i % 1000, i % 20
+    );
+    buf_puts(buf, tmp);
+  }
+  buf_puts(buf, "]");
+}
+
+static void read_file(buf_t * const buf, const char * const path) {
+  FILE *fh = fopen(path, "rb");
+  if (!fh) {
+    err(EXIT_FAILURE, "fopen(\"%s\")", path);
+  }
+
+  char tmp[4096];
+  size_t len;
+  while ((len = fread(tmp, 1, sizeof(tmp) - 1, fh)) > 0) {
+    tmp[len] = '\0';
+    buf_puts(buf, tmp);
+  }
+
+  if (ferror(fh)) {
+    err(EXIT_FAILURE, "fread(\"%s\")", path);
+  }
+
+  fclose(fh);
+}
+
+static double now(void) {
+  struct timespec ts;
+  if (clock_gettime(CLOCK_MONOTONIC, &ts)) {
+    err(EXIT_FAILURE, "clock_gettime()");
+  }
+
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static uint64_t cycles(void) {
+#ifdef HAVE_RDTSC
+  return __rdtsc();
+#else
+  return 0;
+#endif // HAVE_RDTSC
+}
+
+#ifdef JIFFY_PARSER_STATS
+// print share of bytes in each class for the given document
+static void print_stats(const buf_t * const buf) {
+  jiffy_parser_stats_t stats;
+  jiffy_parser_t p;
+
+  if (
+    !jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, NULL) ||
+    !jiffy_parser_push(&p, buf->ptr, buf->len) ||
+    !jiffy_parser_fini(&p) ||
+    !jiffy_parser_get_stats(&p, &stats)
+  ) {
+    errx(EXIT_FAILURE, "bench: stats parse failed");
+  }
+
+  const double len = buf->len ? buf->len : 1;
+  printf("%-10s %5.1f%% whitespace %5.1f%% structural %5.1f%% string "
+    "%5.1f%% number %5.1f%% literal, max stack depth %llu\n", "",
+    100.0 * stats.bytes.whitespace / len,
+    100.0 * stats.bytes.structural / len,
+    100.0 * stats.bytes.string / len,
+    100.0 * stats.bytes.number / len,
+    100.0 * stats.bytes.literal / len,
+    (unsigned long long) stats.max_stack_depth
+  );
+}
+#endif // JIFFY_PARSER_STATS
+
+static void run(const char * const name, const buf_t * const buf) {
+  double best_time = 1e9;
+  uint64_t best_cycles = UINT64_MAX;
+
+  for (size_t i = 0; i < NUM_RUNS; i++) {
+    jiffy_parser_t p;
+    num_values = 0;
+
+    const double t0 = now();
+    const uint64_t c0 = cycles();
+
+    if (
+      !jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, NULL) ||
+      !jiffy_parser_push(&p, buf->ptr, buf->len) ||
+      !jiffy_parser_fini(&p)
+    ) {
+      errx(EXIT_FAILURE, "bench: %s: parse failed", name);
+    }
+
+    const uint64_t c1 = cycles();
+    const double t1 = now();
+
+    if (t1 - t0 < best_time) {
+      best_time = t1 - t0;
+    }
+
+    if (c1 - c0 < best_cycles) {
+      best_cycles = c1 - c0;
+    }
+  }
+
+  printf("%-10s %9zu bytes %8zu values %8.1f MB/s %6.2f ns/byte",
+    name, buf->len, num_values, buf->len / best_time / 1e6,
+    best_time * 1e9 / buf->len
+  );
+#ifdef HAVE_RDTSC
+  printf(" %6.2f cycles/byte", (double) best_cycles / buf->len);
+#endif // HAVE_RDTSC
+  printf("\n");
+
+#ifdef JIFFY_PARSER_STATS
+  print_stats(buf);
+#endif // JIFFY_PARSER_STATS
+}
+
+// number of events in tape benchmark tape
+#define TAPE_LEN 65536
+static jiffy_tape_event_t tape_mem[TAPE_LEN];
+
+// parse in tape mode, draining the tape whenever it fills up
+static void run_tape(const char * const name, const buf_t * const buf) {
+  double best_time = 1e9;
+  size_t num_events = 0;
+
+  for (size_t i = 0; i < NUM_RUNS; i++) {
+    jiffy_tape_t tape;
+    jiffy_parser_t p;
+    num_events = 0;
+
+    const double t0 = now();
+
+    if (
+      !jiffy_tape_init(&tape, tape_mem, TAPE_LEN) ||
+      !jiffy_parser_init_tape(&p, &tape, stack_mem, STACK_LEN, NULL)
+    ) {
+      errx(EXIT_FAILURE, "bench-tape: %s: init failed", name);
+    }
+
+    bool ok = true;
+    while (ok && jiffy_parser_get_num_bytes(&p) < buf->len) {
+      const size_t ofs = jiffy_parser_get_num_bytes(&p);
+      ok = jiffy_parser_push(&p, buf->ptr + ofs, buf->len - ofs);
+      num_events += tape.len;
+      jiffy_tape_clear(&tape);
+    }
+
+    if (!ok || !jiffy_parser_fini(&p)) {
+      errx(EXIT_FAILURE, "bench-tape: %s: parse failed", name);
+    }
+    num_events += tape.len;
+
+    const double t1 = now();
+    if (t1 - t0 < best_time) {
+      best_time = t1 - t0;
+    }
+  }
+
+  printf("%-10s %9zu bytes %9zu events %8.1f MB/s %6.2f ns/byte\n",
+    name, buf->len, num_events, buf->len / best_time / 1e6,
+    best_time * 1e9 / buf->len
+  );
+}
+
+// number of elements in tree benchmark array
+#define TREE_NUM_ELEMS 10000000
+
+// number of times the tree benchmark document is parsed
+#define TREE_NUM_RUNS 3
+
+static void on_tree_error(
+  const jiffy_tree_t * const tree,
+  const jiffy_err_t err
+) {
+  (void) tree;
+  errx(EXIT_FAILURE, "bench-tree: parse error: %s", jiffy_err_to_s(err));
+}
+
+static const jiffy_tree_cbs_t TREE_CBS = {
+  .on_error = on_tree_error,
+};
+
+// generate array of TREE_NUM_ELEMS small numbers
+static void gen_tree_array(buf_t * const buf) {
+  char tmp[32];
+
+  buf_puts(buf, "[");
+  for (size_t i = 0; i < TREE_NUM_ELEMS; i++) {
+    snprintf(tmp, sizeof(tmp), "%s%zu", i ? "," : "", i % 1000);
+    buf_puts(buf, tmp);
+  }
+  buf_puts(buf, "]");
+}
+
+// build and free a tree of one kind, return the number of bytes used
+// for values (not counting byte data)
+typedef size_t (*tree_fn_t)(const buf_t *);
+
+static size_t build_tree(const buf_t * const buf) {
+  jiffy_tree_t tree;
+  if (!jiffy_tree_new(&tree, &TREE_CBS, buf->ptr, buf->len, NULL)) {
+    errx(EXIT_FAILURE, "bench-tree: jiffy_tree_new() failed");
+  }
+
+  const size_t r = tree.num_vals * sizeof(jiffy_value_t);
+  jiffy_tree_free(&tree);
+  return r;
+}
+
+static size_t build_flat(const buf_t * const buf) {
+  jiffy_flat_t flat;
+  if (!jiffy_flat_new(&flat, NULL, buf->ptr, buf->len, NULL)) {
+    errx(EXIT_FAILURE, "bench-tree: jiffy_flat_new() failed");
+  }
+
+  const size_t r = flat.num_words * sizeof(uint64_t);
+  jiffy_flat_free(&flat);
+  return r;
+}
+
+static size_t build_tree32(const buf_t * const buf) {
+  jiffy_tree32_t tree;
+  if (!jiffy_tree32_new(&tree, NULL, buf->ptr, buf->len, NULL)) {
+    errx(EXIT_FAILURE, "bench-tree: jiffy_tree32_new() failed");
+  }
+
+  const size_t r = tree.num_vals * sizeof(jiffy_value32_t);
+  jiffy_tree32_free(&tree);
+  return r;
+}
+
+static void run_tree(const char * const name, const buf_t * const buf) {
+  static const struct {
+    const char * const name;
+    const tree_fn_t fn;
+  } TREES[] = {
+    { "tree",   build_tree },
+    { "flat",   build_flat },
+    { "tree32", build_tree32 },
+  };
+
+  for (size_t i = 0; i < sizeof(TREES) / sizeof(TREES[0]); i++) {
+    double best_time = 1e9;
+    size_t size = 0;
+
+    for (size_t j = 0; j < TREE_NUM_RUNS; j++) {
+      const double t0 = now();
+      size = TREES[i].fn(buf);
+      const double t1 = now();
+
+      if (t1 - t0 < best_time) {
+        best_time = t1 - t0;
+      }
+    }
+
+    printf("%-10s %-6s %9zu bytes %8.1f MB/s %10zu bytes of values\n",
+      name, TREES[i].name, buf->len, buf->len / best_time / 1e6, size
+    );
+  }
+}
+
+void test_bench_tree(int argc, char *argv[]) {
+  if (argc > 0) {
+    // benchmark given files
+    for (int i = 0; i < argc; i++) {
+      buf_t buf = { 0 };
+      read_file(&buf, argv[i]);
+      run_tree(argv[i], &buf);
+      free(buf.ptr);
+    }
+  } else {
+    // benchmark generated documents
+    static const struct {
+      const char * const name;
+      void (* const fn)(buf_t *);
+    } GENS[] = {
+      { "minified", gen_minified },
+      { "array",    gen_tree_array },
+    };
+
+    for (size_t i = 0; i < sizeof(GENS) / sizeof(GENS[0]); i++) {
+      buf_t buf = { 0 };
+
+      GENS[i].fn(&buf);
+      run_tree(GENS[i].name, &buf);
+      free(buf.ptr);
+    }
+  }
+}
+
+void test_bench(int argc, char *argv[]) {
+  if (argc > 0) {
+    // benchmark given files
+    for (int i = 0; i < argc; i++) {
+      buf_t buf = { 0 };
+      read_file(&buf, argv[i]);
+      run(argv[i], &buf);
+      free(buf.ptr);
+    }
+  } else {
+    // benchmark generated documents
+    static const struct {
+      const char * const name;
+      void (* const fn)(buf_t *);
+    } GENS[] = {
+      { "minified", gen_minified },
+      { "pretty",   gen_pretty },
+      { "strings",  gen_strings },
+      { "numbers",  gen_numbers },
+    };
+
+    for (size_t i = 0; i < sizeof(GENS) / sizeof(GENS[0]); i++) {
+      buf_t buf = { 0 };
+
+      GENS[i].fn(&buf);
+      run(GENS[i].name, &buf);
+      free(buf.ptr);
+    }
+  }
+}
+
+void test_bench_tape(int argc, char *argv[]) {
+  if (argc > 0) {
+    // benchmark given files
+    for (int i = 0; i < argc; i++) {
+      buf_t buf = { 0 };
+      read_file(&buf, argv[i]);
+      run_tape(argv[i], &buf);
+      free(buf.ptr);
+    }
+  } else {
+    // benchmark generated documents
+    static const struct {
+      const char * const name;
+      void (* const fn)(buf_t *);
+    } GENS[] = {
+      { "minified", gen_minified },
+      { "pretty",   gen_pretty },
+      { "strings",  gen_strings },
+      { "numbers",  gen_numbers },
+    };
+
+    for (size_t i = 0; i < sizeof(GENS) / sizeof(GENS[0]); i++) {
+      buf_t buf = { 0 };
+
+      GENS[i].fn(&buf);
+      run_tape(GENS[i].name, &buf);
+      free(buf.ptr);
+    }
+  }
+}
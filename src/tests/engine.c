@@ -0,0 +1,252 @@
+#include <stdbool.h> // bool
+#include <stdint.h> // uint8_t, uint64_t
+#include <stdio.h> // printf()
+#include <string.h> // strlen()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // errx()
+#include "../jiffy.h"
+#include "test-set.h"
+
+// Print a log of the callbacks fired for each document, so that the
+// logs of test binaries built with different parser engines can be
+// compared (see the test-engine target in the Makefile).
+
+// number of callbacks fired; used to pick values to skip
+static size_t num_events;
+
+static void
+log_event(
+  const jiffy_parser_t * const p,
+  const char * const name
+) {
+  num_events++;
+  printf("%s@%zu\n", name, jiffy_parser_get_num_bytes(p));
+}
+
+#define DEF_LOG_CB(name) \
+  static void name(const jiffy_parser_t * const p) { \
+    log_event(p, #name); \
+  }
+
+DEF_LOG_CB(on_utf8_bom)
+DEF_LOG_CB(on_utf16_bom)
+DEF_LOG_CB(on_null)
+DEF_LOG_CB(on_true)
+DEF_LOG_CB(on_false)
+DEF_LOG_CB(on_array_start)
+DEF_LOG_CB(on_array_end)
+DEF_LOG_CB(on_array_element_end)
+DEF_LOG_CB(on_object_start)
+DEF_LOG_CB(on_object_end)
+DEF_LOG_CB(on_object_key_start)
+DEF_LOG_CB(on_object_value_start)
+DEF_LOG_CB(on_object_value_end)
+DEF_LOG_CB(on_string_start)
+DEF_LOG_CB(on_string_end)
+DEF_LOG_CB(on_number_start)
+DEF_LOG_CB(on_number_end)
+DEF_LOG_CB(on_number_fraction)
+DEF_LOG_CB(on_number_exponent)
+DEF_LOG_CB(on_document_end)
+
+// skip some array elements and object values, so that the skip states
+// are exercised as well
+static void
+on_array_element_start(
+  const jiffy_parser_t * const p
+) {
+  log_event(p, "on_array_element_start");
+  if (num_events % 5 == 0) {
+    jiffy_parser_skip_value(p);
+  }
+}
+
+static void
+on_object_key_end(
+  const jiffy_parser_t * const p
+) {
+  log_event(p, "on_object_key_end");
+  if (num_events % 3 == 0) {
+    jiffy_parser_skip_value(p);
+  }
+}
+
+static void
+on_byte(
+  const jiffy_parser_t * const p,
+  const uint8_t byte
+) {
+  printf("byte@%zu:%02x\n", jiffy_parser_get_num_bytes(p), byte);
+}
+
+static void
+on_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  printf("data@%zu:%.*s\n", jiffy_parser_get_num_bytes(p), (int) len, (const char *) ptr);
+}
+
+static void
+on_int64(
+  const jiffy_parser_t * const p,
+  const int64_t val
+) {
+  printf("int64@%zu:%lld\n", jiffy_parser_get_num_bytes(p), (long long) val);
+}
+
+static void
+on_uint64(
+  const jiffy_parser_t * const p,
+  const uint64_t val
+) {
+  printf("uint64@%zu:%llu\n", jiffy_parser_get_num_bytes(p), (unsigned long long) val);
+}
+
+static void
+on_double(
+  const jiffy_parser_t * const p,
+  const double val
+) {
+  printf("double@%zu:%.17g\n", jiffy_parser_get_num_bytes(p), val);
+}
+
+static void
+on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  printf("error@%zu:%s\n", jiffy_parser_get_num_bytes(p), jiffy_err_to_s(err));
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_utf8_bom            = on_utf8_bom,
+  .on_utf16_bom           = on_utf16_bom,
+  .on_null                = on_null,
+  .on_true                = on_true,
+  .on_false               = on_false,
+  .on_array_start         = on_array_start,
+  .on_array_end           = on_array_end,
+  .on_array_element_start = on_array_element_start,
+  .on_array_element_end   = on_array_element_end,
+  .on_object_start        = on_object_start,
+  .on_object_end          = on_object_end,
+  .on_object_key_start    = on_object_key_start,
+  .on_object_key_end      = on_object_key_end,
+  .on_object_value_start  = on_object_value_start,
+  .on_object_value_end    = on_object_value_end,
+  .on_string_start        = on_string_start,
+  .on_string_byte         = on_byte,
+  .on_string_data         = on_data,
+  .on_string_end          = on_string_end,
+  .on_number_start        = on_number_start,
+  .on_number_byte         = on_byte,
+  .on_number_data         = on_data,
+  .on_number_end          = on_number_end,
+  .on_number_sign         = on_byte,
+  .on_number_fraction     = on_number_fraction,
+  .on_number_exponent     = on_number_exponent,
+  .on_number_int64        = on_int64,
+  .on_number_uint64       = on_uint64,
+  .on_number_double       = on_double,
+  .on_document_end        = on_document_end,
+  .on_error               = on_error,
+};
+
+#define STACK_LEN 128
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+#define BUF_LEN 1024
+static uint64_t index_mem[JIFFY_INDEX_NUM_WORDS(BUF_LEN)];
+
+// documents with runs which are longer than a SIMD block, runs which
+// end at the end of the buffer, and errors inside runs
+static const char *
+TESTS[] = {
+  "[\"0123456789abcdef0123456789abcdef0123456789abcdef0123456789abcdef\", 12345678901234567890123]",
+  "                                                                    [true]                  ",
+  "{\"a\":[1,2,3,{\"b\":null},[true,false]],\"c\":\"d\\u00e9\\n\",\"e\":-1.5e+10,\"f\":{\"g\":[]}}",
+  "[1.25,-0,0.5e-3,1E2,true,false,null,\"x\",[[[[]]]],{}]",
+  "[\"abc\x01\"]",
+  "[\"\xc3\xa9\xe2\x82\xac\xf0\x9f\x98\x80\", \"\xc3\"]",
+  "\xef\xbb\xbf{\"k\": [1, 2]}",
+  "[nul]",
+  "[1,,2]",
+  "{\"a\":1 \"b\":2}",
+  "[truefalse]",
+  "[1] [2]",
+  "[0123]",
+  NULL,
+};
+
+// parse document with the given flags, in pushes of the given size
+// (zero for one push, or SIZE_MAX for an indexed push)
+static void
+parse(
+  const char * const buf,
+  const size_t len,
+  const uint32_t flags,
+  const size_t step
+) {
+  jiffy_parser_t p;
+  num_events = 0;
+
+  printf("flags=%u step=%zu\n", (unsigned) flags, step);
+  if (!jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, NULL)) {
+    errx(EXIT_FAILURE, "jiffy_parser_init() failed");
+  }
+  jiffy_parser_set_flags(&p, flags);
+
+  bool ok = true;
+  if (step == SIZE_MAX) {
+    // indexed push
+    jiffy_index_t index;
+    ok = (
+      jiffy_index_init(&index, index_mem, JIFFY_INDEX_NUM_WORDS(BUF_LEN)) &&
+      jiffy_index_build(&index, buf, len) &&
+      jiffy_parser_push_index(&p, &index, buf, len)
+    );
+  } else {
+    const size_t n = step ? step : len;
+    for (size_t ofs = 0; ok && ofs < len; ofs += n) {
+      ok = jiffy_parser_push(&p, buf + ofs, (len - ofs < n) ? len - ofs : n);
+    }
+  }
+
+  ok = ok && jiffy_parser_fini(&p);
+  printf("result=%d bytes=%zu\n", ok, jiffy_parser_get_num_bytes(&p));
+}
+
+static void
+test_doc(
+  const char * const buf,
+  const size_t len
+) {
+  printf("doc: %.*s\n", (int) len, buf);
+  parse(buf, len, 0, 0);
+  parse(buf, len, 0, 1);
+  parse(buf, len, 0, 7);
+  parse(buf, len, 0, SIZE_MAX);
+  parse(buf, len, JIFFY_PARSER_FLAG_VALIDATE_UTF8, 0);
+  parse(buf, len, JIFFY_PARSER_FLAG_MULTI_DOCUMENT, 0);
+}
+
+void test_engine(int argc, char *argv[]) {
+  char buf[BUF_LEN];
+
+  for (size_t i = 0; TESTS[i]; i++) {
+    test_doc(TESTS[i], strlen(TESTS[i]));
+  }
+
+  test_set_t set;
+  if (!test_set_init(&set, argc, argv)) {
+    return;
+  }
+
+  bool expect;
+  size_t len;
+  while (test_set_next(&set, buf, sizeof(buf), &expect, &len)) {
+    test_doc(buf, len);
+  }
+}
@@ -0,0 +1,291 @@
+#define _POSIX_C_SOURCE 200809L // mkstemp()
+#include <stdbool.h> // bool
+#include <stdint.h> // uint64_t
+#include <stdio.h> // fprintf(), snprintf()
+#include <string.h> // strlen(), memcmp()
+#include <stdlib.h> // EXIT_*, malloc(), free(), mkstemp()
+#include <unistd.h> // write(), close(), unlink()
+#include <err.h> // err(), errx()
+#include "../jiffy.h"
+#include "test-set.h"
+
+// event counts and checksum of string and number data
+typedef struct {
+  size_t num_values, num_data;
+  uint64_t hash;
+  jiffy_err_t err;
+} ctx_t;
+
+static void on_value(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_values++;
+}
+
+static void on_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_data += len;
+  for (size_t i = 0; i < len; i++) {
+    ctx->hash = (ctx->hash ^ ptr[i]) * 1099511628211u;
+  }
+}
+
+static void on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->err = err;
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_null        = on_value,
+  .on_true        = on_value,
+  .on_false       = on_value,
+  .on_array_end   = on_value,
+  .on_object_end  = on_value,
+  .on_string_end  = on_value,
+  .on_number_end  = on_value,
+  .on_string_data = on_data,
+  .on_number_data = on_data,
+  .on_error       = on_error,
+};
+
+static void
+on_tree_error(
+  const jiffy_tree_t * const tree,
+  const jiffy_err_t err
+) {
+  jiffy_err_t * const ret = jiffy_tree_get_user_data(tree);
+  *ret = err;
+}
+
+static const jiffy_tree_cbs_t TREE_CBS = {
+  .on_error = on_tree_error,
+};
+
+static void
+on_flat_error(
+  const jiffy_flat_t * const flat,
+  const jiffy_err_t err
+) {
+  jiffy_err_t * const ret = jiffy_flat_get_user_data(flat);
+  *ret = err;
+}
+
+static const jiffy_flat_cbs_t FLAT_CBS = {
+  .on_error = on_flat_error,
+};
+
+static void
+on_tree32_error(
+  const jiffy_tree32_t * const tree,
+  const jiffy_err_t err
+) {
+  jiffy_err_t * const ret = jiffy_tree32_get_user_data(tree);
+  *ret = err;
+}
+
+static const jiffy_tree32_cbs_t TREE32_CBS = {
+  .on_error = on_tree32_error,
+};
+
+#define STACK_LEN 16
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+// write buffer to a new temporary file, return path
+static void
+write_file(
+  char * const path,
+  const void * const buf,
+  const size_t len
+) {
+  strcpy(path, "/tmp/jiffy-test-XXXXXX");
+  const int fd = mkstemp(path);
+  if (fd < 0) {
+    err(EXIT_FAILURE, "mkstemp()");
+  }
+
+  if (len > 0 && write(fd, buf, len) != (ssize_t) len) {
+    err(EXIT_FAILURE, "write()");
+  }
+
+  close(fd);
+}
+
+// parse corpus documents from files
+static void
+test_file_corpus(
+  int argc,
+  char *argv[]
+) {
+  char buf[1024], path[32];
+
+  test_set_t set;
+  if (!test_set_init(&set, argc, argv)) {
+    return;
+  }
+
+  bool expect;
+  size_t len;
+  while (test_set_next(&set, buf, sizeof(buf), &expect, &len)) {
+    write_file(path, buf, len);
+
+    ctx_t ctx = { 0 };
+    if (jiffy_parse_file(&CBS, stack_mem, STACK_LEN, path, &ctx) != expect) {
+      errx(EXIT_FAILURE, "jiffy_parse_file(): expected %d", expect);
+    }
+
+    jiffy_err_t tree_err = JIFFY_ERR_OK;
+    jiffy_tree_t tree;
+    if (jiffy_tree_new_from_file(&tree, &TREE_CBS, path, &tree_err) != expect) {
+      errx(EXIT_FAILURE, "jiffy_tree_new_from_file(): expected %d", expect);
+    }
+
+    if (expect) {
+      jiffy_tree_free(&tree);
+    }
+
+    unlink(path);
+  }
+}
+
+// number of records in generated document
+#define NUM_RECORDS 20000
+
+// parse a document which is larger than the mapping window of the
+// test binary built with a small JIFFY_FILE_MAP_MAX
+static void
+test_file_large(void) {
+  // generate document
+  const size_t cap = NUM_RECORDS * 64;
+  char * const buf = malloc(cap);
+  if (!buf) {
+    err(EXIT_FAILURE, "malloc()");
+  }
+
+  size_t len = 0;
+  buf[len++] = '[';
+  for (size_t i = 0; i < NUM_RECORDS; i++) {
+    len += snprintf(buf + len, cap - len, "%s{\"id\":%zu,\"name\":\"user %zu\"}", i ? "," : "", i, i);
+  }
+  buf[len++] = ']';
+
+  char path[32];
+  write_file(path, buf, len);
+
+  // parse buffer and file, compare results
+  ctx_t exp = { 0 }, got = { 0 };
+  if (!jiffy_parse(&CBS, stack_mem, STACK_LEN, buf, len, &exp)) {
+    errx(EXIT_FAILURE, "large: jiffy_parse() failed");
+  }
+
+  if (!jiffy_parse_file(&CBS, stack_mem, STACK_LEN, path, &got)) {
+    errx(EXIT_FAILURE, "large: jiffy_parse_file() failed: %s", jiffy_err_to_s(got.err));
+  }
+
+  if (got.num_values != exp.num_values || got.num_data != exp.num_data || got.hash != exp.hash) {
+    errx(EXIT_FAILURE, "large: got %zu values, %zu bytes, expected %zu values, %zu bytes", got.num_values, got.num_data, exp.num_values, exp.num_data);
+  }
+
+  // build tree from file, check last record
+  jiffy_err_t tree_err = JIFFY_ERR_OK;
+  jiffy_tree_t tree;
+  if (!jiffy_tree_new_from_file(&tree, &TREE_CBS, path, &tree_err)) {
+    errx(EXIT_FAILURE, "large: jiffy_tree_new_from_file() failed: %s", jiffy_err_to_s(tree_err));
+  }
+
+  const jiffy_value_t * const root = jiffy_tree_get_root_value(&tree);
+  if (!root || jiffy_array_get_size(root) != NUM_RECORDS) {
+    errx(EXIT_FAILURE, "large: bad root array");
+  }
+
+  const jiffy_value_t * const last = jiffy_array_get_nth(root, NUM_RECORDS - 1);
+  size_t name_len;
+  const uint8_t * const name = jiffy_string_get_bytes(jiffy_object_get_nth_value(last, 1), &name_len);
+  if (!name || name_len != 10 || memcmp(name, "user 19999", 10)) {
+    errx(EXIT_FAILURE, "large: bad name of last record");
+  }
+
+  jiffy_tree_free(&tree);
+
+  // build flat tree from file, check last record
+  jiffy_flat_t flat;
+  if (!jiffy_flat_new_from_file(&flat, &FLAT_CBS, path, &tree_err)) {
+    errx(EXIT_FAILURE, "large: jiffy_flat_new_from_file() failed: %s", jiffy_err_to_s(tree_err));
+  }
+
+  const size_t flat_root = jiffy_flat_get_root(&flat);
+  const size_t flat_last = jiffy_flat_array_get_nth(&flat, flat_root, NUM_RECORDS - 1);
+  const uint8_t * const flat_name = jiffy_flat_string_get_bytes(&flat, jiffy_flat_object_get_nth_value(&flat, flat_last, 1), &name_len);
+  if (!flat_name || name_len != 10 || memcmp(flat_name, "user 19999", 10)) {
+    errx(EXIT_FAILURE, "large: bad name of last flat record");
+  }
+
+  jiffy_flat_free(&flat);
+
+  // build compact tree from file, check last record
+  jiffy_tree32_t tree32;
+  if (!jiffy_tree32_new_from_file(&tree32, &TREE32_CBS, path, &tree_err)) {
+    errx(EXIT_FAILURE, "large: jiffy_tree32_new_from_file() failed: %s", jiffy_err_to_s(tree_err));
+  }
+
+  const jiffy_value32_t * const root32 = jiffy_tree32_get_root_value(&tree32);
+  const jiffy_value32_t * const last32 = jiffy_tree32_array_get_nth(&tree32, root32, NUM_RECORDS - 1);
+  const uint8_t * const name32 = jiffy_tree32_string_get_bytes(&tree32, jiffy_tree32_object_get_nth_value(&tree32, last32, 1), &name_len);
+  if (!name32 || name_len != 10 || memcmp(name32, "user 19999", 10)) {
+    errx(EXIT_FAILURE, "large: bad name of last compact record");
+  }
+
+  jiffy_tree32_free(&tree32);
+  unlink(path);
+  free(buf);
+
+  fprintf(stderr, "file test: large: %zu bytes, %zu values\n", len, got.num_values);
+}
+
+// check errors for missing files and directories
+static void
+test_file_errors(void) {
+  static const struct {
+    const char * const path;
+    const jiffy_err_t err;
+  } TESTS[] = {
+    { "/nonexistent/jiffy-test.json", JIFFY_ERR_FILE_OPEN_FAILED },
+    { "/", JIFFY_ERR_FILE_STAT_FAILED },
+  };
+
+  for (size_t i = 0; i < sizeof(TESTS) / sizeof(TESTS[0]); i++) {
+    ctx_t ctx = { 0 };
+    if (jiffy_parse_file(&CBS, stack_mem, STACK_LEN, TESTS[i].path, &ctx) || ctx.err != TESTS[i].err) {
+      errx(EXIT_FAILURE, "%s: jiffy_parse_file(): got %s", TESTS[i].path, jiffy_err_to_s(ctx.err));
+    }
+
+    jiffy_err_t tree_err = JIFFY_ERR_OK;
+    jiffy_tree_t tree;
+    if (jiffy_tree_new_from_file(&tree, &TREE_CBS, TESTS[i].path, &tree_err) || tree_err != TESTS[i].err) {
+      errx(EXIT_FAILURE, "%s: jiffy_tree_new_from_file(): got %s", TESTS[i].path, jiffy_err_to_s(tree_err));
+    }
+
+    jiffy_err_t flat_err = JIFFY_ERR_OK;
+    jiffy_flat_t flat;
+    if (jiffy_flat_new_from_file(&flat, &FLAT_CBS, TESTS[i].path, &flat_err) || flat_err != TESTS[i].err) {
+      errx(EXIT_FAILURE, "%s: jiffy_flat_new_from_file(): got %s", TESTS[i].path, jiffy_err_to_s(flat_err));
+    }
+
+    jiffy_err_t tree32_err = JIFFY_ERR_OK;
+    jiffy_tree32_t tree32;
+    if (jiffy_tree32_new_from_file(&tree32, &TREE32_CBS, TESTS[i].path, &tree32_err) || tree32_err != TESTS[i].err) {
+      errx(EXIT_FAILURE, "%s: jiffy_tree32_new_from_file(): got %s", TESTS[i].path, jiffy_err_to_s(tree32_err));
+    }
+  }
+}
+
+void test_file(int argc, char *argv[]) {
+  test_file_corpus(argc, argv);
+  test_file_large();
+  test_file_errors();
+}
@@ -0,0 +1,337 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf(), snprintf()
+#include <string.h> // strlen(), memcpy()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // errx()
+#include "../jiffy.h"
+
+// event log
+typedef struct {
+  const jiffy_filter_t *filter;
+
+  char log[1024];
+  size_t log_len;
+
+  // current string or number
+  char val[128];
+  size_t val_len;
+  bool in_key;
+
+  // nesting depth of forwarded value
+  size_t depth;
+
+  // number of on_number_int64 and on_string_byte calls
+  size_t num_int64, num_bytes;
+} ctx_t;
+
+static void
+log_event(
+  const jiffy_parser_t * const p,
+  const char * const s
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  const size_t len = strlen(s);
+
+  if (ctx->log_len + len + 2 > sizeof(ctx->log)) {
+    errx(EXIT_FAILURE, "event log overflow");
+  }
+
+  if (ctx->log_len > 0) {
+    ctx->log[ctx->log_len++] = ' ';
+  }
+
+  memcpy(ctx->log + ctx->log_len, s, len + 1);
+  ctx->log_len += len;
+}
+
+// log index of matched path at the start of each forwarded value
+static void
+log_value_start(
+  const jiffy_parser_t * const p
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+
+  if (!ctx->depth && !ctx->in_key) {
+    char buf[32];
+    snprintf(buf, sizeof(buf), "#%zu", jiffy_filter_get_match(ctx->filter));
+    log_event(p, buf);
+  }
+}
+
+static void
+on_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  if (ctx->val_len + len >= sizeof(ctx->val)) {
+    errx(EXIT_FAILURE, "value overflow");
+  }
+
+  memcpy(ctx->val + ctx->val_len, ptr, len);
+  ctx->val_len += len;
+}
+
+static void
+on_string_byte(
+  const jiffy_parser_t * const p,
+  const uint8_t byte
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  (void) byte;
+  ctx->num_bytes++;
+}
+
+static void
+on_number_int64(
+  const jiffy_parser_t * const p,
+  const int64_t val
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  (void) val;
+  ctx->num_int64++;
+}
+
+static void on_value_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  log_value_start(p);
+  ctx->val_len = 0;
+}
+
+static void on_string_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  char buf[160];
+
+  snprintf(buf, sizeof(buf), "%s:%.*s",
+    ctx->in_key ? "k" : "s", (int) ctx->val_len, ctx->val
+  );
+  log_event(p, buf);
+}
+
+static void on_number_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  char buf[160];
+
+  snprintf(buf, sizeof(buf), "n:%.*s", (int) ctx->val_len, ctx->val);
+  log_event(p, buf);
+}
+
+// define logging callback for literal
+#define DEF_LITERAL_CB(name) \
+  static void on_##name(const jiffy_parser_t * const p) { \
+    log_value_start(p); \
+    log_event(p, #name); \
+  }
+
+DEF_LITERAL_CB(null)
+DEF_LITERAL_CB(true)
+DEF_LITERAL_CB(false)
+
+static void on_container_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  log_value_start(p);
+  ctx->depth++;
+}
+
+static void on_array_start(const jiffy_parser_t * const p) {
+  on_container_start(p);
+  log_event(p, "[");
+}
+
+static void on_array_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->depth--;
+  log_event(p, "]");
+}
+
+static void on_object_start(const jiffy_parser_t * const p) {
+  on_container_start(p);
+  log_event(p, "{");
+}
+
+static void on_object_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->depth--;
+  log_event(p, "}");
+}
+
+static void on_object_key_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->in_key = true;
+}
+
+static void on_object_key_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->in_key = false;
+}
+
+static void on_document_end(const jiffy_parser_t * const p) {
+  log_event(p, "|");
+}
+
+static void on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  (void) err;
+  log_event(p, "error");
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_null                = on_null,
+  .on_true                = on_true,
+  .on_false               = on_false,
+  .on_array_start         = on_array_start,
+  .on_array_end           = on_array_end,
+  .on_object_start        = on_object_start,
+  .on_object_end          = on_object_end,
+  .on_object_key_start    = on_object_key_start,
+  .on_object_key_end      = on_object_key_end,
+  .on_string_start        = on_value_start,
+  .on_string_byte         = on_string_byte,
+  .on_string_data         = on_data,
+  .on_string_end          = on_string_end,
+  .on_number_start        = on_value_start,
+  .on_number_data         = on_data,
+  .on_number_end          = on_number_end,
+  .on_number_int64        = on_number_int64,
+  .on_document_end        = on_document_end,
+  .on_error               = on_error,
+};
+
+static const char DOC[] =
+  "{"
+    "\"user\": {\"id\": 42, \"name\": \"bob\", \"tags\": [\"a\", \"b\"]}, "
+    "\"items\": ["
+      "{\"id\": 1, \"price\": 9.5, \"meta\": {\"price\": 0}}, "
+      "{\"price\": null, \"id\": 2}, "
+      "{\"id\": 3}"
+    "], "
+    "\"a/b\": true, "
+    "\"m~n\": false, "
+    "\"\\u0078\": \"esc\", "
+    "\"10\": \"ten\""
+  "}";
+
+static const struct {
+  const char * const text; // document, or NULL for DOC
+  const char * const paths[4];
+  const size_t num_paths;
+  const uint32_t flags;
+  const bool ok;
+  const char * const log; // expected event log
+} TESTS[] = {
+  { NULL, { "/user/id" }, 1, 0, true, "#0 n:42" },
+  { NULL, { "/items/*/price" }, 1, 0, true, "#0 n:9.5 #0 null" },
+  { NULL, { "/items/1" }, 1, 0, true, "#0 { k:price null k:id n:2 }" },
+  { NULL, { "/user/tags/1", "/user/name" }, 2, 0, true, "#1 s:bob #0 s:b" },
+  { NULL, { "/user/name", "/user/*" }, 2, 0, true, "#1 n:42 #0 s:bob #1 [ s:a s:b ]" },
+  { NULL, { "/a~1b", "/m~0n" }, 2, 0, true, "#0 true #1 false" },
+  { NULL, { "/x", "/10" }, 2, 0, true, "#0 s:esc #1 s:ten" },
+  { NULL, { "/items/3", "/user/id/x", "/nope" }, 3, 0, true, "" },
+  { NULL, { 0 }, 0, 0, true, "" },
+  { "[1, [2, 3], 4]", { "" }, 1, 0, true, "#0 [ n:1 [ n:2 n:3 ] n:4 ]" },
+  { "[1, [2, 3], 4]", { "/1/0", "/2" }, 2, 0, true, "#0 n:2 #1 n:4" },
+  { "\"a\"", { "/0" }, 1, 0, true, "" },
+  {
+    "{\"id\": 1, \"x\": 2}\n{\"x\": 3}\n[]\n{\"id\": [4]}",
+    { "/id" }, 1, JIFFY_PARSER_FLAG_MULTI_DOCUMENT, true,
+    "#0 n:1 | | | #0 [ n:4 ] |"
+  },
+  { "{\"a\": [1, 2], \"b\": 3", { "/b" }, 1, 0, false, "#0 n:3 error" },
+  { "{\"a\": [1, }, \"b\": 3}", { "/a/0" }, 1, 0, false, "#0 n:1 error" },
+  { NULL, { NULL }, 0, 0, false, NULL },
+};
+
+// paths which jiffy_filter_init() must reject
+static const char * const BAD_PATHS[] = {
+  "user",
+  "/a~",
+  "/a~2",
+  "/a/b~/c",
+};
+
+#define STACK_LEN 16
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+// parse text in chunks of the given size
+static bool
+parse(
+  ctx_t * const ctx,
+  jiffy_filter_t * const filter,
+  const char * const text,
+  const uint32_t flags,
+  const size_t chunk_size
+) {
+  const size_t len = strlen(text);
+  jiffy_parser_t p;
+
+  memset(ctx, 0, sizeof(ctx_t));
+  ctx->filter = filter;
+  if (!jiffy_parser_init_filter(&p, filter, stack_mem, STACK_LEN, ctx)) {
+    errx(EXIT_FAILURE, "%s: jiffy_parser_init_filter() failed", text);
+  }
+  jiffy_parser_set_flags(&p, flags);
+
+  for (size_t ofs = 0; ofs < len; ofs += chunk_size) {
+    const size_t n = (len - ofs < chunk_size) ? (len - ofs) : chunk_size;
+    if (!jiffy_parser_push(&p, text + ofs, n)) {
+      return false;
+    }
+  }
+
+  return jiffy_parser_fini(&p);
+}
+
+void test_filter(int argc, char *argv[]) {
+  (void) argc;
+  (void) argv;
+
+  static jiffy_filter_t filter;
+
+  for (size_t i = 0; TESTS[i].log; i++) {
+    const char * const text = TESTS[i].text ? TESTS[i].text : DOC;
+    fprintf(stderr, "filter test %zu\n", i);
+
+    if (!jiffy_filter_init(&filter, &CBS, TESTS[i].paths, TESTS[i].num_paths)) {
+      errx(EXIT_FAILURE, "filter test %zu: jiffy_filter_init() failed", i);
+    }
+
+    // parse whole text, then byte by byte
+    static const size_t CHUNK_SIZES[] = { 4096, 1 };
+    for (size_t j = 0; j < 2; j++) {
+      ctx_t ctx;
+      const bool ok = parse(&ctx, &filter, text, TESTS[i].flags, CHUNK_SIZES[j]);
+
+      if (ok != TESTS[i].ok || strcmp(ctx.log, TESTS[i].log)) {
+        errx(EXIT_FAILURE, "filter test %zu: got %s \"%s\", expected %s \"%s\" (chunk size = %zu)",
+          i, ok ? "success" : "failure", ctx.log,
+          TESTS[i].ok ? "success" : "failure", TESTS[i].log, CHUNK_SIZES[j]
+        );
+      }
+    }
+  }
+
+  // check that string bytes and number values are forwarded
+  {
+    static const char * const PATHS[] = { "/user" };
+    ctx_t ctx;
+
+    if (
+      !jiffy_filter_init(&filter, &CBS, PATHS, 1) ||
+      !parse(&ctx, &filter, DOC, 0, 4096) ||
+      ctx.num_bytes != 15 ||
+      ctx.num_int64 != 1
+    ) {
+      errx(EXIT_FAILURE, "filter forwarding test failed");
+    }
+  }
+
+  // check bad paths
+  for (size_t i = 0; i < sizeof(BAD_PATHS) / sizeof(BAD_PATHS[0]); i++) {
+    if (jiffy_filter_init(&filter, &CBS, BAD_PATHS + i, 1)) {
+      errx(EXIT_FAILURE, "filter test: jiffy_filter_init() accepted bad path \"%s\"", BAD_PATHS[i]);
+    }
+  }
+}
@@ -0,0 +1,356 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf(), snprintf()
+#include <string.h> // memcmp()
+#include <stdlib.h> // EXIT_*, malloc(), free()
+#include <err.h> // errx()
+#include "../jiffy.h"
+#include "test-set.h"
+
+static void
+on_tree_error(
+  const jiffy_tree_t * const tree,
+  const jiffy_err_t err
+) {
+  (void) tree;
+  (void) err;
+}
+
+static const jiffy_tree_cbs_t TREE_CBS = {
+  .on_error = on_tree_error,
+};
+
+static void
+on_flat_error(
+  const jiffy_flat_t * const flat,
+  const jiffy_err_t err
+) {
+  jiffy_err_t * const ret = jiffy_flat_get_user_data(flat);
+  if (ret) {
+    *ret = err;
+  }
+}
+
+static const jiffy_flat_cbs_t FLAT_CBS = {
+  .on_error = on_flat_error,
+};
+
+// compare number or string bytes of tree value and flat value
+static void
+check_bytes(
+  const uint8_t * const exp,
+  const size_t exp_len,
+  const uint8_t * const got,
+  const size_t got_len
+) {
+  if (!exp || !got || exp_len != got_len || (exp_len > 0 && memcmp(exp, got, exp_len))) {
+    errx(EXIT_FAILURE, "bytes mismatch");
+  }
+}
+
+// context for each callbacks
+typedef struct {
+  const jiffy_value_t *val;
+  size_t num_calls;
+} each_ctx_t;
+
+static void check_value(const jiffy_value_t *, const jiffy_flat_t *, const size_t);
+
+static void
+on_array_each(
+  const jiffy_flat_t * const flat,
+  const size_t i,
+  const size_t ofs,
+  void * const data
+) {
+  each_ctx_t * const ctx = data;
+  if (i != ctx->num_calls++) {
+    errx(EXIT_FAILURE, "jiffy_flat_array_each(): bad index");
+  }
+
+  check_value(jiffy_array_get_nth(ctx->val, i), flat, ofs);
+}
+
+static void
+on_object_each(
+  const jiffy_flat_t * const flat,
+  const size_t key,
+  const size_t val,
+  void * const data
+) {
+  each_ctx_t * const ctx = data;
+  const size_t i = ctx->num_calls++;
+
+  check_value(jiffy_object_get_nth_key(ctx->val, i), flat, key);
+  check_value(jiffy_object_get_nth_value(ctx->val, i), flat, val);
+}
+
+// compare tree value with flat value
+static void
+check_value(
+  const jiffy_value_t * const val,
+  const jiffy_flat_t * const flat,
+  const size_t ofs
+) {
+  const jiffy_type_t type = jiffy_value_get_type(val);
+  if (jiffy_flat_get_type(flat, ofs) != type) {
+    errx(EXIT_FAILURE, "type mismatch: expected %s, got %s", jiffy_type_to_s(type), jiffy_type_to_s(jiffy_flat_get_type(flat, ofs)));
+  }
+
+  switch (type) {
+  case JIFFY_TYPE_NUMBER:
+    {
+      size_t exp_len, got_len;
+      const uint8_t * const exp = jiffy_number_get_bytes(val, &exp_len);
+      const uint8_t * const got = jiffy_flat_number_get_bytes(flat, ofs, &got_len);
+      check_bytes(exp, exp_len, got, got_len);
+    }
+
+    break;
+  case JIFFY_TYPE_STRING:
+    {
+      size_t exp_len, got_len;
+      const uint8_t * const exp = jiffy_string_get_bytes(val, &exp_len);
+      const uint8_t * const got = jiffy_flat_string_get_bytes(flat, ofs, &got_len);
+      check_bytes(exp, exp_len, got, got_len);
+    }
+
+    break;
+  case JIFFY_TYPE_ARRAY:
+    {
+      const size_t len = jiffy_array_get_size(val);
+      if (jiffy_flat_array_get_size(flat, ofs) != len) {
+        errx(EXIT_FAILURE, "array size mismatch");
+      }
+
+      // check elements with get_nth(), and check that skipping the
+      // elements ends at the end word
+      size_t child = jiffy_flat_array_get_nth(flat, ofs, 0);
+      for (size_t i = 0; i < len; i++) {
+        if (jiffy_flat_array_get_nth(flat, ofs, i) != child) {
+          errx(EXIT_FAILURE, "jiffy_flat_array_get_nth(): bad offset");
+        }
+
+        check_value(jiffy_array_get_nth(val, i), flat, child);
+        child = jiffy_flat_skip(flat, child);
+      }
+
+      if (len > 0 && child + 1 != jiffy_flat_skip(flat, ofs)) {
+        errx(EXIT_FAILURE, "jiffy_flat_skip(): bad array end");
+      }
+
+      if (jiffy_flat_array_get_nth(flat, ofs, len) != JIFFY_FLAT_NONE) {
+        errx(EXIT_FAILURE, "jiffy_flat_array_get_nth(): expected JIFFY_FLAT_NONE");
+      }
+
+      each_ctx_t ctx = { .val = val };
+      if (!jiffy_flat_array_each(flat, ofs, on_array_each, &ctx) || ctx.num_calls != len) {
+        errx(EXIT_FAILURE, "jiffy_flat_array_each() failed");
+      }
+    }
+
+    break;
+  case JIFFY_TYPE_OBJECT:
+    {
+      const size_t len = jiffy_object_get_size(val);
+      if (jiffy_flat_object_get_size(flat, ofs) != len) {
+        errx(EXIT_FAILURE, "object size mismatch");
+      }
+
+      for (size_t i = 0; i < len; i++) {
+        check_value(jiffy_object_get_nth_key(val, i), flat, jiffy_flat_object_get_nth_key(flat, ofs, i));
+        check_value(jiffy_object_get_nth_value(val, i), flat, jiffy_flat_object_get_nth_value(flat, ofs, i));
+      }
+
+      if (jiffy_flat_object_get_nth_value(flat, ofs, len) != JIFFY_FLAT_NONE) {
+        errx(EXIT_FAILURE, "jiffy_flat_object_get_nth_value(): expected JIFFY_FLAT_NONE");
+      }
+
+      each_ctx_t ctx = { .val = val };
+      if (!jiffy_flat_object_each(flat, ofs, on_object_each, &ctx) || ctx.num_calls != len) {
+        errx(EXIT_FAILURE, "jiffy_flat_object_each() failed");
+      }
+    }
+
+    break;
+  default:
+    break;
+  }
+}
+
+// compare flat trees with trees for each corpus document
+static void
+test_flat_corpus(
+  int argc,
+  char *argv[]
+) {
+  char buf[1024];
+
+  test_set_t set;
+  if (!test_set_init(&set, argc, argv)) {
+    return;
+  }
+
+  bool expect;
+  size_t len;
+  while (test_set_next(&set, buf, sizeof(buf), &expect, &len)) {
+    jiffy_flat_t flat;
+    if (jiffy_flat_new(&flat, &FLAT_CBS, buf, len, NULL) != expect) {
+      errx(EXIT_FAILURE, "jiffy_flat_new(): expected %d: %s", expect, buf);
+    }
+
+    if (!expect) {
+      continue;
+    }
+
+    jiffy_tree_t tree;
+    if (!jiffy_tree_new(&tree, &TREE_CBS, buf, len, NULL)) {
+      errx(EXIT_FAILURE, "jiffy_tree_new() failed: %s", buf);
+    }
+
+    // compare values, check that the root value covers the whole tape
+    const size_t root = jiffy_flat_get_root(&flat);
+    check_value(jiffy_tree_get_root_value(&tree), &flat, root);
+    if (jiffy_flat_skip(&flat, root) != flat.num_words) {
+      errx(EXIT_FAILURE, "jiffy_flat_skip(): bad root end: %s", buf);
+    }
+
+    jiffy_tree_free(&tree);
+    jiffy_flat_free(&flat);
+  }
+}
+
+// allocator state
+typedef struct {
+  // number of live allocations, and number of calls
+  size_t num_live, num_calls;
+
+  // fail calls after this many (if non-zero)
+  size_t fail_after;
+
+  // last error
+  jiffy_err_t err;
+} alloc_ctx_t;
+
+static void *
+counting_malloc(
+  const size_t size,
+  void * const user_data
+) {
+  alloc_ctx_t * const ctx = user_data;
+  ctx->num_calls++;
+
+  if (ctx->fail_after && ctx->num_calls > ctx->fail_after) {
+    return NULL;
+  }
+
+  void * const r = malloc(size);
+  if (r) {
+    ctx->num_live++;
+  }
+
+  return r;
+}
+
+static void
+counting_free(
+  void * const ptr,
+  void * const user_data
+) {
+  alloc_ctx_t * const ctx = user_data;
+  ctx->num_live--;
+  free(ptr);
+}
+
+static void
+on_alloc_error(
+  const jiffy_flat_t * const flat,
+  const jiffy_err_t err
+) {
+  alloc_ctx_t * const ctx = jiffy_flat_get_user_data(flat);
+  ctx->err = err;
+}
+
+static const jiffy_flat_cbs_t
+ALLOC_CBS = {
+  .malloc   = counting_malloc,
+  .free     = counting_free,
+  .on_error = on_alloc_error,
+};
+
+// number of elements and nesting depth of generated document
+#define NUM_ELEMENTS 10000
+#define DEPTH 200
+
+// build a flat tree which is large and deep enough to grow the parse
+// buffers and stacks, with and without allocation failures
+static void
+test_flat_alloc(void) {
+  static char buf[NUM_ELEMENTS * 32 + 2 * DEPTH];
+  size_t len = 0;
+
+  for (size_t i = 0; i < DEPTH; i++) {
+    buf[len++] = '[';
+  }
+  for (size_t i = 0; i < NUM_ELEMENTS; i++) {
+    len += snprintf(buf + len, sizeof(buf) - len, "%s{\"k\":[%zu,\"v%zu\"]}", i ? "," : "", i, i);
+  }
+  for (size_t i = 0; i < DEPTH; i++) {
+    buf[len++] = ']';
+  }
+
+  // build flat tree, check that only the flat tree memory is live
+  alloc_ctx_t ctx = { 0 };
+  jiffy_flat_t flat;
+  if (!jiffy_flat_new(&flat, &ALLOC_CBS, buf, len, &ctx)) {
+    errx(EXIT_FAILURE, "alloc: jiffy_flat_new() failed: %s", jiffy_err_to_s(ctx.err));
+  }
+
+  if (ctx.num_live != 1) {
+    errx(EXIT_FAILURE, "alloc: %zu live allocations after jiffy_flat_new()", ctx.num_live);
+  }
+
+  // find innermost array, check last element
+  size_t ary = jiffy_flat_get_root(&flat);
+  for (size_t i = 1; i < DEPTH; i++) {
+    ary = jiffy_flat_array_get_nth(&flat, ary, 0);
+  }
+
+  const size_t last = jiffy_flat_array_get_nth(&flat, ary, NUM_ELEMENTS - 1);
+  const size_t val = jiffy_flat_object_get_nth_value(&flat, last, 0);
+  size_t str_len;
+  const uint8_t * const str = jiffy_flat_string_get_bytes(&flat, jiffy_flat_array_get_nth(&flat, val, 1), &str_len);
+  if (jiffy_flat_array_get_size(&flat, ary) != NUM_ELEMENTS || !str || str_len != 5 || memcmp(str, "v9999", 5)) {
+    errx(EXIT_FAILURE, "alloc: bad flat tree");
+  }
+
+  const size_t num_words = flat.num_words;
+  jiffy_flat_free(&flat);
+  const size_t num_calls = ctx.num_calls;
+
+  // fail each allocation in turn, check for leaks
+  for (size_t i = 1; i < num_calls; i++) {
+    alloc_ctx_t fail_ctx = { .fail_after = i };
+    if (jiffy_flat_new(&flat, &ALLOC_CBS, buf, len, &fail_ctx)) {
+      errx(EXIT_FAILURE, "alloc: jiffy_flat_new() succeeded with %zu allocations", i);
+    }
+
+    if (fail_ctx.num_live) {
+      errx(EXIT_FAILURE, "alloc: %zu live allocations after failure %zu", fail_ctx.num_live, i);
+    }
+
+    if (
+      fail_ctx.err != JIFFY_ERR_TREE_PARSE_MALLOC_FAILED &&
+      fail_ctx.err != JIFFY_ERR_TREE_OUTPUT_MALLOC_FAILED &&
+      fail_ctx.err != JIFFY_ERR_STACK_REALLOC_FAILED
+    ) {
+      errx(EXIT_FAILURE, "alloc: failure %zu: got %s", i, jiffy_err_to_s(fail_ctx.err));
+    }
+  }
+
+  fprintf(stderr, "flat test: alloc: %zu bytes, %zu words, %zu allocations\n", len, num_words, num_calls);
+}
+
+void test_flat(int argc, char *argv[]) {
+  test_flat_corpus(argc, argv);
+  test_flat_alloc();
+}
@@ -0,0 +1,300 @@
+#include <stdbool.h> // bool
+#include <stdint.h> // uint8_t, uint64_t
+#include <stdio.h> // fprintf(), snprintf()
+#include <string.h> // strlen(), strchr(), memcmp()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // err(), errx(), warnx()
+#include "../jiffy.h"
+#include "test-set.h"
+
+// event log
+typedef struct {
+  char buf[16384];
+  size_t len;
+} event_log_t;
+
+// append event and parser position to log
+static void
+log_event(
+  const jiffy_parser_t * const p,
+  const char * const name,
+  const void * const ptr,
+  const size_t len
+) {
+  event_log_t * const log = jiffy_parser_get_user_data(p);
+  const size_t avail = sizeof(log->buf) - log->len;
+  const int n = snprintf(log->buf + log->len, avail, "%s@%zu:%.*s\n", name, jiffy_parser_get_num_bytes(p), (int) len, ptr ? (const char *) ptr : "");
+  if (n < 0 || (size_t) n >= avail) {
+    errx(EXIT_FAILURE, "event log overflow");
+  }
+
+  log->len += n;
+}
+
+#define DEF_LOG_CB(name) \
+  static void name(const jiffy_parser_t * const p) { \
+    log_event(p, #name, NULL, 0); \
+  }
+
+#define DEF_LOG_DATA_CB(name) \
+  static void name(const jiffy_parser_t * const p, const uint8_t * const ptr, const size_t len) { \
+    log_event(p, #name, ptr, len); \
+  }
+
+DEF_LOG_CB(on_null)
+DEF_LOG_CB(on_true)
+DEF_LOG_CB(on_false)
+DEF_LOG_CB(on_array_start)
+DEF_LOG_CB(on_array_end)
+DEF_LOG_CB(on_array_element_start)
+DEF_LOG_CB(on_array_element_end)
+DEF_LOG_CB(on_object_start)
+DEF_LOG_CB(on_object_end)
+DEF_LOG_CB(on_object_key_start)
+DEF_LOG_CB(on_object_key_end)
+DEF_LOG_CB(on_object_value_start)
+DEF_LOG_CB(on_object_value_end)
+DEF_LOG_CB(on_string_start)
+DEF_LOG_CB(on_string_end)
+DEF_LOG_CB(on_number_start)
+DEF_LOG_CB(on_number_end)
+DEF_LOG_DATA_CB(on_string_data)
+DEF_LOG_DATA_CB(on_number_data)
+
+static void on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  const char * const s = jiffy_err_to_s(err);
+  log_event(p, "on_error", s, strlen(s));
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_null                = on_null,
+  .on_true                = on_true,
+  .on_false               = on_false,
+  .on_array_start         = on_array_start,
+  .on_array_end           = on_array_end,
+  .on_array_element_start = on_array_element_start,
+  .on_array_element_end   = on_array_element_end,
+  .on_object_start        = on_object_start,
+  .on_object_end          = on_object_end,
+  .on_object_key_start    = on_object_key_start,
+  .on_object_key_end      = on_object_key_end,
+  .on_object_value_start  = on_object_value_start,
+  .on_object_value_end    = on_object_value_end,
+  .on_string_start        = on_string_start,
+  .on_string_data         = on_string_data,
+  .on_string_end          = on_string_end,
+  .on_number_start        = on_number_start,
+  .on_number_data         = on_number_data,
+  .on_number_end          = on_number_end,
+  .on_error               = on_error,
+};
+
+static void
+on_tree_error(
+  const jiffy_tree_t * const tree,
+  const jiffy_err_t err
+) {
+  (void) tree;
+  warnx("tree error: %s", jiffy_err_to_s(err));
+}
+
+static const jiffy_tree_cbs_t
+TREE_CBS = {
+  .on_error = on_tree_error,
+};
+
+#define STACK_LEN 128
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+#define BUF_LEN 1024
+#define INDEX_LEN JIFFY_INDEX_NUM_WORDS(BUF_LEN)
+static uint64_t index_mem[INDEX_LEN];
+
+static void
+dump_index(
+  const jiffy_index_t * const index,
+  const char * const buf
+) {
+  size_t num_words;
+  const uint64_t * const bits = jiffy_index_get_bits(index, &num_words);
+
+  fprintf(stderr, "index = ");
+  for (size_t i = 0, n = 0; i < 64 * num_words; i++) {
+    if (bits[i / 64] & ((uint64_t) 1 << (i % 64))) {
+      fprintf(stderr, "%s%zu:%c", (n++ > 0) ? "," : "", i, buf[i]);
+    }
+  }
+  fprintf(stderr, "\n");
+}
+
+// check index against positions found one byte at a time
+static void
+check_index(
+  const jiffy_index_t * const index,
+  const char * const buf,
+  const size_t len
+) {
+  size_t num_words;
+  const uint64_t * const bits = jiffy_index_get_bits(index, &num_words);
+  bool in_str = false, escaped = false, sep = true;
+
+  if (num_words != JIFFY_INDEX_NUM_WORDS(len)) {
+    errx(EXIT_FAILURE, "jiffy_index_get_bits(): got %zu words, expected %zu", num_words, JIFFY_INDEX_NUM_WORDS(len));
+  }
+
+  for (size_t i = 0; i < 64 * num_words; i++) {
+    bool expect = false;
+
+    if (i >= len) {
+      // padding
+    } else if (in_str) {
+      if (escaped) {
+        escaped = false;
+      } else if (buf[i] == '\\') {
+        escaped = true;
+      } else if (buf[i] == '"') {
+        // closing quote
+        expect = true;
+        in_str = false;
+        sep = true;
+      }
+    } else if (buf[i] == '"') {
+      // opening quote
+      expect = true;
+      in_str = true;
+    } else if (strchr("{}[]:,", buf[i])) {
+      // structural character
+      expect = true;
+      sep = true;
+    } else if (strchr(" \t\v\r\n", buf[i])) {
+      sep = true;
+    } else {
+      // first byte of literal or number
+      expect = sep;
+      sep = false;
+    }
+
+    if (!!(bits[i / 64] & ((uint64_t) 1 << (i % 64))) != expect) {
+      errx(EXIT_FAILURE, "jiffy_index_build(): byte %zu: expected %s: %s", i, expect ? "set" : "clear", buf);
+    }
+  }
+}
+
+// parse buffer with index or with plain push, log events
+static bool
+parse(
+  event_log_t * const log,
+  const jiffy_index_t * const index,
+  const char * const buf,
+  const size_t len
+) {
+  jiffy_parser_t p;
+  log->len = 0;
+
+  return (
+    jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, log) &&
+    (index ? jiffy_parser_push_index(&p, index, buf, len) : jiffy_parser_push(&p, buf, len)) &&
+    jiffy_parser_fini(&p)
+  );
+}
+
+// documents with escapes, strings and tokens which cross 64-byte
+// blocks, and errors between indexed positions
+static const struct {
+  const char * const text;
+  const bool ok;
+} TESTS[] = {
+  { "{\"a\\\"b\":\"c\\\\\",\"d\":[\"\\u00e9\\n\", \"x\\/y\"]}", true },
+  { "[\"0123456789abcdef0123456789abcdef0123456789abcdef0123456789\\\"abcdef\", 1]", true },
+  { "[1, 2.5e10 ,  -3 , true,false ,null, \"0123456789abcdef0123456789abcdef0123456789abcdef\", 12345678901234567890.5]", true },
+  { "  {  \"key\"  :  {  \"nested\"  :  [  [  ]  ,  {  }  ]  }  }  ", true },
+  { "[1 2]", false },
+  { "[tru e]", false },
+  { "[\"a\" \"b\"]", false },
+  { "{\"a\":1,}", false },
+  { "[1,\"\\q\"]", false },
+  { "\xEF\xBB\xBF [1]", true },
+  { " \xEF\xBB\xBF" "1", false },
+  { "   ", false },
+  { NULL, false },
+};
+
+// check index, parse with index and with plain push, compare events
+static void
+test_doc(
+  const char * const buf,
+  const size_t len,
+  const bool expect
+) {
+  static event_log_t logs[2];
+
+  // init index
+  jiffy_index_t index;
+  if (!jiffy_index_init(&index, index_mem, INDEX_LEN)) {
+    errx(EXIT_FAILURE, "jiffy_index_init() failed");
+  }
+
+  // build index; an unterminated string is the only way this can
+  // fail, so the test case must be expected to fail
+  if (!jiffy_index_build(&index, buf, len)) {
+    if (expect) {
+      errx(EXIT_FAILURE, "jiffy_index_build() failed");
+    }
+
+    return;
+  }
+
+  dump_index(&index, buf);
+
+  if (expect) {
+    check_index(&index, buf, len);
+  }
+
+  // parse line using index, then with plain push, and compare the
+  // callbacks fired
+  const bool ok = parse(logs + 0, &index, buf, len);
+  if (ok != expect) {
+    errx(EXIT_FAILURE, "jiffy_parser_push_index() test failed: %s", buf);
+  }
+
+  if (parse(logs + 1, NULL, buf, len) != ok || logs[0].len != logs[1].len || memcmp(logs[0].buf, logs[1].buf, logs[0].len)) {
+    errx(EXIT_FAILURE, "jiffy_parser_push_index() events differ from jiffy_parser_push():\n%.*s\nvs:\n%.*s", (int) logs[0].len, logs[0].buf, (int) logs[1].len, logs[1].buf);
+  }
+
+  // build tree using index
+  jiffy_tree_t tree;
+  if (jiffy_tree_new_index(&tree, &TREE_CBS, stack_mem, STACK_LEN, &index, buf, len, NULL) != expect) {
+    errx(EXIT_FAILURE, "jiffy_tree_new_index() test failed: %s", buf);
+  }
+
+  if (expect) {
+    jiffy_tree_free(&tree);
+  }
+
+  // bitmap memory which is too small
+  if (len > 64 && jiffy_index_init(&index, index_mem, JIFFY_INDEX_NUM_WORDS(len) - 1) && jiffy_index_build(&index, buf, len)) {
+    errx(EXIT_FAILURE, "jiffy_index_build(): expected failure for short bitmap");
+  }
+}
+
+void test_index(int argc, char *argv[]) {
+  char buf[BUF_LEN];
+
+  for (size_t i = 0; TESTS[i].text; i++) {
+    test_doc(TESTS[i].text, strlen(TESTS[i].text), TESTS[i].ok);
+  }
+
+  test_set_t set;
+  if (!test_set_init(&set, argc, argv)) {
+    return;
+  }
+
+  bool expect;
+  size_t len;
+  while (test_set_next(&set, buf, sizeof(buf), &expect, &len)) {
+    test_doc(buf, len, expect);
+  }
+}
@@ -7,7 +7,24 @@
 
 extern void test_parser(int, char **);
 extern void test_tree(int, char **);
+extern void test_flat(int, char **);
+extern void test_tree32(int, char **);
 extern void test_builder(int, char **);
+extern void test_index(int, char **);
+extern void test_tape(int, char **);
+extern void test_number(int, char **);
+extern void test_utf8(int, char **);
+extern void test_ndjson(int, char **);
+extern void test_skip(int, char **);
+extern void test_filter(int, char **);
+extern void test_stop(int, char **);
+extern void test_stack(int, char **);
+extern void test_stats(int, char **);
+extern void test_file(int, char **);
+extern void test_engine(int, char **);
+extern void test_bench(int, char **);
+extern void test_bench_tree(int, char **);
+extern void test_bench_tape(int, char **);
 static void help(int, char **);
 static void run_all_tests(int, char **);
 
@@ -36,11 +53,96 @@ static const struct {
   .text = "test jiffy_tree_new()",
   .fn   = test_tree,
   .test = true,
+}, {
+  .name = "flat",
+  .text = "test jiffy_flat_new()",
+  .fn   = test_flat,
+  .test = true,
+}, {
+  .name = "tree32",
+  .text = "test jiffy_tree32_new()",
+  .fn   = test_tree32,
+  .test = true,
 }, {
   .name = "builder",
   .text = "test jiffy_builder_*()",
   .fn   = test_builder,
   .test = true,
+}, {
+  .name = "index",
+  .text = "test jiffy_index_*()",
+  .fn   = test_index,
+  .test = true,
+}, {
+  .name = "tape",
+  .text = "test jiffy_tape_*()",
+  .fn   = test_tape,
+  .test = true,
+}, {
+  .name = "number",
+  .text = "test on_number_{int64,uint64,double}",
+  .fn   = test_number,
+  .test = true,
+}, {
+  .name = "utf8",
+  .text = "test JIFFY_PARSER_FLAG_VALIDATE_UTF8",
+  .fn   = test_utf8,
+  .test = true,
+}, {
+  .name = "ndjson",
+  .text = "test JIFFY_PARSER_FLAG_MULTI_DOCUMENT",
+  .fn   = test_ndjson,
+  .test = true,
+}, {
+  .name = "skip",
+  .text = "test jiffy_parser_skip_value()",
+  .fn   = test_skip,
+  .test = true,
+}, {
+  .name = "filter",
+  .text = "test jiffy_filter_*()",
+  .fn   = test_filter,
+  .test = true,
+}, {
+  .name = "stop",
+  .text = "test jiffy_parser_stop()",
+  .fn   = test_stop,
+  .test = true,
+}, {
+  .name = "stack",
+  .text = "test jiffy_parser_set_stack_realloc()",
+  .fn   = test_stack,
+  .test = true,
+}, {
+  .name = "stats",
+  .text = "test jiffy_parser_get_stats()",
+  .fn   = test_stats,
+  .test = true,
+}, {
+  .name = "file",
+  .text = "test jiffy_parse_file() and jiffy_tree_new_from_file()",
+  .fn   = test_file,
+  .test = true,
+}, {
+  .name = "engine",
+  .text = "print callback log for comparing parser engines",
+  .fn   = test_engine,
+  .test = false,
+}, {
+  .name = "bench",
+  .text = "benchmark jiffy_parser_push()",
+  .fn   = test_bench,
+  .test = false,
+}, {
+  .name = "bench-tree",
+  .text = "benchmark jiffy_tree_new(), jiffy_flat_new(), and jiffy_tree32_new()",
+  .fn   = test_bench_tree,
+  .test = false,
+}, {
+  .name = "bench-tape",
+  .text = "benchmark jiffy_parser_push() in tape mode",
+  .fn   = test_bench_tape,
+  .test = false,
 }, {
   .name = NULL,
 }};
@@ -0,0 +1,360 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf(), snprintf()
+#include <string.h> // strlen(), memcpy()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // errx()
+#include <stdatomic.h> // atomic_size_t
+#include "../jiffy.h"
+
+// end offsets of parsed documents
+typedef struct {
+  size_t ofs[16];
+  size_t len;
+} docs_t;
+
+static void on_document_end(const jiffy_parser_t * const p) {
+  docs_t * const docs = jiffy_parser_get_user_data(p);
+  if (docs->len < 16) {
+    docs->ofs[docs->len] = jiffy_parser_get_num_bytes(p);
+  }
+  docs->len++;
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_document_end = on_document_end,
+};
+
+static const struct {
+  const char * const text;
+  const bool ok;
+  const size_t num_docs;
+  const size_t ofs[4]; // end offsets of first documents
+} TESTS[] = {
+  { "", true, 0, { 0 } },
+  { "\n\n", true, 0, { 0 } },
+  { "{}\n[]\n", true, 2, { 1, 4 } },
+  { "{\"a\":1}\n{\"a\":2}\n{\"a\":3}", true, 3, { 6, 14, 22 } },
+  { "1\n2\n3", true, 3, { 1, 3, 5 } },
+  { "\"a\"\ntrue\nnull\nfalse\n", true, 4, { 2, 7, 12, 18 } },
+  { "  [1, 2]  \r\n  \"x\"  ", true, 2, { 7, 16 } },
+  { "{}{}", true, 2, { 1, 3 } },
+  { "\xef\xbb\xbf{}\n", true, 1, { 4 } },
+  { "{}\n[", false, 1, { 1 } },
+  { "{}\n]", false, 1, { 1 } },
+  { "1\n-", false, 1, { 1 } },
+  { NULL, false, 0, { 0 } },
+};
+
+#define STACK_LEN 16
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+#define TAPE_LEN 64
+static jiffy_tape_event_t tape_mem[TAPE_LEN];
+
+// check parse result and document offsets
+static void
+check(
+  const size_t i,
+  const char * const mode,
+  const bool ok,
+  const docs_t * const docs
+) {
+  if (ok != TESTS[i].ok || docs->len != TESTS[i].num_docs) {
+    errx(EXIT_FAILURE, "test %zu (%s): got ok = %d, num_docs = %zu", i, mode, ok, docs->len);
+  }
+
+  for (size_t j = 0; j < docs->len && j < 4; j++) {
+    if (docs->ofs[j] != TESTS[i].ofs[j]) {
+      errx(EXIT_FAILURE, "test %zu (%s): document %zu ends at %zu, expected %zu", i, mode, j, docs->ofs[j], TESTS[i].ofs[j]);
+    }
+  }
+}
+
+// number of records in generated buffer for parallel tests
+#define NUM_RECORDS 2000
+
+// generated buffer and document end offsets
+static char records[NUM_RECORDS * 64];
+static size_t records_len;
+static size_t record_ends[NUM_RECORDS];
+
+// generate records; if bad_record is less than NUM_RECORDS, then that
+// record is invalid
+static void
+gen_records(
+  const size_t bad_record
+) {
+  records_len = 0;
+
+  for (size_t i = 0; i < NUM_RECORDS; i++) {
+    char tmp[64];
+    int len;
+
+    switch (i % 4) {
+    case 0:
+      len = snprintf(tmp, sizeof(tmp), "{\"id\":%zu,\"tags\":[1,2,3]}\n", i);
+      break;
+    case 1:
+      len = snprintf(tmp, sizeof(tmp), "[%zu,\"x\",null]\r\n", i);
+      break;
+    case 2:
+      len = snprintf(tmp, sizeof(tmp), "\"record %zu\"\n", i);
+      break;
+    default:
+      len = snprintf(tmp, sizeof(tmp), "%zu\n", i);
+    }
+
+    if (i == bad_record) {
+      len = snprintf(tmp, sizeof(tmp), "{\"id\":]\n");
+    }
+
+    memcpy(records + records_len, tmp, len);
+    records_len += len;
+
+    // offset of the closing byte, or of the newline after a number
+    record_ends[i] = records_len - ((i % 4 == 1) ? 3 : ((i % 4 == 3) ? 1 : 2));
+  }
+}
+
+// parallel test state
+typedef struct {
+  // document end offsets (ordered mode)
+  size_t ofs[NUM_RECORDS + 1];
+  size_t len;
+
+  // number of documents (unordered mode)
+  atomic_size_t count;
+} parallel_t;
+
+static void on_parallel_document_end(const jiffy_parser_t * const p) {
+  parallel_t * const pt = jiffy_parser_get_user_data(p);
+  if (pt->len <= NUM_RECORDS) {
+    pt->ofs[pt->len++] = jiffy_parser_get_num_bytes(p);
+  }
+}
+
+static void on_parallel_document_count(const jiffy_parser_t * const p) {
+  parallel_t * const pt = jiffy_parser_get_user_data(p);
+  atomic_fetch_add(&pt->count, 1);
+}
+
+static void on_parallel_chunk(
+  const jiffy_ndjson_chunk_t * const chunk,
+  void * const user_data
+) {
+  parallel_t * const pt = user_data;
+  size_t num_evs;
+  const jiffy_tape_event_t * const evs = jiffy_tape_get_events(chunk->tape, &num_evs);
+
+  for (size_t i = 0; i < num_evs; i++) {
+    if (evs[i].type == JIFFY_TAPE_EVENT_DOCUMENT_END) {
+      atomic_fetch_add(&pt->count, 1);
+    }
+  }
+}
+
+static const jiffy_parser_cbs_t PARALLEL_ORDERED_CBS = {
+  .on_document_end = on_parallel_document_end,
+};
+
+static const jiffy_parser_cbs_t PARALLEL_COUNT_CBS = {
+  .on_document_end = on_parallel_document_count,
+};
+
+static parallel_t pt;
+
+static void
+test_parallel(void) {
+  fprintf(stderr, "ndjson parallel test\n");
+  gen_records(NUM_RECORDS);
+
+  // ordered: document ends must arrive in input order
+  {
+    const jiffy_ndjson_opts_t opts = {
+      .cbs          = &PARALLEL_ORDERED_CBS,
+      .num_threads  = 4,
+      .chunk_size   = 256,
+      .ordered      = true,
+    };
+
+    pt.len = 0;
+    if (!jiffy_parse_ndjson_parallel(&opts, records, records_len, &pt)) {
+      errx(EXIT_FAILURE, "ordered parallel parse failed");
+    }
+
+    if (pt.len != NUM_RECORDS) {
+      errx(EXIT_FAILURE, "ordered parallel parse: got %zu records, expected %d", pt.len, NUM_RECORDS);
+    }
+
+    for (size_t i = 0; i < NUM_RECORDS; i++) {
+      if (pt.ofs[i] != record_ends[i]) {
+        errx(EXIT_FAILURE, "ordered parallel parse: record %zu ends at %zu, expected %zu", i, pt.ofs[i], record_ends[i]);
+      }
+    }
+  }
+
+  // unordered, with parser callbacks and with chunk tapes
+  for (size_t i = 0; i < 2; i++) {
+    const jiffy_ndjson_opts_t opts = {
+      .cbs          = i ? NULL : &PARALLEL_COUNT_CBS,
+      .on_chunk     = i ? on_parallel_chunk : NULL,
+      .num_threads  = 4,
+      .chunk_size   = 256,
+    };
+
+    atomic_store(&pt.count, 0);
+    if (!jiffy_parse_ndjson_parallel(&opts, records, records_len, &pt)) {
+      errx(EXIT_FAILURE, "unordered parallel parse failed");
+    }
+
+    if (atomic_load(&pt.count) != NUM_RECORDS) {
+      errx(EXIT_FAILURE, "unordered parallel parse: got %zu records, expected %d", atomic_load(&pt.count), NUM_RECORDS);
+    }
+  }
+
+  // ordered, with a bad record: every earlier record is delivered
+  {
+    const jiffy_ndjson_opts_t opts = {
+      .cbs          = &PARALLEL_ORDERED_CBS,
+      .num_threads  = 4,
+      .chunk_size   = 256,
+      .ordered      = true,
+    };
+
+    gen_records(NUM_RECORDS / 2);
+    pt.len = 0;
+    if (jiffy_parse_ndjson_parallel(&opts, records, records_len, &pt)) {
+      errx(EXIT_FAILURE, "parallel parse of bad record succeeded");
+    }
+
+    if (pt.len != NUM_RECORDS / 2) {
+      errx(EXIT_FAILURE, "parallel parse of bad record: got %zu records, expected %d", pt.len, NUM_RECORDS / 2);
+    }
+  }
+}
+
+// number of lines in generated buffer for ordered chunk test
+#define NUM_LINES 64
+
+// chunk numbers in delivery order (ordered chunk test)
+static size_t chunk_nums[NUM_LINES];
+static size_t num_chunks;
+
+static void on_ordered_chunk(
+  const jiffy_ndjson_chunk_t * const chunk,
+  void * const user_data
+) {
+  (void) user_data;
+  if (num_chunks < NUM_LINES) {
+    chunk_nums[num_chunks++] = chunk->num;
+  }
+}
+
+// ordered mode with one line per chunk and a bad line in the middle:
+// chunks after the bad line finish while earlier chunks are still
+// being parsed, and must neither hang nor let chunks through out of
+// order
+static void
+test_parallel_ordered_error(void) {
+  static char buf[NUM_LINES * 16 + 1000000];
+  size_t len = 0;
+
+  fprintf(stderr, "ndjson parallel ordered error test\n");
+
+  // make the line before the bad line large and the bad line fail
+  // late, so that the chunks after the bad line are claimed and finish
+  // first
+  for (size_t i = 0; i < NUM_LINES; i++) {
+    const size_t num_vals = (i == NUM_LINES / 2 - 1) ? 100000 : ((i == NUM_LINES / 2) ? 10000 : 1);
+    buf[len++] = '[';
+    for (size_t j = 0; j < num_vals; j++) {
+      len += snprintf(buf + len, sizeof(buf) - len, "%s%zu", j ? "," : "", j);
+    }
+    if (i == NUM_LINES / 2) {
+      // bad line fails at the end
+      buf[len++] = ',';
+    }
+    buf[len++] = ']';
+    buf[len++] = '\n';
+  }
+
+  const jiffy_ndjson_opts_t opts = {
+    .on_chunk     = on_ordered_chunk,
+    .num_threads  = 4,
+    .chunk_size   = 1,
+    .ordered      = true,
+  };
+
+  for (size_t i = 0; i < 100; i++) {
+    num_chunks = 0;
+    if (jiffy_parse_ndjson_parallel(&opts, buf, len, NULL)) {
+      errx(EXIT_FAILURE, "ordered parse of bad line succeeded");
+    }
+
+    // every chunk up to and including the bad one, in order
+    if (num_chunks != NUM_LINES / 2 + 1) {
+      errx(EXIT_FAILURE, "ordered parse of bad line: got %zu chunks, expected %d", num_chunks, NUM_LINES / 2 + 1);
+    }
+
+    for (size_t j = 0; j < num_chunks; j++) {
+      if (chunk_nums[j] != j) {
+        errx(EXIT_FAILURE, "ordered parse of bad line: chunk %zu delivered at %zu", chunk_nums[j], j);
+      }
+    }
+  }
+}
+
+void test_ndjson(int argc, char *argv[]) {
+  (void) argc;
+  (void) argv;
+
+  for (size_t i = 0; TESTS[i].text; i++) {
+    const char * const text = TESTS[i].text;
+    const size_t len = strlen(text);
+    fprintf(stderr, "ndjson test %zu\n", i);
+
+    // parse as one buffer, then one byte at a time
+    for (size_t split = 0; split < 2; split++) {
+      docs_t docs = { 0 };
+      jiffy_parser_t p;
+
+      if (!jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, &docs)) {
+        errx(EXIT_FAILURE, "jiffy_parser_init() failed");
+      }
+      jiffy_parser_set_flags(&p, JIFFY_PARSER_FLAG_MULTI_DOCUMENT);
+
+      bool ok = true;
+      if (split) {
+        for (size_t j = 0; ok && j < len; j++) {
+          ok = jiffy_parser_push(&p, text + j, 1);
+        }
+      } else {
+        ok = jiffy_parser_push(&p, text, len);
+      }
+
+      check(i, split ? "split" : "whole", ok && jiffy_parser_fini(&p), &docs);
+    }
+
+    // parse into tape, then replay
+    {
+      docs_t docs = { 0 };
+      jiffy_tape_t tape;
+      jiffy_parser_t p;
+
+      if (
+        !jiffy_tape_init(&tape, tape_mem, TAPE_LEN) ||
+        !jiffy_parser_init_tape(&p, &tape, stack_mem, STACK_LEN, NULL)
+      ) {
+        errx(EXIT_FAILURE, "tape init failed");
+      }
+      jiffy_parser_set_flags(&p, JIFFY_PARSER_FLAG_MULTI_DOCUMENT);
+
+      const bool ok = jiffy_parser_push(&p, text, len) && jiffy_parser_fini(&p);
+      const bool replay_ok = jiffy_tape_replay(&tape, &CBS, text, len, &docs);
+      check(i, "tape", ok && replay_ok, &docs);
+    }
+  }
+
+  test_parallel();
+  test_parallel_ordered_error();
+}
@@ -0,0 +1,349 @@
+#include <stdbool.h> // bool
+#include <stdint.h> // int64_t, uint64_t
+#include <stdio.h> // fprintf(), snprintf()
+#include <string.h> // strlen(), memcmp(), memset()
+#include <stdlib.h> // EXIT_*, strtod()
+#include <err.h> // errx()
+#include "../jiffy.h"
+
+// captured number values
+typedef struct {
+  size_t num_int64, num_uint64, num_double;
+  int64_t i64;
+  uint64_t u64;
+  double f64;
+} values_t;
+
+static void on_number_int64(
+  const jiffy_parser_t * const p,
+  const int64_t val
+) {
+  values_t * const vals = jiffy_parser_get_user_data(p);
+  vals->i64 = val;
+  vals->num_int64++;
+}
+
+static void on_number_uint64(
+  const jiffy_parser_t * const p,
+  const uint64_t val
+) {
+  values_t * const vals = jiffy_parser_get_user_data(p);
+  vals->u64 = val;
+  vals->num_uint64++;
+}
+
+static void on_number_double(
+  const jiffy_parser_t * const p,
+  const double val
+) {
+  values_t * const vals = jiffy_parser_get_user_data(p);
+  vals->f64 = val;
+  vals->num_double++;
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_number_int64  = on_number_int64,
+  .on_number_uint64 = on_number_uint64,
+  .on_number_double = on_number_double,
+};
+
+static const struct {
+  const char * const text;
+  const bool is_int64, is_uint64;
+  const int64_t i64;
+  const uint64_t u64;
+} TESTS[] = {
+  { "0", true, true, 0, 0 },
+  { "-0", true, false, 0, 0 },
+  { "1", true, true, 1, 1 },
+  { "-1", true, false, -1, 0 },
+  { "123456789", true, true, 123456789, 123456789 },
+  { "9223372036854775807", true, true, INT64_MAX, INT64_MAX },
+  { "9223372036854775808", false, true, 0, (uint64_t) INT64_MAX + 1 },
+  { "-9223372036854775808", true, false, INT64_MIN, 0 },
+  { "-9223372036854775809", false, false, 0, 0 },
+  { "18446744073709551615", false, true, 0, UINT64_MAX },
+  { "18446744073709551616", false, false, 0, 0 },
+  { "1.0", false, false, 0, 0 },
+  { "1e2", false, false, 0, 0 },
+  { "0.1", false, false, 0, 0 },
+  { "-0.0", false, false, 0, 0 },
+  { "3.14159e+2", false, false, 0, 0 },
+  { "1E-5", false, false, 0, 0 },
+  { "5e-324", false, false, 0, 0 },
+  { "2.4703282292062327e-324", false, false, 0, 0 },
+  { "2.4703282292062328e-324", false, false, 0, 0 },
+  { "2.2250738585072011e-308", false, false, 0, 0 },
+  { "2.2250738585072012e-308", false, false, 0, 0 },
+  { "1.7976931348623157e308", false, false, 0, 0 },
+  { "1.7976931348623158e308", false, false, 0, 0 },
+  { "1.7976931348623159e308", false, false, 0, 0 },
+  { "1e400", false, false, 0, 0 },
+  { "-1e400", false, false, 0, 0 },
+  { "1e-400", false, false, 0, 0 },
+  { "9007199254740993", true, true, 9007199254740993, 9007199254740993 },
+  { "9007199254740992.5", false, false, 0, 0 },
+  { "9007199254740993.0000000000000000001", false, false, 0, 0 },
+  { "123456789012345678901234567890e-10", false, false, 0, 0 },
+  { "0.000000000000000000000000000000000000000000001e45", false, false, 0, 0 },
+  { "7.2057594037927933e16", false, false, 0, 0 },
+  { "4.4501477170144023e-308", false, false, 0, 0 },
+  { "1e99999999999", false, false, 0, 0 },
+  { "1e-99999999999", false, false, 0, 0 },
+  { "2437610607862787.876593314e-18", false, false, 0, 0 },
+  { "-2437610607862787.876593314e-18", false, false, 0, 0 },
+  { "9007199254740993.000000000000000000000000000001", false, false, 0, 0 },
+  { "9007199254740995.000000000000000000000000000000", false, false, 0, 0 },
+  { NULL, false, false, 0, 0 },
+};
+
+#define STACK_LEN 16
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+// parse text as an array element, so that the whole number is in a
+// single buffer
+static void
+parse_number(
+  values_t * const vals,
+  const char * const text
+) {
+  char buf[128];
+  const int len = snprintf(buf, sizeof(buf), "[%s]", text);
+
+  memset(vals, 0, sizeof(values_t));
+  if (!jiffy_parse(&CBS, stack_mem, STACK_LEN, buf, len, vals)) {
+    errx(EXIT_FAILURE, "%s: parse failed", text);
+  }
+}
+
+// parse text one byte at a time, so that the number is split across
+// buffers and ends in jiffy_parser_fini()
+static void
+parse_number_split(
+  values_t * const vals,
+  const char * const text
+) {
+  const size_t len = strlen(text);
+  jiffy_parser_t p;
+
+  memset(vals, 0, sizeof(values_t));
+  if (!jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, vals)) {
+    errx(EXIT_FAILURE, "jiffy_parser_init() failed");
+  }
+
+  for (size_t i = 0; i < len; i++) {
+    if (!jiffy_parser_push(&p, text + i, 1)) {
+      errx(EXIT_FAILURE, "%s: split parse failed", text);
+    }
+  }
+
+  if (!jiffy_parser_fini(&p)) {
+    errx(EXIT_FAILURE, "%s: split parse failed", text);
+  }
+}
+
+// check split parse of text against strtod()
+static void
+check_split(
+  const char * const text
+) {
+  values_t vals;
+  parse_number_split(&vals, text);
+
+  const double expect = strtod(text, NULL);
+  if (vals.num_double != 1 || memcmp(&vals.f64, &expect, sizeof(double))) {
+    errx(EXIT_FAILURE, "%s: split on_number_double test failed (got %.17g, expected %.17g)", text, vals.f64, expect);
+  }
+}
+
+// number of random numbers checked by test_number_random()
+#define NUM_RANDOM 200000
+
+// check split parse of random numbers with more significant digits
+// than fit in 64 bits
+static void
+test_number_random(void) {
+  uint64_t x = 0x9E3779B97F4A7C15ULL;
+
+  fprintf(stderr, "number test: %d random numbers\n", NUM_RANDOM);
+
+  for (size_t i = 0; i < NUM_RANDOM; i++) {
+    char buf[64];
+    size_t len = 0;
+
+    // xorshift64
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+
+    const size_t num_digits = 17 + x % 24,
+                 dot = 1 + (x >> 8) % num_digits;
+    const int exp = (int) ((x >> 16) % 640) - 330;
+
+    buf[len++] = '1' + (x >> 32) % 9;
+    for (size_t j = 1; j < num_digits; j++) {
+      x ^= x << 13;
+      x ^= x >> 7;
+      x ^= x << 17;
+
+      if (j == dot) {
+        buf[len++] = '.';
+      }
+      buf[len++] = '0' + x % 10;
+    }
+
+    snprintf(buf + len, sizeof(buf) - len, "e%d", exp);
+    check_split(buf);
+  }
+}
+
+// digits of 5^1075; 5^1075 * 10^-1075 = 2^-1075 is halfway between
+// zero and the smallest subnormal double
+static char *
+pow5_digits(void) {
+  static char digits[800];
+  size_t len = 1;
+
+  // little-endian decimal digits
+  digits[0] = 1;
+  for (size_t i = 0; i < 1075; i++) {
+    int carry = 0;
+    for (size_t j = 0; j < len; j++) {
+      const int d = digits[j] * 5 + carry;
+      digits[j] = d % 10;
+      carry = d / 10;
+    }
+
+    if (carry) {
+      digits[len++] = carry;
+    }
+  }
+
+  // reverse and convert to text
+  for (size_t i = 0; i < len / 2; i++) {
+    const char t = digits[i];
+    digits[i] = digits[len - 1 - i];
+    digits[len - 1 - i] = t;
+  }
+  for (size_t i = 0; i < len; i++) {
+    digits[i] += '0';
+  }
+  digits[len] = '\0';
+
+  return digits;
+}
+
+// check numbers with hundreds of digits near the halfway point
+// between zero and the smallest subnormal double, parsed in one
+// buffer and split
+static void
+test_number_long(void) {
+  static char text[4096];
+  const char * const digits = pow5_digits();
+
+  static const struct {
+    const char * const tail; // digits appended to 5^1075
+    const size_t num_zeros; // zeros between 5^1075 and tail
+    const double expect;
+  } TESTS[] = {
+    { "", 0, 0.0 },
+    { "1", 0, 5e-324 },
+    { "", 1000, 0.0 },
+    { "1", 1000, 5e-324 },
+    { NULL, 0, 0.0 },
+  };
+
+  for (size_t i = 0; TESTS[i].tail; i++) {
+    const size_t num_zeros = TESTS[i].num_zeros;
+    const size_t tail_len = strlen(TESTS[i].tail);
+    size_t len = snprintf(text, sizeof(text), "[%s", digits);
+
+    memset(text + len, '0', num_zeros);
+    len += num_zeros;
+    len += snprintf(text + len, sizeof(text) - len, "%se-%zu]", TESTS[i].tail, 1075 + num_zeros + tail_len);
+
+    fprintf(stderr, "number test: long %zu (%zu bytes)\n", i, len);
+
+    values_t vals;
+    memset(&vals, 0, sizeof(values_t));
+    if (!jiffy_parse(&CBS, stack_mem, STACK_LEN, text, len, &vals)) {
+      errx(EXIT_FAILURE, "long %zu: parse failed", i);
+    }
+
+    if (vals.num_double != 1 || memcmp(&vals.f64, &TESTS[i].expect, sizeof(double))) {
+      errx(EXIT_FAILURE, "long %zu: on_number_double test failed (got %.17g, expected %.17g)", i, vals.f64, TESTS[i].expect);
+    }
+
+    // strip brackets, parse split
+    text[len - 1] = '\0';
+    parse_number_split(&vals, text + 1);
+    if (vals.num_double != 1 || memcmp(&vals.f64, &TESTS[i].expect, sizeof(double))) {
+      errx(EXIT_FAILURE, "long %zu: split on_number_double test failed (got %.17g, expected %.17g)", i, vals.f64, TESTS[i].expect);
+    }
+  }
+}
+
+void test_number(int argc, char *argv[]) {
+  (void) argc;
+  (void) argv;
+
+  for (size_t i = 0; TESTS[i].text; i++) {
+    const char * const text = TESTS[i].text;
+    values_t vals;
+
+    fprintf(stderr, "number test: %s\n", text);
+    parse_number(&vals, text);
+
+    // check integer values
+    if (
+      vals.num_int64 != TESTS[i].is_int64 ||
+      (TESTS[i].is_int64 && vals.i64 != TESTS[i].i64)
+    ) {
+      errx(EXIT_FAILURE, "%s: on_number_int64 test failed", text);
+    }
+
+    if (
+      vals.num_uint64 != TESTS[i].is_uint64 ||
+      (TESTS[i].is_uint64 && vals.u64 != TESTS[i].u64)
+    ) {
+      errx(EXIT_FAILURE, "%s: on_number_uint64 test failed", text);
+    }
+
+    // check double value against strtod(); compare bits to catch the
+    // sign of zero
+    const double expect = strtod(text, NULL);
+    if (vals.num_double != 1 || memcmp(&vals.f64, &expect, sizeof(double))) {
+      errx(EXIT_FAILURE, "%s: on_number_double test failed (got %.17g, expected %.17g)", text, vals.f64, expect);
+    }
+
+    // check top-level number, split across buffers
+    check_split(text);
+
+    // check tree accessors
+    jiffy_tree_t tree;
+    if (!jiffy_tree_new(&tree, NULL, text, strlen(text), NULL)) {
+      errx(EXIT_FAILURE, "%s: jiffy_tree_new() failed", text);
+    }
+
+    const jiffy_value_t * const root = jiffy_tree_get_root_value(&tree);
+    int64_t i64;
+    uint64_t u64;
+    double f64;
+
+    if (
+      jiffy_number_get_int64(root, &i64) != TESTS[i].is_int64 ||
+      (TESTS[i].is_int64 && i64 != TESTS[i].i64) ||
+      jiffy_number_get_uint64(root, &u64) != TESTS[i].is_uint64 ||
+      (TESTS[i].is_uint64 && u64 != TESTS[i].u64) ||
+      !jiffy_number_get_double(root, &f64) ||
+      memcmp(&f64, &expect, sizeof(double))
+    ) {
+      errx(EXIT_FAILURE, "%s: jiffy_number_get_*() test failed", text);
+    }
+
+    jiffy_tree_free(&tree);
+  }
+
+  test_number_random();
+  test_number_long();
+}
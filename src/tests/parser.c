@@ -106,6 +106,15 @@ static void on_string_byte(
   warnx("D: string byte = %02x", byte);
 }
 
+static void on_string_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  (void) p;
+  warnx("D: string data = \"%.*s\" (%zu bytes)", (int) len, ptr, len);
+}
+
 static void on_number_start(
   const jiffy_parser_t * const p
 ) {
@@ -128,6 +137,15 @@ static void on_number_byte(
   warnx("D: number byte = %02x", byte);
 }
 
+static void on_number_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  (void) p;
+  warnx("D: number data = \"%.*s\" (%zu bytes)", (int) len, ptr, len);
+}
+
 static void on_true(
   const jiffy_parser_t * const p
 ) {
@@ -164,9 +182,11 @@ static const jiffy_parser_cbs_t CBS = {
   .on_string_start        = on_string_start,
   .on_string_end          = on_string_end,
   .on_string_byte         = on_string_byte,
+  .on_string_data         = on_string_data,
   .on_number_start        = on_number_start,
   .on_number_end          = on_number_end,
   .on_number_byte         = on_number_byte,
+  .on_number_data         = on_number_data,
   .on_true                = on_true,
   .on_false               = on_false,
   .on_null                = on_null,
@@ -175,6 +195,28 @@ static const jiffy_parser_cbs_t CBS = {
 #define STACK_LEN 128
 static uint32_t stack_mem[STACK_LEN];
 
+static bool parse_bytewise(
+  const char * const buf,
+  const size_t len
+) {
+  jiffy_parser_t p;
+
+  // init parser, check for error
+  if (!jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, NULL)) {
+    return false;
+  }
+
+  // push one byte at a time, check for error
+  for (size_t i = 0; i < len; i++) {
+    if (!jiffy_parser_push(&p, buf + i, 1)) {
+      return false;
+    }
+  }
+
+  // finalize parser
+  return jiffy_parser_fini(&p);
+}
+
 void test_parser(int argc, char *argv[]) {
   char buf[1024];
 
@@ -194,5 +236,12 @@ void test_parser(int argc, char *argv[]) {
     }
 
     warnx("D: parsing done");
+
+    // parse line again, one byte at a time
+    if (parse_bytewise(buf, len) != expect) {
+      errx(EXIT_FAILURE, "bytewise jiffy_parser_push() test failed.");
+    }
+
+    warnx("D: bytewise parsing done");
   }
 }
@@ -0,0 +1,291 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf(), snprintf()
+#include <string.h> // strlen(), memcpy()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // errx()
+#include "../jiffy.h"
+
+#define MAX_DEPTH 16
+
+// event log and skip state
+typedef struct {
+  char log[1024];
+  size_t log_len;
+
+  // current string or number
+  char val[128];
+  size_t val_len;
+  bool in_key;
+
+  // element index of each open array
+  size_t index[MAX_DEPTH];
+  size_t depth;
+} ctx_t;
+
+static void
+log_event(
+  const jiffy_parser_t * const p,
+  const char * const s
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  const size_t len = strlen(s);
+
+  if (ctx->log_len + len + 2 > sizeof(ctx->log)) {
+    errx(EXIT_FAILURE, "event log overflow");
+  }
+
+  if (ctx->log_len > 0) {
+    ctx->log[ctx->log_len++] = ' ';
+  }
+
+  memcpy(ctx->log + ctx->log_len, s, len + 1);
+  ctx->log_len += len;
+}
+
+static void
+on_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  if (ctx->val_len + len >= sizeof(ctx->val)) {
+    errx(EXIT_FAILURE, "value overflow");
+  }
+
+  memcpy(ctx->val + ctx->val_len, ptr, len);
+  ctx->val_len += len;
+}
+
+static void on_value_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->val_len = 0;
+}
+
+static void on_string_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  char buf[160];
+
+  snprintf(buf, sizeof(buf), "%s:%.*s",
+    ctx->in_key ? "k" : "s", (int) ctx->val_len, ctx->val
+  );
+  log_event(p, buf);
+}
+
+static void on_number_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  char buf[160];
+
+  snprintf(buf, sizeof(buf), "n:%.*s", (int) ctx->val_len, ctx->val);
+  log_event(p, buf);
+}
+
+static void on_null(const jiffy_parser_t * const p) {
+  log_event(p, "null");
+}
+
+static void on_true(const jiffy_parser_t * const p) {
+  log_event(p, "true");
+}
+
+static void on_false(const jiffy_parser_t * const p) {
+  log_event(p, "false");
+}
+
+static void on_array_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  if (ctx->depth < MAX_DEPTH) {
+    ctx->index[ctx->depth] = 0;
+  }
+  ctx->depth++;
+  log_event(p, "[");
+}
+
+static void on_array_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->depth--;
+  log_event(p, "]");
+}
+
+// skip odd array elements
+static void on_array_element_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  const size_t ofs = ctx->depth - 1;
+
+  if (ofs < MAX_DEPTH && (ctx->index[ofs]++ & 1)) {
+    if (!jiffy_parser_skip_value(p)) {
+      errx(EXIT_FAILURE, "jiffy_parser_skip_value() failed in on_array_element_start");
+    }
+    log_event(p, "skip");
+  }
+}
+
+static void on_array_element_end(const jiffy_parser_t * const p) {
+  log_event(p, ",");
+}
+
+static void on_object_start(const jiffy_parser_t * const p) {
+  log_event(p, "{");
+}
+
+static void on_object_end(const jiffy_parser_t * const p) {
+  log_event(p, "}");
+}
+
+static void on_object_key_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->in_key = true;
+}
+
+// skip values of keys which start with "x"
+static void on_object_key_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->in_key = false;
+
+  if (ctx->val_len > 0 && ctx->val[0] == 'x') {
+    if (!jiffy_parser_skip_value(p)) {
+      errx(EXIT_FAILURE, "jiffy_parser_skip_value() failed in on_object_key_end");
+    }
+    log_event(p, "skip");
+  }
+}
+
+// skip values of keys which start with "y"
+static void on_object_value_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+
+  if (ctx->val_len > 0 && ctx->val[0] == 'y') {
+    if (!jiffy_parser_skip_value(p)) {
+      errx(EXIT_FAILURE, "jiffy_parser_skip_value() failed in on_object_value_start");
+    }
+    log_event(p, "skip");
+  }
+}
+
+static void on_object_value_end(const jiffy_parser_t * const p) {
+  log_event(p, ";");
+}
+
+// skip_value() must fail outside of element and value callbacks
+static void on_utf8_bom(const jiffy_parser_t * const p) {
+  if (jiffy_parser_skip_value(p)) {
+    errx(EXIT_FAILURE, "jiffy_parser_skip_value() succeeded in on_utf8_bom");
+  }
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_null                = on_null,
+  .on_true                = on_true,
+  .on_false               = on_false,
+  .on_array_start         = on_array_start,
+  .on_array_end           = on_array_end,
+  .on_array_element_start = on_array_element_start,
+  .on_array_element_end   = on_array_element_end,
+  .on_object_start        = on_object_start,
+  .on_object_end          = on_object_end,
+  .on_object_key_start    = on_object_key_start,
+  .on_object_key_end      = on_object_key_end,
+  .on_object_value_start  = on_object_value_start,
+  .on_object_value_end    = on_object_value_end,
+  .on_string_start        = on_value_start,
+  .on_string_data         = on_data,
+  .on_string_end          = on_string_end,
+  .on_number_start        = on_value_start,
+  .on_number_data         = on_data,
+  .on_number_end          = on_number_end,
+  .on_utf8_bom            = on_utf8_bom,
+};
+
+static const struct {
+  const char * const text;
+  const bool ok;
+  const char * const log; // expected event log
+} TESTS[] = {
+  { "[1,2,3]", true, "[ n:1 , skip , n:3 , ]" },
+  { "[1 , true ,3]", true, "[ n:1 , skip , n:3 , ]" },
+  { "[1,-2.5e3]", true, "[ n:1 , skip , ]" },
+  { "[1,null]", true, "[ n:1 , skip , ]" },
+  { "[1,\"a\\\"],{\"]", true, "[ n:1 , skip , ]" },
+  { "[1,[2,[3,\"]\"],{\"a\":\"}\"}],4]", true, "[ n:1 , skip , n:4 , ]" },
+  { "[[1,2,3],[4,5,6]]", true, "[ [ n:1 , skip , n:3 , ] , skip , ]" },
+  {
+    "[1,[\"0123456789abcdef0123456789abcdef0123456789abcdef\", "
+    "\"]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]\\\"\", "
+    "[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[[]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]]], "
+    "{\"0123456789abcdef0123456789abcdef\": 0123456789012345678901234}"
+    "],2]", true, "[ n:1 , skip , n:2 , ]"
+  },
+  { "\xef\xbb\xbf[0,{}]", true, "[ n:0 , skip , ]" },
+  { "{\"a\":1,\"x\":2,\"b\":3}", true, "{ k:a n:1 ; k:x skip ; k:b n:3 ; }" },
+  { "{\"x\" : {\"a\":[1,2]} , \"b\":true}", true, "{ k:x skip ; k:b true ; }" },
+  { "{\"x\":\"\\\\\",\"b\":\"c\"}", true, "{ k:x skip ; k:b s:c ; }" },
+  { "{\"y\":false,\"b\":null}", true, "{ k:y skip ; k:b null ; }" },
+  { "{\"y\": [ \"}\" ] }", true, "{ k:y skip ; }" },
+  { "{\"x\":true}", true, "{ k:x skip ; }" },
+  { "{\"a\":[5,{\"x\":[]},6,7]}", true, "{ k:a [ n:5 , skip , n:6 , skip , ] ; }" },
+  { "[1,]", false, NULL },
+  { "[1,2", false, NULL },
+  { "[1,[2]", false, NULL },
+  { "[1,\"abc", false, NULL },
+  { "{\"x\":}", false, NULL },
+  { "{\"x\":1:}", false, NULL },
+  { "[1,2\"a\"]", false, NULL },
+  { NULL, false, NULL },
+};
+
+#define STACK_LEN 16
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+// parse text in chunks of the given size
+static bool
+parse(
+  ctx_t * const ctx,
+  const char * const text,
+  const size_t chunk_size
+) {
+  const size_t len = strlen(text);
+  jiffy_parser_t p;
+
+  memset(ctx, 0, sizeof(ctx_t));
+  if (!jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, ctx)) {
+    errx(EXIT_FAILURE, "%s: jiffy_parser_init() failed", text);
+  }
+
+  for (size_t ofs = 0; ofs < len; ofs += chunk_size) {
+    const size_t n = (len - ofs < chunk_size) ? (len - ofs) : chunk_size;
+    if (!jiffy_parser_push(&p, text + ofs, n)) {
+      return false;
+    }
+  }
+
+  return jiffy_parser_fini(&p);
+}
+
+void test_skip(int argc, char *argv[]) {
+  (void) argc;
+  (void) argv;
+
+  for (size_t i = 0; TESTS[i].text; i++) {
+    const char * const text = TESTS[i].text;
+    fprintf(stderr, "skip test: %s\n", text);
+
+    // parse whole text, then byte by byte
+    static const size_t CHUNK_SIZES[] = { 4096, 1 };
+    for (size_t j = 0; j < 2; j++) {
+      ctx_t ctx;
+      const bool ok = parse(&ctx, text, CHUNK_SIZES[j]);
+
+      if (ok != TESTS[i].ok) {
+        errx(EXIT_FAILURE, "%s: expected %s (chunk size = %zu)", text,
+          TESTS[i].ok ? "success" : "failure", CHUNK_SIZES[j]
+        );
+      }
+
+      if (ok && strcmp(ctx.log, TESTS[i].log)) {
+        errx(EXIT_FAILURE, "%s: got \"%s\", expected \"%s\" (chunk size = %zu)",
+          text, ctx.log, TESTS[i].log, CHUNK_SIZES[j]
+        );
+      }
+    }
+  }
+}
@@ -0,0 +1,183 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf()
+#include <string.h> // memset()
+#include <stdlib.h> // EXIT_*, realloc(), free()
+#include <err.h> // errx()
+#include "../jiffy.h"
+
+// allocator state
+typedef struct {
+  // number of live allocations, and number of calls
+  size_t num_live, num_calls;
+
+  // fail allocations larger than this many bytes (if non-zero)
+  size_t fail_size;
+
+  // last error
+  jiffy_err_t err;
+} ctx_t;
+
+static void *
+stack_realloc(
+  void * const ptr,
+  const size_t size,
+  void * const user_data
+) {
+  ctx_t * const ctx = user_data;
+  ctx->num_calls++;
+
+  if (!size) {
+    free(ptr);
+    ctx->num_live--;
+    return NULL;
+  }
+
+  if (ctx->fail_size && size > ctx->fail_size) {
+    return NULL;
+  }
+
+  void * const r = realloc(ptr, size);
+  if (r && !ptr) {
+    ctx->num_live++;
+  }
+
+  return r;
+}
+
+static void on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->err = err;
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_error = on_error,
+};
+
+// number of entries in initial stack
+#define STACK_LEN 4
+
+// build document with the given number of nested arrays and objects
+static size_t
+gen_nested(
+  char * const buf,
+  const size_t depth
+) {
+  size_t len = 0;
+
+  for (size_t i = 0; i < depth; i++) {
+    if (i & 1) {
+      memcpy(buf + len, "{\"a\":", 5);
+      len += 5;
+    } else {
+      buf[len++] = '[';
+    }
+  }
+
+  buf[len++] = '0';
+
+  for (size_t i = depth; i > 0; i--) {
+    buf[len++] = ((i - 1) & 1) ? '}' : ']';
+  }
+
+  return len;
+}
+
+static bool
+parse(
+  ctx_t * const ctx,
+  const char * const buf,
+  const size_t len,
+  const size_t stack_max
+) {
+  jiffy_parser_state_t stack_mem[STACK_LEN];
+  jiffy_parser_t p;
+
+  if (
+    !jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, ctx) ||
+    !jiffy_parser_set_stack_realloc(&p, stack_realloc, stack_max)
+  ) {
+    errx(EXIT_FAILURE, "stack test: parser init failed");
+  }
+
+  const bool r = jiffy_parser_push(&p, buf, len) && jiffy_parser_fini(&p);
+  jiffy_parser_free_stack(&p);
+  return r;
+}
+
+void test_stack(int argc, char *argv[]) {
+  (void) argc;
+  (void) argv;
+
+  static char buf[4 << 20];
+
+  static const struct {
+    const size_t depth, stack_max, fail_size;
+    const bool ok;
+    const jiffy_err_t err;
+  } TESTS[] = {
+    { 0, 4, 0, true, JIFFY_ERR_OK },
+    { 1, 4, 0, true, JIFFY_ERR_OK },
+    { 10, 1024, 0, true, JIFFY_ERR_OK },
+    { 100000, 1 << 20, 0, true, JIFFY_ERR_OK },
+
+    // each entry holds 32 nesting levels
+    { 128, 4, 0, true, JIFFY_ERR_OK },
+    { 129, 4, 0, false, JIFFY_ERR_STACK_OVERFLOW },
+    { 1000, 32, 0, true, JIFFY_ERR_OK },
+    { 1000, 31, 0, false, JIFFY_ERR_STACK_OVERFLOW },
+
+    { 10000, 64, 0, false, JIFFY_ERR_STACK_OVERFLOW },
+    { 10000, 1024, 256, false, JIFFY_ERR_STACK_REALLOC_FAILED },
+  };
+
+  for (size_t i = 0; i < sizeof(TESTS) / sizeof(TESTS[0]); i++) {
+    fprintf(stderr, "stack test: depth = %zu, max = %zu\n", TESTS[i].depth, TESTS[i].stack_max);
+
+    ctx_t ctx = { .fail_size = TESTS[i].fail_size };
+    const size_t len = gen_nested(buf, TESTS[i].depth);
+    const bool ok = parse(&ctx, buf, len, TESTS[i].stack_max);
+
+    if (ok != TESTS[i].ok || ctx.err != TESTS[i].err || ctx.num_live) {
+      errx(EXIT_FAILURE, "stack test failed: depth = %zu, got %s (%s), %zu live allocations",
+        TESTS[i].depth, ok ? "success" : "failure", jiffy_err_to_s(ctx.err),
+        ctx.num_live
+      );
+    }
+  }
+
+  // a stack which does not need to grow must not allocate
+  {
+    ctx_t ctx = { 0 };
+    if (!parse(&ctx, "[1,2]", 5, 1024) || ctx.num_calls) {
+      errx(EXIT_FAILURE, "stack test: unexpected allocation");
+    }
+  }
+
+  // the maximum must not be less than the initial stack size
+  {
+    jiffy_parser_state_t stack_mem[STACK_LEN];
+    jiffy_parser_t p;
+
+    if (
+      !jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, NULL) ||
+      jiffy_parser_set_stack_realloc(&p, stack_realloc, STACK_LEN - 1)
+    ) {
+      errx(EXIT_FAILURE, "stack test: jiffy_parser_set_stack_realloc() accepted bad maximum");
+    }
+  }
+
+  // jiffy_tree_new() grows its stack for deep documents
+  {
+    const size_t len = gen_nested(buf, 10000);
+    jiffy_tree_t tree;
+
+    if (!jiffy_tree_new(&tree, NULL, buf, len, NULL)) {
+      errx(EXIT_FAILURE, "stack test: jiffy_tree_new() failed");
+    }
+
+    jiffy_tree_free(&tree);
+  }
+}
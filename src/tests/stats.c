@@ -0,0 +1,178 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf()
+#include <string.h> // strlen(), memcmp()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // errx()
+#include "../jiffy.h"
+
+static void on_value(const jiffy_parser_t * const p) {
+  (void) p;
+}
+
+// skip object values if the user data is non-NULL
+static void on_object_key_end(const jiffy_parser_t * const p) {
+  if (jiffy_parser_get_user_data(p)) {
+    jiffy_parser_skip_value(p);
+  }
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_true              = on_value,
+  .on_array_start       = on_value,
+  .on_object_key_start  = on_value,
+  .on_object_key_end    = on_object_key_end,
+  .on_string_end        = on_value,
+  .on_number_end        = on_value,
+};
+
+#define STACK_LEN 4
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+#define INDEX_LEN 64
+static uint64_t index_mem[INDEX_LEN];
+
+static const char DOC[] = "{\"a\": [1, -2.5, \"xy\"], \"b\": true}";
+
+// parse document with the given chunk size (zero to use a structural
+// index), and return the parser statistics
+static void
+parse(
+  jiffy_parser_stats_t * const stats,
+  const size_t chunk_size,
+  const bool skip
+) {
+  const size_t len = strlen(DOC);
+  jiffy_parser_t p;
+
+  if (!jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, skip ? stats : NULL)) {
+    errx(EXIT_FAILURE, "stats test: parser init failed");
+  }
+
+  if (chunk_size) {
+    for (size_t ofs = 0; ofs < len; ofs += chunk_size) {
+      const size_t n = (len - ofs < chunk_size) ? (len - ofs) : chunk_size;
+      if (!jiffy_parser_push(&p, DOC + ofs, n)) {
+        errx(EXIT_FAILURE, "stats test: jiffy_parser_push() failed");
+      }
+    }
+  } else {
+    jiffy_index_t index;
+    if (
+      !jiffy_index_init(&index, index_mem, INDEX_LEN) ||
+      !jiffy_index_build(&index, DOC, len) ||
+      !jiffy_parser_push_index(&p, &index, DOC, len)
+    ) {
+      errx(EXIT_FAILURE, "stats test: jiffy_parser_push_index() failed");
+    }
+  }
+
+  if (!jiffy_parser_fini(&p)) {
+    errx(EXIT_FAILURE, "stats test: jiffy_parser_fini() failed");
+  }
+
+  if (!jiffy_parser_get_stats(&p, stats)) {
+    errx(EXIT_FAILURE, "stats test: jiffy_parser_get_stats() failed");
+  }
+}
+
+static void
+check_bytes(
+  const char * const name,
+  const jiffy_parser_stats_t * const stats,
+  const uint64_t whitespace,
+  const uint64_t structural,
+  const uint64_t string,
+  const uint64_t number,
+  const uint64_t literal,
+  const uint64_t skipped
+) {
+  fprintf(stderr, "stats test: %s: whitespace = %llu, structural = %llu, "
+    "string = %llu, number = %llu, literal = %llu, skipped = %llu\n", name,
+    (unsigned long long) stats->bytes.whitespace,
+    (unsigned long long) stats->bytes.structural,
+    (unsigned long long) stats->bytes.string,
+    (unsigned long long) stats->bytes.number,
+    (unsigned long long) stats->bytes.literal,
+    (unsigned long long) stats->bytes.skipped
+  );
+
+  if (
+    stats->bytes.whitespace != whitespace ||
+    stats->bytes.structural != structural ||
+    stats->bytes.string != string ||
+    stats->bytes.number != number ||
+    stats->bytes.literal != literal ||
+    stats->bytes.skipped != skipped
+  ) {
+    errx(EXIT_FAILURE, "stats test: %s: bad byte counts", name);
+  }
+}
+
+void test_stats(int argc, char *argv[]) {
+  (void) argc;
+  (void) argv;
+
+#ifndef JIFFY_PARSER_STATS
+  // statistics are not compiled in
+  {
+    jiffy_parser_t p;
+    jiffy_parser_stats_t stats;
+
+    if (
+      !jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, NULL) ||
+      jiffy_parser_get_stats(&p, &stats)
+    ) {
+      errx(EXIT_FAILURE, "stats test: jiffy_parser_get_stats() returned statistics");
+    }
+
+    fprintf(stderr, "stats test: statistics disabled\n");
+    return;
+  }
+#endif // JIFFY_PARSER_STATS
+
+  const size_t len = strlen(DOC);
+  jiffy_parser_stats_t stats;
+
+  // whole buffer
+  parse(&stats, len, false);
+  check_bytes("whole", &stats, 5, 9, 10, 5, 4, 0);
+
+  if (
+    stats.events.on_array_start != 1 ||
+    stats.events.on_object_key_start != 2 ||
+    stats.events.on_object_key_end != 2 ||
+    stats.events.on_string_end != 3 ||
+    stats.events.on_number_end != 2 ||
+    stats.events.on_true != 1 ||
+    stats.events.on_object_start != 0 ||
+    stats.events.on_null != 0
+  ) {
+    errx(EXIT_FAILURE, "stats test: bad event counts");
+  }
+
+  if (stats.max_stack_depth != 5 || stats.num_pushes != 1) {
+    errx(EXIT_FAILURE, "stats test: max_stack_depth = %llu, num_pushes = %llu",
+      (unsigned long long) stats.max_stack_depth,
+      (unsigned long long) stats.num_pushes
+    );
+  }
+
+  // one byte at a time; the byte counts must not depend on the buffer
+  // boundaries
+  parse(&stats, 1, false);
+  check_bytes("bytewise", &stats, 5, 9, 10, 5, 4, 0);
+
+  if (stats.num_pushes != len) {
+    errx(EXIT_FAILURE, "stats test: bytewise: num_pushes = %llu", (unsigned long long) stats.num_pushes);
+  }
+
+  // structural index
+  parse(&stats, 0, false);
+  check_bytes("index", &stats, 5, 9, 10, 5, 4, 0);
+
+  // skip object values
+  parse(&stats, len, true);
+  check_bytes("skip", &stats, 3, 5, 6, 0, 0, 19);
+  parse(&stats, 1, true);
+  check_bytes("skip bytewise", &stats, 3, 5, 6, 0, 0, 19);
+}
@@ -0,0 +1,224 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf()
+#include <string.h> // strlen(), memcmp()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // errx()
+#include "../jiffy.h"
+
+// stop state
+typedef struct {
+  // stop at the end of the value of this key
+  const char *key;
+
+  // current key
+  char buf[64];
+  size_t len;
+  bool in_key;
+
+  // object depth, and depth of the stop key (zero if not found)
+  size_t depth, found;
+
+  // number of callbacks fired after stopping; callbacks fired by the
+  // byte which stopped the parser are allowed
+  size_t num_late;
+  bool stopped;
+} ctx_t;
+
+static void
+on_string_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_late += ctx->stopped;
+
+  if (ctx->in_key && ctx->len + len < sizeof(ctx->buf)) {
+    memcpy(ctx->buf + ctx->len, ptr, len);
+    ctx->len += len;
+  }
+}
+
+static void on_object_key_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_late += ctx->stopped;
+  ctx->in_key = true;
+  ctx->len = 0;
+}
+
+static void on_object_key_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_late += ctx->stopped;
+  ctx->in_key = false;
+
+  if (ctx->len == strlen(ctx->key) && !memcmp(ctx->buf, ctx->key, ctx->len)) {
+    ctx->found = ctx->depth;
+  }
+}
+
+// stop at the end of the value of the stop key
+static void on_object_value_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_late += ctx->stopped;
+
+  if (ctx->found && ctx->found == ctx->depth) {
+    jiffy_parser_stop(p);
+    ctx->stopped = true;
+  }
+}
+
+static void on_other(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_late += ctx->stopped;
+}
+
+static void on_object_start(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_late += ctx->stopped;
+  ctx->depth++;
+}
+
+static void on_object_end(const jiffy_parser_t * const p) {
+  ctx_t * const ctx = jiffy_parser_get_user_data(p);
+  ctx->num_late += ctx->stopped;
+  ctx->depth--;
+}
+
+static void on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  (void) err;
+  on_other(p);
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_null                = on_other,
+  .on_true                = on_other,
+  .on_false               = on_other,
+  .on_array_start         = on_other,
+  .on_array_end           = on_other,
+  .on_object_start        = on_object_start,
+  .on_object_end          = on_object_end,
+  .on_object_key_start    = on_object_key_start,
+  .on_object_key_end      = on_object_key_end,
+  .on_object_value_end    = on_object_value_end,
+  .on_string_start        = on_other,
+  .on_string_data         = on_string_data,
+  .on_string_end          = on_other,
+  .on_number_start        = on_other,
+  .on_number_end          = on_other,
+  .on_error               = on_error,
+};
+
+static const struct {
+  const char * const text;
+  const char * const key;
+  const bool stopped;
+  const size_t num_bytes; // bytes consumed, including the byte which
+                          // ended the value
+} TESTS[] = {
+  { "{\"type\":\"a\",\"data\":[1,2,3]}", "type", true, 12 },
+  { "{\"type\": 123 , \"data\":[1,2,3]}", "type", true, 14 },
+  { "{\"type\":true,\"data\":\"x\"}", "type", true, 13 },
+  { "{\"id\":1,\"type\":{\"a\":[]},\"data\":{\"b\":2}}", "type", true, 24 },
+  { "{\"type\":null}", "type", true, 13 },
+  { "{\"data\":[1,2,3],\"type\":\"a\"}", "type", true, 27 },
+  { "{\"data\":[1,2,3]}", "type", false, 16 },
+
+  // bytes after the stop are never parsed
+  { "{\"type\":\"a\",\"data\":[1,2,3}", "type", true, 12 },
+  { "{\"type\":\"a\"} garbage", "type", true, 12 },
+  { NULL, NULL, false, 0 },
+};
+
+#define STACK_LEN 16
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+#define INDEX_LEN 64
+static uint64_t index_mem[INDEX_LEN];
+
+// parse text in chunks of the given size, or with a structural index
+// if the chunk size is zero
+static bool
+parse(
+  jiffy_parser_t * const p,
+  ctx_t * const ctx,
+  const char * const text,
+  const size_t chunk_size
+) {
+  const size_t len = strlen(text);
+
+  if (!jiffy_parser_init(p, &CBS, stack_mem, STACK_LEN, ctx)) {
+    errx(EXIT_FAILURE, "%s: jiffy_parser_init() failed", text);
+  }
+
+  if (!chunk_size) {
+    jiffy_index_t index;
+    if (
+      !jiffy_index_init(&index, index_mem, INDEX_LEN) ||
+      !jiffy_index_build(&index, text, len)
+    ) {
+      errx(EXIT_FAILURE, "%s: index build failed", text);
+    }
+
+    return jiffy_parser_push_index(p, &index, text, len);
+  }
+
+  for (size_t ofs = 0; ofs < len; ofs += chunk_size) {
+    const size_t n = (len - ofs < chunk_size) ? (len - ofs) : chunk_size;
+    if (!jiffy_parser_push(p, text + ofs, n)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void test_stop(int argc, char *argv[]) {
+  (void) argc;
+  (void) argv;
+
+  for (size_t i = 0; TESTS[i].text; i++) {
+    const char * const text = TESTS[i].text;
+    fprintf(stderr, "stop test: %s\n", text);
+
+    // parse whole text, byte by byte, and with an index
+    static const size_t CHUNK_SIZES[] = { 4096, 1, 0 };
+    for (size_t j = 0; j < 3; j++) {
+      ctx_t ctx = { .key = TESTS[i].key };
+      jiffy_parser_t p;
+
+      const bool ok = parse(&p, &ctx, text, CHUNK_SIZES[j]);
+      if (!ok || jiffy_parser_is_stopped(&p) != TESTS[i].stopped) {
+        errx(EXIT_FAILURE, "%s: stop test failed (chunk size = %zu)", text, CHUNK_SIZES[j]);
+      }
+
+      if (!TESTS[i].stopped) {
+        if (!jiffy_parser_fini(&p)) {
+          errx(EXIT_FAILURE, "%s: jiffy_parser_fini() failed", text);
+        }
+
+        continue;
+      }
+
+      if (jiffy_parser_get_num_bytes(&p) != TESTS[i].num_bytes) {
+        errx(EXIT_FAILURE, "%s: got %zu bytes, expected %zu (chunk size = %zu)",
+          text, jiffy_parser_get_num_bytes(&p), TESTS[i].num_bytes, CHUNK_SIZES[j]
+        );
+      }
+
+      // pushing more data and finishing must succeed without parsing
+      // anything or firing any callbacks
+      ctx.num_late = 0;
+      if (
+        !jiffy_parser_push(&p, "]]]", 3) ||
+        !jiffy_parser_fini(&p) ||
+        jiffy_parser_get_num_bytes(&p) != TESTS[i].num_bytes ||
+        ctx.num_late
+      ) {
+        errx(EXIT_FAILURE, "%s: parser did not stay stopped (chunk size = %zu)", text, CHUNK_SIZES[j]);
+      }
+    }
+  }
+}
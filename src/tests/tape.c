@@ -0,0 +1,331 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // snprintf()
+#include <string.h> // memcmp(), memcpy()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // errx(), warnx()
+#include "../jiffy.h"
+#include "test-set.h"
+
+// event log; used to compare direct parsing with tape replay
+typedef struct {
+  char buf[1 << 16];
+  size_t len;
+} event_log_t;
+
+static void
+log_event(
+  const jiffy_parser_t * const p,
+  const char * const name,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  event_log_t * const log = jiffy_parser_get_user_data(p);
+  char tmp[128];
+
+  const int tmp_len = snprintf(tmp, sizeof(tmp), "%zu:%s:%.*s\n",
+    jiffy_parser_get_num_bytes(p), name, (int) len, ptr
+  );
+
+  if (tmp_len < 0 || log->len + tmp_len > sizeof(log->buf)) {
+    errx(EXIT_FAILURE, "event log overflow");
+  }
+
+  memcpy(log->buf + log->len, tmp, tmp_len);
+  log->len += tmp_len;
+}
+
+static void on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  const char * const s = jiffy_err_to_s(err);
+  log_event(p, "error", (const uint8_t*) s, strlen(s));
+}
+
+static void on_byte(
+  const jiffy_parser_t * const p,
+  const uint8_t byte
+) {
+  log_event(p, "byte", &byte, 1);
+}
+
+static void on_data(
+  const jiffy_parser_t * const p,
+  const uint8_t * const ptr,
+  const size_t len
+) {
+  log_event(p, "data", ptr, len);
+}
+
+static void on_sign(
+  const jiffy_parser_t * const p,
+  const uint8_t byte
+) {
+  log_event(p, "sign", &byte, 1);
+}
+
+// define logging callback for event with no value
+#define DEF_LOG_CB(name) \
+  static void on_##name(const jiffy_parser_t * const p) { \
+    log_event(p, #name, NULL, 0); \
+  }
+
+DEF_LOG_CB(utf8_bom)
+DEF_LOG_CB(utf16_bom)
+DEF_LOG_CB(null)
+DEF_LOG_CB(true)
+DEF_LOG_CB(false)
+DEF_LOG_CB(array_start)
+DEF_LOG_CB(array_end)
+DEF_LOG_CB(array_element_start)
+DEF_LOG_CB(array_element_end)
+DEF_LOG_CB(object_start)
+DEF_LOG_CB(object_end)
+DEF_LOG_CB(object_key_start)
+DEF_LOG_CB(object_key_end)
+DEF_LOG_CB(object_value_start)
+DEF_LOG_CB(object_value_end)
+DEF_LOG_CB(string_start)
+DEF_LOG_CB(string_end)
+DEF_LOG_CB(number_start)
+DEF_LOG_CB(number_end)
+DEF_LOG_CB(number_fraction)
+DEF_LOG_CB(number_exponent)
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_utf8_bom            = on_utf8_bom,
+  .on_utf16_bom           = on_utf16_bom,
+  .on_null                = on_null,
+  .on_true                = on_true,
+  .on_false               = on_false,
+  .on_array_start         = on_array_start,
+  .on_array_end           = on_array_end,
+  .on_array_element_start = on_array_element_start,
+  .on_array_element_end   = on_array_element_end,
+  .on_object_start        = on_object_start,
+  .on_object_end          = on_object_end,
+  .on_object_key_start    = on_object_key_start,
+  .on_object_key_end      = on_object_key_end,
+  .on_object_value_start  = on_object_value_start,
+  .on_object_value_end    = on_object_value_end,
+  .on_string_start        = on_string_start,
+  .on_string_byte         = on_byte,
+  .on_string_data         = on_data,
+  .on_string_end          = on_string_end,
+  .on_number_start        = on_number_start,
+  .on_number_byte         = on_byte,
+  .on_number_data         = on_data,
+  .on_number_end          = on_number_end,
+  .on_number_sign         = on_sign,
+  .on_number_fraction     = on_number_fraction,
+  .on_number_exponent     = on_number_exponent,
+  .on_error               = on_error,
+};
+
+#define STACK_LEN 128
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+#define TAPE_LEN 1024
+static jiffy_tape_event_t tape_mem[TAPE_LEN];
+
+static event_log_t direct_log, tape_log, small_tape_log;
+
+static void
+dump_tape(
+  const jiffy_tape_t * const tape
+) {
+  size_t len;
+  const jiffy_tape_event_t * const evs = jiffy_tape_get_events(tape, &len);
+
+  for (size_t i = 0; i < len; i++) {
+    fprintf(stderr, "tape[%zu] = %s (depth = %u, ofs = %zu, len = %zu)\n",
+      i, jiffy_tape_event_type_to_s(evs[i].type), evs[i].depth,
+      evs[i].ofs, evs[i].len
+    );
+  }
+}
+
+// parse buffer with the smallest possible tape, draining and replaying
+// the tape whenever the parser stops early.
+static bool
+parse_small_tape(
+  const char * const buf,
+  const size_t len
+) {
+  jiffy_tape_event_t mem[JIFFY_TAPE_MIN_FREE];
+  jiffy_tape_t tape;
+  jiffy_parser_t p;
+
+  if (
+    !jiffy_tape_init(&tape, mem, JIFFY_TAPE_MIN_FREE) ||
+    !jiffy_parser_init_tape(&p, &tape, stack_mem, STACK_LEN, NULL)
+  ) {
+    errx(EXIT_FAILURE, "tape init failed");
+  }
+
+  bool ok = true;
+  while (ok && jiffy_parser_get_num_bytes(&p) < len) {
+    const size_t ofs = jiffy_parser_get_num_bytes(&p);
+    ok = jiffy_parser_push(&p, buf + ofs, len - ofs);
+
+    jiffy_tape_replay(&tape, &CBS, buf, len, &small_tape_log);
+    jiffy_tape_clear(&tape);
+  }
+
+  ok = ok && jiffy_parser_fini(&p);
+  jiffy_tape_replay(&tape, &CBS, buf, len, &small_tape_log);
+  return ok;
+}
+
+// get last line of event log; for a failed parse this is the error
+static const char *
+last_line(
+  const event_log_t * const log,
+  size_t * const ret_len
+) {
+  size_t ofs = log->len ? log->len - 1 : 0;
+  while (ofs > 0 && log->buf[ofs - 1] != '\n') {
+    ofs--;
+  }
+
+  *ret_len = log->len - ofs;
+  return log->buf + ofs;
+}
+
+// replayed errors must match the errors from a direct parse, including
+// errors found by jiffy_parser_fini() past the end of the source
+static const struct {
+  const char *text, *error;
+} ERROR_TESTS[] = {
+  { "[null", "6:error:not done\n" },
+  { "{\"a\":[1,2", "10:error:not done\n" },
+  { "[1,@]", "3:error:bad byte\n" },
+  { "{\"a\":1}x", "7:error:bad byte\n" },
+  { "[\"ab\\q\"]", "5:error:bad escape\n" },
+  { NULL, NULL },
+};
+
+static void
+test_tape_errors(void) {
+  for (size_t i = 0; ERROR_TESTS[i].text; i++) {
+    const char * const buf = ERROR_TESTS[i].text;
+    const size_t len = strlen(buf);
+    direct_log.len = tape_log.len = 0;
+
+    // parse directly
+    if (jiffy_parse(&CBS, stack_mem, STACK_LEN, buf, len, &direct_log)) {
+      errx(EXIT_FAILURE, "tape error test: direct parse of \"%s\" succeeded", buf);
+    }
+
+    // parse into tape
+    jiffy_tape_t tape;
+    jiffy_parser_t p;
+    if (
+      !jiffy_tape_init(&tape, tape_mem, TAPE_LEN) ||
+      !jiffy_parser_init_tape(&p, &tape, stack_mem, STACK_LEN, NULL)
+    ) {
+      errx(EXIT_FAILURE, "tape init failed");
+    }
+
+    if (jiffy_parser_push(&p, buf, len) && jiffy_parser_fini(&p)) {
+      errx(EXIT_FAILURE, "tape error test: tape parse of \"%s\" succeeded", buf);
+    }
+
+    // replay tape
+    if (jiffy_tape_replay(&tape, &CBS, buf, len, &tape_log)) {
+      errx(EXIT_FAILURE, "tape error test: replay of \"%s\" succeeded", buf);
+    }
+
+    size_t direct_len, tape_len;
+    const char * const direct_err = last_line(&direct_log, &direct_len);
+    const char * const tape_err = last_line(&tape_log, &tape_len);
+    const size_t exp_len = strlen(ERROR_TESTS[i].error);
+
+    if (
+      direct_len != exp_len || memcmp(direct_err, ERROR_TESTS[i].error, exp_len) ||
+      tape_len != exp_len || memcmp(tape_err, ERROR_TESTS[i].error, exp_len)
+    ) {
+      dump_tape(&tape);
+      errx(EXIT_FAILURE, "tape error test: \"%s\": expected \"%.*s\", got \"%.*s\" (direct) and \"%.*s\" (replay)",
+        buf, (int) exp_len - 1, ERROR_TESTS[i].error,
+        (int) direct_len - 1, direct_err, (int) tape_len - 1, tape_err
+      );
+    }
+
+    warnx("tape error test: \"%s\": %.*s", buf, (int) tape_len - 1, tape_err);
+  }
+}
+
+void test_tape(int argc, char *argv[]) {
+  char buf[1024];
+
+  test_tape_errors();
+
+  test_set_t set;
+  if (!test_set_init(&set, argc, argv)) {
+    return;
+  }
+
+  bool expect;
+  size_t len;
+  while (test_set_next(&set, buf, sizeof(buf), &expect, &len)) {
+    direct_log.len = tape_log.len = small_tape_log.len = 0;
+
+    // parse directly
+    const bool direct_ok = jiffy_parse(&CBS, stack_mem, STACK_LEN, buf, len, &direct_log);
+
+    // parse into tape
+    jiffy_tape_t tape;
+    jiffy_parser_t p;
+    if (
+      !jiffy_tape_init(&tape, tape_mem, TAPE_LEN) ||
+      !jiffy_parser_init_tape(&p, &tape, stack_mem, STACK_LEN, NULL)
+    ) {
+      errx(EXIT_FAILURE, "tape init failed");
+    }
+
+    const bool ok = (
+      jiffy_parser_push(&p, buf, len) &&
+      jiffy_parser_fini(&p)
+    );
+
+    dump_tape(&tape);
+
+    if (ok != expect || direct_ok != expect) {
+      errx(EXIT_FAILURE, "tape parse test failed.");
+    }
+
+    // replay tape; fails if the tape contains an error
+    if (jiffy_tape_replay(&tape, &CBS, buf, len, &tape_log) != expect) {
+      errx(EXIT_FAILURE, "jiffy_tape_replay() test failed.");
+    }
+
+    // replay must match direct parse, except for values which are cut
+    // short by an error
+    if (expect && (
+      tape_log.len != direct_log.len ||
+      memcmp(tape_log.buf, direct_log.buf, tape_log.len)
+    )) {
+      errx(EXIT_FAILURE, "tape replay does not match direct parse.");
+    }
+
+    // replayed error must match the direct parse error
+    size_t direct_err_len, tape_err_len;
+    const char * const direct_err = last_line(&direct_log, &direct_err_len);
+    const char * const tape_err = last_line(&tape_log, &tape_err_len);
+    if (!expect && (
+      direct_err_len != tape_err_len ||
+      memcmp(direct_err, tape_err, tape_err_len)
+    )) {
+      errx(EXIT_FAILURE, "tape replay error does not match direct parse.");
+    }
+
+    // parse with a small tape; replay must match full tape
+    if (parse_small_tape(buf, len) != expect || (
+      small_tape_log.len != tape_log.len ||
+      memcmp(small_tape_log.buf, tape_log.buf, tape_log.len)
+    )) {
+      errx(EXIT_FAILURE, "small tape test failed.");
+    }
+  }
+}
@@ -120,6 +120,176 @@ TREE_CBS = {
   .on_error      = on_parse_error,
 };
 
+// allocator state
+typedef struct {
+  // number of live allocations, and number of calls
+  size_t num_live, num_calls;
+
+  // fail calls after this many (if non-zero)
+  size_t fail_after;
+
+  // last error
+  jiffy_err_t err;
+} alloc_ctx_t;
+
+static void *
+counting_malloc(
+  const size_t size,
+  void * const user_data
+) {
+  alloc_ctx_t * const ctx = user_data;
+  ctx->num_calls++;
+
+  if (ctx->fail_after && ctx->num_calls > ctx->fail_after) {
+    return NULL;
+  }
+
+  void * const r = malloc(size);
+  if (r) {
+    ctx->num_live++;
+  }
+
+  return r;
+}
+
+static void
+counting_free(
+  void * const ptr,
+  void * const user_data
+) {
+  alloc_ctx_t * const ctx = user_data;
+  ctx->num_live--;
+  free(ptr);
+}
+
+static void
+on_alloc_error(
+  const jiffy_tree_t * const tree,
+  const jiffy_err_t err
+) {
+  alloc_ctx_t * const ctx = jiffy_tree_get_user_data(tree);
+  ctx->err = err;
+}
+
+static const jiffy_tree_cbs_t
+ALLOC_CBS = {
+  .malloc   = counting_malloc,
+  .free     = counting_free,
+  .on_error = on_alloc_error,
+};
+
+// number of elements in generated document
+#define NUM_ELEMENTS 10000
+
+// build a tree which is large enough to grow the parse buffers, with
+// and without allocation failures
+static void
+test_tree_alloc(void) {
+  static char buf[NUM_ELEMENTS * 32];
+  size_t len = 0;
+
+  buf[len++] = '[';
+  for (size_t i = 0; i < NUM_ELEMENTS; i++) {
+    len += snprintf(buf + len, sizeof(buf) - len, "%s{\"k\":[%zu,\"v%zu\"]}", i ? "," : "", i, i);
+  }
+  buf[len++] = ']';
+
+  // build tree, check that only the tree memory is live
+  alloc_ctx_t ctx = { 0 };
+  jiffy_tree_t tree;
+  if (!jiffy_tree_new(&tree, &ALLOC_CBS, buf, len, &ctx)) {
+    errx(EXIT_FAILURE, "alloc: jiffy_tree_new() failed: %s", jiffy_err_to_s(ctx.err));
+  }
+
+  if (ctx.num_live != 1) {
+    errx(EXIT_FAILURE, "alloc: %zu live allocations after jiffy_tree_new()", ctx.num_live);
+  }
+
+  // check last element
+  const jiffy_value_t * const root = jiffy_tree_get_root_value(&tree);
+  const jiffy_value_t * const last = jiffy_array_get_nth(root, NUM_ELEMENTS - 1);
+  const jiffy_value_t * const ary = jiffy_object_get_nth_value(last, 0);
+  size_t str_len;
+  const uint8_t * const str = jiffy_string_get_bytes(jiffy_array_get_nth(ary, 1), &str_len);
+  if (jiffy_array_get_size(root) != NUM_ELEMENTS || !str || str_len != 5 || memcmp(str, "v9999", 5)) {
+    errx(EXIT_FAILURE, "alloc: bad tree");
+  }
+
+  jiffy_tree_free(&tree);
+  const size_t num_calls = ctx.num_calls;
+
+  // fail each allocation in turn, check for leaks
+  for (size_t i = 1; i < num_calls; i++) {
+    alloc_ctx_t fail_ctx = { .fail_after = i };
+    if (jiffy_tree_new(&tree, &ALLOC_CBS, buf, len, &fail_ctx)) {
+      errx(EXIT_FAILURE, "alloc: jiffy_tree_new() succeeded with %zu allocations", i);
+    }
+
+    if (fail_ctx.num_live) {
+      errx(EXIT_FAILURE, "alloc: %zu live allocations after failure %zu", fail_ctx.num_live, i);
+    }
+
+    if (
+      fail_ctx.err != JIFFY_ERR_TREE_PARSE_MALLOC_FAILED &&
+      fail_ctx.err != JIFFY_ERR_TREE_OUTPUT_MALLOC_FAILED
+    ) {
+      errx(EXIT_FAILURE, "alloc: failure %zu: got %s", i, jiffy_err_to_s(fail_ctx.err));
+    }
+  }
+
+  fprintf(stderr, "tree test: alloc: %zu bytes, %zu allocations\n", len, num_calls);
+}
+
+// check that the children of each container are stored contiguously
+static void
+test_tree_layout(void) {
+  static const char SRC[] = "{\"a\":[1,[2,3],{\"b\":4},[]],\"c\":\"x\"}";
+
+  jiffy_tree_t tree;
+  if (!jiffy_tree_new(&tree, &TREE_CBS, SRC, strlen(SRC), NULL)) {
+    errx(EXIT_FAILURE, "layout: jiffy_tree_new() failed");
+  }
+
+  // root object: keys and values are adjacent, pairs are contiguous
+  const jiffy_value_t * const root = jiffy_tree_get_root_value(&tree);
+  if (
+    jiffy_object_get_size(root) != 2 ||
+    jiffy_object_get_nth_value(root, 0) != jiffy_object_get_nth_key(root, 0) + 1 ||
+    jiffy_object_get_nth_key(root, 1) != jiffy_object_get_nth_key(root, 0) + 2
+  ) {
+    errx(EXIT_FAILURE, "layout: bad root object");
+  }
+
+  // array: elements are contiguous
+  const jiffy_value_t * const ary = jiffy_object_get_nth_value(root, 0);
+  if (jiffy_array_get_size(ary) != 4) {
+    errx(EXIT_FAILURE, "layout: bad array size");
+  }
+
+  for (size_t i = 1; i < 4; i++) {
+    if (jiffy_array_get_nth(ary, i) != jiffy_array_get_nth(ary, 0) + i) {
+      errx(EXIT_FAILURE, "layout: array element %zu is not contiguous", i);
+    }
+  }
+
+  // nested containers
+  const jiffy_value_t * const inner = jiffy_array_get_nth(ary, 1);
+  const jiffy_value_t * const obj = jiffy_array_get_nth(ary, 2);
+  size_t len;
+  const uint8_t * const num = jiffy_number_get_bytes(jiffy_array_get_nth(inner, 1), &len);
+  if (
+    !num || len != 1 || num[0] != '3' ||
+    jiffy_array_get_nth(inner, 1) != jiffy_array_get_nth(inner, 0) + 1 ||
+    jiffy_value_get_type(jiffy_object_get_nth_value(obj, 0)) != JIFFY_TYPE_NUMBER ||
+    jiffy_array_get_size(jiffy_array_get_nth(ary, 3)) != 0 ||
+    jiffy_array_get_nth(jiffy_array_get_nth(ary, 3), 0)
+  ) {
+    errx(EXIT_FAILURE, "layout: bad nested containers");
+  }
+
+  jiffy_tree_free(&tree);
+}
+
 void test_tree(int argc, char *argv[]) {
   char buf[1024];
 
@@ -160,4 +330,7 @@ void test_tree(int argc, char *argv[]) {
     // free tree
     jiffy_tree_free(&tree);
   }
+
+  test_tree_layout();
+  test_tree_alloc();
 }
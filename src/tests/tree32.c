@@ -0,0 +1,288 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf()
+#include <string.h> // memcmp(), memcpy()
+#include <stdlib.h> // EXIT_*, malloc(), free()
+#include <err.h> // err(), errx()
+#include "../jiffy.h"
+#include "test-set.h"
+
+static void
+on_tree_error(
+  const jiffy_tree_t * const tree,
+  const jiffy_err_t err
+) {
+  (void) tree;
+  (void) err;
+}
+
+static const jiffy_tree_cbs_t TREE_CBS = {
+  .on_error = on_tree_error,
+};
+
+static void
+on_tree32_error(
+  const jiffy_tree32_t * const tree,
+  const jiffy_err_t err
+) {
+  (void) tree;
+  (void) err;
+}
+
+static const jiffy_tree32_cbs_t TREE32_CBS = {
+  .on_error = on_tree32_error,
+};
+
+// compare number or string bytes of tree value and compact value
+static void
+check_bytes(
+  const uint8_t * const exp,
+  const size_t exp_len,
+  const uint8_t * const got,
+  const size_t got_len
+) {
+  if (!exp || !got || exp_len != got_len || (exp_len > 0 && memcmp(exp, got, exp_len))) {
+    errx(EXIT_FAILURE, "bytes mismatch");
+  }
+}
+
+// context for each callbacks
+typedef struct {
+  const jiffy_value_t *val;
+  size_t num_calls;
+} each_ctx_t;
+
+static void check_value(const jiffy_value_t *, const jiffy_tree32_t *, const jiffy_value32_t *);
+
+static void
+on_array_each(
+  const jiffy_tree32_t * const tree,
+  const size_t i,
+  const jiffy_value32_t * const val,
+  void * const data
+) {
+  each_ctx_t * const ctx = data;
+  if (i != ctx->num_calls++) {
+    errx(EXIT_FAILURE, "jiffy_tree32_array_each(): bad index");
+  }
+
+  check_value(jiffy_array_get_nth(ctx->val, i), tree, val);
+}
+
+static void
+on_object_each(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const key,
+  const jiffy_value32_t * const val,
+  void * const data
+) {
+  each_ctx_t * const ctx = data;
+  const size_t i = ctx->num_calls++;
+
+  check_value(jiffy_object_get_nth_key(ctx->val, i), tree, key);
+  check_value(jiffy_object_get_nth_value(ctx->val, i), tree, val);
+}
+
+// compare tree value with compact value
+static void
+check_value(
+  const jiffy_value_t * const val,
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const got
+) {
+  const jiffy_type_t type = jiffy_value_get_type(val);
+  if (jiffy_tree32_value_get_type(got) != type) {
+    errx(EXIT_FAILURE, "type mismatch: expected %s, got %s", jiffy_type_to_s(type), jiffy_type_to_s(jiffy_tree32_value_get_type(got)));
+  }
+
+  switch (type) {
+  case JIFFY_TYPE_NUMBER:
+    {
+      size_t exp_len, got_len;
+      const uint8_t * const exp = jiffy_number_get_bytes(val, &exp_len);
+      const uint8_t * const ptr = jiffy_tree32_number_get_bytes(tree, got, &got_len);
+      check_bytes(exp, exp_len, ptr, got_len);
+    }
+
+    break;
+  case JIFFY_TYPE_STRING:
+    {
+      size_t exp_len, got_len;
+      const uint8_t * const exp = jiffy_string_get_bytes(val, &exp_len);
+      const uint8_t * const ptr = jiffy_tree32_string_get_bytes(tree, got, &got_len);
+      check_bytes(exp, exp_len, ptr, got_len);
+    }
+
+    break;
+  case JIFFY_TYPE_ARRAY:
+    {
+      const size_t len = jiffy_array_get_size(val);
+      if (jiffy_tree32_array_get_size(got) != len) {
+        errx(EXIT_FAILURE, "array size mismatch");
+      }
+
+      for (size_t i = 0; i < len; i++) {
+        check_value(jiffy_array_get_nth(val, i), tree, jiffy_tree32_array_get_nth(tree, got, i));
+      }
+
+      if (jiffy_tree32_array_get_nth(tree, got, len)) {
+        errx(EXIT_FAILURE, "jiffy_tree32_array_get_nth(): expected NULL");
+      }
+
+      each_ctx_t ctx = { .val = val };
+      if (!jiffy_tree32_array_each(tree, got, on_array_each, &ctx) || ctx.num_calls != len) {
+        errx(EXIT_FAILURE, "jiffy_tree32_array_each() failed");
+      }
+    }
+
+    break;
+  case JIFFY_TYPE_OBJECT:
+    {
+      const size_t len = jiffy_object_get_size(val);
+      if (jiffy_tree32_object_get_size(got) != len) {
+        errx(EXIT_FAILURE, "object size mismatch");
+      }
+
+      for (size_t i = 0; i < len; i++) {
+        check_value(jiffy_object_get_nth_key(val, i), tree, jiffy_tree32_object_get_nth_key(tree, got, i));
+        check_value(jiffy_object_get_nth_value(val, i), tree, jiffy_tree32_object_get_nth_value(tree, got, i));
+      }
+
+      if (jiffy_tree32_object_get_nth_value(tree, got, len)) {
+        errx(EXIT_FAILURE, "jiffy_tree32_object_get_nth_value(): expected NULL");
+      }
+
+      each_ctx_t ctx = { .val = val };
+      if (!jiffy_tree32_object_each(tree, got, on_object_each, &ctx) || ctx.num_calls != len) {
+        errx(EXIT_FAILURE, "jiffy_tree32_object_each() failed");
+      }
+    }
+
+    break;
+  default:
+    break;
+  }
+}
+
+static void walk_value(const jiffy_tree32_t *, const jiffy_value32_t *, size_t *);
+
+static void
+on_walk_array_each(
+  const jiffy_tree32_t * const tree,
+  const size_t i,
+  const jiffy_value32_t * const val,
+  void * const data
+) {
+  (void) i;
+  walk_value(tree, val, data);
+}
+
+static void
+on_walk_object_each(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const key,
+  const jiffy_value32_t * const val,
+  void * const data
+) {
+  (void) key;
+  walk_value(tree, val, data);
+}
+
+// count values below the given value, walking nested containers with
+// the tree passed to the each callbacks
+static void
+walk_value(
+  const jiffy_tree32_t * const tree,
+  const jiffy_value32_t * const val,
+  size_t * const num_vals
+) {
+  (*num_vals)++;
+
+  switch (jiffy_tree32_value_get_type(val)) {
+  case JIFFY_TYPE_ARRAY:
+    jiffy_tree32_array_each(tree, val, on_walk_array_each, num_vals);
+    break;
+  case JIFFY_TYPE_OBJECT:
+    jiffy_tree32_object_each(tree, val, on_walk_object_each, num_vals);
+    break;
+  default:
+    break;
+  }
+}
+
+// walk a nested document from inside the each callbacks
+static void
+test_tree32_walk(void) {
+  static const char DOC[] = "{\"a\":[1,[2,3]],\"b\":{\"c\":[4,{}]}}";
+
+  jiffy_tree32_t tree;
+  if (!jiffy_tree32_new(&tree, &TREE32_CBS, DOC, strlen(DOC), NULL)) {
+    errx(EXIT_FAILURE, "jiffy_tree32_new() failed: %s", DOC);
+  }
+
+  // root, 2 arrays and 3 numbers under "a", and the object, array, 1
+  // number, and empty object under "b"
+  size_t num_vals = 0;
+  walk_value(&tree, jiffy_tree32_get_root_value(&tree), &num_vals);
+  if (num_vals != 10) {
+    errx(EXIT_FAILURE, "jiffy_tree32 walk: expected 10 values, got %zu", num_vals);
+  }
+
+  jiffy_tree32_free(&tree);
+}
+
+// compare compact trees with trees for each corpus document.  Each
+// compact tree is checked after copying its data to new memory, since
+// it holds no pointers.
+void test_tree32(int argc, char *argv[]) {
+  char buf[1024];
+  size_t num_vals = 0, num_bytes = 0;
+
+  test_tree32_walk();
+
+  test_set_t set;
+  if (!test_set_init(&set, argc, argv)) {
+    return;
+  }
+
+  bool expect;
+  size_t len;
+  while (test_set_next(&set, buf, sizeof(buf), &expect, &len)) {
+    jiffy_tree32_t tree32;
+    if (jiffy_tree32_new(&tree32, &TREE32_CBS, buf, len, NULL) != expect) {
+      errx(EXIT_FAILURE, "jiffy_tree32_new(): expected %d: %s", expect, buf);
+    }
+
+    if (!expect) {
+      continue;
+    }
+
+    jiffy_tree_t tree;
+    if (!jiffy_tree_new(&tree, &TREE_CBS, buf, len, NULL)) {
+      errx(EXIT_FAILURE, "jiffy_tree_new() failed: %s", buf);
+    }
+
+    if (tree32.num_vals != tree.num_vals) {
+      errx(EXIT_FAILURE, "value count mismatch: %s", buf);
+    }
+
+    // copy compact tree data, free original
+    jiffy_tree32_t copy = tree32;
+    copy.data = malloc(tree32.size);
+    if (!copy.data) {
+      err(EXIT_FAILURE, "malloc()");
+    }
+    memcpy(copy.data, tree32.data, tree32.size);
+    jiffy_tree32_free(&tree32);
+
+    // compare values
+    check_value(jiffy_tree_get_root_value(&tree), &copy, jiffy_tree32_get_root_value(&copy));
+
+    num_vals += copy.num_vals;
+    num_bytes += copy.size;
+
+    jiffy_tree_free(&tree);
+    jiffy_tree32_free(&copy);
+  }
+
+  fprintf(stderr, "tree32 test: %zu values, %zu bytes\n", num_vals, num_bytes);
+}
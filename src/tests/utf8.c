@@ -0,0 +1,185 @@
+#include <stdbool.h> // bool
+#include <stdio.h> // fprintf()
+#include <string.h> // strlen()
+#include <stdlib.h> // EXIT_*
+#include <err.h> // errx()
+#include "../jiffy.h"
+
+static const struct {
+  const char * const name;
+  const char * const text;
+  const bool ok;
+  const size_t ofs; // offset of first invalid byte
+} TESTS[] = {
+  { "ascii", "\"hello\"", true, 0 },
+  { "2-byte", "\"caf\xc3\xa9\"", true, 0 },
+  { "3-byte", "\"\xe2\x82\xac 100\"", true, 0 },
+  { "4-byte", "\"\xf0\x9f\x98\x80\"", true, 0 },
+  { "max code point", "\"\xf4\x8f\xbf\xbf\"", true, 0 },
+  { "escape after sequence", "\"\xc3\xa9\\n\xc3\xa9\"", true, 0 },
+  { "object key", "{\"\xc3\xa9\":\"\xe2\x82\xac\"}", true, 0 },
+  {
+    "long",
+    "\"0123456789abcdef0123456789abcdef"
+    "\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac"
+    "\xf0\x9f\x98\x80\xf0\x9f\x98\x80\xf0\x9f\x98\x80\xf0\x9f\x98\x80"
+    "0123456789abcdef0123456789abcdef\"",
+    true, 0,
+  },
+  { "bare continuation", "\"ab\x80\"", false, 3 },
+  { "overlong 2-byte", "\"\xc0\xaf\"", false, 1 },
+  { "overlong 3-byte", "\"\xe0\x80\xaf\"", false, 2 },
+  { "overlong 4-byte", "\"\xf0\x80\x80\xaf\"", false, 2 },
+  { "surrogate", "\"\xed\xa0\x80\"", false, 2 },
+  { "too large", "\"\xf4\x90\x80\x80\"", false, 2 },
+  { "bad lead byte", "\"\xf5\x80\x80\x80\"", false, 1 },
+  { "truncated at quote", "\"\xe2\x82\"", false, 3 },
+  { "truncated at escape", "\"\xe2\\n\"", false, 2 },
+  { "truncated by ascii", "\"\xc3" "a\"", false, 2 },
+  {
+    "long error",
+    "\"0123456789abcdef0123456789abcdef"
+    "\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82\xac\xe2\x82"
+    "0123456789abcdef0123456789abcdef\"",
+    false, 50,
+  },
+  {
+    "2-byte across 16-byte block",
+    "\"" "aaaaaaaaaaaaaaa"
+    "\xc3\xa9"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    true, 0,
+  },
+  {
+    "2-byte across 32-byte block",
+    "\"" "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "\xc3\xa9"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    true, 0,
+  },
+  {
+    "4-byte across 32-byte block",
+    "\"" "aaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "\xf0\x9f\x98\x80"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    true, 0,
+  },
+  {
+    "2-byte truncated at 16-byte block",
+    "\"" "aaaaaaaaaaaaaaa"
+    "\xc3"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    false, 17,
+  },
+  {
+    "3-byte truncated at 16-byte block",
+    "\"" "aaaaaaaaaaaaaa"
+    "\xe2\x82"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    false, 17,
+  },
+  {
+    "4-byte truncated at 16-byte block",
+    "\"" "aaaaaaaaaaaaa"
+    "\xf0\x9f\x98"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    false, 17,
+  },
+  {
+    "2-byte truncated at 32-byte block",
+    "\"" "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "\xc3"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    false, 33,
+  },
+  {
+    "3-byte truncated at 32-byte block",
+    "\"" "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "\xe2\x82"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    false, 33,
+  },
+  {
+    "4-byte truncated at 32-byte block",
+    "\"" "aaaaaaaaaaaaaaaaaaaaaaaaaaaaa"
+    "\xf0\x9f\x98"
+    "bbbbbbbbbbbbbbbbbbbbbbbbbbbbbbbb\"",
+    false, 33,
+  },
+  { NULL, NULL, false, 0 },
+};
+
+#define STACK_LEN 16
+static jiffy_parser_state_t stack_mem[STACK_LEN];
+
+static void on_error(
+  const jiffy_parser_t * const p,
+  const jiffy_err_t err
+) {
+  jiffy_err_t * const ret = jiffy_parser_get_user_data(p);
+  *ret = err;
+}
+
+static const jiffy_parser_cbs_t CBS = {
+  .on_error = on_error,
+};
+
+// parse text, either in one buffer or one byte at a time
+static bool
+parse(
+  const char * const text,
+  const bool split,
+  jiffy_err_t * const err,
+  size_t * const ofs
+) {
+  const size_t len = strlen(text);
+  jiffy_parser_t p;
+  bool ok;
+
+  if (!jiffy_parser_init(&p, &CBS, stack_mem, STACK_LEN, err)) {
+    errx(EXIT_FAILURE, "jiffy_parser_init() failed");
+  }
+
+  jiffy_parser_set_flags(&p, JIFFY_PARSER_FLAG_VALIDATE_UTF8);
+
+  if (split) {
+    ok = true;
+    for (size_t i = 0; ok && i < len; i++) {
+      ok = jiffy_parser_push(&p, text + i, 1);
+    }
+  } else {
+    ok = jiffy_parser_push(&p, text, len);
+  }
+
+  ok = ok && jiffy_parser_fini(&p);
+  *ofs = jiffy_parser_get_num_bytes(&p);
+  return ok;
+}
+
+void test_utf8(int argc, char *argv[]) {
+  (void) argc;
+  (void) argv;
+
+  for (size_t i = 0; TESTS[i].text; i++) {
+    fprintf(stderr, "utf8 test: %s\n", TESTS[i].name);
+
+    for (size_t j = 0; j < 2; j++) {
+      jiffy_err_t err = JIFFY_ERR_OK;
+      size_t ofs;
+
+      const bool ok = parse(TESTS[i].text, j, &err, &ofs);
+      if (ok != TESTS[i].ok) {
+        errx(EXIT_FAILURE, "%s: expected %s", TESTS[i].name, TESTS[i].ok ? "success" : "failure");
+      }
+
+      if (!ok && (err != JIFFY_ERR_BAD_UTF8 || ofs != TESTS[i].ofs)) {
+        errx(EXIT_FAILURE, "%s: got %s at %zu, expected bad UTF-8 at %zu", TESTS[i].name, jiffy_err_to_s(err), ofs, TESTS[i].ofs);
+      }
+    }
+
+    // strings are not checked unless validation is enabled
+    if (!jiffy_parse(NULL, stack_mem, STACK_LEN, TESTS[i].text, strlen(TESTS[i].text), NULL)) {
+      errx(EXIT_FAILURE, "%s: unvalidated parse failed", TESTS[i].name);
+    }
+  }
+}